@@ -0,0 +1,877 @@
+// SPDX-License-Identifier: ISC
+
+/**
+ * @file bench.c
+ * @brief Suíte de benchmarks das somas de Riemann, com saída em JSON.
+ *
+ * @details Este programa varre o grau do polinômio, o número de retângulos,
+ * o tipo de soma, o número de threads, o nível de vetorização e a dimensão,
+ * e mede para cada configuração:
+ *
+ * - o tempo mediano e o mínimo, após execuções de aquecimento;
+ * - o tempo por avaliação da função e as avaliações por segundo;
+ * - a vazão de memória estimada, contando a escrita e a leitura das abscissas
+ *   e dos valores da função nos buffers de cada bloco (16 bytes por ponto,
+ *   e nenhum nas precisões `float` e `dd`, que somam os polinômios sem
+ *   buffers);
+ * - o erro relativo em relação à integral analítica;
+ * - o erro relativo em relação à própria soma de Riemann, calculada em
+ *   `long double` com soma compensada, que isola o erro de arredondamento do
+ *   erro de discretização e mostra o ganho de cada precisão.
+ *
+ * Na dimensão 2 (ver `riemann2d()`), a função é um `BIPOLYNOMIAL` de mesmo
+ * grau nas duas variáveis, somado no quadrado \f$[0, 1]^2\f$ numa grade de
+ * \f$\sqrt{n} \times \sqrt{n}\f$ pontos (com o lado arredondado), e o tempo
+ * por avaliação é comparável ao da dimensão 1. Ela é medida somente em
+ * precisão dupla.
+ *
+ * A soma ponto a ponto é medida em cada precisão de `--precision` (`double`,
+ * `float` ou `dd`, ver `RiemannPrecision`), para comparar a vazão e o erro de
+ * cada uma.
+ *
+ * As configurações com fórmula fechada (ver `RIEMANN_CLOSED_MAX_DEGREE`) são
+ * medidas também no modo `"fechado"`, apenas com uma thread e o nível de
+ * vetorização padrão, já que ele não avalia a função.
+ *
+ * Os resultados vão em JSON para a saída padrão (ou para o arquivo de
+ * `--out`), um objeto por linha dentro de `"resultados"`, e numa tabela
+ * legível para a saída de erro. O modo `--compare` lê duas saídas e aponta as
+ * configurações cujo tempo por avaliação piorou além de um limiar de ruído.
+ *
+ * Uso:
+ * @code
+ * bench [--quick] [--degrees L] [--ns L] [--threads L] [--simd L]
+ *       [--precision L] [--dims L] [--reps R] [--warmup W] [--cpu C]
+ *       [--out ARQUIVO]
+ * bench --compare BASE.json ATUAL.json [--threshold PORCENTAGEM]
+ * @endcode
+ *
+ * onde `L` é uma lista separada por vírgulas, como `0,8,64`, `1e3,1e9` ou
+ * `1,2`, e a
+ * lista de `--simd` tem nomes como `scalar,avx2`, e a de `--precision`, como
+ * `double,dd`.
+ */
+
+#define _GNU_SOURCE
+
+#include <math.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "func.h"
+#include "func2d.h"
+#include "pool.h"
+#include "riemann.h"
+#include "riemann2d.h"
+#include "simd.h"
+
+/**
+ * @brief Número máximo de elementos em cada lista de parâmetros.
+ */
+#define BENCH_MAX_LIST 32
+
+/**
+ * @brief Maior grau de polinômio medido.
+ */
+#define BENCH_MAX_DEGREE 64
+
+/**
+ * @brief Número máximo de execuções medidas por configuração.
+ */
+#define BENCH_MAX_REPS 101
+
+/**
+ * @brief Versão do formato da saída em JSON.
+ */
+#define BENCH_VERSION 3
+
+/**
+ * @brief Uma lista de parâmetros da varredura.
+ */
+typedef struct {
+	double values[BENCH_MAX_LIST]; /**< Os valores. */
+	size_t count; /**< Número de valores. */
+} List;
+
+/**
+ * @brief Parâmetros da varredura e estado da saída.
+ */
+typedef struct {
+	List degrees; /**< Graus dos polinômios. */
+	List ns; /**< Números de retângulos. */
+	List threads; /**< Números de threads. */
+	List simds; /**< Níveis de vetorização. */
+	List precisions; /**< Precisões da soma ponto a ponto. */
+	List dims; /**< Dimensões do domínio, 1 ou 2. */
+	SimdLevel top; /**< Nível de vetorização padrão. */
+	unsigned warmup; /**< Execuções de aquecimento por configuração. */
+	unsigned reps; /**< Execuções medidas por configuração. */
+	FILE *out; /**< Arquivo da saída em JSON. */
+	bool first; /**< Se ainda não foi escrito nenhum resultado. */
+} Bench;
+
+/**
+ * @brief Resultado de uma configuração.
+ */
+typedef struct {
+	size_t degree; /**< Grau do polinômio. */
+	size_t n; /**< Número de retângulos. */
+	unsigned dim; /**< Dimensão do domínio. */
+	SumType type; /**< Tipo de soma. */
+	unsigned threads; /**< Número de threads. */
+	SimdLevel simd; /**< Nível de vetorização. */
+	RiemannPrecision precision; /**< Precisão da soma. */
+	bool closed; /**< Se a fórmula fechada foi permitida. */
+	double median; /**< Tempo mediano, em segundos. */
+	double best; /**< Tempo mínimo, em segundos. */
+	double error; /**< Erro relativo em relação à integral analítica. */
+	double sum_error; /**< Erro relativo em relação à soma exata. */
+} Result;
+
+/**
+ * @brief Uma linha lida de uma saída anterior, no modo de comparação.
+ */
+typedef struct {
+	char key[128]; /**< Identificação da configuração. */
+	double ns; /**< Tempo mínimo por avaliação, em nanossegundos. */
+} Entry;
+
+// Declarações internas.
+static double now(void);
+static bool parse_list(const char *arg, List *list);
+static bool parse_simd(const char *arg, List *list);
+static bool parse_precision(const char *arg, List *list);
+static void pin(unsigned cpu, unsigned count);
+static double exact(const double *coeffs, size_t degree, double a, double b);
+static double exact_sum(const double *coeffs, size_t degree, size_t n,
+			SumType type);
+static double exact_sum2d(const double *coeffs, size_t degree, size_t side,
+			  SumType type);
+static void run(Bench *b, size_t degree);
+static void run2d(Bench *b, size_t degree);
+static Result measure(const Bench *b, Function *func, Function2D *func2d,
+		      size_t degree, const double ref[2], size_t n,
+		      SumType type, unsigned threads,
+		      RiemannPrecision precision, bool closed);
+static void print_result(Bench *b, const Result *r);
+static int compare(const char *base, const char *cur, double threshold);
+static size_t load(const char *path, Entry **entries);
+static int cmp_double(const void *a, const void *b);
+
+/**
+ * @brief Limite inferior de integração.
+ */
+static const double lower = 0;
+
+/**
+ * @brief Limite superior de integração.
+ */
+static const double upper = 1;
+
+/**
+ * @brief Nomes das precisões, na ordem de `RiemannPrecision`.
+ */
+static const char *const precision_names[] = { "double", "float", "dd" };
+
+/**
+ * @brief Nomes dos tipos de soma, na ordem de `SumType`.
+ */
+static const char *const sum_names[] = {
+	[DIREITA] = "direita",
+	[ESQUERDA] = "esquerda",
+	[MEIO] = "meio",
+};
+
+/**
+ * @brief Função principal do benchmark.
+ *
+ * @param argc Número de argumentos.
+ * @param argv Argumentos, conforme a descrição do arquivo.
+ * @return EXIT_SUCCESS em caso de sucesso; no modo de comparação,
+ * EXIT_FAILURE se houver regressões.
+ */
+int main(int argc, char *argv[])
+{
+	Bench b = {
+		.degrees = { { 0, 1, 2, 4, 8, 16, 32, 64 }, 8 },
+		.ns = { { 1e3, 1e5, 1e7 }, 3 },
+		.threads = { { 1 }, 1 },
+		.precisions = { { RIEMANN_DOUBLE, RIEMANN_FLOAT,
+				  RIEMANN_DOUBLE_DOUBLE }, 3 },
+		.dims = { { 1, 2 }, 2 },
+		.top = simd_level(),
+		.warmup = 1,
+		.reps = 5,
+		.out = stdout,
+		.first = true,
+	};
+	unsigned cpu = 0;
+	const char *path = nullptr;
+
+	if (argc >= 2 && strcmp(argv[1], "--compare") == 0) {
+		double threshold = 5;
+		char *end;
+
+		// Somente as duas saídas, seguidas ou não do limiar.
+		if (argc == 6 && strcmp(argv[4], "--threshold") == 0) {
+			threshold = strtod(argv[5], &end);
+			if (end == argv[5] || *end != '\0' ||
+			    !(threshold >= 0 && isfinite(threshold)))
+				goto usage;
+		} else if (argc != 4) {
+			goto usage;
+		}
+		return compare(argv[2], argv[3], threshold / 100);
+	}
+
+	// Por padrão, mede uma thread e todos os processadores, e todos os
+	// níveis de vetorização suportados.
+	unsigned cpus = pool_cpu_count();
+	if (cpus > 1)
+		b.threads.values[b.threads.count++] = cpus;
+	for (SimdLevel l = SIMD_SCALAR; l <= b.top; ++l)
+		if (simd_set_level(l) == l)
+			b.simds.values[b.simds.count++] = l;
+	simd_set_level(b.top);
+
+	for (int i = 1; i < argc; ++i) {
+		const char *arg = argv[i];
+		const char *val = i + 1 < argc ? argv[i + 1] : nullptr;
+		bool ok = true;
+
+		if (strcmp(arg, "--quick") == 0) {
+			b.ns = (List){ { 1e3, 1e5 }, 2 };
+			b.reps = 3;
+			continue;
+		}
+		if (val == nullptr)
+			goto usage;
+		++i;
+
+		if (strcmp(arg, "--degrees") == 0)
+			ok = parse_list(val, &b.degrees);
+		else if (strcmp(arg, "--ns") == 0)
+			ok = parse_list(val, &b.ns);
+		else if (strcmp(arg, "--threads") == 0)
+			ok = parse_list(val, &b.threads);
+		else if (strcmp(arg, "--simd") == 0)
+			ok = parse_simd(val, &b.simds);
+		else if (strcmp(arg, "--precision") == 0)
+			ok = parse_precision(val, &b.precisions);
+		else if (strcmp(arg, "--dims") == 0)
+			ok = parse_list(val, &b.dims);
+		else if (strcmp(arg, "--reps") == 0)
+			b.reps = strtoul(val, nullptr, 10);
+		else if (strcmp(arg, "--warmup") == 0)
+			b.warmup = strtoul(val, nullptr, 10);
+		else if (strcmp(arg, "--cpu") == 0)
+			cpu = strtoul(val, nullptr, 10);
+		else if (strcmp(arg, "--out") == 0)
+			path = val;
+		else
+			ok = false;
+		if (!ok)
+			goto usage;
+	}
+	if (b.reps == 0 || b.reps > BENCH_MAX_REPS)
+		b.reps = b.reps == 0 ? 1 : BENCH_MAX_REPS;
+
+	// Fixa o processo nos processadores a partir de `cpu`, antes de criar
+	// o conjunto de threads, cujas threads herdam a máscara.
+	unsigned max_threads = 1;
+	for (size_t i = 0; i < b.threads.count; ++i)
+		if (b.threads.values[i] > max_threads)
+			max_threads = b.threads.values[i];
+	pin(cpu, max_threads);
+
+	if (path != nullptr && (b.out = fopen(path, "w")) == nullptr) {
+		perror(path);
+		return EXIT_FAILURE;
+	}
+
+	fprintf(b.out,
+		"{\"versao\":%d,\"cpus\":%u,\"simd\":\"%s\",\"resultados\":[",
+		BENCH_VERSION, cpus, simd_level_name(b.top));
+	fprintf(stderr,
+		"%5s %3s %11s %8s %7s %7s %6s %7s %10s %12s %8s %10s %10s\n",
+		"grau", "dim", "n", "soma", "threads", "simd", "prec", "modo",
+		"ns/aval", "aval/s", "GB/s", "erro rel.", "erro soma");
+
+	for (size_t d = 0; d < b.degrees.count; ++d) {
+		size_t degree = b.degrees.values[d];
+		if (degree > BENCH_MAX_DEGREE)
+			degree = BENCH_MAX_DEGREE;
+		for (size_t i = 0; i < b.dims.count; ++i) {
+			if (b.dims.values[i] == 1)
+				run(&b, degree);
+			else if (b.dims.values[i] == 2)
+				run2d(&b, degree);
+		}
+	}
+	simd_set_level(b.top);
+
+	fputs("\n]}\n", b.out);
+	if (b.out != stdout)
+		fclose(b.out);
+	return EXIT_SUCCESS;
+
+usage:
+	fprintf(stderr,
+		"Uso: %s [--quick] [--degrees L] [--ns L] [--threads L]\n"
+		"          [--simd L] [--precision L] [--dims L] [--reps R]\n"
+		"          [--warmup W] [--cpu C] [--out ARQUIVO]\n"
+		"     %s --compare BASE.json ATUAL.json "
+		"[--threshold PORCENTAGEM]\n",
+		argv[0], argv[0]);
+	return EXIT_FAILURE;
+}
+
+/**
+ * @brief Retorna o tempo monotônico atual, em segundos.
+ */
+static double now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/**
+ * @brief Lê uma lista de números separados por vírgulas.
+ *
+ * @param arg A lista.
+ * @param list Ponteiro onde os valores serão escritos.
+ * @return `true` se a lista for válida e não vazia.
+ */
+static bool parse_list(const char *arg, List *list)
+{
+	char *end;
+
+	list->count = 0;
+	for (const char *p = arg; *p != '\0'; p = end + (*end == ',')) {
+		if (list->count == BENCH_MAX_LIST)
+			return false;
+		double v = strtod(p, &end);
+		if (end == p || v < 0 || (*end != ',' && *end != '\0'))
+			return false;
+		list->values[list->count++] = v;
+	}
+	return list->count > 0;
+}
+
+/**
+ * @brief Lê uma lista de níveis de vetorização separados por vírgulas.
+ *
+ * @details Níveis não suportados pelo processador são descartados, pois
+ * seriam medidos com o nível inferior.
+ *
+ * @param arg A lista, com nomes como os de `simd_level_name()`.
+ * @param list Ponteiro onde os níveis serão escritos.
+ * @return `true` se todos os nomes forem conhecidos.
+ */
+static bool parse_simd(const char *arg, List *list)
+{
+	SimdLevel top = simd_level();
+
+	list->count = 0;
+	for (const char *p = arg; *p != '\0';) {
+		size_t len = strcspn(p, ",");
+		SimdLevel l = SIMD_SCALAR;
+		while (l <= SIMD_AVX512 &&
+		       (strlen(simd_level_name(l)) != len ||
+			strncmp(p, simd_level_name(l), len) != 0))
+			++l;
+		if (l > SIMD_AVX512 || list->count == BENCH_MAX_LIST)
+			return false;
+		if (simd_set_level(l) == l)
+			list->values[list->count++] = l;
+		p += len + (p[len] == ',');
+	}
+	simd_set_level(top);
+	return true;
+}
+
+/**
+ * @brief Lê uma lista de precisões separadas por vírgulas.
+ *
+ * @param arg A lista, com nomes como os de `precision_names`.
+ * @param list Ponteiro onde as precisões serão escritas.
+ * @return `true` se a lista for não vazia e todos os nomes forem conhecidos.
+ */
+static bool parse_precision(const char *arg, List *list)
+{
+	constexpr size_t count = sizeof(precision_names) /
+				 sizeof(*precision_names);
+
+	list->count = 0;
+	for (const char *p = arg; *p != '\0';) {
+		size_t len = strcspn(p, ",");
+		size_t k = 0;
+		while (k < count && (strlen(precision_names[k]) != len ||
+				     strncmp(p, precision_names[k], len) != 0))
+			++k;
+		if (k == count || list->count == BENCH_MAX_LIST)
+			return false;
+		list->values[list->count++] = k;
+		p += len + (p[len] == ',');
+	}
+	return list->count > 0;
+}
+
+/**
+ * @brief Fixa o processo num intervalo de processadores.
+ *
+ * @param cpu O primeiro processador.
+ * @param count Número de processadores.
+ */
+static void pin(unsigned cpu, unsigned count)
+{
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	for (unsigned i = 0; i < count; ++i)
+		CPU_SET((cpu + i) % CPU_SETSIZE, &set);
+	if (sched_setaffinity(0, sizeof(set), &set) != 0)
+		perror("Aviso: não foi possível fixar os processadores");
+}
+
+/**
+ * @brief Calcula a integral analítica de um polinômio.
+ *
+ * @param coeffs Coeficientes do polinômio.
+ * @param degree Grau do polinômio.
+ * @param a Limite inferior.
+ * @param b Limite superior.
+ * @return \f$\sum_i c_i (b^{i+1} - a^{i+1}) / (i + 1)\f$, calculada em
+ * `long double`.
+ */
+static double exact(const double *coeffs, size_t degree, double a, double b)
+{
+	long double sum = 0, pa = a, pb = b;
+	for (size_t i = 0; i <= degree; ++i, pa *= a, pb *= b)
+		sum += coeffs[i] * (pb - pa) / (i + 1);
+	return sum;
+}
+
+/**
+ * @brief Calcula uma soma de Riemann de um polinômio com precisão estendida.
+ *
+ * @details Os pontos da grade são arredondados para `double` como em
+ * `riemann_opts()`, mas os valores são calculados em `long double` e somados
+ * com a soma compensada de Kahan, de modo que o resultado serve de
+ * referência mesmo para `RIEMANN_DOUBLE_DOUBLE`.
+ *
+ * @param coeffs Coeficientes do polinômio.
+ * @param degree Grau do polinômio.
+ * @param n Número de retângulos em [`lower`, `upper`].
+ * @param type Tipo de soma.
+ * @return A soma, multiplicada pela largura dos retângulos.
+ */
+static double exact_sum(const double *coeffs, size_t degree, size_t n,
+			SumType type)
+{
+	double dx = (upper - lower) / n;
+	double a = type == MEIO ? lower + dx / 2 : lower;
+	size_t first = type == DIREITA ? 1 : 0;
+	long double sum = 0, c = 0;
+
+	for (size_t i = first; i < first + n; ++i) {
+		long double x = a + i * dx, y = coeffs[degree];
+		for (size_t k = degree; k-- > 0;)
+			y = y * x + coeffs[k];
+		long double t = sum + (y - c);
+		c = (t - sum) - (y - c);
+		sum = t;
+	}
+	return sum * dx;
+}
+
+/**
+ * @brief Calcula uma soma de Riemann de um polinômio em duas variáveis com
+ * precisão estendida.
+ *
+ * @details Os pontos da grade são arredondados para `double` como em
+ * `riemann2d()`. A soma é \f$\sum_{j,i} c_{j,i} X_i Y_j\f$, onde \f$X_i\f$ e
+ * \f$Y_j\f$ são as somas das potências das abscissas e das ordenadas, todas
+ * em `long double`.
+ *
+ * @param coeffs Coeficientes do polinômio, no formato de `Bipolynomial`.
+ * @param degree Grau do polinômio em cada variável.
+ * @param side Número de retângulos em cada lado de [`lower`, `upper`]².
+ * @param type Tipo de soma.
+ * @return A soma, multiplicada pela área dos retângulos.
+ */
+static double exact_sum2d(const double *coeffs, size_t degree, size_t side,
+			  SumType type)
+{
+	double dx = (upper - lower) / side;
+	double a = type == MEIO ? lower + dx / 2 : lower;
+	size_t first = type == DIREITA ? 1 : 0;
+	long double pow_sums[BENCH_MAX_DEGREE + 1] = { 0 };
+	long double sum = 0;
+
+	for (size_t i = first; i < first + side; ++i) {
+		long double x = a + i * dx, p = 1;
+		for (size_t k = 0; k <= degree; ++k, p *= x)
+			pow_sums[k] += p;
+	}
+	for (size_t j = 0; j <= degree; ++j)
+		for (size_t i = 0; i <= degree; ++i)
+			sum += coeffs[j * (degree + 1) + i] * pow_sums[i] *
+			       pow_sums[j];
+	return sum * dx * dx;
+}
+
+/**
+ * @brief Mede todas as configurações de um grau.
+ *
+ * @details A soma ponto a ponto é medida em cada precisão, e o modo fechado
+ * só onde a fórmula se aplica, com uma thread, o nível de vetorização padrão
+ * e a precisão dupla, pois não avalia a função.
+ *
+ * @param b Ponteiro para os parâmetros da varredura.
+ * @param degree O grau do polinômio.
+ */
+static void run(Bench *b, size_t degree)
+{
+	// Coeficientes alternados, de magnitude decrescente.
+	double coeffs[BENCH_MAX_DEGREE + 1];
+	for (size_t i = 0; i <= degree; ++i)
+		coeffs[i] = (i % 2 ? -1.0 : 1.0) / (i + 1);
+	Function *f = function_new(POLYNOMIAL, degree, coeffs);
+	if (f == nullptr)
+		exit(EXIT_FAILURE);
+	double ref[2] = { exact(coeffs, degree, lower, upper) };
+
+	for (size_t j = 0; j < b->ns.count; ++j) {
+		size_t n = b->ns.values[j];
+		bool closed = degree <= RIEMANN_CLOSED_MAX_DEGREE &&
+			      n >= RIEMANN_CLOSED_MIN_N;
+
+		for (SumType type = DIREITA; type <= MEIO; ++type) {
+			ref[1] = exact_sum(coeffs, degree, n, type);
+
+			for (size_t p = 0; p < b->precisions.count; ++p) {
+				RiemannPrecision prec = b->precisions.values[p];
+				for (size_t t = 0; t < b->threads.count; ++t) {
+					unsigned threads = b->threads.values[t];
+					for (size_t l = 0; l < b->simds.count;
+					     ++l) {
+						simd_set_level(
+							b->simds.values[l]);
+						Result r = measure(
+							b, f, nullptr, degree,
+							ref, n, type, threads,
+							prec, false);
+						print_result(b, &r);
+					}
+				}
+			}
+
+			if (closed) {
+				simd_set_level(b->top);
+				Result r = measure(b, f, nullptr, degree, ref,
+						   n, type, 1, RIEMANN_DOUBLE,
+						   true);
+				print_result(b, &r);
+			}
+		}
+	}
+
+	function_free(f);
+}
+
+/**
+ * @brief Mede todas as configurações de um grau na dimensão 2.
+ *
+ * @details A soma ponto a ponto é medida em precisão dupla, com cada número
+ * de threads e nível de vetorização, e a redução a somas de uma variável (o
+ * modo fechado), onde ela se aplica, com uma thread e o nível padrão.
+ *
+ * @param b Ponteiro para os parâmetros da varredura.
+ * @param degree O grau do polinômio em cada variável.
+ */
+static void run2d(Bench *b, size_t degree)
+{
+	// Coeficientes alternados, de magnitude decrescente com i + j.
+	size_t terms = degree + 1;
+	double *coeffs = malloc(terms * terms * sizeof(*coeffs));
+	if (coeffs == nullptr)
+		exit(EXIT_FAILURE);
+	for (size_t j = 0; j < terms; ++j)
+		for (size_t i = 0; i < terms; ++i)
+			coeffs[j * terms + i] =
+				((i + j) % 2 ? -1.0 : 1.0) / (i + j + 1);
+	Function2D *f = function2d_new(BIPOLYNOMIAL, degree, degree, coeffs);
+	if (f == nullptr)
+		exit(EXIT_FAILURE);
+
+	// A integral é a soma das integrais das linhas, vezes as de yʲ.
+	long double integral = 0, pj = upper, qj = lower;
+	for (size_t j = 0; j < terms; ++j, pj *= upper, qj *= lower)
+		integral += exact(coeffs + j * terms, degree, lower, upper) *
+			    (pj - qj) / (j + 1);
+	double ref[2] = { integral };
+
+	for (size_t k = 0; k < b->ns.count; ++k) {
+		size_t side = llround(sqrt(b->ns.values[k]));
+		size_t n = side * side;
+		if (side == 0)
+			continue;
+
+		for (SumType type = DIREITA; type <= MEIO; ++type) {
+			ref[1] = exact_sum2d(coeffs, degree, side, type);
+
+			for (size_t t = 0; t < b->threads.count; ++t) {
+				unsigned threads = b->threads.values[t];
+				for (size_t l = 0; l < b->simds.count; ++l) {
+					simd_set_level(b->simds.values[l]);
+					Result r = measure(b, nullptr, f,
+							   degree, ref, n,
+							   type, threads,
+							   RIEMANN_DOUBLE,
+							   false);
+					print_result(b, &r);
+				}
+			}
+
+			if (degree <= RIEMANN_CLOSED_MAX_DEGREE) {
+				simd_set_level(b->top);
+				Result r = measure(b, nullptr, f, degree, ref,
+						   n, type, 1, RIEMANN_DOUBLE,
+						   true);
+				print_result(b, &r);
+			}
+		}
+	}
+
+	function2d_free(f);
+	free(coeffs);
+}
+
+/**
+ * @brief Mede uma configuração.
+ *
+ * @param b Ponteiro para os parâmetros da varredura.
+ * @param func A função a integrar, ou `nullptr` na dimensão 2.
+ * @param func2d A função de duas variáveis a integrar, na dimensão 2, ou
+ * `nullptr`.
+ * @param degree O grau da função.
+ * @param ref A integral analítica da função, seguida da soma de Riemann
+ * calculada por `exact_sum()` ou `exact_sum2d()`.
+ * @param n Número de retângulos, que na dimensão 2 é um quadrado perfeito.
+ * @param type Tipo de soma.
+ * @param threads Número de threads.
+ * @param precision Precisão da soma.
+ * @param closed Se a fórmula fechada é permitida.
+ * @return O resultado da configuração.
+ */
+static Result measure(const Bench *b, Function *func, Function2D *func2d,
+		      size_t degree, const double ref[2], size_t n,
+		      SumType type, unsigned threads,
+		      RiemannPrecision precision, bool closed)
+{
+	RiemannOptions opts = {
+		.threads = threads,
+		.brute_force = !closed,
+		.precision = precision,
+	};
+	double times[BENCH_MAX_REPS];
+	unsigned reps = b->reps;
+	size_t side = llround(sqrt(n));
+	double res = 0;
+
+	for (unsigned i = 0; i < b->warmup + reps; ++i) {
+		double start = now();
+		if (func2d != nullptr)
+			res = riemann2d(lower, upper, lower, upper, func2d,
+					side, side, type, &opts);
+		else
+			res = riemann_opts(lower, upper, func, n, type, &opts);
+		if (i >= b->warmup)
+			times[i - b->warmup] = now() - start;
+	}
+	qsort(times, reps, sizeof(*times), cmp_double);
+
+	return (Result){
+		.degree = degree,
+		.n = n,
+		.dim = func2d != nullptr ? 2 : 1,
+		.type = type,
+		.threads = threads,
+		.simd = simd_level(),
+		.precision = precision,
+		.closed = closed,
+		.median = times[reps / 2],
+		.best = times[0],
+		.error = ref[0] != 0 ? fabs(res - ref[0]) / fabs(ref[0]) :
+				       fabs(res),
+		.sum_error = ref[1] != 0 ? fabs(res - ref[1]) / fabs(ref[1]) :
+					   fabs(res),
+	};
+}
+
+/**
+ * @brief Escreve um resultado em JSON e na tabela legível.
+ *
+ * @param b Ponteiro para os parâmetros da varredura.
+ * @param r O resultado.
+ */
+static void print_result(Bench *b, const Result *r)
+{
+	double ns = r->median * 1e9 / r->n;
+	double rate = r->n / r->median;
+	bool buffered = !r->closed && r->precision == RIEMANN_DOUBLE &&
+			r->dim == 1;
+	double bytes = buffered ? r->n * 2.0 * sizeof(double) : 0;
+	double gbs = bytes / r->median * 1e-9;
+	const char *soma = sum_names[r->type];
+	const char *modo = r->closed ? "fechado" : "bruto";
+	const char *simd = simd_level_name(r->simd);
+	const char *prec = precision_names[r->precision];
+
+	fprintf(b->out,
+		"%s\n{\"grau\":%zu,\"n\":%zu,\"soma\":\"%s\",\"threads\":%u,"
+		"\"simd\":\"%s\",\"modo\":\"%s\",\"tempo_mediano\":%.9g,"
+		"\"tempo_minimo\":%.9g,\"ns_por_avaliacao\":%.6g,"
+		"\"avaliacoes_por_s\":%.6g,\"gb_por_s\":%.6g,"
+		"\"erro_relativo\":%.3g,\"erro_soma\":%.3g,"
+		"\"precisao\":\"%s\",\"dim\":%u}",
+		b->first ? "" : ",", r->degree, r->n, soma, r->threads, simd, modo,
+		r->median, r->best, ns, rate, gbs, r->error, r->sum_error,
+		prec, r->dim);
+	fprintf(stderr,
+		"%5zu %3u %11zu %8s %7u %7s %6s %7s %10.3f %12.4g %8.2f "
+		"%10.2e %10.2e\n",
+		r->degree, r->dim, r->n, soma, r->threads, simd, prec, modo,
+		ns, rate, gbs, r->error, r->sum_error);
+	b->first = false;
+}
+
+/**
+ * @brief Compara duas saídas do benchmark.
+ *
+ * @details Cada configuração da saída atual é procurada na de base. O tempo
+ * comparado é o mínimo de cada configuração, que é menos sensível a
+ * interferências que a mediana. Se o tempo por avaliação for maior que o da base multiplicado por
+ * \f$1 + \text{threshold}\f$, é uma regressão, e se for menor que o da base
+ * dividido pelo mesmo fator, uma melhora.
+ *
+ * @param base Caminho da saída de base.
+ * @param cur Caminho da saída atual.
+ * @param threshold O limiar de ruído, como fração (0.05 para 5%).
+ * @return EXIT_SUCCESS se não houver regressões.
+ */
+static int compare(const char *base, const char *cur, double threshold)
+{
+	Entry *b = nullptr, *c = nullptr;
+	size_t nb = load(base, &b), nc = load(cur, &c);
+	size_t regressions = 0, improvements = 0, missing = 0;
+
+	for (size_t i = 0; i < nc; ++i) {
+		size_t j = 0;
+		while (j < nb && strcmp(b[j].key, c[i].key) != 0)
+			++j;
+		if (j == nb) {
+			++missing;
+			continue;
+		}
+
+		double ratio = c[i].ns / b[j].ns;
+		const char *tag = nullptr;
+		if (ratio > 1 + threshold) {
+			tag = "REGRESSÃO";
+			++regressions;
+		} else if (ratio < 1 / (1 + threshold)) {
+			tag = "melhora";
+			++improvements;
+		}
+		if (tag != nullptr)
+			printf("%-10s %+7.1f%%  %s  (%.4g -> %.4g ns/aval)\n",
+			       tag, (ratio - 1) * 100, c[i].key, b[j].ns,
+			       c[i].ns);
+	}
+
+	printf("%zu configurações, %zu regressões, %zu melhoras, "
+	       "%zu sem base (limiar de %.1f%%)\n",
+	       nc, regressions, improvements, missing, threshold * 100);
+	free(b);
+	free(c);
+	return nc > 0 && regressions == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * @brief Lê as configurações e os tempos de uma saída do benchmark.
+ *
+ * @details Depende do formato escrito por `print_result()`: um resultado por
+ * linha, com os campos sempre na mesma ordem. As saídas da versão 1 não têm
+ * o campo `"precisao"`, e seus resultados são todos em precisão dupla; as
+ * anteriores à versão 3 não têm o campo `"dim"`, e são todas na dimensão 1.
+ *
+ * @param path Caminho da saída.
+ * @param entries Ponteiro onde o arranjo alocado será escrito.
+ * @return O número de configurações lidas.
+ */
+static size_t load(const char *path, Entry **entries)
+{
+	FILE *in = fopen(path, "r");
+	size_t count = 0, cap = 0;
+	char line[1024];
+
+	*entries = nullptr;
+	if (in == nullptr) {
+		perror(path);
+		return 0;
+	}
+
+	while (fgets(line, sizeof(line), in) != nullptr) {
+		size_t degree, n;
+		unsigned threads, dim = 1;
+		char soma[16], simd[16], modo[16], prec[16] = "double";
+		double best;
+
+		const char *p = strchr(line, '{');
+		if (p == nullptr ||
+		    sscanf(p,
+			   "{\"grau\":%zu,\"n\":%zu,\"soma\":\"%15[^\"]\","
+			   "\"threads\":%u,\"simd\":\"%15[^\"]\","
+			   "\"modo\":\"%15[^\"]\",\"tempo_mediano\":%*g,"
+			   "\"tempo_minimo\":%lg",
+			   &degree, &n, soma, &threads, simd, modo, &best) != 7)
+			continue;
+		const char *q = strstr(p, "\"precisao\":\"");
+		if (q != nullptr)
+			sscanf(q, "\"precisao\":\"%15[^\"]", prec);
+		q = strstr(p, "\"dim\":");
+		if (q != nullptr)
+			sscanf(q, "\"dim\":%u", &dim);
+
+		if (count == cap) {
+			cap = cap ? 2 * cap : 64;
+			Entry *e = realloc(*entries, cap * sizeof(*e));
+			if (e == nullptr)
+				break;
+			*entries = e;
+		}
+		Entry *e = &(*entries)[count++];
+		snprintf(e->key, sizeof(e->key),
+			 "grau=%zu n=%zu %s threads=%u %s %s %s%s", degree, n,
+			 soma, threads, simd, prec, modo,
+			 dim == 2 ? " 2d" : "");
+		e->ns = best * 1e9 / n;
+	}
+
+	fclose(in);
+	return count;
+}
+
+/**
+ * @brief Compara dois `double` para `qsort()`.
+ */
+static int cmp_double(const void *a, const void *b)
+{
+	double x = *(const double *)a, y = *(const double *)b;
+	return (x > y) - (x < y);
+}
\ No newline at end of file
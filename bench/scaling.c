@@ -0,0 +1,96 @@
+// SPDX-License-Identifier: ISC
+
+/**
+ * @file scaling.c
+ * @brief Mede a escalabilidade das somas de Riemann com o número de threads.
+ *
+ * @details Este programa integra um polinômio de grau fixo com um número
+ * grande de retângulos, variando o número de threads em potências de 2 até o
+ * número de processadores disponíveis. Para cada configuração, exibe o tempo
+ * decorrido, a aceleração em relação a uma thread, e a eficiência paralela.
+ * Também verifica que o resultado é idêntico bit a bit para todos os números
+ * de threads, e termina com erro caso contrário.
+ *
+ * Uso: `scaling [n] [grau] [threads]`, com padrões \f$n = 10^8\f$, grau 8, e
+ * número máximo de threads igual ao de processadores.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "func.h"
+#include "pool.h"
+#include "riemann.h"
+
+/**
+ * @brief Retorna o tempo monotônico atual, em segundos.
+ */
+static double now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/**
+ * @brief Função principal do benchmark.
+ *
+ * @param argc Número de argumentos.
+ * @param argv Argumentos: número de retângulos, grau do polinômio, e número
+ * máximo de threads.
+ * @return EXIT_SUCCESS se todos os resultados coincidirem, EXIT_FAILURE caso
+ * contrário.
+ */
+int main(int argc, char *argv[])
+{
+	size_t n = argc > 1 ? strtoull(argv[1], nullptr, 10) : 100000000;
+	size_t degree = argc > 2 ? strtoull(argv[2], nullptr, 10) : 8;
+	unsigned cpus = argc > 3 ? strtoul(argv[3], nullptr, 10) :
+				   pool_cpu_count();
+	int status = EXIT_SUCCESS;
+
+	if (cpus == 0)
+		cpus = 1;
+
+	// Coeficientes alternados, de magnitude decrescente.
+	double *coeffs = malloc((degree + 1) * sizeof(*coeffs));
+	if (coeffs == nullptr)
+		return EXIT_FAILURE;
+	for (size_t i = 0; i <= degree; ++i)
+		coeffs[i] = (i % 2 ? -1.0 : 1.0) / (i + 1);
+	Function *f = function_new(POLYNOMIAL, degree, coeffs);
+	free(coeffs);
+	if (f == nullptr)
+		return EXIT_FAILURE;
+
+	printf("n = %zu, grau = %zu, threads = %u\n", n, degree, cpus);
+	printf("%8s %12s %10s %10s %24s\n", "threads", "tempo (s)",
+	       "aceleração", "eficiência", "resultado");
+
+	double base_time = 0, base_res = 0;
+	for (unsigned t = 1;; t = t * 2 < cpus ? t * 2 : cpus) {
+		RiemannOptions opts = { .threads = t };
+		double start = now();
+		double res = riemann_opts(-1, 1, f, n, ESQUERDA, &opts);
+		double elapsed = now() - start;
+
+		if (t == 1) {
+			base_time = elapsed;
+			base_res = res;
+		}
+
+		printf("%8u %12.4f %10.2f %10.2f %24.17g%s\n", t, elapsed,
+		       base_time / elapsed, base_time / elapsed / t, res,
+		       memcmp(&res, &base_res, sizeof(res)) ? " (DIFERE!)" : "");
+		if (memcmp(&res, &base_res, sizeof(res)) != 0)
+			status = EXIT_FAILURE;
+
+		if (t == cpus)
+			break;
+	}
+
+	function_free(f);
+	return status;
+}
\ No newline at end of file
@@ -0,0 +1,211 @@
+// SPDX-License-Identifier: ISC
+
+/**
+ * @file cache.h
+ * @brief Declarações do cache de resultados de somas de Riemann.
+ *
+ * @details O cache memoriza o resultado de cada soma calculada por
+ * `riemann_opts()` (ver `RiemannOptions::cache`), indexado pela chave
+ * canônica (`CacheKey`): um resumo de 128 bits do conteúdo da função (ver
+ * `function_digest()`), os padrões de bits exatos dos limites, o número de
+ * retângulos, o tipo de soma e as opções que alteram o resultado. Como o
+ * resumo não depende da representação, um mesmo polinômio com ou sem
+ * coeficientes nulos à direita, denso ou esparso, tem a mesma chave.
+ *
+ * O cache é uma tabela limitada, dividida em `CACHE_SHARDS` partes
+ * independentes, cada uma com a sua trava, escolhidas pelo hash da chave.
+ * Quando uma parte se enche, a entrada a substituir é escolhida pelo
+ * algoritmo CLOCK: um ponteiro percorre as entradas em círculo, dando uma
+ * segunda chance às que foram consultadas desde a última passagem.
+ *
+ * O conteúdo pode ser gravado num arquivo com `cache_save()` e recarregado
+ * em outra execução com `cache_load()`. O arquivo tem um cabeçalho
+ * (`CacheFileHeader`) de 64 bytes seguido dos registros (`CacheRecord`), na
+ * ordem de bytes da máquina.
+ */
+
+#pragma once
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "func.h"
+#include "riemann.h"
+
+/**
+ * @brief Número de partes independentes do cache (potência de dois).
+ */
+#define CACHE_SHARDS 16
+
+/**
+ * @brief Capacidade padrão do cache, em resultados.
+ */
+#define CACHE_CAPACITY ((size_t)1 << 16)
+
+/**
+ * @brief Versão do formato do arquivo do cache.
+ */
+#define CACHE_VERSION 1
+
+/**
+ * @brief Valor gravado no cabeçalho para verificar a ordem de bytes.
+ */
+#define CACHE_BYTE_ORDER 0x01020304
+
+/**
+ * @brief Opção de `CacheKey::flags`: a soma foi feita ponto a ponto
+ * (`RiemannOptions::brute_force`), o que pode mudar o arredondamento.
+ */
+#define CACHE_BRUTE_FORCE 1u
+
+/**
+ * @brief Posição, em `CacheKey::flags`, da precisão da soma
+ * (`RiemannOptions::precision`).
+ */
+#define CACHE_PRECISION_SHIFT 8
+
+/**
+ * @brief Chave canônica de uma soma de Riemann.
+ *
+ * @details Não tem bytes de preenchimento, de modo que duas chaves são iguais
+ * se e somente se os seus bytes forem iguais.
+ */
+typedef struct {
+	uint64_t digest[2]; /**< Resumo do conteúdo da função. */
+	uint64_t min; /**< Padrão de bits do limite inferior. */
+	uint64_t max; /**< Padrão de bits do limite superior. */
+	uint64_t n; /**< Número de retângulos. */
+	uint32_t type; /**< Tipo de soma de Riemann (`SumType`). */
+	uint32_t flags; /**< Opções que alteram o resultado. */
+} CacheKey;
+
+/**
+ * @brief Um resultado memorizado, como gravado no arquivo.
+ */
+typedef struct {
+	CacheKey key; /**< A chave. */
+	double value; /**< O resultado da soma. */
+} CacheRecord;
+
+/**
+ * @brief Cabeçalho de um arquivo do cache.
+ */
+typedef struct {
+	char magic[8]; /**< Identificação do formato: `"RIEMCACH"`. */
+	uint32_t version; /**< Versão do formato (`CACHE_VERSION`). */
+	uint32_t byte_order; /**< `CACHE_BYTE_ORDER`. */
+	uint32_t header_size; /**< Tamanho deste cabeçalho, em bytes. */
+	uint32_t record_size; /**< Tamanho de cada `CacheRecord`, em bytes. */
+	uint64_t count; /**< Número de registros. */
+	uint64_t reserved[4]; /**< Reservado; deve ser zero. */
+} CacheFileHeader;
+
+/**
+ * @brief Contadores de um cache.
+ */
+typedef struct {
+	uint64_t hits; /**< Consultas que encontraram o resultado. */
+	uint64_t misses; /**< Consultas que não o encontraram. */
+	uint64_t insertions; /**< Resultados inseridos. */
+	uint64_t evictions; /**< Resultados descartados para dar lugar a
+			     * outros. */
+	size_t size; /**< Número de resultados no cache. */
+	size_t capacity; /**< Número máximo de resultados. */
+} CacheStats;
+
+/**
+ * @brief Cache de resultados. Sua definição é opaca.
+ */
+typedef struct ResultCache ResultCache;
+
+/**
+ * @brief Cria um cache de resultados vazio.
+ *
+ * @param capacity Número máximo de resultados (0 para `CACHE_CAPACITY`),
+ * dividido igualmente entre as partes.
+ * @return Ponteiro para o novo cache, ou `nullptr` em caso de erro.
+ * @note Ignorar o retorno pode causar vazamento de memória.
+ */
+[[nodiscard("Ignorar retorno pode causar vazamento de memória")]]
+ResultCache *cache_new(size_t capacity);
+
+/**
+ * @brief Libera um cache de resultados.
+ *
+ * @param cache Ponteiro para o cache.
+ */
+void cache_free(ResultCache *cache);
+
+/**
+ * @brief Monta a chave canônica de uma soma de Riemann.
+ *
+ * @param key Ponteiro onde a chave será escrita.
+ * @param func Ponteiro para a função.
+ * @param min O limite inferior do intervalo.
+ * @param max O limite superior do intervalo.
+ * @param n O número de retângulos.
+ * @param type O tipo de soma de Riemann.
+ * @param opts Opções do cálculo; somente as que alteram o resultado entram na
+ * chave.
+ * @return `true` em caso de sucesso, `false` se o conteúdo da função não
+ * puder ser resumido (e a soma não puder ser memorizada).
+ */
+bool cache_key(CacheKey *key, const Function *func, double min, double max,
+	       size_t n, SumType type, const RiemannOptions *opts);
+
+/**
+ * @brief Procura um resultado no cache.
+ *
+ * @param cache Ponteiro para o cache.
+ * @param key Ponteiro para a chave.
+ * @param value Ponteiro onde o resultado será escrito, se encontrado.
+ * @return `true` se o resultado foi encontrado, `false` caso contrário.
+ */
+bool cache_lookup(ResultCache *cache, const CacheKey *key, double *value);
+
+/**
+ * @brief Insere ou atualiza um resultado no cache.
+ *
+ * @details Se a parte da chave estiver cheia, descarta o resultado escolhido
+ * pelo algoritmo CLOCK.
+ *
+ * @param cache Ponteiro para o cache.
+ * @param key Ponteiro para a chave.
+ * @param value O resultado.
+ */
+void cache_insert(ResultCache *cache, const CacheKey *key, double value);
+
+/**
+ * @brief Lê os contadores de um cache.
+ *
+ * @param cache Ponteiro para o cache.
+ * @param stats Ponteiro onde os contadores serão escritos.
+ */
+void cache_stats(ResultCache *cache, CacheStats *stats);
+
+/**
+ * @brief Grava o conteúdo de um cache num arquivo.
+ *
+ * @details O arquivo é escrito com outro nome e renomeado ao final, de modo
+ * que uma gravação interrompida não corrompe um arquivo anterior.
+ *
+ * @param cache Ponteiro para o cache.
+ * @param path O caminho do arquivo a criar ou substituir.
+ * @return `true` em caso de sucesso, `false` em caso de erro de E/S.
+ */
+bool cache_save(ResultCache *cache, const char *path);
+
+/**
+ * @brief Insere num cache os resultados gravados num arquivo.
+ *
+ * @param cache Ponteiro para o cache.
+ * @param path O caminho do arquivo.
+ * @return O número de resultados lidos, ou -1 se o arquivo não pôde ser
+ * lido ou não estiver no formato esperado (com `errno` igual a `ENOENT` se
+ * ele não existir).
+ */
+long cache_load(ResultCache *cache, const char *path);
+
+#endif // !CACHE_H
\ No newline at end of file
@@ -0,0 +1,54 @@
+// SPDX-License-Identifier: ISC
+
+/**
+ * @file elementary.h
+ * @brief Declarações das funções elementares: exponenciais, logaritmos,
+ * senoides, funções racionais e somas de funções.
+ *
+ * @details Estes tipos cobrem os integrandos mais comuns além dos polinômios.
+ * A avaliação num ponto usa a biblioteca padrão; a avaliação em lote usa os
+ * núcleos vetorizados de `simd.h` (`simd_exp()`, `simd_log()`, `simd_sin()` e
+ * `simd_poly_horner()`), cujos erros estão documentados lá. Cada função
+ * ocupa um único bloco, com o objeto `Function` no início, como as de
+ * `plugin.h`, e é criada por `function_new()` e liberada por
+ * `function_free()`.
+ */
+
+#pragma once
+#ifndef ELEMENTARY_H
+#define ELEMENTARY_H
+
+#include <stdarg.h>
+
+#include "func.h"
+
+/**
+ * @brief Número de pontos avaliados de uma vez pelos lotes de `RATIONAL` e
+ * `SUM`, que precisam de um arranjo auxiliar na pilha.
+ */
+#define ELEMENTARY_BLOCK 256
+
+/**
+ * @brief Instancia uma função elementar.
+ *
+ * @details Normalmente, é chamada por `function_new()`, que documenta os
+ * parâmetros de cada tipo.
+ *
+ * @param type O tipo da função: `EXPONENTIAL`, `LOGARITHM`, `SINUSOID`,
+ * `RATIONAL` ou `SUM`.
+ * @param args Os parâmetros variáveis, conforme `function_new()`.
+ * @return Ponteiro para a nova função, ou `nullptr` em caso de erro.
+ * @note Ignorar o retorno pode causar vazamento de memória.
+ */
+[[nodiscard("Ignorar retorno pode causar vazamento de memória")]]
+Function *elementary_new(FunctionType type, va_list args);
+
+/**
+ * @brief Libera uma função elementar. Os termos de um `SUM` são liberados
+ * por `function_free()`.
+ *
+ * @param func Ponteiro para a função, criada por `elementary_new()`.
+ */
+void elementary_free(Function *func);
+
+#endif // !ELEMENTARY_H
\ No newline at end of file
@@ -0,0 +1,96 @@
+// SPDX-License-Identifier: ISC
+
+/**
+ * @file expr.h
+ * @brief Declarações do compilador e da máquina virtual de expressões.
+ *
+ * @details Este arquivo declara o tipo `Expression`, que implementa funções
+ * dadas por uma expressão textual em \f$x\f$, como `"sin(x)*exp(-x^2)+3"`. A
+ * expressão é analisada uma única vez e compilada para um programa plano de
+ * instruções sobre registradores, com as subexpressões constantes já
+ * calculadas e as subexpressões comuns eliminadas. A máquina virtual executa
+ * cada instrução sobre um bloco inteiro de valores de \f$x\f$, de modo que o
+ * custo de interpretação é dividido entre todos os pontos do bloco.
+ *
+ * A gramática aceita números, a variável `x`, as constantes `pi` e `e`, os
+ * operadores binários `+`, `-`, `*`, `/` e `^` (potência, associativa à
+ * direita), o menos unário, parênteses, e as funções `sin`, `cos`, `tan`,
+ * `exp`, `log`, `sqrt` e `abs`.
+ */
+
+#pragma once
+#ifndef EXPR_H
+#define EXPR_H
+
+#include <stddef.h>
+
+/**
+ * @brief Número de pontos processados por cada instrução da máquina virtual.
+ */
+#define EXPR_BLOCK 128
+
+/**
+ * @brief Número máximo de registradores de uma expressão compilada.
+ * Expressões que precisem de mais são recusadas por `expression_new()`.
+ */
+#define EXPR_MAX_REGS 256
+
+/**
+ * @brief Expressão compilada. Sua definição é opaca.
+ */
+typedef struct Expression Expression;
+
+/**
+ * @brief Analisa e compila uma expressão em \f$x\f$.
+ *
+ * @param src A expressão, terminada em nulo.
+ * @return Ponteiro para a expressão compilada, ou `nullptr` se houver erro de
+ * sintaxe (que é exibido na saída de erro), de alocação, ou se a expressão
+ * precisar de mais de `EXPR_MAX_REGS` registradores.
+ * @note Ignorar o retorno pode causar vazamento de memória.
+ */
+[[nodiscard("Ignorar retorno pode causar vazamento de memória")]]
+Expression *expression_new(const char *src);
+
+/**
+ * @brief Libera uma expressão compilada.
+ *
+ * @param expr Ponteiro para a expressão a ser liberada.
+ */
+void expression_free(Expression *expr);
+
+/**
+ * @brief Avalia uma expressão compilada em um ponto.
+ *
+ * @details Executa as instruções sobre registradores escalares, sem alocar
+ * memória. O resultado é o mesmo de `expression_eval_batch()`.
+ *
+ * @param x O valor em que a expressão será avaliada.
+ * @param expr Ponteiro para a expressão.
+ * @return O valor da expressão avaliada em `x`.
+ */
+double expression_eval(double x, Expression *expr);
+
+/**
+ * @brief Avalia uma expressão compilada em vários pontos.
+ *
+ * @details Os pontos são processados em blocos de até `EXPR_BLOCK`, e cada
+ * instrução do programa é aplicada ao bloco inteiro antes da seguinte.
+ *
+ * @param x Arranjo com os pontos em que a expressão será avaliada.
+ * @param y Arranjo onde os resultados serão escritos.
+ * @param count Número de pontos a avaliar.
+ * @param expr Ponteiro para a expressão.
+ */
+void expression_eval_batch(const double *x, double *y, size_t count,
+			   Expression *expr);
+
+/**
+ * @brief Retorna a expressão original de uma expressão compilada.
+ *
+ * @param expr Ponteiro para a expressão.
+ * @return A string de origem, pertencente à expressão.
+ */
+const char *expression_source(const Expression *expr);
+
+#endif // !EXPR_H
\ No newline at end of file
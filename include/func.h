@@ -16,6 +16,54 @@
 #ifndef FUNC_H
 #define FUNC_H
 
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Tamanho padrão, em bytes, dos blocos de uma arena de funções.
+ */
+#define FUNCTION_ARENA_BLOCK ((size_t)1 << 16)
+
+/**
+ * @brief Menor grau para o qual um polinômio pode ser guardado na
+ * representação esparsa.
+ *
+ * @details Abaixo deste grau, a regra de Horner vetorizada sobre todos os
+ * coeficientes é mais rápida que as cadeias de potências da representação
+ * esparsa, mesmo com poucos termos.
+ */
+#define FUNCTION_SPARSE_MIN_DEGREE 64
+
+/**
+ * @brief Maior fração de coeficientes não nulos para a qual um polinômio é
+ * guardado na representação esparsa, como o inverso: com o valor 4, no
+ * máximo um quarto dos coeficientes pode ser não nulo.
+ */
+#define FUNCTION_SPARSE_MAX_FILL 4
+
+/**
+ * @brief Maior grau com um núcleo de avaliação especializado.
+ *
+ * @details Para cada grau de 0 até este, há uma versão de `Function::eval`
+ * com o grau fixo em tempo de compilação e o esquema de Estrin (ver
+ * `FUNCTION_ESTRIN_BLOCK`) totalmente desenrolado, escolhida na criação do
+ * polinômio. Ela faz as mesmas operações que a versão de grau alto.
+ */
+#define FUNCTION_FIXED_MAX_DEGREE 16
+
+/**
+ * @brief Número de coeficientes por bloco do esquema de Estrin, usado por
+ * `Function::eval` nos polinômios densos.
+ *
+ * @details Cada bloco \f$(c_{4k} + c_{4k+1} x) + (c_{4k+2} + c_{4k+3} x)
+ * x^2\f$ é independente dos demais, e os blocos são combinados pela regra
+ * de Horner em \f$x^4\f$. Assim, a cadeia de dependências tem uma
+ * multiplicação e uma soma a cada quatro coeficientes, e não uma soma por
+ * coeficiente. O resultado difere do da soma termo a termo em no máximo
+ * `SIMD_POLY_ERROR_BOUND`, como o dos núcleos vetorizados.
+ */
+#define FUNCTION_ESTRIN_BLOCK 4
+
 /**
  * @brief Tipo de ponteiro de função para avaliar uma função genérica.
  *
@@ -40,11 +88,54 @@
  */
 typedef double (*eval_ptr_t)(double x, void *impl);
 
+/**
+ * @brief Tipo de ponteiro de função para avaliar uma função genérica em lote.
+ *
+ * @details Este tipo define um ponteiro para uma função que avalia a função
+ * concreta em vários pontos de uma só vez. Ao contrário de `eval_ptr_t`, que
+ * exige uma chamada indireta por ponto, uma função deste tipo recebe um
+ * arranjo inteiro de abscissas e escreve os resultados em outro arranjo, o que
+ * permite ao compilador vetorizar o laço interno e amortiza o custo da chamada
+ * indireta sobre todos os pontos. A função apontada deve aceitar quatro
+ * parâmetros:
+ * - Um arranjo `x` de `count` valores do tipo `double`, com os pontos nos
+ *   quais a função deve ser avaliada.
+ * - Um arranjo `y` de no mínimo `count` posições, no qual o resultado da
+ *   avaliação em cada `x[i]` será escrito em `y[i]`.
+ * - O número `count` de pontos a avaliar.
+ * - Um ponteiro `void *` para o objeto que implementa a função concreta.
+ *
+ * Para cada `i`, o valor escrito em `y[i]` deve ser igual ao retornado por
+ * `eval(x[i], impl)`, a menos de erros de arredondamento dentro do limite
+ * documentado pelo tipo da função.
+ *
+ * @param x Arranjo com os pontos nos quais a função deve ser avaliada.
+ * @param y Arranjo onde os resultados serão escritos.
+ * @param count Número de pontos a avaliar.
+ * @param impl Ponteiro para o objeto que implementa a função concreta.
+ */
+typedef void (*batch_ptr_t)(const double *x, double *y, size_t count,
+			    void *impl);
+
 /**
  * @brief Tipos de funções que podemos avaliar.
  */
 typedef enum {
-	POLYNOMIAL /**< Função do tipo polinomial clássico de grau arbitrário. */
+	POLYNOMIAL, /**< Função do tipo polinomial clássico de grau arbitrário.
+		     * Os de grau alto e poucos termos são guardados numa
+		     * representação esparsa, escolhida automaticamente. */
+	EXPRESSION, /**< Função dada por uma expressão textual em \f$x\f$,
+		     * compilada para uma máquina virtual (ver `expr.h`). */
+	TABULATED, /**< Função dada por amostras num arquivo mapeado na
+		    * memória, interpoladas entre si (ver `tabulated.h`). */
+	PLUGIN, /**< Função compilada num objeto compartilhado, carregado em
+		 * tempo de execução (ver `plugin.h`). */
+	EXPONENTIAL, /**< Exponencial \f$a e^{b x}\f$ (ver `elementary.h`). */
+	LOGARITHM, /**< Logaritmo natural \f$a \log(b x)\f$. */
+	SINUSOID, /**< Senoide \f$a \sin(b x + c)\f$. */
+	RATIONAL, /**< Função racional \f$P(x) / Q(x)\f$, com \f$P\f$ e
+		   * \f$Q\f$ polinômios. */
+	SUM /**< Soma de outras funções. */
 } FunctionType;
 
 /**
@@ -63,12 +154,65 @@ typedef struct Function {
 			  * concreta encapsulada. Este ponteiro permite que a
 			  * função concreta seja chamada de maneira uniforme,
 			  * independentemente de sua implementação. */
+	batch_ptr_t eval_batch; /**< Ponteiro para a função que avalia a
+				 * função concreta em lote, ou `nullptr` se o
+				 * tipo não oferecer avaliação em lote. Neste
+				 * caso, deve-se recorrer a `eval`. */
 	void *impl; /**< Ponteiro para o objeto que implementa a função
 		     * concreta. Este ponteiro é um detalhe de implementação e
 		     * não deve ser acessado diretamente fora das funções que
 		     * manipulam a estrutura `Function`. */
 } Function;
 
+/**
+ * @brief Estrutura que define um polinômio clássico de grau arbitrário.
+ *
+ * @details A estrutura `Polynomial` é usada para representar um polinômio de
+ * grau arbitrário. Os coeficientes dos termos do polinômio são armazenados em
+ * ordem crescente de grau. Isso significa que o coeficiente do termo constante
+ * (grau 0) vem primeiro, seguido pelo coeficiente do termo de grau 1, e assim
+ * por diante.
+ *
+ * Por exemplo, para um polinômio \f$f(x) = 1 + 2x^2 + 3x^4\f$, o grau será 4,
+ * e o arranjo dos coeficientes será: \f$\{1, 0, 2, 0, 3\}\f$.
+ *
+ * A estrutura é pública apenas para que `FunctionView` possa contê-la; fora
+ * de `func.c`, deve-se usar `function_polynomial()`.
+ */
+typedef struct {
+	size_t degree; /**< O grau do polinômio, que é o maior expoente com um
+                        * coeficiente não zero. */
+	double *coefficients; /**< Um ponteiro para um array de coeficientes
+			       * dos termos do polinômio, armazenados em ordem
+			       * crescente de grau. O comprimento deste array é
+			       * \f$\text{degree} + 1\f$. */
+} Polynomial;
+
+/**
+ * @brief Função polinomial que referencia coeficientes externos.
+ *
+ * @details Uma visão é inicializada por `function_view_init()` num espaço
+ * fornecido por quem chama (na pilha, por exemplo), e aponta diretamente para
+ * os coeficientes dados, sem alocar nem copiar nada. Ela é útil quando os
+ * coeficientes já estão na memória, como num arquivo mapeado (ver
+ * `jobfile.h`). Os coeficientes devem permanecer válidos enquanto a visão for
+ * usada, e a visão não deve ser passada a `function_free()`.
+ */
+typedef struct {
+	Function func; /**< A função genérica. */
+	Polynomial poly; /**< O polinômio referenciado por `func.impl`. */
+} FunctionView;
+
+/**
+ * @brief Arena de funções. Sua definição é opaca.
+ *
+ * @details Uma arena aloca funções sequencialmente em blocos grandes, sem uma
+ * chamada a `malloc()` por função. As funções de uma arena não são liberadas
+ * individualmente: `function_arena_reset()` descarta todas de uma vez, em
+ * tempo constante, e reaproveita a memória para as próximas.
+ */
+typedef struct FunctionArena FunctionArena;
+
 // Métodos públicos das funções genéricas. O método `function_new()`, que gera
 // funções arbitrárias, recebe o atributo `[[nodiscard]]` para avisar ao
 // usuário que ignorar o seu resultado pode causar vazamento de memória.
@@ -77,9 +221,45 @@ typedef struct Function {
  * @brief Instancia uma função arbitrária a partir de um tipo e de n
  * parâmetros.
  *
+ * @details Os parâmetros variáveis dependem do tipo:
+ * - `POLYNOMIAL`: o grau (`size_t`) e o arranjo de coeficientes
+ *   (`double *`), em ordem crescente de grau. Se o grau for pelo menos
+ *   `FUNCTION_SPARSE_MIN_DEGREE` e no máximo
+ *   \f$1 / \text{FUNCTION\_SPARSE\_MAX\_FILL}\f$ dos coeficientes for não
+ *   nulo, o polinômio é guardado como uma lista de termos (expoente e
+ *   coeficiente), e avaliado por cadeias de potências entre os expoentes
+ *   consecutivos. A escolha não muda a interface da função. Na
+ *   representação densa, `Function::eval` é um núcleo especializado para o
+ *   grau (ver `FUNCTION_FIXED_MAX_DEGREE` e `FUNCTION_ESTRIN_BLOCK`).
+ * - `EXPRESSION`: a expressão em \f$x\f$ (`const char *`), como
+ *   `"sin(x)*exp(-x^2)+3"`.
+ * - `TABULATED`: o caminho do arquivo de amostras (`const char *`) e o método
+ *   de interpolação (`TabulatedInterp`). O arquivo fica mapeado até
+ *   `function_free()`, e o domínio das amostras é dado por
+ *   `function_domain()`.
+ * - `PLUGIN`: o caminho do objeto compartilhado (`const char *`) e os
+ *   parâmetros repassados ao plugin (`const char *`, ou `nullptr`). O objeto
+ *   fica carregado até `function_free()`.
+ * - `EXPONENTIAL` e `LOGARITHM`: a amplitude \f$a\f$ e o fator \f$b\f$
+ *   (`double`, e não inteiros). A avaliação em lote usa `simd_exp()` ou
+ *   `simd_log()`, e difere da pontual em no máximo `SIMD_EXP_MAX_ULP` ou
+ *   `SIMD_LOG_MAX_ULP` na função elementar, antes do produto por \f$a\f$.
+ * - `SINUSOID`: a amplitude \f$a\f$, a frequência \f$b\f$ e a fase
+ *   \f$c\f$ (`double`). O cosseno é a senoide de fase \f$\pi / 2\f$. A
+ *   avaliação em lote usa `simd_sin()` (ver `SIMD_SIN_MAX_ULP`).
+ * - `RATIONAL`: o grau do numerador (`size_t`), os seus coeficientes
+ *   (`const double *`), o grau do denominador (`size_t`) e os seus
+ *   coeficientes (`const double *`), em ordem crescente de grau, como em
+ *   `POLYNOMIAL`. Os coeficientes são copiados.
+ * - `SUM`: o número de termos (`size_t`, no mínimo 1) e o arranjo de termos
+ *   (`Function **`), criados por `function_new()`. O arranjo é copiado, e os
+ *   termos passam a pertencer à soma, que os libera em `function_free()`; em
+ *   caso de erro, continuam com quem chamou.
+ *
  * @param type O tipo da função.
  * @param ... Parâmetros variáveis dependendo do tipo da função.
- * @return Ponteiro para a nova função criada.
+ * @return Ponteiro para a nova função criada. A função, o polinômio e os
+ * coeficientes de um `POLYNOMIAL` ocupam uma única alocação.
  * @note Ignorar o retorno pode causar vazamento de memória.
  */
 [[nodiscard("Ignorar retorno pode causar vazamento de memória")]]
@@ -88,8 +268,119 @@ Function *function_new(FunctionType type, ...);
 /**
  * @brief Libera uma função arbitrária.
  *
- * @param func Ponteiro para a função a ser liberada.
+ * @param func Ponteiro para a função a ser liberada. Não pode ter sido criada
+ * numa arena nem ser uma visão.
  */
 void function_free(Function *func);
 
+/**
+ * @brief Cria uma arena de funções.
+ *
+ * @param block_size Tamanho de cada bloco, em bytes (0 para
+ * `FUNCTION_ARENA_BLOCK`). Funções maiores que um bloco recebem um bloco
+ * próprio.
+ * @return Ponteiro para a nova arena, ou `nullptr` em caso de erro.
+ * @note Ignorar o retorno pode causar vazamento de memória.
+ */
+[[nodiscard("Ignorar retorno pode causar vazamento de memória")]]
+FunctionArena *function_arena_new(size_t block_size);
+
+/**
+ * @brief Instancia uma função arbitrária dentro de uma arena.
+ *
+ * @details Recebe os mesmos parâmetros de `function_new()`. A função vive até
+ * a próxima chamada a `function_arena_reset()` ou `function_arena_free()` e
+ * não deve ser passada a `function_free()`. Somente o tipo `POLYNOMIAL` é
+ * suportado.
+ *
+ * @param arena Ponteiro para a arena.
+ * @param type O tipo da função.
+ * @param ... Parâmetros variáveis dependendo do tipo da função.
+ * @return Ponteiro para a nova função, ou `nullptr` em caso de erro.
+ */
+Function *function_new_in(FunctionArena *arena, FunctionType type, ...);
+
+/**
+ * @brief Descarta todas as funções de uma arena, mantendo a sua memória.
+ *
+ * @param arena Ponteiro para a arena.
+ */
+void function_arena_reset(FunctionArena *arena);
+
+/**
+ * @brief Libera uma arena e todas as suas funções.
+ *
+ * @param arena Ponteiro para a arena.
+ */
+void function_arena_free(FunctionArena *arena);
+
+/**
+ * @brief Acessa os coeficientes de uma função polinomial.
+ *
+ * @details Permite que algoritmos especializados em polinômios (como as
+ * fórmulas fechadas das somas de Riemann) trabalhem diretamente sobre os
+ * coeficientes, sem avaliar a função ponto a ponto.
+ *
+ * @param func Ponteiro para a função.
+ * @param degree Ponteiro onde o grau do polinômio será escrito.
+ * @return Ponteiro para os coeficientes, em ordem crescente de grau, ou
+ * `nullptr` se a função não for um polinômio ou se estiver na representação
+ * esparsa (que não tem o arranjo denso).
+ */
+const double *function_polynomial(const Function *func, size_t *degree);
+
+/**
+ * @brief Verifica se uma função é um dado polinômio, em qualquer
+ * representação.
+ *
+ * @param func Ponteiro para a função.
+ * @param degree O grau do polinômio.
+ * @param coeffs Arranjo com os `degree + 1` coeficientes, em ordem crescente
+ * de grau.
+ * @return `true` se `func` for um polinômio com o mesmo grau e coeficientes
+ * iguais, `false` caso contrário.
+ */
+bool function_polynomial_equal(const Function *func, size_t degree,
+			       const double *coeffs);
+
+/**
+ * @brief Obtém o domínio de uma função definida somente num intervalo.
+ *
+ * @param func Ponteiro para a função.
+ * @param min Ponteiro onde o limite inferior será escrito.
+ * @param max Ponteiro onde o limite superior será escrito.
+ * @return `true` se a função tiver um domínio limitado (como as do tipo
+ * `TABULATED`), `false` se estiver definida em toda a reta.
+ */
+bool function_domain(const Function *func, double *min, double *max);
+
+/**
+ * @brief Calcula um resumo de 128 bits do conteúdo de uma função.
+ *
+ * @details O resumo depende somente da função matemática, e não da sua
+ * representação: um polinômio é resumido pelos seus termos não nulos
+ * (expoente e padrão de bits do coeficiente), de modo que os coeficientes
+ * nulos à direita e a escolha entre as representações densa e esparsa não o
+ * alteram. Uma expressão é resumida pelo seu texto. É usado como parte da
+ * chave do cache de resultados (ver `cache.h`).
+ *
+ * @param func Ponteiro para a função.
+ * @param digest Arranjo onde o resumo será escrito.
+ * @return `true` em caso de sucesso, `false` se o tipo da função não puder
+ * ser resumido (como `TABULATED`, cujo arquivo pode mudar).
+ */
+bool function_digest(const Function *func, uint64_t digest[2]);
+
+/**
+ * @brief Inicializa uma visão polinomial sobre coeficientes externos.
+ *
+ * @param view Ponteiro para o espaço da visão.
+ * @param degree O grau do polinômio.
+ * @param coeffs Arranjo com os `degree + 1` coeficientes, em ordem crescente
+ * de grau. Não é copiado nem modificado.
+ * @return Ponteiro para a função da visão (`&view->func`).
+ */
+Function *function_view_init(FunctionView *view, size_t degree,
+			     const double *coeffs);
+
 #endif // !FUNC_H
\ No newline at end of file
@@ -0,0 +1,160 @@
+// SPDX-License-Identifier: ISC
+
+/**
+ * @file func2d.h
+ * @brief Declarações de tipos e funções para funções de duas variáveis.
+ *
+ * @details Este arquivo é o análogo de `func.h` para funções
+ * \f$f(x, y)\f$, integradas sobre retângulos por `riemann2d()`. Uma função de
+ * duas variáveis é encapsulada na estrutura `Function2D`, que, como
+ * `Function`, guarda o tipo, os ponteiros que a avaliam e o objeto que a
+ * implementa.
+ */
+
+#pragma once
+#ifndef FUNC2D_H
+#define FUNC2D_H
+
+#include <stddef.h>
+
+#include "func.h"
+
+/**
+ * @brief Tipo de ponteiro de função para avaliar uma função de duas
+ * variáveis num ponto.
+ *
+ * @param x A abscissa do ponto.
+ * @param y A ordenada do ponto.
+ * @param impl Ponteiro para o objeto que implementa a função concreta.
+ * @return O valor da função no ponto.
+ */
+typedef double (*eval2d_ptr_t)(double x, double y, void *impl);
+
+/**
+ * @brief Tipo de ponteiro de função para avaliar uma função de duas
+ * variáveis numa linha de pontos.
+ *
+ * @details Avalia a função nos pontos \f$(x_t, y)\f$, todos com a mesma
+ * ordenada, de uma só vez. É o análogo de `batch_ptr_t`: a parte da função
+ * que depende somente de \f$y\f$ é calculada uma vez por linha, e o laço
+ * sobre os pontos pode ser vetorizado. Para cada `t`, o valor escrito em
+ * `out[t]` deve ser igual ao retornado por `eval(x[t], y, impl)`, a menos de
+ * erros de arredondamento dentro do limite documentado pelo tipo da função.
+ *
+ * @param x Arranjo com as abscissas dos pontos.
+ * @param count Número de pontos.
+ * @param y A ordenada comum a todos os pontos.
+ * @param out Arranjo onde os resultados serão escritos.
+ * @param impl Ponteiro para o objeto que implementa a função concreta.
+ */
+typedef void (*row_ptr_t)(const double *x, size_t count, double y,
+			  double *out, void *impl);
+
+/**
+ * @brief Tipos de funções de duas variáveis que podemos avaliar.
+ */
+typedef enum {
+	BIPOLYNOMIAL, /**< Polinômio em \f$x\f$ e \f$y\f$, dado por uma matriz
+		       * de coeficientes (ver `Bipolynomial`). */
+	SEPARABLE /**< Produto \f$f(x) g(y)\f$ de duas funções de uma
+		   * variável. */
+} Function2DType;
+
+/**
+ * @brief Definição de uma função de duas variáveis genérica abstrata.
+ */
+typedef struct Function2D {
+	Function2DType type; /**< Tipo da função, dentre os listados no enum
+			      * `Function2DType`. */
+	eval2d_ptr_t eval; /**< Ponteiro para a função que avalia a função
+			    * concreta num ponto. */
+	row_ptr_t eval_row; /**< Ponteiro para a função que avalia a função
+			     * concreta numa linha de pontos. */
+	void *impl; /**< Ponteiro para o objeto que implementa a função
+		     * concreta. Este ponteiro é um detalhe de implementação e
+		     * não deve ser acessado diretamente fora das funções que
+		     * manipulam a estrutura `Function2D`. */
+} Function2D;
+
+/**
+ * @brief Estrutura que define um polinômio em duas variáveis.
+ *
+ * @details Representa
+ * \f[
+ * p(x, y) = \sum_{j=0}^{d_y} \sum_{i=0}^{d_x} c_{j,i} x^i y^j.
+ * \f]
+ * Os coeficientes formam uma matriz com uma linha por potência de \f$y\f$ e
+ * uma coluna por potência de \f$x\f$, guardada linha após linha: o
+ * coeficiente \f$c_{j,i}\f$ fica na posição \f$j (d_x + 1) + i\f$. Assim, a
+ * linha \f$j\f$ é o polinômio em \f$x\f$ que multiplica \f$y^j\f$, no mesmo
+ * formato de `Polynomial`.
+ *
+ * Um ponto é avaliado em duas etapas: primeiro, os coeficientes de cada
+ * potência de \f$x\f$ são reduzidos a \f$r_i = \sum_j c_{j,i} y^j\f$ pela
+ * regra de Horner em \f$y\f$; depois, \f$\sum_i r_i x^i\f$ é acumulado
+ * termo a termo, na ordem crescente de \f$i\f$, como em `Polynomial`. A
+ * avaliação em linha (`Function2D::eval_row`) reduz os coeficientes uma vez
+ * por linha e, como `polynomial_eval_batch()`, avalia o polinômio em \f$x\f$
+ * com o núcleo vetorizado de `simd.h`, se houver um.
+ */
+typedef struct {
+	size_t degree_x; /**< O grau em \f$x\f$, \f$d_x\f$. */
+	size_t degree_y; /**< O grau em \f$y\f$, \f$d_y\f$. */
+	double *coefficients; /**< A matriz de
+			       * \f$(d_y + 1) \times (d_x + 1)\f$
+			       * coeficientes, linha após linha. */
+} Bipolynomial;
+
+/**
+ * @brief Instancia uma função de duas variáveis a partir de um tipo e de n
+ * parâmetros.
+ *
+ * @details Os parâmetros variáveis dependem do tipo:
+ * - `BIPOLYNOMIAL`: o grau em \f$x\f$ (`size_t`), o grau em \f$y\f$
+ *   (`size_t`) e a matriz de coeficientes (`const double *`), no formato de
+ *   `Bipolynomial`, que é copiada.
+ * - `SEPARABLE`: as funções \f$f\f$ de \f$x\f$ e \f$g\f$ de \f$y\f$
+ *   (`Function *`). Elas não são copiadas, e devem permanecer válidas
+ *   enquanto a nova função for usada.
+ *
+ * @param type O tipo da função.
+ * @param ... Parâmetros variáveis dependendo do tipo da função.
+ * @return Ponteiro para a nova função, ou `nullptr` em caso de erro.
+ * @note Ignorar o retorno pode causar vazamento de memória.
+ */
+[[nodiscard("Ignorar retorno pode causar vazamento de memória")]]
+Function2D *function2d_new(Function2DType type, ...);
+
+/**
+ * @brief Libera uma função de duas variáveis.
+ *
+ * @details As funções de uma variável de um `SEPARABLE` não são liberadas.
+ *
+ * @param func Ponteiro para a função a ser liberada.
+ */
+void function2d_free(Function2D *func);
+
+/**
+ * @brief Acessa os coeficientes de um polinômio em duas variáveis.
+ *
+ * @param func Ponteiro para a função.
+ * @param degree_x Ponteiro onde o grau em \f$x\f$ será escrito.
+ * @param degree_y Ponteiro onde o grau em \f$y\f$ será escrito.
+ * @return Ponteiro para a matriz de coeficientes, no formato de
+ * `Bipolynomial`, ou `nullptr` se a função não for um `BIPOLYNOMIAL`.
+ */
+const double *function2d_bipolynomial(const Function2D *func,
+				      size_t *degree_x, size_t *degree_y);
+
+/**
+ * @brief Acessa os fatores de uma função separável.
+ *
+ * @param func Ponteiro para a função.
+ * @param fx Ponteiro onde a função de \f$x\f$ será escrita.
+ * @param fy Ponteiro onde a função de \f$y\f$ será escrita.
+ * @return `true` se a função for um `SEPARABLE`, `false` caso contrário.
+ */
+bool function2d_separable(const Function2D *func, Function **fx,
+			  Function **fy);
+
+#endif // !FUNC2D_H
\ No newline at end of file
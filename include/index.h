@@ -0,0 +1,155 @@
+// SPDX-License-Identifier: ISC
+
+/**
+ * @file index.h
+ * @brief Declarações do índice de somas prefixadas para consultas de
+ * subintervalos.
+ *
+ * @details Um índice guarda, para uma função numa grade fixa de \f$n\f$
+ * retângulos sobre \f$[min, max]\f$, as somas prefixadas
+ * \f$P_k = \sum_{i < k} f(x_i)\f$ dos valores da função nos \f$n + 1\f$ pontos
+ * \f$x_i = min + i \Delta x\f$. Com elas, a soma de Riemann pela esquerda ou
+ * pela direita sobre qualquer subintervalo \f$[a, b]\f$ alinhado à grade é uma
+ * diferença de duas somas prefixadas, em \f$O(1)\f$, em vez de uma nova soma
+ * em \f$O(n)\f$.
+ *
+ * Cada soma prefixada é guardada como um par (soma, compensação), acumulado
+ * com a soma compensada de Neumaier, e as diferenças são tomadas nas duas
+ * partes separadamente. Assim, o erro de uma consulta é da ordem do erro de
+ * arredondamento do próprio resultado, e não do das somas prefixadas, que
+ * podem ser muito maiores.
+ *
+ * O índice tem o mesmo formato na memória e em disco (um cabeçalho de 64
+ * bytes seguido das somas), de modo que pode ser gravado com `index_save()` e
+ * mapeado por outros processos com `index_open()`, que compartilham as
+ * mesmas páginas.
+ */
+
+#pragma once
+#ifndef INDEX_H
+#define INDEX_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "func.h"
+#include "riemann.h"
+
+/**
+ * @brief Versão do formato do índice.
+ */
+#define INDEX_VERSION 1
+
+/**
+ * @brief Valor gravado no cabeçalho para verificar a ordem de bytes.
+ */
+#define INDEX_BYTE_ORDER 0x01020304
+
+/**
+ * @brief Cabeçalho de um índice.
+ */
+typedef struct {
+	char magic[8]; /**< Identificação do formato: `"RIEMINDX"`. */
+	uint32_t version; /**< Versão do formato (`INDEX_VERSION`). */
+	uint32_t byte_order; /**< `INDEX_BYTE_ORDER`. */
+	uint32_t header_size; /**< Tamanho deste cabeçalho, em bytes. */
+	uint32_t entry_size; /**< Tamanho de cada `IndexPrefix`, em bytes. */
+	uint64_t n; /**< Número de retângulos da grade. */
+	double min; /**< Limite inferior do domínio. */
+	double max; /**< Limite superior do domínio. */
+	uint64_t reserved[2]; /**< Reservado; deve ser zero. */
+} IndexHeader;
+
+/**
+ * @brief Uma soma prefixada compensada, igual a `sum + comp`.
+ */
+typedef struct {
+	double sum; /**< A soma acumulada. */
+	double comp; /**< A compensação do erro de arredondamento de `sum`. */
+} IndexPrefix;
+
+/**
+ * @brief Índice de somas prefixadas. Sua definição é opaca.
+ */
+typedef struct RiemannIndex RiemannIndex;
+
+/**
+ * @brief Constrói o índice de uma função numa grade.
+ *
+ * @details Os pontos da grade são divididos em blocos de `RIEMANN_BLOCK`
+ * pontos, distribuídos pelo conjunto global de threads (ver `pool.h`). Cada
+ * bloco calcula as suas somas prefixadas locais; em seguida, os totais dos
+ * blocos são acumulados em ordem, e cada bloco soma o total dos anteriores às
+ * suas entradas. Como os blocos não dependem do número de threads, o índice é
+ * idêntico bit a bit para qualquer valor de `threads`.
+ *
+ * @param min O limite inferior do domínio.
+ * @param max O limite superior do domínio.
+ * @param func Ponteiro para a função.
+ * @param n O número de retângulos da grade (positivo).
+ * @param threads Número de threads (0 para uma por processador).
+ * @return Ponteiro para o novo índice, ou `nullptr` em caso de erro.
+ * @note Ignorar o retorno pode causar vazamento de memória.
+ */
+[[nodiscard("Ignorar retorno pode causar vazamento de memória")]]
+RiemannIndex *index_new(double min, double max, Function *func, size_t n,
+			unsigned threads);
+
+/**
+ * @brief Mapeia um índice gravado com `index_save()`, somente para leitura.
+ *
+ * @param path O caminho do arquivo.
+ * @return Ponteiro para o índice, ou `nullptr` se o arquivo não pôde ser
+ * mapeado ou não estiver no formato esperado.
+ * @note Ignorar o retorno pode causar vazamento de memória.
+ */
+[[nodiscard("Ignorar retorno pode causar vazamento de memória")]]
+RiemannIndex *index_open(const char *path);
+
+/**
+ * @brief Grava um índice num arquivo.
+ *
+ * @param idx Ponteiro para o índice.
+ * @param path O caminho do arquivo a criar ou substituir.
+ * @return `true` em caso de sucesso, `false` em caso de erro de E/S.
+ */
+bool index_save(const RiemannIndex *idx, const char *path);
+
+/**
+ * @brief Libera um índice, ou desfaz o seu mapeamento.
+ *
+ * @param idx Ponteiro para o índice.
+ */
+void index_free(RiemannIndex *idx);
+
+/**
+ * @brief Retorna o cabeçalho de um índice, com a sua grade.
+ *
+ * @param idx Ponteiro para o índice.
+ * @return Ponteiro para o cabeçalho.
+ */
+const IndexHeader *index_header(const RiemannIndex *idx);
+
+/**
+ * @brief Calcula a soma de Riemann de um subintervalo a partir do índice.
+ *
+ * @details Se \f$a\f$ e \f$b\f$ forem pontos da grade, o resultado é a soma de
+ * Riemann do tipo pedido com os retângulos da grade entre eles, e coincide com
+ * `riemann()` sobre o domínio inteiro a menos de erros de arredondamento. Caso
+ * contrário, as somas prefixadas são interpoladas linearmente dentro do
+ * retângulo que contém cada extremo, o que equivale a integrar exatamente a
+ * função em degraus da soma de Riemann. Extremos a menos de alguns ULPs de um
+ * ponto da grade são considerados alinhados. Se \f$a > b\f$, o resultado tem o
+ * sinal trocado.
+ *
+ * @param idx Ponteiro para o índice.
+ * @param a O limite inferior do subintervalo.
+ * @param b O limite superior do subintervalo.
+ * @param type O tipo de soma de Riemann (esquerda ou direita).
+ * @return A soma de Riemann no subintervalo, ou `NAN` se algum dos extremos
+ * estiver fora do domínio do índice ou se `type` for `MEIO`, cujos pontos não
+ * estão na grade do índice.
+ */
+double index_query(const RiemannIndex *idx, double a, double b, SumType type);
+
+#endif // !INDEX_H
\ No newline at end of file
@@ -0,0 +1,160 @@
+// SPDX-License-Identifier: ISC
+
+/**
+ * @file instr.h
+ * @brief Declarações da instrumentação opcional dos integradores.
+ *
+ * @details Este arquivo declara uma camada de instrumentação que conta, para
+ * cada integrador (“local”), o número de chamadas, o número de avaliações da
+ * função, o tempo decorrido, e os ciclos e instruções do processador. Os
+ * ciclos e as instruções vêm de contadores de hardware abertos com
+ * `perf_event_open()`; se eles não estiverem disponíveis, os ciclos vêm do
+ * contador de tempo do processador (`rdtsc`), e as instruções ficam zeradas.
+ * Os ciclos e as instruções são os da thread que chamou o integrador; o
+ * trabalho das threads auxiliares aparece somente no tempo decorrido.
+ *
+ * Os contadores são locais a cada thread, e somados somente quando pedidos
+ * (`instr_snapshot()`). A instrumentação é ativada pela variável de ambiente
+ * `RIEMANN_INSTR`:
+ *
+ * - `1` ou `summary`: exibe um resumo na saída de erro ao final do programa;
+ * - `periodic:S`: exibe também um resumo a cada `S` segundos.
+ *
+ * Desativada, cada ponto de instrumentação custa um único desvio, sempre no
+ * mesmo sentido. Definindo `RIEMANN_NO_INSTR` na compilação, os pontos de
+ * instrumentação são removidos por completo.
+ */
+
+#pragma once
+#ifndef INSTR_H
+#define INSTR_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+/**
+ * @brief Locais instrumentados.
+ */
+typedef enum {
+	INSTR_RIEMANN, /**< `riemann()` e `riemann_opts()`. */
+	INSTR_SWEEP, /**< `riemann_sweep()`. */
+	INSTR_QUAD, /**< `quad_gk()`. */
+	INSTR_RIEMANN2D, /**< `riemann2d()`. */
+	INSTR_SITES /**< Número de locais. */
+} InstrSite;
+
+/**
+ * @brief Contadores de um local.
+ */
+typedef struct {
+	uint64_t calls; /**< Número de chamadas. */
+	uint64_t evals; /**< Número de avaliações da função. */
+	uint64_t nanoseconds; /**< Tempo decorrido, em nanossegundos. */
+	uint64_t cycles; /**< Ciclos do processador. */
+	uint64_t instructions; /**< Instruções executadas (0 se indisponível). */
+} InstrCounters;
+
+/**
+ * @brief Leituras no início de uma chamada instrumentada.
+ */
+typedef struct {
+	InstrSite site; /**< O local. */
+	uint64_t evals; /**< Avaliações da thread no local, no início. */
+	uint64_t nanoseconds; /**< Tempo no início. */
+	uint64_t cycles; /**< Ciclos no início. */
+	uint64_t instructions; /**< Instruções no início. */
+} InstrScope;
+
+/**
+ * @brief Indica se a instrumentação está ativa. Definida na inicialização do
+ * programa, a partir de `RIEMANN_INSTR`.
+ */
+extern bool instr_enabled;
+
+#ifdef RIEMANN_NO_INSTR
+#define INSTR_BEGIN(scope, site) ((void)0)
+#define INSTR_END(scope) ((void)0)
+#define INSTR_EVALS(site, count) ((void)0)
+#else
+/**
+ * @brief Inicia uma chamada instrumentada, declarando a variável `scope`.
+ */
+#define INSTR_BEGIN(scope, site)                                   \
+	InstrScope scope = instr_enabled ? instr_begin((site)) : \
+					   (InstrScope){ 0 }
+
+/**
+ * @brief Termina a chamada instrumentada iniciada por `INSTR_BEGIN`.
+ */
+#define INSTR_END(scope)                        \
+	do {                                    \
+		if (instr_enabled)              \
+			instr_end(&(scope));    \
+	} while (0)
+
+/**
+ * @brief Contabiliza avaliações da função num local.
+ */
+#define INSTR_EVALS(site, count)                        \
+	do {                                            \
+		if (instr_enabled)                      \
+			instr_evals((site), (count));   \
+	} while (0)
+#endif
+
+/**
+ * @brief Inicia uma chamada instrumentada. Use `INSTR_BEGIN`.
+ *
+ * @param site O local.
+ * @return As leituras iniciais.
+ */
+InstrScope instr_begin(InstrSite site);
+
+/**
+ * @brief Termina uma chamada instrumentada. Use `INSTR_END`.
+ *
+ * @param scope As leituras iniciais.
+ */
+void instr_end(const InstrScope *scope);
+
+/**
+ * @brief Contabiliza avaliações da função. Use `INSTR_EVALS`.
+ *
+ * @param site O local.
+ * @param count Número de avaliações.
+ */
+void instr_evals(InstrSite site, uint64_t count);
+
+/**
+ * @brief Retorna os contadores da última chamada terminada num local pela
+ * thread atual.
+ *
+ * @param site O local.
+ * @return Os contadores da chamada, com `calls` igual a 1, ou zerados se a
+ * thread não tiver terminado nenhuma chamada no local.
+ */
+InstrCounters instr_last(InstrSite site);
+
+/**
+ * @brief Soma os contadores de todas as threads.
+ *
+ * @param out Arranjo de `INSTR_SITES` elementos onde as somas serão escritas.
+ */
+void instr_snapshot(InstrCounters out[INSTR_SITES]);
+
+/**
+ * @brief Exibe um resumo dos contadores de todas as threads.
+ *
+ * @param out O arquivo de saída.
+ */
+void instr_dump(FILE *out);
+
+/**
+ * @brief Retorna o nome legível de um local.
+ *
+ * @param site O local.
+ * @return Uma string estática, como `"riemann"`.
+ */
+const char *instr_site_name(InstrSite site);
+
+#endif // !INSTR_H
\ No newline at end of file
@@ -0,0 +1,248 @@
+// SPDX-License-Identifier: ISC
+
+/**
+ * @file jobfile.h
+ * @brief Declarações do formato binário de trabalhos e resultados.
+ *
+ * @details Este arquivo declara um formato binário compacto para lotes de
+ * trabalhos de integração, alternativo ao formato textual de `jobs.h`. Um
+ * arquivo de trabalhos contém:
+ *
+ * - um cabeçalho (`JobFileHeader`) de 64 bytes;
+ * - um arranjo de registros de tamanho fixo (`JobRecord`), um por trabalho;
+ * - um conjunto de coeficientes (`double`), endereçados por índice a partir
+ *   de cada registro.
+ *
+ * O arquivo é mapeado na memória, e as funções dos trabalhos são visões
+ * (`FunctionView`) que apontam diretamente para os coeficientes mapeados, sem
+ * análise de texto, alocação ou cópia.
+ *
+ * Os resultados vão para um segundo arquivo mapeado, com um cabeçalho
+ * (`ResultFileHeader`) e um registro (`ResultRecord`) por trabalho, na mesma
+ * posição do trabalho correspondente. Cada registro tem um estado, escrito
+ * depois do valor; assim, uma execução interrompida pode ser retomada,
+ * calculando apenas os trabalhos ainda pendentes. O cabeçalho dos resultados
+ * guarda o hash do conteúdo do arquivo de trabalhos, e um arquivo de
+ * resultados de outros trabalhos é recusado, mesmo que as contagens sejam
+ * iguais.
+ *
+ * Os números são gravados na ordem de bytes da máquina, que é verificada na
+ * abertura. Os registros e os coeficientes começam em posições alinhadas a
+ * `JOBFILE_ALIGN` bytes.
+ */
+
+#pragma once
+#ifndef JOBFILE_H
+#define JOBFILE_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "func.h"
+#include "jobs.h"
+
+/**
+ * @brief Versão do formato binário.
+ */
+#define JOBFILE_VERSION 2
+
+/**
+ * @brief Valor gravado no cabeçalho para verificar a ordem de bytes.
+ */
+#define JOBFILE_BYTE_ORDER 0x01020304
+
+/**
+ * @brief Alinhamento, em bytes, das seções do arquivo.
+ */
+#define JOBFILE_ALIGN 64
+
+/**
+ * @brief Cabeçalho de um arquivo de trabalhos.
+ */
+typedef struct {
+	char magic[8]; /**< Identificação do formato: `"RIEMJOBS"`. */
+	uint32_t version; /**< Versão do formato (`JOBFILE_VERSION`). */
+	uint32_t byte_order; /**< `JOBFILE_BYTE_ORDER`. */
+	uint32_t header_size; /**< Tamanho deste cabeçalho, em bytes. */
+	uint32_t record_size; /**< Tamanho de cada `JobRecord`, em bytes. */
+	uint64_t count; /**< Número de trabalhos. */
+	uint64_t records; /**< Posição dos registros no arquivo, em bytes. */
+	uint64_t pool; /**< Posição dos coeficientes no arquivo, em bytes. */
+	uint64_t pool_count; /**< Número de coeficientes. */
+	uint64_t content; /**< Hash FNV-1a dos registros, seguidos dos
+			   * coeficientes, calculado por `jobfile_encode()`. */
+} JobFileHeader;
+
+/**
+ * @brief Registro de um trabalho no arquivo binário.
+ */
+typedef struct {
+	uint64_t id; /**< Identificador do trabalho. */
+	double min; /**< Limite inferior de integração. */
+	double max; /**< Limite superior de integração. */
+	uint64_t n; /**< Número de retângulos. */
+	uint64_t coeffs; /**< Índice do primeiro coeficiente no conjunto. */
+	uint32_t degree; /**< Grau do polinômio. */
+	uint32_t method; /**< Tipo de soma de Riemann (`SumType`). */
+} JobRecord;
+
+/**
+ * @brief Estados de um registro de resultado.
+ */
+typedef enum {
+	RESULT_PENDING, /**< O trabalho ainda não foi calculado. */
+	RESULT_DONE, /**< O valor está pronto. */
+	RESULT_INVALID /**< O registro do trabalho é inválido. */
+} ResultStatus;
+
+/**
+ * @brief Cabeçalho de um arquivo de resultados.
+ */
+typedef struct {
+	char magic[8]; /**< Identificação do formato: `"RIEMRSLT"`. */
+	uint32_t version; /**< Versão do formato (`JOBFILE_VERSION`). */
+	uint32_t byte_order; /**< `JOBFILE_BYTE_ORDER`. */
+	uint32_t header_size; /**< Tamanho deste cabeçalho, em bytes. */
+	uint32_t record_size; /**< Tamanho de cada `ResultRecord`, em bytes. */
+	uint64_t count; /**< Número de registros. */
+	uint64_t records; /**< Posição dos registros no arquivo, em bytes. */
+	uint64_t source; /**< O hash `JobFileHeader::content` do arquivo de
+			  * trabalhos, para detectar a retomada com outro
+			  * arquivo. */
+	uint64_t reserved[2]; /**< Reservado; deve ser zero. */
+} ResultFileHeader;
+
+/**
+ * @brief Registro de um resultado no arquivo binário.
+ */
+typedef struct {
+	uint64_t id; /**< Identificador do trabalho. */
+	double value; /**< Valor da integral. */
+	_Atomic uint32_t status; /**< Estado do registro (`ResultStatus`),
+				  * escrito depois dos demais campos. */
+	uint32_t reserved; /**< Reservado; deve ser zero. */
+} ResultRecord;
+
+/**
+ * @brief Um arquivo de trabalhos mapeado na memória (somente leitura).
+ */
+typedef struct {
+	void *base; /**< Início do mapeamento. */
+	size_t size; /**< Tamanho do mapeamento, em bytes. */
+	const JobFileHeader *header; /**< O cabeçalho. */
+	const JobRecord *records; /**< Os registros dos trabalhos. */
+	const double *pool; /**< O conjunto de coeficientes. */
+} JobFile;
+
+/**
+ * @brief Um arquivo de resultados mapeado na memória.
+ */
+typedef struct {
+	void *base; /**< Início do mapeamento. */
+	size_t size; /**< Tamanho do mapeamento, em bytes. */
+	ResultFileHeader *header; /**< O cabeçalho. */
+	ResultRecord *records; /**< Os registros dos resultados. */
+} ResultFile;
+
+/**
+ * @brief Mapeia e valida um arquivo de trabalhos.
+ *
+ * @param file Ponteiro onde o arquivo mapeado será descrito.
+ * @param path O caminho do arquivo.
+ * @return `true` em caso de sucesso, `false` se o arquivo não pôde ser
+ * mapeado ou não estiver no formato esperado.
+ */
+bool jobfile_open(JobFile *file, const char *path);
+
+/**
+ * @brief Desfaz o mapeamento de um arquivo de trabalhos.
+ *
+ * @param file Ponteiro para o arquivo mapeado.
+ */
+void jobfile_close(JobFile *file);
+
+/**
+ * @brief Constrói a função de um trabalho como uma visão sobre os
+ * coeficientes mapeados.
+ *
+ * @param file Ponteiro para o arquivo mapeado.
+ * @param index Índice do trabalho.
+ * @param view Ponteiro para o espaço da visão.
+ * @return Ponteiro para a função, ou `nullptr` se o registro for inválido
+ * (coeficientes fora do conjunto, zero retângulos ou método desconhecido).
+ */
+Function *jobfile_function(const JobFile *file, size_t index,
+			   FunctionView *view);
+
+/**
+ * @brief Converte trabalhos do formato textual para o binário.
+ *
+ * @details A conversão é feita em fluxo: os registros são escritos
+ * diretamente no arquivo de saída, e os coeficientes num arquivo temporário
+ * que é anexado ao final. Linhas inválidas são relatadas na saída de erro e
+ * descartadas.
+ *
+ * @param in O arquivo de entrada, no formato textual.
+ * @param path O caminho do arquivo binário a criar.
+ * @return O número de linhas descartadas, ou -1 em caso de erro de E/S.
+ */
+long jobfile_encode(FILE *in, const char *path);
+
+/**
+ * @brief Converte trabalhos do formato binário para o textual.
+ *
+ * @param file Ponteiro para o arquivo mapeado.
+ * @param out O arquivo de saída.
+ * @return O número de registros inválidos, que são descartados.
+ */
+long jobfile_decode(const JobFile *file, FILE *out);
+
+/**
+ * @brief Abre ou cria o arquivo de resultados de um arquivo de trabalhos.
+ *
+ * @details Se o arquivo não existir ou estiver vazio, ele é criado com todos
+ * os registros pendentes. Caso contrário, é validado contra o arquivo de
+ * trabalhos, e os registros já calculados são preservados.
+ *
+ * @param file Ponteiro onde o arquivo mapeado será descrito.
+ * @param path O caminho do arquivo.
+ * @param jobs Ponteiro para o arquivo de trabalhos correspondente.
+ * @return `true` em caso de sucesso, `false` caso contrário.
+ */
+bool resultfile_open(ResultFile *file, const char *path, const JobFile *jobs);
+
+/**
+ * @brief Grava e desfaz o mapeamento de um arquivo de resultados.
+ *
+ * @param file Ponteiro para o arquivo mapeado.
+ */
+void resultfile_close(ResultFile *file);
+
+/**
+ * @brief Calcula os trabalhos pendentes de um arquivo de trabalhos.
+ *
+ * @details Os trabalhos são divididos em blocos de tamanho fixo e
+ * distribuídos pelo conjunto global de threads (ver `pool.h`); cada soma usa
+ * uma única thread. Os trabalhos cujo resultado não está pendente são
+ * pulados.
+ *
+ * @param jobs Ponteiro para o arquivo de trabalhos.
+ * @param results Ponteiro para o arquivo de resultados correspondente.
+ * @param threads Número de threads (0 para uma por processador).
+ * @return O número de trabalhos calculados nesta chamada.
+ */
+size_t jobfile_run(const JobFile *jobs, ResultFile *results, unsigned threads);
+
+/**
+ * @brief Escreve os resultados já calculados no formato textual escolhido.
+ *
+ * @param file Ponteiro para o arquivo de resultados.
+ * @param out O arquivo de saída.
+ * @param format O formato da saída.
+ * @return O número de resultados com erro.
+ */
+long resultfile_print(const ResultFile *file, FILE *out, JobsFormat format);
+
+#endif // !JOBFILE_H
\ No newline at end of file
@@ -0,0 +1,131 @@
+// SPDX-License-Identifier: ISC
+
+/**
+ * @file jobs.h
+ * @brief Declarações do processamento em fluxo de trabalhos de integração.
+ *
+ * @details Este arquivo declara o formato textual dos trabalhos de integração
+ * e o pipeline que os processa em fluxo. Cada linha da entrada descreve um
+ * trabalho:
+ *
+ * @code
+ * <id> <min> <max> <n> <método> <c0> [c1 ... cd]
+ * @endcode
+ *
+ * onde `id` é um inteiro sem sinal, `min` e `max` são os limites de
+ * integração, `n` é o número de retângulos, `método` é `direita`, `esquerda`
+ * ou `meio`, e `c0` a `cd` são os coeficientes do polinômio em ordem
+ * crescente de grau. Linhas vazias ou iniciadas por `#` são ignoradas.
+ *
+ * O pipeline tem três estágios: a thread chamadora lê e analisa as linhas,
+ * um conjunto de threads de trabalho calcula as integrais, e uma thread de
+ * escrita serializa os resultados. Os estágios se comunicam por um número
+ * fixo de posições pré-alocadas, de modo que o uso de memória não depende do
+ * tamanho da entrada.
+ */
+
+#pragma once
+#ifndef JOBS_H
+#define JOBS_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "cache.h"
+#include "riemann.h"
+
+/**
+ * @brief Maior grau de polinômio aceito num trabalho.
+ */
+#define JOB_MAX_DEGREE 64
+
+/**
+ * @brief Um trabalho de integração.
+ */
+typedef struct {
+	uint64_t id; /**< Identificador do trabalho. */
+	double min; /**< Limite inferior de integração. */
+	double max; /**< Limite superior de integração. */
+	size_t n; /**< Número de retângulos. */
+	SumType method; /**< Tipo de soma de Riemann. */
+	size_t degree; /**< Grau do polinômio. */
+	double coeffs[JOB_MAX_DEGREE + 1]; /**< Coeficientes do polinômio, em
+					    * ordem crescente de grau. */
+} Job;
+
+/**
+ * @brief Formatos de saída dos resultados.
+ */
+typedef enum {
+	JOBS_CSV, /**< Valores separados por vírgula: `id,valor,erro`. */
+	JOBS_JSONL /**< Um objeto JSON por linha: `{"id":…,"valor":…}` ou
+		    * `{"id":…,"erro":"…"}`. */
+} JobsFormat;
+
+/**
+ * @brief Opções do processamento de trabalhos.
+ */
+typedef struct {
+	JobsFormat format; /**< Formato da saída. */
+	bool unordered; /**< Se verdadeiro, os resultados são escritos na ordem
+			 * em que ficam prontos, e não na ordem da entrada. */
+	unsigned threads; /**< Número de threads de cálculo (0 para uma por
+			   * processador). */
+	size_t queue; /**< Número máximo de trabalhos em andamento (0 para o
+		       * padrão). */
+	ResultCache *cache; /**< Cache de resultados compartilhado pelas threads
+			     * de cálculo, ou `nullptr` para não memorizar. */
+} JobsOptions;
+
+/**
+ * @brief Analisa uma linha no formato textual de trabalhos.
+ *
+ * @param line A linha, terminada em nulo (com ou sem quebra de linha).
+ * @param job Ponteiro onde o trabalho será escrito.
+ * @param err Ponteiro onde uma descrição estática do erro será escrita, se
+ * houver.
+ * @return 1 se um trabalho foi lido, 0 se a linha deve ser ignorada, ou -1 em
+ * caso de erro.
+ */
+int job_parse(const char *line, Job *job, const char **err);
+
+/**
+ * @brief Escreve um trabalho no formato textual.
+ *
+ * @param out O arquivo de saída.
+ * @param job O trabalho.
+ */
+void job_print(FILE *out, const Job *job);
+
+/**
+ * @brief Escreve o cabeçalho da saída de resultados, se o formato tiver um.
+ *
+ * @param out O arquivo de saída.
+ * @param format O formato da saída.
+ */
+void jobs_print_header(FILE *out, JobsFormat format);
+
+/**
+ * @brief Escreve o resultado de um trabalho.
+ *
+ * @param out O arquivo de saída.
+ * @param format O formato da saída.
+ * @param id O identificador do trabalho.
+ * @param value O valor da integral (ignorado se houver erro).
+ * @param err Descrição do erro, ou `nullptr` se não houver.
+ */
+void jobs_print_result(FILE *out, JobsFormat format, uint64_t id, double value,
+		       const char *err);
+
+/**
+ * @brief Processa em fluxo os trabalhos de um arquivo.
+ *
+ * @param in O arquivo de entrada, no formato textual de trabalhos.
+ * @param out O arquivo onde os resultados serão escritos.
+ * @param opts Opções do processamento.
+ * @return O número de trabalhos com erro, ou -1 se o pipeline não pôde ser
+ * iniciado.
+ */
+long jobs_run(FILE *in, FILE *out, const JobsOptions *opts);
+
+#endif // !JOBS_H
\ No newline at end of file
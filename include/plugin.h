@@ -0,0 +1,119 @@
+// SPDX-License-Identifier: ISC
+
+/**
+ * @file plugin.h
+ * @brief Interface binária dos plugins de funções, carregados em tempo de
+ * execução.
+ *
+ * @details Um plugin é um objeto compartilhado (`.so`) que implementa uma
+ * função de uma variável compilada separadamente do programa. Ele exporta um
+ * único símbolo, `riemann_plugin_v1`, do tipo `RiemannPlugin`, com a versão
+ * da interface e os ponteiros para as suas funções:
+ *
+ * @code
+ * #include "plugin.h"
+ *
+ * static double quadrado(double x, [[maybe_unused]] void *state)
+ * {
+ *	return x * x;
+ * }
+ *
+ * const RiemannPlugin riemann_plugin_v1 = {
+ *	.abi = RIEMANN_PLUGIN_ABI,
+ *	.size = sizeof(RiemannPlugin),
+ *	.name = "quadrado",
+ *	.eval = &quadrado,
+ * };
+ * @endcode
+ *
+ * A função do plugin é instanciada por `function_new(PLUGIN, caminho,
+ * parâmetros)`. Os ponteiros `eval` e `eval_batch` do plugin são usados
+ * diretamente na `Function`, sem nenhuma camada intermediária, de modo que a
+ * função roda dentro de `riemann()` com a mesma velocidade de um tipo
+ * nativo. Um exemplo completo está em `plugins/gauss.c`.
+ *
+ * Os campos são acrescentados somente ao final de `RiemannPlugin`, e o campo
+ * `size` indica quantos deles o plugin conhece: os que estiverem além dele
+ * são tratados como nulos. Uma mudança incompatível incrementa
+ * `RIEMANN_PLUGIN_ABI` e o nome do símbolo.
+ */
+
+#pragma once
+#ifndef PLUGIN_H
+#define PLUGIN_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "func.h"
+
+/**
+ * @brief Versão da interface binária dos plugins.
+ */
+#define RIEMANN_PLUGIN_ABI 1
+
+/**
+ * @brief Nome do símbolo exportado por um plugin desta versão.
+ */
+#define RIEMANN_PLUGIN_SYMBOL "riemann_plugin_v1"
+
+/**
+ * @brief Tabela de símbolos de um plugin.
+ */
+typedef struct {
+	uint32_t abi; /**< Versão da interface, `RIEMANN_PLUGIN_ABI`. */
+	uint32_t size; /**< Tamanho desta estrutura no plugin, em bytes
+			* (`sizeof(RiemannPlugin)`). */
+	const char *name; /**< Nome da função, para mensagens. */
+	/**
+	 * @brief Cria o estado da função a partir dos parâmetros. Pode ser
+	 * `nullptr`, se a função não tiver parâmetros.
+	 *
+	 * @details Recebe os parâmetros (que podem ser `nullptr`) e escreve em
+	 * `*state` o ponteiro que será passado a `eval`, `eval_batch` e
+	 * `destroy`. Retorna 0 em caso de sucesso. Sem `init`, o estado é
+	 * `nullptr`.
+	 */
+	int (*init)(const char *params, void **state);
+	void (*destroy)(void *state); /**< Libera o estado criado por `init`,
+				       * ou `nullptr`. */
+	eval_ptr_t eval; /**< Avalia a função num ponto. Obrigatório. */
+	batch_ptr_t eval_batch; /**< Avalia a função em lote, ou `nullptr`.
+				 * Deve seguir o contrato de `batch_ptr_t`. */
+} RiemannPlugin;
+
+/**
+ * @brief Carrega um plugin e instancia a sua função.
+ *
+ * @details O objeto é carregado com `dlopen()`, e a sua tabela, validada: a
+ * versão deve ser `RIEMANN_PLUGIN_ABI`, e `eval` não pode ser nulo. Em
+ * seguida, `init` é chamado com `params`. Normalmente, é chamado por
+ * `function_new()`.
+ *
+ * @param path Caminho do objeto compartilhado. Sem uma barra, é procurado
+ * nos diretórios de bibliotecas do sistema, como em `dlopen()`.
+ * @param params Parâmetros repassados a `init`, ou `nullptr`.
+ * @return Ponteiro para a nova função, do tipo `PLUGIN`, ou `nullptr` em
+ * caso de erro (que é exibido na saída de erro).
+ * @note Ignorar o retorno pode causar vazamento de memória.
+ */
+[[nodiscard("Ignorar retorno pode causar vazamento de memória")]]
+Function *plugin_open(const char *path, const char *params);
+
+/**
+ * @brief Libera a função de um plugin e descarrega o objeto.
+ *
+ * @param func Ponteiro para a função, criada por `plugin_open()`.
+ */
+void plugin_free(Function *func);
+
+/**
+ * @brief Retorna o nome da função de um plugin.
+ *
+ * @param func Ponteiro para a função, criada por `plugin_open()`.
+ * @return O nome declarado pelo plugin, ou o caminho do objeto se o plugin
+ * não declarar um.
+ */
+const char *plugin_name(const Function *func);
+
+#endif // !PLUGIN_H
\ No newline at end of file
@@ -0,0 +1,112 @@
+// SPDX-License-Identifier: ISC
+
+/**
+ * @file pool.h
+ * @brief Declarações de um conjunto reutilizável de threads de trabalho.
+ *
+ * @details Este arquivo declara um conjunto (“pool”) de threads POSIX que é
+ * criado uma única vez e reutilizado entre chamadas, evitando o custo de criar
+ * e destruir threads a cada integração. O modelo de uso é do tipo
+ * “fork-join”: o chamador submete um número de tarefas indexadas de 0 a
+ * \f$n - 1\f$, participa da sua execução, e só retorna quando todas tiverem
+ * terminado. A ordem em que as tarefas executam e a thread que executa cada
+ * uma não são especificadas; por isso, cada tarefa deve escrever seu resultado
+ * numa posição própria, determinada apenas pelo seu índice.
+ */
+
+#pragma once
+#ifndef POOL_H
+#define POOL_H
+
+#include <stddef.h>
+
+/**
+ * @brief Tipo de ponteiro para uma tarefa executada pelo conjunto de threads.
+ *
+ * @param index O índice da tarefa, entre 0 e o número de tarefas menos 1.
+ * @param ctx Ponteiro para o contexto compartilhado entre as tarefas.
+ */
+typedef void (*pool_task_t)(size_t index, void *ctx);
+
+/**
+ * @brief Número máximo de threads por processador aceito por
+ * `pool_parse_threads()`.
+ */
+#define POOL_THREADS_PER_CPU 4
+
+/**
+ * @brief Conjunto de threads de trabalho. Sua definição é opaca.
+ */
+typedef struct Pool Pool;
+
+/**
+ * @brief Instancia um conjunto de threads.
+ *
+ * @param workers Número de threads de trabalho a criar, além da thread que
+ * chama `pool_run()`.
+ * @return Ponteiro para o novo conjunto, ou `nullptr` em caso de erro.
+ * @note Ignorar o retorno pode causar vazamento de memória.
+ */
+[[nodiscard("Ignorar retorno pode causar vazamento de memória")]]
+Pool *pool_new(unsigned workers);
+
+/**
+ * @brief Termina as threads de um conjunto e o libera.
+ *
+ * @param pool Ponteiro para o conjunto a ser liberado.
+ */
+void pool_free(Pool *pool);
+
+/**
+ * @brief Retorna o conjunto global de threads, criando-o na primeira chamada.
+ *
+ * @details O conjunto global é compartilhado por todo o programa e cresce sob
+ * demanda até `threads - 1` threads de trabalho. Ele nunca é liberado. Se o
+ * crescimento falhar, o conjunto continua com as threads que já tinha, e
+ * não tenta mais crescer além delas.
+ *
+ * @param threads Número total de threads (incluindo a chamadora) que se
+ * pretende usar.
+ * @return Ponteiro para o conjunto global, ou `nullptr` se não foi possível
+ * criá-lo.
+ */
+Pool *pool_global(unsigned threads);
+
+/**
+ * @brief Executa um lote de tarefas e aguarda o término de todas.
+ *
+ * @details A thread chamadora participa da execução. Chamadas concorrentes no
+ * mesmo conjunto são serializadas. Uma tarefa não deve chamar `pool_run()` no
+ * mesmo conjunto em que está sendo executada, pois isto causaria um impasse.
+ *
+ * @param pool Ponteiro para o conjunto.
+ * @param count Número de tarefas.
+ * @param threads Número máximo de threads (incluindo a chamadora) a usar.
+ * @param task Função que executa cada tarefa.
+ * @param ctx Contexto repassado a cada tarefa.
+ */
+void pool_run(Pool *pool, size_t count, unsigned threads, pool_task_t task,
+	      void *ctx);
+
+/**
+ * @brief Retorna o número de processadores disponíveis.
+ *
+ * @return O número de processadores, ou 1 se não for possível determiná-lo.
+ */
+unsigned pool_cpu_count(void);
+
+/**
+ * @brief Interpreta um número de threads dado pelo usuário.
+ *
+ * @details Aceita um número decimal sem sinal ou `auto` (um por
+ * processador). Valores acima de `POOL_THREADS_PER_CPU` threads por
+ * processador são reduzidos a esse limite.
+ *
+ * @param str O texto, terminado em nulo.
+ * @param threads Onde o número será escrito.
+ * @return `true` em caso de sucesso, `false` (com `errno` igual a `EINVAL`)
+ * se o texto for vazio, negativo ou não numérico.
+ */
+bool pool_parse_threads(const char *str, unsigned *threads);
+
+#endif // !POOL_H
\ No newline at end of file
@@ -0,0 +1,83 @@
+// SPDX-License-Identifier: ISC
+
+/**
+ * @file quad.h
+ * @brief Declarações do integrador adaptativo de Gauss–Kronrod.
+ *
+ * @details Este arquivo declara um integrador numérico adaptativo, alternativo
+ * às somas de Riemann de `riemann.h`. Enquanto o erro das somas de Riemann
+ * decai como \f$O(1/n)\f$, a regra de Gauss–Kronrod de 15 pontos é exata para
+ * polinômios de grau até 22 e converge muito mais rápido para funções suaves.
+ * O integrador subdivide adaptativamente os subintervalos com maior erro
+ * estimado até atingir a tolerância pedida ou esgotar o orçamento de
+ * avaliações.
+ */
+
+#pragma once
+#ifndef QUAD_H
+#define QUAD_H
+
+#include <stddef.h>
+#include "func.h"
+
+/**
+ * @brief Número de avaliações da função por subintervalo (regra de 15 pontos).
+ */
+#define QUAD_POINTS 15
+
+/**
+ * @brief Situação final de uma integração adaptativa.
+ */
+typedef enum {
+	QUAD_OK, /**< A tolerância pedida foi atingida. */
+	QUAD_MAX_EVALS, /**< O orçamento de avaliações se esgotou antes. */
+	QUAD_ROUNDOFF, /**< Os subintervalos ficaram pequenos demais para serem
+			* divididos em ponto flutuante. */
+	QUAD_NOMEM, /**< Faltou memória para os subintervalos. */
+	QUAD_NONFINITE /**< A função assumiu um valor infinito ou `NaN` num dos
+			* pontos, e o erro deixou de ser finito. */
+} QuadStatus;
+
+/**
+ * @brief Resultado de uma integração adaptativa.
+ */
+typedef struct {
+	double value; /**< Estimativa da integral. */
+	double error; /**< Estimativa do erro absoluto de `value`. */
+	size_t evals; /**< Número de avaliações da função realizadas. */
+	size_t intervals; /**< Número de subintervalos ao final. */
+	QuadStatus status; /**< Situação final. */
+} QuadResult;
+
+/**
+ * @brief Integra uma função arbitrária com a regra adaptativa de
+ * Gauss–Kronrod G7-K15.
+ *
+ * @details Em cada subintervalo, a regra de Kronrod de 15 pontos fornece a
+ * estimativa da integral, e a diferença para a regra de Gauss de 7 pontos
+ * (que usa um subconjunto dos mesmos pontos) fornece a estimativa do erro,
+ * ajustada como no QUADPACK. Os subintervalos são mantidos num heap ordenado
+ * pelo erro; a cada passo, o de maior erro é dividido ao meio. O processo
+ * termina quando o erro total for menor que
+ * \f$\max(\text{epsabs}, \text{epsrel} \cdot |I|)\f$, ou quando a próxima
+ * divisão excederia `max_evals` avaliações. Se a estimativa do erro de algum
+ * subintervalo não for finita, o processo para com `QUAD_NONFINITE`; se
+ * faltar memória, com `QUAD_NOMEM`. Em ambos os casos, `value` e `error`
+ * ainda cobrem o intervalo inteiro.
+ *
+ * A função é avaliada com `Function::eval_batch` (15 pontos por chamada) se
+ * disponível, ou com `Function::eval` caso contrário.
+ *
+ * @param min O limite inferior do intervalo de integração.
+ * @param max O limite superior do intervalo de integração.
+ * @param func Ponteiro para a função a ser integrada.
+ * @param epsabs Tolerância absoluta (ou 0 para ignorá-la).
+ * @param epsrel Tolerância relativa (ou 0 para ignorá-la).
+ * @param max_evals Número máximo de avaliações da função. Pelo menos uma
+ * aplicação da regra (`QUAD_POINTS` avaliações) é sempre feita.
+ * @return A estimativa, o erro, o número de avaliações e a situação final.
+ */
+QuadResult quad_gk(double min, double max, Function *func, double epsabs,
+		   double epsrel, size_t max_evals);
+
+#endif // !QUAD_H
\ No newline at end of file
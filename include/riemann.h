@@ -6,8 +6,8 @@
  *
  * @details Este arquivo contém as declarações de tipos e funções utilizadas
  * para calcular somas de Riemann de funções arbitrárias. Ele define o tipo de
- * soma de Riemann (esquerda ou direita) e a função que realiza o cálculo da
- * soma de Riemann em um intervalo especificado.
+ * soma de Riemann (esquerda, direita ou ponto médio) e a função que realiza o
+ * cálculo da soma de Riemann em um intervalo especificado.
  */
 
 #pragma once
@@ -17,32 +17,252 @@
 #include <stdlib.h>
 #include "func.h"
 
+/**
+ * @brief Número de pontos da grade em cada bloco da redução.
+ *
+ * @details As somas de Riemann são calculadas em blocos deste tamanho, que são
+ * a unidade de trabalho distribuída entre as threads. Para \f$n\f$ até este
+ * valor, a soma é feita num único bloco, na mesma ordem da soma sequencial.
+ */
+#define RIEMANN_BLOCK ((size_t)1 << 14)
+
+/**
+ * @brief Maior grau de polinômio para o qual a soma usa a fórmula fechada.
+ *
+ * @details Acima deste grau, os números de Bernoulli envolvidos crescem a
+ * ponto de o cancelamento entre os termos comprometer a precisão, e a soma é
+ * feita ponto a ponto.
+ */
+#define RIEMANN_CLOSED_MAX_DEGREE 32
+
+/**
+ * @brief Menor número de retângulos para o qual a soma usa a fórmula fechada.
+ *
+ * @details Abaixo deste valor, a soma ponto a ponto já é barata, e a série de
+ * Faulhaber converge mal quando \f$n\f$ não é grande em relação ao grau.
+ */
+#define RIEMANN_CLOSED_MIN_N 64
+
+/**
+ * @brief Maior erro relativo estimado aceito na fórmula fechada.
+ *
+ * @details Se a estimativa do erro de arredondamento da fórmula fechada,
+ * relativa ao resultado, exceder este valor, a soma é feita ponto a ponto.
+ */
+#define RIEMANN_CLOSED_TOL 1e-12
+
 /**
  * @brief Tipos de soma de Riemann.
  * @details Corresponde a qual das arestas dos retângulos (direita ou esquerda)
- * os valores de \f$x_i\f$ serão amostrados.
+ * os valores de \f$x_i\f$ serão amostrados, ou se serão amostrados no centro
+ * de cada retângulo.
  */
 typedef enum {
 	DIREITA, /**< Soma de Riemann pela direita. */
-	ESQUERDA /**< Soma de Riemann pela esquerda. */
+	ESQUERDA, /**< Soma de Riemann pela esquerda. */
+	MEIO /**< Regra do ponto médio: a soma pela esquerda com a grade
+	      * deslocada de \f$\Delta x / 2\f$. O erro decai como
+	      * \f$O(1/n^2)\f$, e não como \f$O(1/n)\f$. */
 } SumType;
 
+/**
+ * @brief Precisões da soma ponto a ponto.
+ *
+ * @details Escolhem o compromisso entre vazão e exatidão quando a função é
+ * avaliada em todos os pontos da grade. Não afetam a fórmula fechada (ver
+ * `riemann_opts()`), que já é exata a menos de `RIEMANN_CLOSED_TOL`.
+ */
+typedef enum {
+	RIEMANN_DOUBLE, /**< Avaliação e soma em `double`. */
+	RIEMANN_FLOAT, /**< Polinômios densos de grau até
+			* `SIMD_SUM_MAX_DEGREE` são avaliados e somados em
+			* `float`, com o dobro de pontos por registrador (ver
+			* `simd_poly_sum_f32()`), em trechos de algumas
+			* centenas de pontos cujas somas são acumuladas em
+			* `double`. O erro relativo é da ordem de
+			* \f$10^{-6}\f$; serve para triagens. As demais
+			* funções são somadas em `double`. */
+	RIEMANN_DOUBLE_DOUBLE /**< Polinômios densos de grau até
+			       * `SIMD_SUM_MAX_DEGREE` são avaliados pela regra
+			       * de Horner compensada, e todos os valores são
+			       * acumulados em pares dupla-dupla, inclusive na
+			       * árvore de redução (ver `simd_poly_sum_dd()`).
+			       * O erro da soma deixa de crescer com \f$n\f$, a
+			       * um custo de algumas vezes o de
+			       * `RIEMANN_DOUBLE`.
+			       * As demais funções são avaliadas em `double`,
+			       * mas também acumuladas em dupla-dupla. */
+} RiemannPrecision;
+
+/**
+ * @brief Opções que ajustam o cálculo de uma soma de Riemann.
+ *
+ * @details Uma instância zerada (`(RiemannOptions){ 0 }`) corresponde ao
+ * comportamento padrão de `riemann()`.
+ */
+typedef struct {
+	unsigned threads; /**< Número de threads a usar. Se 0, usa o valor da
+			   * variável de ambiente `RIEMANN_THREADS`, ou 1 se
+			   * ela não estiver definida. */
+	bool brute_force; /**< Se verdadeiro, sempre avalia a função em todos
+			   * os pontos da grade, mesmo quando houver uma
+			   * fórmula fechada para a soma. */
+	RiemannPrecision precision; /**< Precisão da soma ponto a ponto. */
+	struct ResultCache *cache; /**< Cache de resultados (ver `cache.h`)
+				    * consultado antes da soma e atualizado
+				    * depois dela, ou `nullptr` para não
+				    * memorizar. */
+} RiemannOptions;
+
 /**
  * @brief Calcula uma soma de Riemann de uma função arbitrária em um intervalo.
  *
  * @details Esta função calcula a soma de Riemann de uma função arbitrária no
  * intervalo \f$[min, max]\f$ usando um número especificado de retângulos. O
- * tipo de soma de Riemann (esquerda ou direita) é determinado pelo parâmetro
- * `type`.
+ * tipo de soma de Riemann (esquerda, direita ou ponto médio) é determinado
+ * pelo parâmetro `type`.
  *
  * @param min O limite inferior do intervalo de integração.
  * @param max O limite superior do intervalo de integração.
  * @param func Ponteiro para a função a ser integrada.
  * @param num O número de retângulos a serem usados na soma de Riemann.
- * @param type O tipo de soma de Riemann (esquerda ou direita).
+ * @param type O tipo de soma de Riemann.
  * @return O valor aproximado da integral da função no intervalo especificado.
  */
 double riemann(double min, double max, Function *func, size_t num,
 	       SumType type);
 
+/**
+ * @brief Calcula uma soma de Riemann com opções explícitas.
+ *
+ * @details Idêntica a `riemann()`, mas permite ajustar o cálculo por meio de
+ * `opts`. Os pontos da grade são divididos em blocos de tamanho fixo
+ * (`RIEMANN_BLOCK`), cada bloco é somado sequencialmente, e as somas dos
+ * blocos são combinadas numa árvore binária de forma fixa. Como nem o
+ * tamanho dos blocos nem a forma da árvore dependem do número de threads, o
+ * resultado é idêntico bit a bit para qualquer valor de `opts->threads`.
+ *
+ * Se `func` for um polinômio de grau até `RIEMANN_CLOSED_MAX_DEGREE` e `num`
+ * for pelo menos `RIEMANN_CLOSED_MIN_N`, a soma é calculada em
+ * \f$O(\text{grau}^2)\f$ operações por uma fórmula fechada, independente de
+ * `num`, a menos que `opts->brute_force` seja verdadeiro. O resultado coincide
+ * com o da soma ponto a ponto a menos de erros de arredondamento; se a
+ * estimativa desses erros exceder `RIEMANN_CLOSED_TOL`, a soma é feita ponto a
+ * ponto.
+ *
+ * Se `opts->cache` não for nulo e o conteúdo de `func` puder ser resumido
+ * (ver `function_digest()`), o resultado é procurado no cache antes da soma,
+ * e inserido nele depois. Como o resultado não depende do número de threads,
+ * `opts->threads` não faz parte da chave.
+ *
+ * @param min O limite inferior do intervalo de integração.
+ * @param max O limite superior do intervalo de integração.
+ * @param func Ponteiro para a função a ser integrada.
+ * @param num O número de retângulos a serem usados na soma de Riemann.
+ * @param type O tipo de soma de Riemann.
+ * @param opts Opções do cálculo, ou `nullptr` para usar as padrão.
+ * @return O valor aproximado da integral da função no intervalo especificado.
+ */
+double riemann_opts(double min, double max, Function *func, size_t num,
+		    SumType type, const RiemannOptions *opts);
+
+/**
+ * @brief Determina o número de threads a usar numa soma.
+ *
+ * @details Se `opts->threads` for positivo, usa esse valor. Caso contrário,
+ * consulta a variável de ambiente `RIEMANN_THREADS`, que pode conter um número
+ * positivo ou `auto` (um por processador), interpretada por
+ * `pool_parse_threads()`. Na ausência de ambos, ou se a variável for
+ * inválida (o que é avisado uma vez), usa 1. É usada por `riemann_opts()`,
+ * `riemann_multi()` e `riemann2d()`.
+ *
+ * @param opts Opções do cálculo, ou `nullptr`.
+ * @return O número de threads.
+ */
+unsigned riemann_threads(const RiemannOptions *opts);
+
+/**
+ * @brief Calcula as somas de Riemann de vários polinômios na mesma grade.
+ *
+ * @details Equivale a chamar `riemann_opts()` para cada função de `funcs`, mas
+ * os polinômios que precisam ser somados ponto a ponto (por terem a fórmula
+ * fechada desabilitada em `opts` ou rejeitada) compartilham uma única passada
+ * pela grade. Nela, calculam-se somente as somas das potências dos pontos,
+ * \f$s_k = \sum_i x_i^k\f$, até o maior grau entre eles (ver
+ * `simd_power_sums()`), com os mesmos blocos e a mesma árvore de redução de
+ * `riemann_opts()`. Cada soma é então o produto escalar \f$\sum_k c_k s_k\f$:
+ * os coeficientes são dispostos numa matriz com uma linha por potência e uma
+ * coluna por função, e todas as somas saem de um único produto
+ * matriz-vetor, feito em blocos de colunas. O custo por ponto da grade é
+ * proporcional ao grau, e não ao número de funções.
+ *
+ * Os resultados coincidem com os de `riemann_opts()` a menos de erros de
+ * arredondamento, pois os termos são somados em outra ordem. Polinômios na
+ * representação esparsa (ver `function_new()`) ou de grau maior que
+ * `SIMD_POWERS_MAX_DEGREE` são somados um a um, por `riemann_opts()`, e
+ * somente estes passam pelo cache de resultados de `opts`. Se
+ * `opts->precision` não for `RIEMANN_DOUBLE`, todos são somados um a um.
+ *
+ * @param min O limite inferior do intervalo de integração.
+ * @param max O limite superior do intervalo de integração.
+ * @param funcs Arranjo de ponteiros para as funções, todas polinomiais.
+ * @param count Número de funções e de elementos de `out`.
+ * @param num O número de retângulos a serem usados na soma de Riemann.
+ * @param type O tipo de soma de Riemann.
+ * @param opts Opções do cálculo, ou `nullptr` para usar as padrão.
+ * @param out Arranjo onde as somas serão escritas, na ordem de `funcs`.
+ * @return `true` em caso de sucesso, `false` se alguma função não for um
+ * polinômio (caso em que nada é calculado) ou se faltou memória.
+ */
+bool riemann_multi(double min, double max, Function *const *funcs,
+		   size_t count, size_t num, SumType type,
+		   const RiemannOptions *opts, double *out);
+
+/**
+ * @brief Resultados de uma soma de Riemann numa varredura de valores de n.
+ */
+typedef struct {
+	size_t n; /**< Número de retângulos. */
+	double direita; /**< Soma de Riemann pela direita. */
+	double esquerda; /**< Soma de Riemann pela esquerda. */
+	double romberg; /**< Estimativa extrapolada (Richardson/Romberg) a
+			 * partir desta e de todas as somas anteriores da
+			 * varredura, ou `NAN` se não foi pedida ou não pôde
+			 * ser calculada. */
+} RiemannSweep;
+
+/**
+ * @brief Calcula as somas de Riemann de uma função para vários valores de n,
+ * reaproveitando avaliações entre eles.
+ *
+ * @details As somas pela esquerda e pela direita compartilham todos os pontos
+ * interiores da grade, que são avaliados uma única vez, além dos dois
+ * extremos do intervalo. Além disso, se uma grade com \f$n_j\f$ retângulos
+ * contém uma grade já calculada com \f$n_p\f$ retângulos (isto é, se
+ * \f$n_p\f$ divide \f$n_j\f$), somente os pontos novos são avaliados. Numa
+ * sequência aninhada como \f$n, 2n, 4n, \ldots\f$, o número total de
+ * avaliações é então aproximadamente o maior \f$n\f$, e não a soma de todos.
+ *
+ * Se `extrapolate` for verdadeiro e os valores de `ns` forem estritamente
+ * crescentes, aplica-se a extrapolação de Richardson à regra do trapézio
+ * (a média das somas pela esquerda e pela direita), cujo erro só tem potências
+ * pares de \f$\Delta x\f$. Com grades que dobram a cada passo, isto é
+ * exatamente o método de Romberg. Os pontos de grades não aninhadas são
+ * avaliados do zero, mas entram na extrapolação normalmente.
+ *
+ * As somas diferem das de `riemann()` apenas pela ordem de acumulação.
+ *
+ * @param min O limite inferior do intervalo de integração.
+ * @param max O limite superior do intervalo de integração.
+ * @param func Ponteiro para a função a ser integrada.
+ * @param ns Arranjo com os números de retângulos.
+ * @param count Número de elementos de `ns` e de `out`.
+ * @param extrapolate Se verdadeiro, calcula também as estimativas
+ * extrapoladas.
+ * @param out Arranjo onde os resultados serão escritos, na ordem de `ns`.
+ * @return `true` em caso de sucesso, `false` se faltou memória.
+ */
+bool riemann_sweep(double min, double max, Function *func, const size_t *ns,
+		   size_t count, bool extrapolate, RiemannSweep *out);
+
 #endif // !RIEMANN_H
\ No newline at end of file
@@ -0,0 +1,99 @@
+// SPDX-License-Identifier: ISC
+
+/**
+ * @file riemann2d.h
+ * @brief Declarações das somas de Riemann de funções de duas variáveis.
+ *
+ * @details Este arquivo declara o integrador de funções \f$f(x, y)\f$ (ver
+ * `func2d.h`) sobre retângulos \f$[x_{min}, x_{max}] \times
+ * [y_{min}, y_{max}]\f$, pela soma de Riemann numa grade de
+ * \f$n_x \times n_y\f$ retângulos. Os tipos de soma são os mesmos das somas
+ * de uma variável (`SumType`), aplicados às duas coordenadas.
+ */
+
+#pragma once
+#ifndef RIEMANN2D_H
+#define RIEMANN2D_H
+
+#include <stddef.h>
+
+#include "func2d.h"
+#include "riemann.h"
+
+/**
+ * @brief Maior número de colunas da grade em cada ladrilho.
+ *
+ * @details As abscissas, os valores de uma linha e os acumuladores das colunas
+ * de um ladrilho cabem juntos no cache L1.
+ */
+#define RIEMANN2D_TILE_X 512
+
+/**
+ * @brief Número de linhas da grade em cada ladrilho.
+ *
+ * @details Com `RIEMANN2D_TILE_X` colunas, um ladrilho tem tantos pontos
+ * quanto um bloco de `RIEMANN_BLOCK` das somas de uma variável.
+ */
+#define RIEMANN2D_TILE_Y 32
+
+/**
+ * @brief Maior tamanho, em bytes, da tabela de potências de um ladrilho.
+ *
+ * @details Num `BIPOLYNOMIAL` de grau \f$d_x\f$ em \f$x\f$, cada ladrilho
+ * guarda as potências \f$x^0, \ldots, x^{d_x}\f$ das suas abscissas, que são
+ * reaproveitadas por todas as suas linhas. O número de colunas do ladrilho é
+ * reduzido para que a tabela caiba no cache L2; para graus baixos, ela cabe
+ * também no L1.
+ */
+#define RIEMANN2D_TABLE_BYTES ((size_t)1 << 18)
+
+/**
+ * @brief Calcula uma soma de Riemann de uma função de duas variáveis num
+ * retângulo.
+ *
+ * @details Calcula
+ * \f[
+ * \Delta x \Delta y \sum_{i} \sum_{j} f(x_i, y_j),
+ * \f]
+ * onde \f$x_i\f$ e \f$y_j\f$ são os pontos das grades de `riemann_opts()`
+ * em cada coordenada, com o mesmo `type`.
+ *
+ * A grade é dividida em ladrilhos de até `RIEMANN2D_TILE_X` colunas por
+ * `RIEMANN2D_TILE_Y` linhas. Num ladrilho, as abscissas são geradas uma vez, e
+ * cada linha é avaliada de uma só vez (`Function2D::eval_row`), o que, num
+ * `BIPOLYNOMIAL`, custa a redução dos coeficientes em \f$y\f$ e uma
+ * avaliação vetorizada em \f$x\f$. Sem núcleo vetorizado, as potências das
+ * abscissas ficam numa tabela do ladrilho (ver `RIEMANN2D_TABLE_BYTES`), e
+ * cada linha custa a redução e um produto pela tabela. Os valores de cada
+ * coluna são acumulados ao longo das linhas, e os acumuladores, somados no
+ * final do ladrilho. Os ladrilhos são distribuídos entre `opts->threads`
+ * threads, e as suas somas são combinadas numa árvore de forma fixa; como em
+ * `riemann_opts()`, o resultado é idêntico bit a bit para qualquer número de
+ * threads.
+ *
+ * A menos que `opts->brute_force` seja verdadeiro, as funções separáveis
+ * são somadas como o produto das somas de uma variável dos seus fatores, e
+ * os polinômios de graus até `RIEMANN_CLOSED_MAX_DEGREE`, como
+ * \f$\sum_j R_j S_j\f$, onde \f$R_j\f$ é a soma em \f$x\f$ da linha \f$j\f$
+ * da matriz de coeficientes e \f$S_j\f$, a soma de \f$y^j\f$, calculadas por
+ * `riemann_opts()` (com as suas fórmulas fechadas). Se o cancelamento entre
+ * os termos puder comprometer mais que `RIEMANN_CLOSED_TOL` do resultado, a
+ * soma é feita ponto a ponto. As opções `opts->precision` e `opts->cache`
+ * valem somente para essas somas de uma variável.
+ *
+ * @param xmin O limite inferior em \f$x\f$.
+ * @param xmax O limite superior em \f$x\f$.
+ * @param ymin O limite inferior em \f$y\f$.
+ * @param ymax O limite superior em \f$y\f$.
+ * @param func Ponteiro para a função a ser integrada.
+ * @param nx O número de retângulos em \f$x\f$.
+ * @param ny O número de retângulos em \f$y\f$.
+ * @param type O tipo de soma de Riemann.
+ * @param opts Opções do cálculo, ou `nullptr` para usar as padrão.
+ * @return O valor aproximado da integral da função no retângulo.
+ */
+double riemann2d(double xmin, double xmax, double ymin, double ymax,
+		 Function2D *func, size_t nx, size_t ny, SumType type,
+		 const RiemannOptions *opts);
+
+#endif // !RIEMANN2D_H
\ No newline at end of file
@@ -0,0 +1,57 @@
+// SPDX-License-Identifier: ISC
+
+/**
+ * @file ring.h
+ * @brief Fila circular limitada de índices, usada pelos pipelines.
+ *
+ * @details Os pipelines de `jobs.c` e de `server.c` guardam os trabalhos
+ * em posições de um arranjo fixo e passam os índices dessas posições de um
+ * estágio a outro por filas circulares. A capacidade de cada fila é o número
+ * de posições, de modo que ela nunca enche; o chamador aloca `data` e
+ * protege a fila com a sua própria trava.
+ */
+
+#pragma once
+#ifndef RING_H
+#define RING_H
+
+#include <stddef.h>
+
+/**
+ * @brief Fila circular de índices de posições.
+ */
+typedef struct {
+	size_t *data; /**< Arranjo com os índices. */
+	size_t head; /**< Posição do primeiro elemento. */
+	size_t size; /**< Número de elementos na fila. */
+	size_t capacity; /**< Capacidade de `data`. */
+} Ring;
+
+/**
+ * @brief Insere um índice no fim de uma fila circular (que não pode estar
+ * cheia).
+ *
+ * @param ring Ponteiro para a fila.
+ * @param value O índice.
+ */
+static inline void ring_push(Ring *ring, size_t value)
+{
+	ring->data[(ring->head + ring->size++) % ring->capacity] = value;
+}
+
+/**
+ * @brief Retira o índice do início de uma fila circular (que não pode estar
+ * vazia).
+ *
+ * @param ring Ponteiro para a fila.
+ * @return O índice retirado.
+ */
+static inline size_t ring_pop(Ring *ring)
+{
+	size_t value = ring->data[ring->head];
+	ring->head = (ring->head + 1) % ring->capacity;
+	--ring->size;
+	return value;
+}
+
+#endif // !RING_H
\ No newline at end of file
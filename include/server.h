@@ -0,0 +1,198 @@
+// SPDX-License-Identifier: ISC
+
+/**
+ * @file server.h
+ * @brief Declarações do servidor de integração por socket Unix.
+ *
+ * @details O servidor é um processo de longa duração que recebe trabalhos de
+ * integração (os mesmos de `jobs.h`) por um socket de domínio Unix, evitando
+ * o custo de iniciar um processo e reconstruir as funções a cada trabalho.
+ *
+ * O protocolo é binário e orientado a quadros: cada mensagem, nos dois
+ * sentidos, é um comprimento de 32 bits seguido de tantos bytes de conteúdo,
+ * e o conteúdo começa com o tipo da mensagem (`ServerMessage`), também de 32
+ * bits. Os números estão na ordem de bytes da máquina, pois o socket é local.
+ *
+ * - `SERVER_INTEGRATE`: um `ServerRequest` seguido dos `degree + 1`
+ *   coeficientes; a resposta é um `ServerResult` com o mesmo `id`.
+ * - `SERVER_STATS`: somente o tipo; a resposta é um `ServerStats`.
+ * - `SERVER_SHUTDOWN`: somente o tipo; a resposta é um `ServerResult`, e o
+ *   servidor termina como ao receber `SIGINT` ou `SIGTERM`.
+ *
+ * Um cliente pode enviar vários pedidos antes de ler as respostas. As
+ * respostas de integração chegam na ordem em que ficam prontas, que pode não
+ * ser a dos pedidos.
+ *
+ * Os trabalhos recebidos num intervalo curto (`SERVER_WINDOW_US`) são
+ * agrupados em lotes de até `SERVER_BATCH` trabalhos, e cada lote é
+ * calculado por uma das threads de trabalho: as funções do lote são obtidas
+ * do cache numa só travessia, e as respostas a uma mesma conexão são
+ * enviadas numa só escrita. As funções ficam num cache LRU compartilhado,
+ * indexado por um hash do polinômio.
+ *
+ * Ao terminar, o servidor deixa de aceitar conexões e pedidos, mas calcula e
+ * responde todos os trabalhos já recebidos.
+ */
+
+#pragma once
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "jobs.h"
+
+/**
+ * @brief Número máximo de trabalhos num lote.
+ */
+#define SERVER_BATCH 32
+
+/**
+ * @brief Tempo padrão, em microssegundos, que um trabalho pode esperar por
+ * outros para formar um lote.
+ */
+#define SERVER_WINDOW_US 200
+
+/**
+ * @brief Número padrão de funções no cache.
+ */
+#define SERVER_CACHE 1024
+
+/**
+ * @brief Número padrão de trabalhos recebidos e ainda não respondidos.
+ */
+#define SERVER_QUEUE 4096
+
+/**
+ * @brief Número de latências recentes usadas nas estatísticas.
+ */
+#define SERVER_SAMPLES 4096
+
+/**
+ * @brief Número de pedidos que o cliente envia antes de ler as respostas.
+ */
+#define SERVER_PIPELINE 64
+
+/**
+ * @brief Tipos de mensagem do protocolo.
+ */
+typedef enum {
+	SERVER_INTEGRATE = 1, /**< Pedido ou resposta de integração. */
+	SERVER_STATS, /**< Pedido ou resposta de estatísticas. */
+	SERVER_SHUTDOWN /**< Pedido de término do servidor. */
+} ServerMessage;
+
+/**
+ * @brief Estados de uma resposta.
+ */
+typedef enum {
+	SERVER_OK, /**< O valor está pronto. */
+	SERVER_ERROR /**< O pedido é inválido ou não pôde ser calculado. */
+} ServerStatus;
+
+/**
+ * @brief Pedido de integração, seguido dos coeficientes (`double`).
+ */
+typedef struct {
+	uint32_t type; /**< `SERVER_INTEGRATE`. */
+	uint32_t degree; /**< Grau do polinômio (até `JOB_MAX_DEGREE`). */
+	uint64_t id; /**< Identificador do trabalho. */
+	double min; /**< Limite inferior de integração. */
+	double max; /**< Limite superior de integração. */
+	uint64_t n; /**< Número de retângulos. */
+	uint32_t method; /**< Tipo de soma de Riemann (`SumType`). */
+	uint32_t reserved; /**< Reservado; deve ser zero. */
+} ServerRequest;
+
+/**
+ * @brief Resposta a um pedido de integração ou de término.
+ */
+typedef struct {
+	uint32_t type; /**< O tipo do pedido respondido. */
+	uint32_t status; /**< Estado da resposta (`ServerStatus`). */
+	uint64_t id; /**< Identificador do trabalho. */
+	double value; /**< Valor da integral. */
+} ServerResult;
+
+/**
+ * @brief Resposta a um pedido de estatísticas.
+ */
+typedef struct {
+	uint32_t type; /**< `SERVER_STATS`. */
+	uint32_t reserved; /**< Reservado; deve ser zero. */
+	uint64_t requests; /**< Pedidos de integração recebidos. */
+	uint64_t errors; /**< Pedidos de integração respondidos com erro. */
+	uint64_t cache_hits; /**< Funções encontradas no cache. */
+	uint64_t cache_misses; /**< Funções construídas. */
+	uint64_t batches; /**< Lotes calculados. */
+	uint64_t connections; /**< Conexões aceitas. */
+	double p50_us; /**< Mediana das latências recentes, em µs. */
+	double p99_us; /**< Percentil 99 das latências recentes, em µs. */
+} ServerStats;
+
+/**
+ * @brief Opções do servidor.
+ */
+typedef struct {
+	unsigned threads; /**< Número de threads de trabalho (0 para uma por
+			   * processador). */
+	unsigned window_us; /**< Janela de agrupamento, em microssegundos (0
+			     * para `SERVER_WINDOW_US`). */
+	size_t cache; /**< Número de funções no cache (0 para
+		       * `SERVER_CACHE`). */
+	size_t queue; /**< Número máximo de trabalhos em andamento (0 para
+		       * `SERVER_QUEUE`). */
+	ResultCache *results; /**< Cache de resultados compartilhado pelas
+			       * threads de trabalho, ou `nullptr` para não
+			       * memorizar. */
+} ServerOptions;
+
+/**
+ * @brief Executa o servidor até receber `SIGINT`, `SIGTERM` ou um pedido de
+ * término.
+ *
+ * @details Cria o socket em `path`, substituindo um socket antigo que tenha
+ * ficado no caminho, e o remove ao terminar.
+ *
+ * @param path O caminho do socket.
+ * @param opts Opções do servidor, ou `nullptr` para usar as padrão.
+ * @return `true` se o servidor terminou normalmente, `false` se não pôde ser
+ * iniciado.
+ */
+bool server_run(const char *path, const ServerOptions *opts);
+
+/**
+ * @brief Envia ao servidor os trabalhos de um arquivo e escreve as respostas.
+ *
+ * @details Lê os trabalhos no formato textual de `jobs.h` e envia-os em
+ * grupos de `SERVER_PIPELINE`, lendo as respostas de cada grupo antes de
+ * enviar o próximo. Os resultados são escritos na ordem em que chegam.
+ *
+ * @param path O caminho do socket.
+ * @param in O arquivo de entrada.
+ * @param out O arquivo onde os resultados serão escritos.
+ * @param format O formato da saída.
+ * @return O número de trabalhos com erro, ou -1 se a comunicação falhou.
+ */
+long server_client(const char *path, FILE *in, FILE *out, JobsFormat format);
+
+/**
+ * @brief Obtém as estatísticas de um servidor.
+ *
+ * @param path O caminho do socket.
+ * @param stats Ponteiro onde as estatísticas serão escritas.
+ * @return `true` em caso de sucesso, `false` se a comunicação falhou.
+ */
+bool server_stats(const char *path, ServerStats *stats);
+
+/**
+ * @brief Pede a um servidor que termine.
+ *
+ * @param path O caminho do socket.
+ * @return `true` se o servidor aceitou o pedido, `false` caso contrário.
+ */
+bool server_shutdown(const char *path);
+
+#endif // !SERVER_H
\ No newline at end of file
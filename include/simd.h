@@ -0,0 +1,315 @@
+// SPDX-License-Identifier: ISC
+
+/**
+ * @file simd.h
+ * @brief Declarações dos núcleos vetorizados e do despacho em tempo de
+ * execução.
+ *
+ * @details Este arquivo declara os núcleos SIMD usados na avaliação em lote de
+ * funções, bem como o mecanismo que escolhe, na inicialização do programa, o
+ * conjunto de instruções mais largo suportado pelo processador (SSE2, AVX2 ou
+ * AVX-512). Assim, um mesmo executável roda bem em todas as máquinas, sem que
+ * seja preciso compilá-lo com `-march` específico.
+ */
+
+#pragma once
+#ifndef SIMD_H
+#define SIMD_H
+
+#include <stddef.h>
+
+/**
+ * @brief Níveis de vetorização suportados pelos núcleos.
+ * @details Os níveis são ordenados do mais estreito para o mais largo, de modo
+ * que podem ser comparados entre si.
+ */
+typedef enum {
+	SIMD_SCALAR, /**< Sem vetorização explícita. */
+	SIMD_SSE2, /**< 2 `double` por registrador, 4 pontos por iteração. */
+	SIMD_AVX2, /**< 4 `double` por registrador (com FMA), 8 pontos por
+		    * iteração. */
+	SIMD_AVX512 /**< 8 `double` por registrador, 16 pontos por
+		     * iteração. */
+} SimdLevel;
+
+/**
+ * @brief Limite da diferença entre a avaliação vetorizada e a escalar.
+ *
+ * @details Os núcleos vetorizados avaliam o polinômio pela regra de Horner,
+ * enquanto `polynomial_eval()` soma os termos \f$c_i x^i\f$ um a um. Ambos os
+ * métodos têm erro direto limitado por \f$\gamma_{2d} \sum |c_i| |x|^i\f$,
+ * onde \f$d\f$ é o grau, \f$u = 2^{-53}\f$ e \f$\gamma_k = ku / (1 - ku)\f$.
+ * Logo, a diferença entre os dois resultados é de no máximo
+ * \f$4du \sum |c_i| |x|^i\f$ (desprezando termos de ordem \f$u^2\f$). Quando
+ * todos os termos têm o mesmo sinal, isto equivale a no máximo \f$4d\f$ ULPs
+ * do resultado; quando há cancelamento, o limite em ULPs cresce com o número
+ * de condição do polinômio em \f$x\f$.
+ *
+ * Esta macro fornece o fator \f$4d\f$, em unidades de \f$u\f$, que multiplica
+ * \f$\sum |c_i| |x|^i\f$.
+ *
+ * @param degree O grau do polinômio.
+ */
+#define SIMD_POLY_ERROR_BOUND(degree) (4.0 * ((degree) > 0 ? (degree) : 1))
+
+/**
+ * @brief Maior grau aceito por `simd_power_sums()`.
+ */
+#define SIMD_POWERS_MAX_DEGREE 64
+
+/**
+ * @brief Número de pontos processados simultaneamente por `simd_power_sums()`.
+ */
+#define SIMD_POWERS_LANES 8
+
+/**
+ * @brief Maior grau aceito por `simd_poly_sum_f32()` e `simd_poly_sum_dd()`.
+ */
+#define SIMD_SUM_MAX_DEGREE 64
+
+/**
+ * @brief Número de pontos processados simultaneamente por
+ * `simd_poly_sum_f32()`.
+ *
+ * @details Um registrador AVX-512 comporta 16 `float`; com o dobro disso, há
+ * ao menos duas cadeias de Horner independentes em cada nível, o que esconde
+ * parte da latência das operações.
+ */
+#define SIMD_F32_LANES 32
+
+/**
+ * @brief Número de pontos processados simultaneamente por
+ * `simd_poly_sum_dd()`.
+ */
+#define SIMD_DD_LANES 8
+
+/**
+ * @brief Número de pontos processados simultaneamente pelos núcleos de
+ * funções elementares (`simd_exp()`, `simd_log()` e `simd_sin()`).
+ */
+#define SIMD_MATH_LANES 8
+
+/**
+ * @brief Maior erro de `simd_exp()`, em ULPs do resultado.
+ *
+ * @details A redução \f$x = k \ln 2 + r\f$, com \f$|r| \le \ln 2 / 2\f$, é
+ * exata até o último arredondamento (\f$\ln 2\f$ dividido em duas partes, a
+ * primeira com os 32 bits altos), e \f$e^r\f$ é aproximada pela série de
+ * Taylor de grau 13, cujo erro de truncamento é menor que \f$2^{-57}\f$. O
+ * maior erro medido, em \f$10^8\f$ pontos de \f$[-708, 708]\f$, foi de
+ * 1,17 ULP.
+ */
+#define SIMD_EXP_MAX_ULP 1.5
+
+/**
+ * @brief Maior erro de `simd_log()`, em ULPs do resultado.
+ *
+ * @details Com \f$x = 2^k m\f$ e \f$m \in [\sqrt{2}/2, \sqrt{2})\f$, usa
+ * \f$\log m = 2 \operatorname{atanh}(s)\f$, com \f$s = (m - 1) / (m + 1)\f$,
+ * aproximado pelo polinômio de grau 14 em \f$s\f$ da fdlibm, e soma
+ * \f$k \ln 2\f$ em duas partes. O maior erro medido, em \f$10^8\f$ pontos
+ * de \f$[10^{-300}, 10^{300}]\f$, foi de 0,83 ULP.
+ */
+#define SIMD_LOG_MAX_ULP 1.0
+
+/**
+ * @brief Maior argumento, em valor absoluto, reduzido pelo núcleo
+ * vetorizado de `simd_sin()`.
+ *
+ * @details Com \f$|k| \le 2^{20}\f$, os produtos de \f$k\f$ pelas duas
+ * primeiras partes de \f$\pi / 2\f$, de 33 bits cada, são exatos. Acima
+ * deste limite, e para os valores não finitos, o ponto é avaliado por
+ * `sin()` da biblioteca padrão.
+ */
+#define SIMD_SIN_MAX_ARG 0x1p19
+
+/**
+ * @brief Maior erro de `simd_sin()`, em ULPs do resultado, para
+ * \f$|x| \le\f$ `SIMD_SIN_MAX_ARG`.
+ *
+ * @details A redução \f$x = k \pi / 2 + r\f$, com \f$|r| \le \pi / 4\f$, usa
+ * \f$\pi / 2\f$ em três partes (Cody e Waite), e \f$\sin r\f$ e
+ * \f$\cos r\f$ são aproximados pelos polinômios da fdlibm, escolhidos e com
+ * o sinal trocado conforme \f$k \bmod 4\f$. O maior erro medido foi de
+ * 1,42 ULP em \f$[-10, 10]\f$ e de 2,40 ULPs em
+ * \f$[-5 \cdot 10^5, 5 \cdot 10^5]\f$, onde a redução perde alguns bits.
+ */
+#define SIMD_SIN_MAX_ULP 2.5
+
+/**
+ * @brief Retorna o nível de vetorização usado atualmente pelos núcleos.
+ *
+ * @return O nível selecionado na inicialização, ou o definido por
+ * `simd_set_level()`.
+ */
+SimdLevel simd_level(void);
+
+/**
+ * @brief Força o uso de um nível de vetorização.
+ *
+ * @details Útil para comparar os núcleos entre si. Se o processador não
+ * suportar o nível pedido, usa o mais largo que ele suporta abaixo dele. O
+ * nível inicial pode também ser limitado pela variável de ambiente
+ * `RIEMANN_SIMD` (`scalar`, `sse2`, `avx2` ou `avx512`).
+ *
+ * @param level O nível desejado.
+ * @return O nível efetivamente selecionado.
+ * @note Esta função não é segura para uso concorrente com os núcleos.
+ */
+SimdLevel simd_set_level(SimdLevel level);
+
+/**
+ * @brief Retorna o nome legível de um nível de vetorização.
+ *
+ * @param level O nível.
+ * @return Uma string estática, como `"avx2"`.
+ */
+const char *simd_level_name(SimdLevel level);
+
+/**
+ * @brief Avalia um polinômio em vários pontos pela regra de Horner, usando o
+ * núcleo vetorizado selecionado.
+ *
+ * @details Cada ponto ocupa uma lane de um registrador vetorial, e a regra de
+ * Horner é aplicada a todas as lanes simultaneamente. Os resultados diferem de
+ * `polynomial_eval()` em no máximo o limite de `SIMD_POLY_ERROR_BOUND`. No
+ * nível `SIMD_SCALAR`, a função não deve ser chamada; o chamador deve usar seu
+ * próprio laço escalar.
+ *
+ * @param coeffs Coeficientes do polinômio, em ordem crescente de grau.
+ * @param degree O grau do polinômio.
+ * @param x Arranjo com os pontos em que o polinômio será avaliado.
+ * @param y Arranjo onde os resultados serão escritos.
+ * @param count Número de pontos a avaliar.
+ */
+void simd_poly_horner(const double *coeffs, size_t degree, const double *x,
+		      double *y, size_t count);
+
+/**
+ * @brief Soma as potências dos pontos de uma grade uniforme, usando o núcleo
+ * vetorizado selecionado.
+ *
+ * @details Calcula, para cada \f$k\f$ de 0 a `degree`,
+ * \f[
+ * s_k = \sum_{i = \text{first}}^{\text{first} + \text{count} - 1}
+ * (a + i \Delta x)^k.
+ * \f]
+ * Cada lane de um vetor de `SIMD_POWERS_LANES` pontos acumula as suas próprias
+ * somas, que são combinadas no final, sempre na mesma ordem; o resultado é o
+ * mesmo em todos os níveis de vetorização. Ao contrário de
+ * `simd_poly_horner()`, pode ser chamada também no nível `SIMD_SCALAR`.
+ *
+ * @param a Origem da grade.
+ * @param dx Espaçamento da grade.
+ * @param first Índice do primeiro ponto.
+ * @param count Número de pontos.
+ * @param degree Maior potência, até `SIMD_POWERS_MAX_DEGREE`.
+ * @param sums Arranjo de `degree + 1` posições onde as somas serão escritas.
+ */
+void simd_power_sums(double a, double dx, size_t first, size_t count,
+		     size_t degree, double *sums);
+
+/**
+ * @brief Soma os valores de um polinômio numa grade uniforme em precisão
+ * simples, usando o núcleo vetorizado selecionado.
+ *
+ * @details Calcula \f$\sum_{j=0}^{\text{count}-1} p(x_0 + j \Delta x)\f$
+ * inteiramente em `float`: as abscissas, a regra de Horner e a soma. Cada
+ * lane de um vetor de `SIMD_F32_LANES` pontos acumula a sua própria soma, e
+ * as somas das lanes são combinadas no final, sempre na mesma ordem. Como
+ * não se usa FMA, o resultado é o mesmo em todos os níveis de vetorização.
+ *
+ * Cada registrador comporta o dobro de pontos da precisão dupla, mas o erro
+ * relativo de cada valor é da ordem de \f$2^{-24}\f$ (vezes o número de
+ * condição do polinômio), e o da soma cresce com `count`. Serve para triagens
+ * grosseiras, com `count` pequeno (ver `RIEMANN_FLOAT`).
+ *
+ * @param coeffs Coeficientes do polinômio, em ordem crescente de grau.
+ * @param degree O grau do polinômio, até `SIMD_SUM_MAX_DEGREE`.
+ * @param x0 O primeiro ponto da grade.
+ * @param dx Espaçamento da grade.
+ * @param count Número de pontos.
+ * @return A soma.
+ */
+float simd_poly_sum_f32(const float *coeffs, size_t degree, float x0,
+			float dx, size_t count);
+
+/**
+ * @brief Soma os valores de um polinômio numa grade uniforme em precisão
+ * dupla-dupla, usando o núcleo vetorizado selecionado.
+ *
+ * @details Calcula \f$\sum_{i = \text{first}}^{\text{first} + \text{count}
+ * - 1} p(a + i \Delta x)\f$, com os pontos arredondados para `double` como
+ * na soma comum. Cada valor é avaliado pela regra de Horner compensada
+ * (Graillat, Langlois e Louvet), em que os erros de cada produto e de cada
+ * soma, obtidos pelas transformações exatas TwoProduct (pela divisão de
+ * Dekker, sem FMA) e TwoSum, são acumulados numa segunda regra de Horner. O
+ * valor resultante, um par \f$(h, l)\f$, é tão preciso quanto se fosse
+ * calculado com o dobro da precisão e arredondado para `double`. As somas
+ * dos valores são acumuladas em pares dupla-dupla, uma por lane de um vetor
+ * de `SIMD_DD_LANES` pontos, e combinadas no final, sempre na mesma ordem; o
+ * resultado é o mesmo em todos os níveis.
+ *
+ * @param coeffs Coeficientes do polinômio, em ordem crescente de grau.
+ * @param degree O grau do polinômio, até `SIMD_SUM_MAX_DEGREE`.
+ * @param a Origem da grade.
+ * @param dx Espaçamento da grade.
+ * @param first Índice do primeiro ponto.
+ * @param count Número de pontos.
+ * @param sum Arranjo onde a soma será escrita, como a parte alta seguida da
+ * parte baixa (com \f$|\text{sum}[1]| \le \text{ulp}(\text{sum}[0]) / 2\f$).
+ */
+void simd_poly_sum_dd(const double *coeffs, size_t degree, double a,
+		      double dx, size_t first, size_t count, double sum[2]);
+
+/**
+ * @brief Calcula a exponencial de vários pontos, usando o núcleo vetorizado
+ * selecionado.
+ *
+ * @details Os pontos são processados em grupos de `SIMD_MATH_LANES`, e toda a
+ * redução de argumento é feita nas lanes: o inteiro \f$k\f$ é obtido somando
+ * e subtraindo \f$1{,}5 \cdot 2^{52}\f$, e \f$2^k\f$ é montado
+ * diretamente nos bits do expoente. As lanes com \f$|x| > 708\f$ (onde o
+ * resultado transborda ou é subnormal) ou \f$x\f$ não numérico são
+ * recalculadas por `exp()`, depois do grupo. Nos níveis abaixo de
+ * `SIMD_AVX2`, em que as lanes não são mais rápidas que a biblioteca padrão,
+ * todos os pontos são avaliados por `exp()`. O erro é de no máximo
+ * `SIMD_EXP_MAX_ULP`.
+ *
+ * @param x Arranjo com os pontos.
+ * @param y Arranjo onde os resultados serão escritos. Pode ser o próprio `x`.
+ * @param count Número de pontos.
+ */
+void simd_exp(const double *x, double *y, size_t count);
+
+/**
+ * @brief Calcula o logaritmo natural de vários pontos, usando o núcleo
+ * vetorizado selecionado.
+ *
+ * @details Organizado como `simd_exp()`: o expoente e a mantissa são
+ * extraídos dos bits de cada lane, e as lanes com \f$x\f$ não positivo,
+ * subnormal, infinito ou não numérico são recalculadas por `log()`. O erro é
+ * de no máximo `SIMD_LOG_MAX_ULP`.
+ *
+ * @param x Arranjo com os pontos.
+ * @param y Arranjo onde os resultados serão escritos. Pode ser o próprio `x`.
+ * @param count Número de pontos.
+ */
+void simd_log(const double *x, double *y, size_t count);
+
+/**
+ * @brief Calcula o seno de vários pontos, usando o núcleo vetorizado
+ * selecionado.
+ *
+ * @details Organizado como `simd_exp()`. As lanes com \f$|x| >\f$
+ * `SIMD_SIN_MAX_ARG` ou \f$x\f$ não finito são recalculadas por `sin()`, e
+ * as com \f$|x| < 2^{-26}\f$ recebem o próprio \f$x\f$ (preservando o sinal
+ * de zero). O erro é de no máximo `SIMD_SIN_MAX_ULP`.
+ *
+ * @param x Arranjo com os pontos.
+ * @param y Arranjo onde os resultados serão escritos. Pode ser o próprio `x`.
+ * @param count Número de pontos.
+ */
+void simd_sin(const double *x, double *y, size_t count);
+
+#endif // !SIMD_H
\ No newline at end of file
@@ -0,0 +1,183 @@
+// SPDX-License-Identifier: ISC
+
+/**
+ * @file tabulated.h
+ * @brief Declarações das funções tabeladas, dadas por amostras num arquivo.
+ *
+ * @details Este arquivo declara o tipo `Tabulated`, que implementa funções
+ * dadas por amostras medidas, e não por uma fórmula. As amostras ficam num
+ * arquivo binário mapeado na memória, com um cabeçalho (`TabulatedHeader`) de
+ * 64 bytes seguido de um arranjo de `double`, em um de dois leiautes:
+ *
+ * - `TABULATED_PAIRS`: pares \f$(x_i, y_i)\f$ intercalados, com as abscissas
+ *   estritamente crescentes;
+ * - `TABULATED_UNIFORM`: somente os \f$y_i\f$, com
+ *   \f$x_i = x_0 + i \Delta x\f$.
+ *
+ * Entre as amostras, a função é interpolada linearmente ou por uma cúbica de
+ * Hermite, cujas derivadas nas amostras são estimadas pelas diferenças
+ * centradas dos vizinhos. Fora do intervalo das amostras, a função é
+ * estendida pelo valor da amostra mais próxima.
+ *
+ * Como o arquivo é apenas mapeado, a função pode ser maior que a memória: as
+ * páginas são lidas sob demanda. Para integrar a interpolação inteira,
+ * `tabulated_integrate()` percorre o arquivo uma única vez, em ordem, sem
+ * manter nada além de uma janela.
+ */
+
+#pragma once
+#ifndef TABULATED_H
+#define TABULATED_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Versão do formato do arquivo de amostras.
+ */
+#define TABULATED_VERSION 1
+
+/**
+ * @brief Valor gravado no cabeçalho para verificar a ordem de bytes.
+ */
+#define TABULATED_BYTE_ORDER 0x01020304
+
+/**
+ * @brief Tamanho, em bytes, da janela de leitura de `tabulated_integrate()`.
+ *
+ * @details A janela seguinte é pedida ao sistema (leitura antecipada)
+ * enquanto a atual é processada, e a anterior é descartada do mapeamento.
+ */
+#define TABULATED_WINDOW ((size_t)1 << 23)
+
+/**
+ * @brief Leiautes das amostras no arquivo.
+ */
+typedef enum {
+	TABULATED_PAIRS, /**< Pares \f$(x_i, y_i)\f$ intercalados. */
+	TABULATED_UNIFORM /**< Somente \f$y_i\f$, igualmente espaçados. */
+} TabulatedLayout;
+
+/**
+ * @brief Métodos de interpolação entre as amostras.
+ */
+typedef enum {
+	TABULATED_LINEAR, /**< Interpolação linear. */
+	TABULATED_CUBIC /**< Cúbica de Hermite com derivadas centradas. */
+} TabulatedInterp;
+
+/**
+ * @brief Cabeçalho de um arquivo de amostras.
+ */
+typedef struct {
+	char magic[8]; /**< Identificação do formato: `"RIEMTABL"`. */
+	uint32_t version; /**< Versão do formato (`TABULATED_VERSION`). */
+	uint32_t byte_order; /**< `TABULATED_BYTE_ORDER`. */
+	uint32_t header_size; /**< Tamanho deste cabeçalho, em bytes. */
+	uint32_t layout; /**< Leiaute das amostras (`TabulatedLayout`). */
+	uint64_t count; /**< Número de amostras (pelo menos 2). */
+	double x0; /**< Primeira abscissa, no leiaute uniforme. */
+	double dx; /**< Espaçamento positivo, no leiaute uniforme. */
+	uint64_t reserved[2]; /**< Reservado; deve ser zero. */
+} TabulatedHeader;
+
+/**
+ * @brief Função tabelada. Sua definição é opaca.
+ */
+typedef struct Tabulated Tabulated;
+
+/**
+ * @brief Mapeia e valida um arquivo de amostras.
+ *
+ * @details Além do cabeçalho, verifica no leiaute de pares que as abscissas
+ * são estritamente crescentes, o que lê todas as amostras uma vez.
+ *
+ * @param path O caminho do arquivo.
+ * @param interp O método de interpolação.
+ * @return Ponteiro para a função tabelada, ou `nullptr` se o arquivo não pôde
+ * ser mapeado ou não estiver no formato esperado.
+ * @note Ignorar o retorno pode causar vazamento de memória.
+ */
+[[nodiscard("Ignorar retorno pode causar vazamento de memória")]]
+Tabulated *tabulated_open(const char *path, TabulatedInterp interp);
+
+/**
+ * @brief Desfaz o mapeamento e libera uma função tabelada.
+ *
+ * @param tab Ponteiro para a função tabelada.
+ */
+void tabulated_free(Tabulated *tab);
+
+/**
+ * @brief Avalia uma função tabelada em um ponto.
+ *
+ * @details Localiza o intervalo entre amostras que contém \f$x\f$ (em tempo
+ * constante no leiaute uniforme, por busca binária no de pares) e o
+ * interpola.
+ *
+ * @param x O valor em que a função será avaliada.
+ * @param tab Ponteiro para a função tabelada.
+ * @return O valor interpolado em `x`.
+ */
+double tabulated_eval(double x, Tabulated *tab);
+
+/**
+ * @brief Avalia uma função tabelada em vários pontos.
+ *
+ * @details No leiaute de pares, a busca de cada ponto começa no intervalo do
+ * ponto anterior, de modo que pontos crescentes (como os de uma grade) custam
+ * tempo constante amortizado. O resultado é idêntico ao de
+ * `tabulated_eval()`.
+ *
+ * @param x Arranjo com os pontos em que a função será avaliada.
+ * @param y Arranjo onde os resultados serão escritos.
+ * @param count Número de pontos a avaliar.
+ * @param tab Ponteiro para a função tabelada.
+ */
+void tabulated_eval_batch(const double *x, double *y, size_t count,
+			  Tabulated *tab);
+
+/**
+ * @brief Retorna o intervalo coberto pelas amostras.
+ *
+ * @param tab Ponteiro para a função tabelada.
+ * @param min Ponteiro onde a primeira abscissa será escrita.
+ * @param max Ponteiro onde a última abscissa será escrita.
+ */
+void tabulated_domain(const Tabulated *tab, double *min, double *max);
+
+/**
+ * @brief Grava amostras num arquivo no formato de `tabulated_open()`.
+ *
+ * @param path O caminho do arquivo a criar ou substituir.
+ * @param layout O leiaute das amostras.
+ * @param x0 A primeira abscissa, no leiaute uniforme (ignorada no outro).
+ * @param dx O espaçamento, no leiaute uniforme (ignorado no outro).
+ * @param data As amostras: `count` pares intercalados ou `count` ordenadas.
+ * @param count O número de amostras (pelo menos 2).
+ * @return `true` em caso de sucesso, `false` em caso de erro de E/S.
+ */
+bool tabulated_save(const char *path, TabulatedLayout layout, double x0,
+		    double dx, const double *data, size_t count);
+
+/**
+ * @brief Integra exatamente a interpolação de um arquivo de amostras, numa
+ * única passada sequencial.
+ *
+ * @details O arquivo é mapeado com o aviso de acesso sequencial e percorrido
+ * em janelas de `TABULATED_WINDOW` bytes: a leitura da janela seguinte é
+ * antecipada, e a janela anterior é descartada do mapeamento, de modo que o
+ * consumo de memória não depende do tamanho do arquivo. A integral de cada
+ * intervalo é exata para a interpolação escolhida (a regra do trapézio, na
+ * linear) e as integrais são acumuladas com a soma compensada de Neumaier.
+ *
+ * @param path O caminho do arquivo.
+ * @param interp O método de interpolação.
+ * @param out Ponteiro onde a integral será escrita.
+ * @return `true` em caso de sucesso, `false` se o arquivo for inválido (ou
+ * tiver abscissas que não sejam estritamente crescentes).
+ */
+bool tabulated_integrate(const char *path, TabulatedInterp interp,
+			 double *out);
+
+#endif // !TABULATED_H
\ No newline at end of file
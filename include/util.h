@@ -6,8 +6,9 @@
  *
  * @details Este arquivo contém declarações de utilidades diversas que podem
  * ser usadas em várias partes do projeto. Atualmente, ele define uma macro
- * para verificação de erros (`ERRNOCHECK`), mas outras utilidades miscelâneas
- * poderão ser adicionadas futuramente.
+ * para verificação de erros (`ERRNOCHECK`) e o passo da soma compensada de
+ * Neumaier (`neumaier_add()`), mas outras utilidades miscelâneas poderão ser
+ * adicionadas futuramente.
  */
 
 #pragma once
@@ -15,6 +16,7 @@
 #define UTIL_H
 
 #include <errno.h>
+#include <math.h>
 
 /**
  * @brief Macro para verificação de erros e redirecionamento de fluxo.
@@ -40,4 +42,25 @@
 		}                                                      \
 	} while (0)
 
+/**
+ * @brief Acumula um valor numa soma compensada de Neumaier.
+ *
+ * @details O erro de arredondamento de cada adição é acumulado à parte, em
+ * `comp`, e o resultado da soma é \f$\text{sum} + \text{comp}\f$.
+ * Diferentemente da soma de Kahan, a compensação continua correta quando o
+ * valor somado é maior que a soma.
+ *
+ * @param sum Ponteiro para a soma.
+ * @param comp Ponteiro para a compensação.
+ * @param value O valor a somar.
+ */
+static inline void neumaier_add(double *sum, double *comp, double value)
+{
+	double t = *sum + value;
+
+	*comp += fabs(*sum) >= fabs(value) ? (*sum - t) + value :
+					     (value - t) + *sum;
+	*sum = t;
+}
+
 #endif // !UTIL_H
\ No newline at end of file
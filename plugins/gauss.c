@@ -0,0 +1,143 @@
+// SPDX-License-Identifier: ISC
+
+/**
+ * @file gauss.c
+ * @brief Plugin de exemplo: a gaussiana
+ * \f$a \exp(-(x - \mu)^2 / (2 \sigma^2))\f$.
+ *
+ * @details Os parâmetros são pares `nome=valor` separados por vírgulas, como
+ * `"a=2,mu=0.5,sigma=0.1"`; os omitidos valem \f$a = 1\f$, \f$\mu = 0\f$ e
+ * \f$\sigma = 1\f$. A integral em toda a reta é
+ * \f$a \sigma \sqrt{2 \pi}\f$.
+ *
+ * Compilado com `make plugins`, que gera `build/plugins/gauss.so`, e
+ * integrado com:
+ * @code
+ * build/main --plugin build/plugins/gauss.so -8 8 1000000 sigma=2
+ * @endcode
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "plugin.h"
+
+/**
+ * @brief Estado da gaussiana.
+ */
+typedef struct {
+	double a; /**< Amplitude. */
+	double mu; /**< Centro. */
+	double k; /**< \f$-1 / (2 \sigma^2)\f$. */
+} Gauss;
+
+// Declarações internas.
+static int gauss_init(const char *params, void **state);
+static void gauss_destroy(void *state);
+static double gauss_eval(double x, void *state);
+static void gauss_eval_batch(const double *x, double *y, size_t count,
+			     void *state);
+
+/**
+ * @brief Tabela de símbolos do plugin.
+ */
+const RiemannPlugin riemann_plugin_v1 = {
+	.abi = RIEMANN_PLUGIN_ABI,
+	.size = sizeof(RiemannPlugin),
+	.name = "gauss",
+	.init = &gauss_init,
+	.destroy = &gauss_destroy,
+	.eval = &gauss_eval,
+	.eval_batch = &gauss_eval_batch,
+};
+
+/**
+ * @brief Lê os parâmetros e cria o estado da gaussiana.
+ *
+ * @param params Os parâmetros, ou `nullptr` para os padrão.
+ * @param state Ponteiro onde o estado será escrito.
+ * @return 0 em caso de sucesso, -1 se houver um parâmetro inválido ou faltar
+ * memória.
+ */
+static int gauss_init(const char *params, void **state)
+{
+	double a = 1, mu = 0, sigma = 1;
+
+	for (const char *p = params; p != nullptr && *p != '\0';) {
+		const char *eq = strchr(p, '=');
+		char *end;
+		if (eq == nullptr)
+			return -1;
+
+		double v = strtod(eq + 1, &end);
+		size_t len = eq - p;
+		if (end == eq + 1 || (*end != ',' && *end != '\0'))
+			return -1;
+		if (len == 1 && strncmp(p, "a", len) == 0)
+			a = v;
+		else if (len == 2 && strncmp(p, "mu", len) == 0)
+			mu = v;
+		else if (len == 5 && strncmp(p, "sigma", len) == 0)
+			sigma = v;
+		else
+			return -1;
+		p = *end == ',' ? end + 1 : end;
+	}
+	if (!(sigma > 0))
+		return -1;
+
+	Gauss *g = malloc(sizeof(*g));
+	if (g == nullptr)
+		return -1;
+	*g = (Gauss){ .a = a, .mu = mu, .k = -1 / (2 * sigma * sigma) };
+	*state = g;
+	return 0;
+}
+
+/**
+ * @brief Libera o estado da gaussiana.
+ *
+ * @param state O estado, criado por `gauss_init()`.
+ */
+static void gauss_destroy(void *state)
+{
+	free(state);
+}
+
+/**
+ * @brief Avalia a gaussiana num ponto.
+ *
+ * @param x O ponto.
+ * @param state O estado da gaussiana.
+ * @return O valor da gaussiana em `x`.
+ */
+static double gauss_eval(double x, void *state)
+{
+	const Gauss *g = state;
+	double d = x - g->mu;
+	return g->a * exp(g->k * d * d);
+}
+
+/**
+ * @brief Avalia a gaussiana em vários pontos.
+ *
+ * @details Os parâmetros são lidos uma vez, fora do laço, e cada ponto segue
+ * a mesma sequência de operações de `gauss_eval()`.
+ *
+ * @param x Arranjo com os pontos.
+ * @param y Arranjo onde os resultados serão escritos.
+ * @param count Número de pontos.
+ * @param state O estado da gaussiana.
+ */
+static void gauss_eval_batch(const double *x, double *y, size_t count,
+			     void *state)
+{
+	const Gauss *g = state;
+	double a = g->a, mu = g->mu, k = g->k;
+
+	for (size_t i = 0; i < count; ++i) {
+		double d = x[i] - mu;
+		y[i] = a * exp(k * d * d);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,421 @@
+// SPDX-License-Identifier: ISC
+
+/**
+ * @file cache.c
+ * @brief Implementação do cache de resultados de somas de Riemann.
+ *
+ * @details Cada parte do cache guarda os seus resultados num arranjo fixo de
+ * `capacity` registros, percorrido pelo ponteiro do CLOCK, e localiza-os por
+ * uma tabela de índices com sondagem linear, com pelo menos o dobro de
+ * posições. A remoção de um índice desloca para trás os seguintes da mesma
+ * sequência de sondagem, de modo que a tabela nunca acumula marcas de
+ * remoção.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdalign.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "cache.h"
+#include "func.h"
+#include "riemann.h"
+#include "util.h"
+
+/**
+ * @brief Número de registros lidos ou gravados por chamada de E/S.
+ */
+#define CACHE_CHUNK 1024
+
+/**
+ * @brief Identificação de um arquivo do cache.
+ */
+static const char cache_magic[8] = { 'R', 'I', 'E', 'M', 'C', 'A', 'C', 'H' };
+
+/**
+ * @brief Uma parte independente do cache.
+ *
+ * @details Alinhada à linha de cache, para que as travas de partes vizinhas
+ * não compartilhem linhas.
+ */
+typedef struct {
+	alignas(64) pthread_mutex_t lock; /**< Protege os campos abaixo. */
+	CacheRecord *records; /**< Os resultados. */
+	uint64_t *hashes; /**< O hash da chave de cada resultado. */
+	bool *referenced; /**< O bit de referência de cada resultado. */
+	uint32_t *index; /**< A tabela de índices: o registro mais um, ou 0 se
+			  * a posição estiver vazia. */
+	size_t mask; /**< Número de posições da tabela, menos um. */
+	size_t capacity; /**< Número máximo de resultados. */
+	size_t count; /**< Número de resultados. */
+	size_t hand; /**< O ponteiro do CLOCK. */
+	uint64_t hits; /**< Consultas que encontraram o resultado. */
+	uint64_t misses; /**< Consultas que não o encontraram. */
+	uint64_t insertions; /**< Resultados inseridos. */
+	uint64_t evictions; /**< Resultados descartados. */
+} CacheShard;
+
+/**
+ * @brief Estrutura que define um cache de resultados.
+ */
+struct ResultCache {
+	CacheShard shards[CACHE_SHARDS]; /**< As partes. */
+};
+
+// Declarações internas.
+static uint64_t cache_hash(const CacheKey *key);
+static size_t cache_find(const CacheShard *s, const CacheKey *key,
+			 uint64_t hash);
+static void cache_unlink(CacheShard *s, size_t record);
+
+// Cria um cache de resultados vazio.
+[[nodiscard("Ignorar retorno pode causar vazamento de memória")]]
+ResultCache *cache_new(size_t capacity)
+{
+	if (capacity == 0)
+		capacity = CACHE_CAPACITY;
+	size_t per_shard = (capacity + CACHE_SHARDS - 1) / CACHE_SHARDS;
+	size_t size = 1;
+	while (size < 2 * per_shard)
+		size <<= 1;
+
+	errno = EINVAL;
+	ERRNOCHECK(per_shard >= UINT32_MAX, "Capacidade inválida para o cache",
+		   ret);
+	ResultCache *cache = aligned_alloc(alignof(ResultCache),
+					   sizeof(ResultCache));
+	ERRNOCHECK(cache == nullptr, "Falha ao alocar o cache", ret);
+
+	size_t i = 0;
+	for (; i < CACHE_SHARDS; ++i) {
+		CacheShard *s = &cache->shards[i];
+		*s = (CacheShard){ .mask = size - 1, .capacity = per_shard };
+		s->records = malloc(per_shard * sizeof(*s->records));
+		s->hashes = malloc(per_shard * sizeof(*s->hashes));
+		s->referenced = calloc(per_shard, sizeof(*s->referenced));
+		s->index = calloc(size, sizeof(*s->index));
+		ERRNOCHECK(s->records == nullptr || s->hashes == nullptr ||
+				   s->referenced == nullptr ||
+				   s->index == nullptr,
+			   "Falha ao alocar o cache", free_shards);
+		pthread_mutex_init(&s->lock, nullptr);
+	}
+	return cache;
+
+free_shards: // Libera também a parte que falhou, que não tem trava.
+	free(cache->shards[i].index);
+	free(cache->shards[i].referenced);
+	free(cache->shards[i].hashes);
+	free(cache->shards[i].records);
+	while (i-- > 0) {
+		CacheShard *s = &cache->shards[i];
+		pthread_mutex_destroy(&s->lock);
+		free(s->index);
+		free(s->referenced);
+		free(s->hashes);
+		free(s->records);
+	}
+	free(cache);
+ret:
+	return nullptr;
+}
+
+// Libera um cache de resultados.
+void cache_free(ResultCache *cache)
+{
+	for (size_t i = 0; i < CACHE_SHARDS; ++i) {
+		CacheShard *s = &cache->shards[i];
+		pthread_mutex_destroy(&s->lock);
+		free(s->index);
+		free(s->referenced);
+		free(s->hashes);
+		free(s->records);
+	}
+	free(cache);
+}
+
+// Monta a chave canônica de uma soma de Riemann.
+bool cache_key(CacheKey *key, const Function *func, double min, double max,
+	       size_t n, SumType type, const RiemannOptions *opts)
+{
+	memset(key, 0, sizeof(*key));
+	if (!function_digest(func, key->digest))
+		return false;
+
+	memcpy(&key->min, &min, sizeof(min));
+	memcpy(&key->max, &max, sizeof(max));
+	key->n = n;
+	key->type = type;
+	key->flags = (opts->brute_force ? CACHE_BRUTE_FORCE : 0) |
+		     (uint32_t)opts->precision << CACHE_PRECISION_SHIFT;
+	return true;
+}
+
+// Procura um resultado no cache.
+bool cache_lookup(ResultCache *cache, const CacheKey *key, double *value)
+{
+	uint64_t hash = cache_hash(key);
+	CacheShard *s = &cache->shards[hash >> 60 & (CACHE_SHARDS - 1)];
+	bool found = false;
+
+	pthread_mutex_lock(&s->lock);
+	size_t pos = cache_find(s, key, hash);
+	if (s->index[pos] != 0) {
+		size_t r = s->index[pos] - 1;
+		s->referenced[r] = true;
+		*value = s->records[r].value;
+		found = true;
+		++s->hits;
+	} else {
+		++s->misses;
+	}
+	pthread_mutex_unlock(&s->lock);
+
+	return found;
+}
+
+// Insere ou atualiza um resultado no cache.
+void cache_insert(ResultCache *cache, const CacheKey *key, double value)
+{
+	uint64_t hash = cache_hash(key);
+	CacheShard *s = &cache->shards[hash >> 60 & (CACHE_SHARDS - 1)];
+
+	pthread_mutex_lock(&s->lock);
+	size_t pos = cache_find(s, key, hash);
+	if (s->index[pos] != 0) {
+		s->records[s->index[pos] - 1].value = value;
+		pthread_mutex_unlock(&s->lock);
+		return;
+	}
+
+	size_t r;
+	if (s->count < s->capacity) {
+		r = s->count++;
+	} else {
+		// CLOCK: limpa os bits de referência até achar um registro
+		// não consultado desde a última passagem, e descarta-o.
+		while (s->referenced[s->hand]) {
+			s->referenced[s->hand] = false;
+			s->hand = (s->hand + 1) % s->capacity;
+		}
+		r = s->hand;
+		s->hand = (s->hand + 1) % s->capacity;
+		cache_unlink(s, r);
+		++s->evictions;
+
+		// A remoção pode ter deslocado a posição livre da chave.
+		pos = cache_find(s, key, hash);
+	}
+
+	s->records[r] = (CacheRecord){ *key, value };
+	s->hashes[r] = hash;
+	s->referenced[r] = false;
+	s->index[pos] = r + 1;
+	++s->insertions;
+	pthread_mutex_unlock(&s->lock);
+}
+
+// Lê os contadores de um cache.
+void cache_stats(ResultCache *cache, CacheStats *stats)
+{
+	*stats = (CacheStats){ 0 };
+	for (size_t i = 0; i < CACHE_SHARDS; ++i) {
+		CacheShard *s = &cache->shards[i];
+
+		pthread_mutex_lock(&s->lock);
+		stats->hits += s->hits;
+		stats->misses += s->misses;
+		stats->insertions += s->insertions;
+		stats->evictions += s->evictions;
+		stats->size += s->count;
+		stats->capacity += s->capacity;
+		pthread_mutex_unlock(&s->lock);
+	}
+}
+
+// Grava o conteúdo de um cache num arquivo.
+bool cache_save(ResultCache *cache, const char *path)
+{
+	CacheFileHeader h = {
+		.version = CACHE_VERSION,
+		.byte_order = CACHE_BYTE_ORDER,
+		.header_size = sizeof(CacheFileHeader),
+		.record_size = sizeof(CacheRecord),
+	};
+	memcpy(h.magic, cache_magic, sizeof(cache_magic));
+
+	// Escreve num arquivo temporário, renomeado só se tudo der certo.
+	size_t len = strlen(path);
+	char *tmp = malloc(len + sizeof(".tmp"));
+	ERRNOCHECK(tmp == nullptr, "Falha ao alocar o nome do arquivo", ret);
+	memcpy(tmp, path, len);
+	memcpy(tmp + len, ".tmp", sizeof(".tmp"));
+
+	FILE *out = fopen(tmp, "wb");
+	ERRNOCHECK(out == nullptr, tmp, free_tmp);
+	ERRNOCHECK(fwrite(&h, sizeof(h), 1, out) != 1,
+		   "Falha ao gravar o cache", close_out);
+
+	// Grava as partes uma de cada vez, cada uma sob a sua trava.
+	for (size_t i = 0; i < CACHE_SHARDS; ++i) {
+		CacheShard *s = &cache->shards[i];
+
+		pthread_mutex_lock(&s->lock);
+		size_t written = fwrite(s->records, sizeof(*s->records),
+					s->count, out);
+		bool ok = written == s->count;
+		h.count += s->count;
+		pthread_mutex_unlock(&s->lock);
+		ERRNOCHECK(!ok, "Falha ao gravar o cache", close_out);
+	}
+
+	// Completa o cabeçalho com o número de registros.
+	ERRNOCHECK(fseek(out, 0, SEEK_SET) != 0 ||
+			   fwrite(&h, sizeof(h), 1, out) != 1,
+		   "Falha ao gravar o cache", close_out);
+	ERRNOCHECK(fclose(out) != 0, "Falha ao gravar o cache", unlink_tmp);
+	ERRNOCHECK(rename(tmp, path) != 0, path, unlink_tmp);
+	free(tmp);
+	return true;
+
+close_out:
+	fclose(out);
+unlink_tmp:
+	remove(tmp);
+free_tmp:
+	free(tmp);
+ret:
+	return false;
+}
+
+// Insere num cache os resultados gravados num arquivo.
+long cache_load(ResultCache *cache, const char *path)
+{
+	CacheFileHeader h;
+	CacheRecord buf[CACHE_CHUNK];
+	long loaded = 0;
+
+	// A ausência do arquivo (numa primeira execução) não é um erro a
+	// relatar.
+	FILE *in = fopen(path, "rb");
+	if (in == nullptr && errno == ENOENT)
+		return -1;
+	ERRNOCHECK(in == nullptr, path, ret);
+
+	errno = EINVAL;
+	ERRNOCHECK(fread(&h, sizeof(h), 1, in) != 1 ||
+			   memcmp(h.magic, cache_magic,
+				  sizeof(cache_magic)) != 0 ||
+			   h.version != CACHE_VERSION ||
+			   h.byte_order != CACHE_BYTE_ORDER ||
+			   h.header_size != sizeof(CacheFileHeader) ||
+			   h.record_size != sizeof(CacheRecord),
+		   "Formato inválido do arquivo do cache", close_in);
+
+	for (uint64_t left = h.count; left > 0;) {
+		size_t want = left < CACHE_CHUNK ? left : CACHE_CHUNK;
+		errno = EINVAL;
+		ERRNOCHECK(fread(buf, sizeof(*buf), want, in) != want,
+			   "Arquivo do cache truncado", close_in);
+		for (size_t i = 0; i < want; ++i)
+			cache_insert(cache, &buf[i].key, buf[i].value);
+		loaded += want;
+		left -= want;
+	}
+
+	fclose(in);
+	return loaded;
+
+close_in:
+	fclose(in);
+ret:
+	return -1;
+}
+
+/**
+ * @brief Calcula o hash de uma chave.
+ *
+ * @details Combina as palavras da chave com a função de mistura do
+ * SplitMix64. Os 4 bits mais altos escolhem a parte, e os mais baixos, a
+ * posição inicial na tabela de índices.
+ *
+ * @param key Ponteiro para a chave.
+ * @return O hash.
+ */
+static uint64_t cache_hash(const CacheKey *key)
+{
+	uint64_t words[sizeof(*key) / sizeof(uint64_t)];
+	uint64_t h = 0;
+
+	memcpy(words, key, sizeof(words));
+	for (size_t i = 0; i < sizeof(words) / sizeof(*words); ++i) {
+		h = (h ^ words[i]) + 0x9e3779b97f4a7c15;
+		h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9;
+		h = (h ^ (h >> 27)) * 0x94d049bb133111eb;
+		h ^= h >> 31;
+	}
+	return h;
+}
+
+/**
+ * @brief Procura uma chave na tabela de índices de uma parte.
+ *
+ * @details Deve ser chamada com a trava da parte adquirida.
+ *
+ * @param s Ponteiro para a parte.
+ * @param key Ponteiro para a chave.
+ * @param hash O hash da chave.
+ * @return A posição da tabela com a chave ou, se ela não estiver na parte, a
+ * posição vazia em que seria inserida.
+ */
+static size_t cache_find(const CacheShard *s, const CacheKey *key,
+			 uint64_t hash)
+{
+	size_t pos = hash & s->mask;
+
+	while (s->index[pos] != 0) {
+		size_t r = s->index[pos] - 1;
+		if (s->hashes[r] == hash &&
+		    memcmp(&s->records[r].key, key, sizeof(*key)) == 0)
+			break;
+		pos = (pos + 1) & s->mask;
+	}
+	return pos;
+}
+
+/**
+ * @brief Remove um registro da tabela de índices de uma parte.
+ *
+ * @details Esvazia a posição do registro e desloca para ela os índices
+ * seguintes cuja posição inicial não esteja entre ela e a posição atual
+ * deles (algoritmo R de Knuth), preservando as sequências de sondagem.
+ *
+ * @param s Ponteiro para a parte, com a trava adquirida.
+ * @param record O registro a remover.
+ */
+static void cache_unlink(CacheShard *s, size_t record)
+{
+	size_t i = s->hashes[record] & s->mask;
+
+	while (s->index[i] != record + 1)
+		i = (i + 1) & s->mask;
+
+	for (size_t j = i;;) {
+		j = (j + 1) & s->mask;
+		if (s->index[j] == 0)
+			break;
+
+		// Move o índice de j para i se a sua posição inicial k não
+		// estiver no intervalo circular (i, j].
+		size_t k = s->hashes[s->index[j] - 1] & s->mask;
+		if (i <= j ? (i < k && k <= j) : (i < k || k <= j))
+			continue;
+		s->index[i] = s->index[j];
+		i = j;
+	}
+	s->index[i] = 0;
+}
\ No newline at end of file
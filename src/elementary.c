@@ -0,0 +1,510 @@
+// SPDX-License-Identifier: ISC
+
+/**
+ * @file elementary.c
+ * @brief Implementação das funções elementares.
+ *
+ * @details Cada tipo tem o seu bloco, com o objeto `Function` no início e os
+ * parâmetros logo depois, e o campo `impl` aponta para o próprio bloco. Os
+ * lotes de `EXPONENTIAL`, `LOGARITHM` e `SINUSOID` calculam o argumento em
+ * `y`, aplicam o núcleo vetorizado no lugar e multiplicam pela amplitude, de
+ * modo que cada ponto difere do avaliado por `eval` somente pelo erro do
+ * núcleo.
+ */
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "elementary.h"
+#include "simd.h"
+#include "util.h"
+
+/**
+ * @brief Bloco de uma função \f$a f(b x + c)\f$, com \f$f\f$ igual a
+ * \f$\exp\f$, \f$\log\f$ ou \f$\sin\f$.
+ */
+typedef struct {
+	Function func; /**< O objeto função, no início do bloco. */
+	double a; /**< A amplitude. */
+	double b; /**< A frequência, ou o fator de escala do argumento. */
+	double c; /**< A fase (somente em `SINUSOID`). */
+} ElementaryBlock;
+
+/**
+ * @brief Bloco de uma função racional \f$P(x) / Q(x)\f$.
+ */
+typedef struct {
+	Function func; /**< O objeto função, no início do bloco. */
+	size_t p_degree; /**< O grau do numerador. */
+	size_t q_degree; /**< O grau do denominador. */
+	const double *q; /**< Os coeficientes do denominador, em `coeffs`. */
+	double coeffs[]; /**< Os coeficientes do numerador, seguidos dos do
+			  * denominador, em ordem crescente de grau. */
+} RationalBlock;
+
+/**
+ * @brief Bloco de uma soma de funções.
+ */
+typedef struct {
+	Function func; /**< O objeto função, no início do bloco. */
+	size_t count; /**< O número de termos. */
+	Function *terms[]; /**< Os termos, que pertencem à soma. */
+} SumBlock;
+
+// Declarações internas.
+static Function *elementary_scaled(FunctionType type, double a, double b,
+				   double c);
+static Function *rational_new(size_t p_degree, const double *p,
+			      size_t q_degree, const double *q);
+static Function *sum_new(size_t count, Function **terms);
+static double exponential_eval(double x, void *impl);
+static void exponential_eval_batch(const double *x, double *y, size_t count,
+				   void *impl);
+static double logarithm_eval(double x, void *impl);
+static void logarithm_eval_batch(const double *x, double *y, size_t count,
+				 void *impl);
+static double sinusoid_eval(double x, void *impl);
+static void sinusoid_eval_batch(const double *x, double *y, size_t count,
+				void *impl);
+static double rational_horner(const double *coeffs, size_t degree, double x);
+static void rational_horner_batch(const double *coeffs, size_t degree,
+				  const double *x, double *y, size_t count);
+static double rational_eval(double x, void *impl);
+static void rational_eval_batch(const double *x, double *y, size_t count,
+				void *impl);
+static double sum_eval(double x, void *impl);
+static void sum_eval_batch(const double *x, double *y, size_t count,
+			   void *impl);
+static void sum_term_batch(const Function *term, const double *x, double *y,
+			   size_t count);
+
+// Instancia uma função elementar.
+[[nodiscard("Ignorar retorno pode causar vazamento de memória")]]
+Function *elementary_new(FunctionType type, va_list args)
+{
+	double a, b, c = 0;
+	size_t p_degree, q_degree, count;
+	const double *p, *q;
+
+	switch (type) {
+	case EXPONENTIAL:
+	case LOGARITHM:
+		a = va_arg(args, double);
+		b = va_arg(args, double);
+		return elementary_scaled(type, a, b, c);
+	case SINUSOID:
+		a = va_arg(args, double);
+		b = va_arg(args, double);
+		c = va_arg(args, double);
+		return elementary_scaled(type, a, b, c);
+	case RATIONAL:
+		p_degree = va_arg(args, size_t);
+		p = va_arg(args, const double *);
+		q_degree = va_arg(args, size_t);
+		q = va_arg(args, const double *);
+		return rational_new(p_degree, p, q_degree, q);
+	case SUM:
+		count = va_arg(args, size_t);
+		return sum_new(count, va_arg(args, Function **));
+	default:
+		fprintf(stderr, "Tipo de função elementar desconhecido: %d\n",
+			type);
+		return nullptr;
+	}
+}
+
+// Libera uma função elementar.
+void elementary_free(Function *func)
+{
+	if (func->type == SUM) {
+		SumBlock *s = func->impl;
+		for (size_t t = 0; t < s->count; ++t)
+			function_free(s->terms[t]);
+	}
+	free(func);
+}
+
+/**
+ * @brief Instancia uma função \f$a f(b x + c)\f$.
+ *
+ * @param type `EXPONENTIAL`, `LOGARITHM` ou `SINUSOID`.
+ * @param a A amplitude.
+ * @param b O fator de escala do argumento.
+ * @param c A fase (nula, exceto em `SINUSOID`).
+ * @return Ponteiro para a função criada, ou `nullptr` em caso de erro.
+ */
+static Function *elementary_scaled(FunctionType type, double a, double b,
+				   double c)
+{
+	ElementaryBlock *e = malloc(sizeof(*e));
+	ERRNOCHECK(e == nullptr, "Falha ao alocar função elementar", ret);
+
+	*e = (ElementaryBlock){
+		.func = { .type = type, .impl = e },
+		.a = a,
+		.b = b,
+		.c = c,
+	};
+	switch (type) {
+	case EXPONENTIAL:
+		e->func.eval = &exponential_eval;
+		e->func.eval_batch = &exponential_eval_batch;
+		break;
+	case LOGARITHM:
+		e->func.eval = &logarithm_eval;
+		e->func.eval_batch = &logarithm_eval_batch;
+		break;
+	default:
+		e->func.eval = &sinusoid_eval;
+		e->func.eval_batch = &sinusoid_eval_batch;
+		break;
+	}
+	return (Function *)e;
+
+ret:
+	return nullptr;
+}
+
+/**
+ * @brief Instancia uma função racional.
+ *
+ * @param p_degree O grau do numerador.
+ * @param p Os `p_degree + 1` coeficientes do numerador, em ordem crescente
+ * de grau.
+ * @param q_degree O grau do denominador.
+ * @param q Os `q_degree + 1` coeficientes do denominador, em ordem crescente
+ * de grau.
+ * @return Ponteiro para a função criada, ou `nullptr` em caso de erro.
+ */
+static Function *rational_new(size_t p_degree, const double *p,
+			      size_t q_degree, const double *q)
+{
+	errno = EINVAL;
+	ERRNOCHECK(p == nullptr || q == nullptr,
+		   "Coeficientes da função racional ausentes", ret);
+	ERRNOCHECK(p_degree > SIZE_MAX / sizeof(double) / 2 ||
+			   q_degree > SIZE_MAX / sizeof(double) / 2,
+		   "Grau da função racional grande demais", ret);
+
+	size_t np = p_degree + 1, nq = q_degree + 1;
+	RationalBlock *r = malloc(sizeof(*r) + (np + nq) * sizeof(double));
+	ERRNOCHECK(r == nullptr, "Falha ao alocar função racional", ret);
+
+	r->func = (Function){
+		.type = RATIONAL,
+		.eval = &rational_eval,
+		.eval_batch = &rational_eval_batch,
+		.impl = r,
+	};
+	r->p_degree = p_degree;
+	r->q_degree = q_degree;
+	r->q = r->coeffs + np;
+	memcpy(r->coeffs, p, np * sizeof(double));
+	memcpy(r->coeffs + np, q, nq * sizeof(double));
+	return (Function *)r;
+
+ret:
+	return nullptr;
+}
+
+/**
+ * @brief Instancia uma soma de funções.
+ *
+ * @param count O número de termos, no mínimo 1.
+ * @param terms Os termos. O arranjo é copiado, e os termos passam a pertencer
+ * à soma somente em caso de sucesso.
+ * @return Ponteiro para a função criada, ou `nullptr` em caso de erro.
+ */
+static Function *sum_new(size_t count, Function **terms)
+{
+	errno = EINVAL;
+	ERRNOCHECK(count == 0 || terms == nullptr, "Soma sem termos", ret);
+	for (size_t t = 0; t < count; ++t)
+		ERRNOCHECK(terms[t] == nullptr, "Termo da soma ausente", ret);
+	ERRNOCHECK(count > (SIZE_MAX - sizeof(SumBlock)) / sizeof(*terms),
+		   "Soma com termos demais", ret);
+
+	SumBlock *s = malloc(sizeof(*s) + count * sizeof(*terms));
+	ERRNOCHECK(s == nullptr, "Falha ao alocar soma de funções", ret);
+
+	s->func = (Function){
+		.type = SUM,
+		.eval = &sum_eval,
+		.eval_batch = &sum_eval_batch,
+		.impl = s,
+	};
+	s->count = count;
+	memcpy(s->terms, terms, count * sizeof(*terms));
+	return (Function *)s;
+
+ret:
+	return nullptr;
+}
+
+/**
+ * @brief Avalia \f$a e^{b x}\f$ num ponto.
+ *
+ * @param x O ponto.
+ * @param impl O bloco da função.
+ * @return O valor da função em `x`.
+ */
+static double exponential_eval(double x, void *impl)
+{
+	const ElementaryBlock *e = impl;
+	return e->a * exp(e->b * x);
+}
+
+/**
+ * @brief Avalia \f$a e^{b x}\f$ em vários pontos, com `simd_exp()`.
+ *
+ * @param x Arranjo com os pontos.
+ * @param y Arranjo onde os resultados serão escritos.
+ * @param count Número de pontos.
+ * @param impl O bloco da função.
+ */
+static void exponential_eval_batch(const double *x, double *y, size_t count,
+				   void *impl)
+{
+	const ElementaryBlock *e = impl;
+	double a = e->a, b = e->b;
+
+	for (size_t i = 0; i < count; ++i)
+		y[i] = b * x[i];
+	simd_exp(y, y, count);
+	for (size_t i = 0; i < count; ++i)
+		y[i] *= a;
+}
+
+/**
+ * @brief Avalia \f$a \log(b x)\f$ num ponto.
+ *
+ * @param x O ponto.
+ * @param impl O bloco da função.
+ * @return O valor da função em `x`.
+ */
+static double logarithm_eval(double x, void *impl)
+{
+	const ElementaryBlock *e = impl;
+	return e->a * log(e->b * x);
+}
+
+/**
+ * @brief Avalia \f$a \log(b x)\f$ em vários pontos, com `simd_log()`.
+ *
+ * @param x Arranjo com os pontos.
+ * @param y Arranjo onde os resultados serão escritos.
+ * @param count Número de pontos.
+ * @param impl O bloco da função.
+ */
+static void logarithm_eval_batch(const double *x, double *y, size_t count,
+				 void *impl)
+{
+	const ElementaryBlock *e = impl;
+	double a = e->a, b = e->b;
+
+	for (size_t i = 0; i < count; ++i)
+		y[i] = b * x[i];
+	simd_log(y, y, count);
+	for (size_t i = 0; i < count; ++i)
+		y[i] *= a;
+}
+
+/**
+ * @brief Avalia \f$a \sin(b x + c)\f$ num ponto.
+ *
+ * @param x O ponto.
+ * @param impl O bloco da função.
+ * @return O valor da função em `x`.
+ */
+static double sinusoid_eval(double x, void *impl)
+{
+	const ElementaryBlock *e = impl;
+	return e->a * sin(e->b * x + e->c);
+}
+
+/**
+ * @brief Avalia \f$a \sin(b x + c)\f$ em vários pontos, com `simd_sin()`.
+ *
+ * @param x Arranjo com os pontos.
+ * @param y Arranjo onde os resultados serão escritos.
+ * @param count Número de pontos.
+ * @param impl O bloco da função.
+ */
+static void sinusoid_eval_batch(const double *x, double *y, size_t count,
+				void *impl)
+{
+	const ElementaryBlock *e = impl;
+	double a = e->a, b = e->b, c = e->c;
+
+	for (size_t i = 0; i < count; ++i)
+		y[i] = b * x[i] + c;
+	simd_sin(y, y, count);
+	for (size_t i = 0; i < count; ++i)
+		y[i] *= a;
+}
+
+/**
+ * @brief Avalia um polinômio num ponto pela regra de Horner.
+ *
+ * @param coeffs Os coeficientes, em ordem crescente de grau.
+ * @param degree O grau.
+ * @param x O ponto.
+ * @return O valor do polinômio em `x`.
+ */
+static double rational_horner(const double *coeffs, size_t degree, double x)
+{
+	double acc = coeffs[degree];
+	for (size_t k = degree; k-- > 0;)
+		acc = acc * x + coeffs[k];
+	return acc;
+}
+
+/**
+ * @brief Avalia um polinômio em vários pontos pela regra de Horner.
+ *
+ * @details Usa `simd_poly_horner()` se houver um núcleo vetorizado. Sem ele,
+ * o laço sobre os pontos fica dentro do laço sobre os coeficientes, para que
+ * o compilador possa vetorizá-lo.
+ *
+ * @param coeffs Os coeficientes, em ordem crescente de grau.
+ * @param degree O grau.
+ * @param x Arranjo com os pontos.
+ * @param y Arranjo onde os valores serão escritos.
+ * @param count Número de pontos.
+ */
+static void rational_horner_batch(const double *coeffs, size_t degree,
+				  const double *x, double *y, size_t count)
+{
+	if (simd_level() != SIMD_SCALAR) {
+		simd_poly_horner(coeffs, degree, x, y, count);
+		return;
+	}
+
+	for (size_t j = 0; j < count; ++j)
+		y[j] = coeffs[degree];
+	for (size_t k = degree; k-- > 0;) {
+		double c = coeffs[k];
+		for (size_t j = 0; j < count; ++j)
+			y[j] = y[j] * x[j] + c;
+	}
+}
+
+/**
+ * @brief Avalia uma função racional num ponto.
+ *
+ * @param x O ponto.
+ * @param impl O bloco da função.
+ * @return \f$P(x) / Q(x)\f$.
+ */
+static double rational_eval(double x, void *impl)
+{
+	const RationalBlock *r = impl;
+	return rational_horner(r->coeffs, r->p_degree, x) /
+	       rational_horner(r->q, r->q_degree, x);
+}
+
+/**
+ * @brief Avalia uma função racional em vários pontos.
+ *
+ * @details Os pontos são processados em blocos de `ELEMENTARY_BLOCK`: o
+ * denominador de cada bloco é avaliado num arranjo na pilha, e o numerador,
+ * diretamente em `y`.
+ *
+ * @param x Arranjo com os pontos.
+ * @param y Arranjo onde os resultados serão escritos.
+ * @param count Número de pontos.
+ * @param impl O bloco da função.
+ */
+static void rational_eval_batch(const double *x, double *y, size_t count,
+				void *impl)
+{
+	const RationalBlock *r = impl;
+	double den[ELEMENTARY_BLOCK];
+
+	for (size_t start = 0; start < count; start += ELEMENTARY_BLOCK) {
+		size_t len = count - start < ELEMENTARY_BLOCK ?
+				     count - start :
+				     ELEMENTARY_BLOCK;
+		const double *xb = x + start;
+		double *yb = y + start;
+
+		rational_horner_batch(r->q, r->q_degree, xb, den, len);
+		rational_horner_batch(r->coeffs, r->p_degree, xb, yb, len);
+		for (size_t j = 0; j < len; ++j)
+			yb[j] /= den[j];
+	}
+}
+
+/**
+ * @brief Avalia uma soma de funções num ponto.
+ *
+ * @param x O ponto.
+ * @param impl O bloco da função.
+ * @return A soma dos valores dos termos em `x`, na ordem dos termos.
+ */
+static double sum_eval(double x, void *impl)
+{
+	const SumBlock *s = impl;
+	double sum = s->terms[0]->eval(x, s->terms[0]->impl);
+
+	for (size_t t = 1; t < s->count; ++t)
+		sum += s->terms[t]->eval(x, s->terms[t]->impl);
+	return sum;
+}
+
+/**
+ * @brief Avalia uma soma de funções em vários pontos.
+ *
+ * @details Os pontos são processados em blocos de `ELEMENTARY_BLOCK`: o
+ * primeiro termo é avaliado diretamente em `y`, e cada um dos demais, num
+ * arranjo na pilha somado a `y`. As somas seguem a ordem de `sum_eval()`.
+ *
+ * @param x Arranjo com os pontos.
+ * @param y Arranjo onde os resultados serão escritos.
+ * @param count Número de pontos.
+ * @param impl O bloco da função.
+ */
+static void sum_eval_batch(const double *x, double *y, size_t count,
+			   void *impl)
+{
+	const SumBlock *s = impl;
+	double term[ELEMENTARY_BLOCK];
+
+	for (size_t start = 0; start < count; start += ELEMENTARY_BLOCK) {
+		size_t len = count - start < ELEMENTARY_BLOCK ?
+				     count - start :
+				     ELEMENTARY_BLOCK;
+		const double *xb = x + start;
+		double *yb = y + start;
+
+		sum_term_batch(s->terms[0], xb, yb, len);
+		for (size_t t = 1; t < s->count; ++t) {
+			sum_term_batch(s->terms[t], xb, term, len);
+			for (size_t j = 0; j < len; ++j)
+				yb[j] += term[j];
+		}
+	}
+}
+
+/**
+ * @brief Avalia um termo de uma soma em vários pontos, em lote se o tipo do
+ * termo permitir, ou ponto a ponto caso contrário.
+ *
+ * @param term O termo.
+ * @param x Arranjo com os pontos.
+ * @param y Arranjo onde os resultados serão escritos.
+ * @param count Número de pontos.
+ */
+static void sum_term_batch(const Function *term, const double *x, double *y,
+			   size_t count)
+{
+	if (term->eval_batch != nullptr) {
+		term->eval_batch(x, y, count, term->impl);
+		return;
+	}
+	for (size_t j = 0; j < count; ++j)
+		y[j] = term->eval(x[j], term->impl);
+}
\ No newline at end of file
@@ -0,0 +1,809 @@
+// SPDX-License-Identifier: ISC
+
+/**
+ * @file expr.c
+ * @brief Implementação do compilador e da máquina virtual de expressões.
+ *
+ * @details A compilação tem três etapas:
+ * 1. Um analisador descendente recursivo constrói um grafo acíclico de nós.
+ *    Cada nó novo é primeiro simplificado (dobra de constantes, identidades
+ *    como \f$e + 0\f$ e \f$e^1\f$, e expansão de potências inteiras em
+ *    multiplicações) e então procurado entre os nós existentes, de modo que
+ *    subexpressões iguais compartilham o mesmo nó.
+ * 2. Os nós alcançáveis a partir da raiz recebem registradores por varredura
+ *    linear: o registrador de um nó é liberado após o seu último uso e pode
+ *    ser reaproveitado pelos seguintes. Constantes não ocupam registradores;
+ *    elas são embutidas nas instruções que as usam.
+ * 3. Cada nó vira uma instrução de três endereços, num arranjo plano.
+ *
+ * A máquina virtual aplica cada instrução a um bloco de `EXPR_BLOCK` pontos,
+ * num laço que o compilador pode vetorizar no caso das operações aritméticas.
+ * A avaliação num único ponto percorre as mesmas instruções sobre
+ * registradores escalares, sem os arranjos dos blocos.
+ */
+
+#include <ctype.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "expr.h"
+#include "util.h"
+
+/**
+ * @brief Maior expoente inteiro expandido em multiplicações.
+ */
+#define EXPR_MAX_POWI 32
+
+/**
+ * @brief Valor de \f$\pi\f$, para a constante `pi`.
+ */
+#define EXPR_PI 3.14159265358979323846
+
+/**
+ * @brief Valor de \f$e\f$, para a constante `e`.
+ */
+#define EXPR_E 2.71828182845904523536
+
+/**
+ * @brief Número de registradores de `EXPR_BLOCK` pontos alocados na pilha
+ * durante a avaliação em lote. Programas que precisem de mais usam blocos
+ * proporcionalmente menores.
+ */
+#define EXPR_STACK_REGS 16
+
+#if EXPR_MAX_REGS > EXPR_STACK_REGS * EXPR_BLOCK
+#error "Os blocos da avaliação em lote devem ter ao menos um ponto"
+#endif
+
+/**
+ * @brief Operações dos nós e das instruções.
+ *
+ * @details As operações com sufixo `K` têm uma constante como segundo
+ * operando, e as com prefixo `K`, como primeiro.
+ */
+typedef enum {
+	OP_CONST, /**< Constante. */
+	OP_X, /**< A variável \f$x\f$. */
+	OP_ADD, /**< \f$a + b\f$. */
+	OP_SUB, /**< \f$a - b\f$. */
+	OP_MUL, /**< \f$a \cdot b\f$. */
+	OP_DIV, /**< \f$a / b\f$. */
+	OP_POW, /**< \f$a^b\f$. */
+	OP_NEG, /**< \f$-a\f$. */
+	OP_SIN, /**< \f$\sin a\f$. */
+	OP_COS, /**< \f$\cos a\f$. */
+	OP_TAN, /**< \f$\tan a\f$. */
+	OP_EXP, /**< \f$e^a\f$. */
+	OP_LOG, /**< \f$\ln a\f$. */
+	OP_SQRT, /**< \f$\sqrt a\f$. */
+	OP_ABS, /**< \f$|a|\f$. */
+	OP_ADDK, /**< \f$a + k\f$. */
+	OP_SUBK, /**< \f$a - k\f$. */
+	OP_KSUB, /**< \f$k - a\f$. */
+	OP_MULK, /**< \f$a \cdot k\f$. */
+	OP_DIVK, /**< \f$a / k\f$. */
+	OP_KDIV, /**< \f$k / a\f$. */
+	OP_POWK, /**< \f$a^k\f$. */
+	OP_KPOW, /**< \f$k^a\f$. */
+} Op;
+
+/**
+ * @brief Nome e operação de cada função reconhecida pelo analisador.
+ */
+static const struct {
+	const char *name;
+	Op op;
+} functions[] = {
+	{ "sin", OP_SIN },   { "cos", OP_COS }, { "tan", OP_TAN },
+	{ "exp", OP_EXP },   { "log", OP_LOG }, { "sqrt", OP_SQRT },
+	{ "abs", OP_ABS },
+};
+
+/**
+ * @brief Um nó do grafo da expressão.
+ */
+typedef struct {
+	Op op; /**< A operação. */
+	uint32_t a; /**< Índice do primeiro operando, se houver. */
+	uint32_t b; /**< Índice do segundo operando, se houver. */
+	double value; /**< O valor, se a operação for `OP_CONST`. */
+} Node;
+
+/**
+ * @brief Uma instrução da máquina virtual.
+ */
+typedef struct {
+	Op op; /**< A operação. */
+	uint32_t dst; /**< Registrador de destino. */
+	uint32_t a; /**< Registrador do primeiro operando. */
+	uint32_t b; /**< Registrador do segundo operando. */
+	double k; /**< Operando constante, se houver. */
+} Instr;
+
+/**
+ * @brief Estrutura que define uma expressão compilada.
+ */
+struct Expression {
+	char *src; /**< Cópia da expressão original. */
+	Instr *code; /**< Programa, em ordem de execução. */
+	size_t length; /**< Número de instruções. */
+	uint32_t regs; /**< Número de registradores, incluindo o 0 (\f$x\f$). */
+	uint32_t result; /**< Registrador que contém o resultado. */
+};
+
+/**
+ * @brief Estado do analisador sintático.
+ */
+typedef struct {
+	const char *src; /**< Início da expressão. */
+	const char *pos; /**< Posição atual. */
+	Node *nodes; /**< Nós construídos até agora. */
+	size_t count; /**< Número de nós. */
+	size_t capacity; /**< Capacidade de `nodes`. */
+	bool error; /**< Indica que houve erro. */
+} Parser;
+
+// Declarações internas.
+static uint32_t parse_expr(Parser *p);
+static uint32_t node_make(Parser *p, Op op, uint32_t a, uint32_t b,
+			  double value);
+static bool expression_compile(Expression *expr, const Parser *p,
+			       uint32_t root);
+
+// Analisa e compila uma expressão em x.
+[[nodiscard("Ignorar retorno pode causar vazamento de memória")]]
+Expression *expression_new(const char *src)
+{
+	Parser p = { .src = src, .pos = src };
+	Expression *expr = calloc(1, sizeof(typeof(*expr)));
+	ERRNOCHECK(expr == nullptr, "Falha ao alocar expressão", ret);
+
+	size_t len = strlen(src) + 1;
+	expr->src = malloc(len);
+	ERRNOCHECK(expr->src == nullptr, "Falha ao copiar expressão", cleanup);
+	memcpy(expr->src, src, len);
+
+	// Analisa a expressão inteira.
+	uint32_t root = parse_expr(&p);
+	while (isspace((unsigned char)*p.pos))
+		++p.pos;
+	if (!p.error && *p.pos != '\0') {
+		fprintf(stderr, "Erro de sintaxe na posição %td de \"%s\": %s\n",
+			p.pos - p.src, p.src, "caractere inesperado");
+		p.error = true;
+	}
+	if (p.error) {
+		errno = EINVAL;
+		goto cleanup;
+	}
+	if (!expression_compile(expr, &p, root))
+		goto cleanup;
+
+	free(p.nodes);
+	return expr;
+
+cleanup:
+	free(p.nodes);
+	expression_free(expr);
+ret:
+	return nullptr;
+}
+
+// Libera uma expressão compilada.
+void expression_free(Expression *expr)
+{
+	free(expr->code);
+	free(expr->src);
+	free(expr);
+}
+
+// Retorna a expressão original de uma expressão compilada.
+const char *expression_source(const Expression *expr)
+{
+	return expr->src;
+}
+
+/**
+ * @brief Aplica uma operação a valores escalares.
+ *
+ * @details Usada tanto na dobra de constantes quanto, indiretamente, como
+ * referência para a máquina virtual, que aplica as mesmas funções da
+ * biblioteca matemática.
+ *
+ * @param op A operação (sem operandos constantes embutidos).
+ * @param a O primeiro operando.
+ * @param b O segundo operando, se houver.
+ * @return O resultado.
+ */
+static double op_apply(Op op, double a, double b)
+{
+	switch (op) {
+	case OP_ADD:
+		return a + b;
+	case OP_SUB:
+		return a - b;
+	case OP_MUL:
+		return a * b;
+	case OP_DIV:
+		return a / b;
+	case OP_POW:
+		return pow(a, b);
+	case OP_NEG:
+		return -a;
+	case OP_SIN:
+		return sin(a);
+	case OP_COS:
+		return cos(a);
+	case OP_TAN:
+		return tan(a);
+	case OP_EXP:
+		return exp(a);
+	case OP_LOG:
+		return log(a);
+	case OP_SQRT:
+		return sqrt(a);
+	case OP_ABS:
+		return fabs(a);
+	default:
+		return NAN;
+	}
+}
+
+/**
+ * @brief Indica se uma operação tem dois operandos.
+ */
+static bool op_binary(Op op)
+{
+	return op >= OP_ADD && op <= OP_POW;
+}
+
+// Avalia uma expressão compilada em um ponto.
+double expression_eval(double x, Expression *expr)
+{
+	double r[EXPR_MAX_REGS];
+
+	r[0] = x;
+	for (size_t i = 0; i < expr->length; ++i) {
+		const Instr *in = &expr->code[i];
+		double a = r[in->a], k = in->k;
+
+		switch (in->op) {
+		case OP_CONST:
+			r[in->dst] = k;
+			break;
+		case OP_ADDK:
+			r[in->dst] = a + k;
+			break;
+		case OP_SUBK:
+			r[in->dst] = a - k;
+			break;
+		case OP_KSUB:
+			r[in->dst] = k - a;
+			break;
+		case OP_MULK:
+			r[in->dst] = a * k;
+			break;
+		case OP_DIVK:
+			r[in->dst] = a / k;
+			break;
+		case OP_KDIV:
+			r[in->dst] = k / a;
+			break;
+		case OP_POWK:
+			r[in->dst] = pow(a, k);
+			break;
+		case OP_KPOW:
+			r[in->dst] = pow(k, a);
+			break;
+		default:
+			r[in->dst] = op_apply(in->op, a, r[in->b]);
+		}
+	}
+	return r[expr->result];
+}
+
+/**
+ * @brief Executa o programa de uma expressão sobre um bloco de pontos.
+ *
+ * @param expr Ponteiro para a expressão.
+ * @param r Arranjo de ponteiros para os registradores, com `r[0]` apontando
+ * para os valores de \f$x\f$.
+ * @param len Número de pontos do bloco (no máximo `EXPR_BLOCK`).
+ */
+static void expression_run(const Expression *expr, double **r, size_t len)
+{
+	for (size_t i = 0; i < expr->length; ++i) {
+		const Instr *in = &expr->code[i];
+		double *d = r[in->dst];
+		const double *a = r[in->a], *b = r[in->b];
+		double k = in->k;
+
+// Aplica uma expressão elemento a elemento ao bloco.
+#define EXPR_LOOP(expression)                  \
+	for (size_t j = 0; j < len; ++j)       \
+		d[j] = (expression);           \
+	break
+
+		switch (in->op) {
+		case OP_CONST:
+			EXPR_LOOP(k);
+		case OP_ADD:
+			EXPR_LOOP(a[j] + b[j]);
+		case OP_SUB:
+			EXPR_LOOP(a[j] - b[j]);
+		case OP_MUL:
+			EXPR_LOOP(a[j] * b[j]);
+		case OP_DIV:
+			EXPR_LOOP(a[j] / b[j]);
+		case OP_POW:
+			EXPR_LOOP(pow(a[j], b[j]));
+		case OP_NEG:
+			EXPR_LOOP(-a[j]);
+		case OP_SIN:
+			EXPR_LOOP(sin(a[j]));
+		case OP_COS:
+			EXPR_LOOP(cos(a[j]));
+		case OP_TAN:
+			EXPR_LOOP(tan(a[j]));
+		case OP_EXP:
+			EXPR_LOOP(exp(a[j]));
+		case OP_LOG:
+			EXPR_LOOP(log(a[j]));
+		case OP_SQRT:
+			EXPR_LOOP(sqrt(a[j]));
+		case OP_ABS:
+			EXPR_LOOP(fabs(a[j]));
+		case OP_ADDK:
+			EXPR_LOOP(a[j] + k);
+		case OP_SUBK:
+			EXPR_LOOP(a[j] - k);
+		case OP_KSUB:
+			EXPR_LOOP(k - a[j]);
+		case OP_MULK:
+			EXPR_LOOP(a[j] * k);
+		case OP_DIVK:
+			EXPR_LOOP(a[j] / k);
+		case OP_KDIV:
+			EXPR_LOOP(k / a[j]);
+		case OP_POWK:
+			EXPR_LOOP(pow(a[j], k));
+		case OP_KPOW:
+			EXPR_LOOP(pow(k, a[j]));
+		default:
+			break;
+		}
+#undef EXPR_LOOP
+	}
+}
+
+// Avalia uma expressão compilada em vários pontos.
+void expression_eval_batch(const double *x, double *y, size_t count,
+			   Expression *expr)
+{
+	double regs[EXPR_STACK_REGS * EXPR_BLOCK];
+	double *r[EXPR_MAX_REGS];
+
+	// Se os registradores não couberem na pilha com blocos inteiros, os
+	// blocos encolhem.
+	size_t block = expr->regs <= EXPR_STACK_REGS ?
+			       EXPR_BLOCK :
+			       EXPR_STACK_REGS * EXPR_BLOCK / expr->regs;
+	for (uint32_t i = 1; i < expr->regs; ++i)
+		r[i] = regs + i * block;
+
+	for (size_t start = 0; start < count; start += block) {
+		size_t len = count - start < block ? count - start : block;
+		r[0] = (double *)(x + start);
+		expression_run(expr, r, len);
+		memcpy(y + start, r[expr->result], len * sizeof(*y));
+	}
+}
+
+// Analisador sintático.
+
+/**
+ * @brief Reporta um erro de sintaxe na posição atual.
+ *
+ * @param p Estado do analisador.
+ * @param msg Descrição do erro.
+ * @return Sempre 0, para ser usado como índice de nó inválido.
+ */
+static uint32_t parse_error(Parser *p, const char *msg)
+{
+	if (!p->error)
+		fprintf(stderr, "Erro de sintaxe na posição %td de \"%s\": %s\n",
+			p->pos - p->src, p->src, msg);
+	p->error = true;
+	return 0;
+}
+
+/**
+ * @brief Pula espaços e consome um caractere, se for o esperado.
+ *
+ * @param p Estado do analisador.
+ * @param c O caractere esperado.
+ * @return `true` se o caractere foi consumido.
+ */
+static bool parse_accept(Parser *p, char c)
+{
+	while (isspace((unsigned char)*p->pos))
+		++p->pos;
+	if (*p->pos != c)
+		return false;
+	++p->pos;
+	return true;
+}
+
+static uint32_t parse_unary(Parser *p);
+
+/**
+ * @brief Analisa um elemento primário: número, variável, constante, chamada
+ * de função, ou expressão entre parênteses.
+ */
+static uint32_t parse_primary(Parser *p)
+{
+	while (isspace((unsigned char)*p->pos))
+		++p->pos;
+
+	if (parse_accept(p, '(')) {
+		uint32_t e = parse_expr(p);
+		if (!parse_accept(p, ')'))
+			return parse_error(p, "esperava ')'");
+		return e;
+	}
+
+	if (isdigit((unsigned char)*p->pos) || *p->pos == '.') {
+		char *end;
+		double v = strtod(p->pos, &end);
+		if (end == p->pos)
+			return parse_error(p, "número inválido");
+		p->pos = end;
+		return node_make(p, OP_CONST, 0, 0, v);
+	}
+
+	if (isalpha((unsigned char)*p->pos)) {
+		const char *start = p->pos;
+		while (isalnum((unsigned char)*p->pos) || *p->pos == '_')
+			++p->pos;
+		size_t len = p->pos - start;
+
+		if (len == 1 && *start == 'x')
+			return node_make(p, OP_X, 0, 0, 0);
+		if (len == 2 && strncmp(start, "pi", 2) == 0)
+			return node_make(p, OP_CONST, 0, 0, EXPR_PI);
+		if (len == 1 && *start == 'e')
+			return node_make(p, OP_CONST, 0, 0, EXPR_E);
+
+		for (size_t i = 0; i < sizeof(functions) / sizeof(*functions);
+		     ++i) {
+			if (strlen(functions[i].name) != len ||
+			    strncmp(start, functions[i].name, len) != 0)
+				continue;
+			if (!parse_accept(p, '('))
+				return parse_error(p, "esperava '('");
+			uint32_t arg = parse_expr(p);
+			if (!parse_accept(p, ')'))
+				return parse_error(p, "esperava ')'");
+			return node_make(p, functions[i].op, arg, 0, 0);
+		}
+
+		p->pos = start;
+		return parse_error(p, "identificador desconhecido");
+	}
+
+	return parse_error(p, "esperava um número, 'x', ou '('");
+}
+
+/**
+ * @brief Analisa uma potência, associativa à direita: `primário ^ unário`.
+ */
+static uint32_t parse_power(Parser *p)
+{
+	uint32_t base = parse_primary(p);
+	if (p->error || !parse_accept(p, '^'))
+		return base;
+	return node_make(p, OP_POW, base, parse_unary(p), 0);
+}
+
+/**
+ * @brief Analisa um menos (ou mais) unário seguido de uma potência.
+ */
+static uint32_t parse_unary(Parser *p)
+{
+	if (parse_accept(p, '-'))
+		return node_make(p, OP_NEG, parse_unary(p), 0, 0);
+	if (parse_accept(p, '+'))
+		return parse_unary(p);
+	return parse_power(p);
+}
+
+/**
+ * @brief Analisa um termo: unários separados por `*` ou `/`.
+ */
+static uint32_t parse_term(Parser *p)
+{
+	uint32_t lhs = parse_unary(p);
+	while (!p->error) {
+		if (parse_accept(p, '*'))
+			lhs = node_make(p, OP_MUL, lhs, parse_unary(p), 0);
+		else if (parse_accept(p, '/'))
+			lhs = node_make(p, OP_DIV, lhs, parse_unary(p), 0);
+		else
+			break;
+	}
+	return lhs;
+}
+
+/**
+ * @brief Analisa uma expressão: termos separados por `+` ou `-`.
+ */
+static uint32_t parse_expr(Parser *p)
+{
+	uint32_t lhs = parse_term(p);
+	while (!p->error) {
+		if (parse_accept(p, '+'))
+			lhs = node_make(p, OP_ADD, lhs, parse_term(p), 0);
+		else if (parse_accept(p, '-'))
+			lhs = node_make(p, OP_SUB, lhs, parse_term(p), 0);
+		else
+			break;
+	}
+	return lhs;
+}
+
+// Construção e simplificação dos nós.
+
+/**
+ * @brief Indica se um nó é a constante `v`.
+ */
+static bool node_is(const Parser *p, uint32_t i, double v)
+{
+	return p->nodes[i].op == OP_CONST && p->nodes[i].value == v;
+}
+
+/**
+ * @brief Acrescenta um nó, ou retorna um existente idêntico.
+ *
+ * @details Procura linearmente entre os nós existentes; as expressões que
+ * interessam têm poucas dezenas de nós, e a busca só ocorre na compilação.
+ * As constantes são comparadas bit a bit, para distinguir \f$0\f$ de
+ * \f$-0\f$.
+ */
+static uint32_t node_intern(Parser *p, Node n)
+{
+	for (size_t i = 0; i < p->count; ++i) {
+		const Node *m = &p->nodes[i];
+		if (m->op == n.op && m->a == n.a && m->b == n.b &&
+		    memcmp(&m->value, &n.value, sizeof(n.value)) == 0)
+			return (uint32_t)i;
+	}
+
+	if (p->count == p->capacity) {
+		size_t cap = p->capacity ? 2 * p->capacity : 32;
+		Node *nodes = realloc(p->nodes, cap * sizeof(*nodes));
+		ERRNOCHECK(nodes == nullptr, "Falha ao alocar nós", error);
+		p->nodes = nodes;
+		p->capacity = cap;
+	}
+
+	p->nodes[p->count] = n;
+	return (uint32_t)p->count++;
+
+error:
+	p->error = true;
+	return 0;
+}
+
+/**
+ * @brief Constrói um nó, simplificando-o sempre que possível.
+ *
+ * @param p Estado do analisador.
+ * @param op A operação.
+ * @param a Índice do primeiro operando, se houver.
+ * @param b Índice do segundo operando, se houver.
+ * @param value O valor, se a operação for `OP_CONST`.
+ * @return O índice do nó resultante.
+ */
+static uint32_t node_make(Parser *p, Op op, uint32_t a, uint32_t b,
+			  double value)
+{
+	if (p->error)
+		return 0;
+	if (op == OP_CONST || op == OP_X)
+		return node_intern(p, (Node){ op, 0, 0, value });
+
+	const Node *na = &p->nodes[a], *nb = &p->nodes[b];
+	bool binary = op_binary(op);
+
+	// Dobra de constantes.
+	if (na->op == OP_CONST && (!binary || nb->op == OP_CONST))
+		return node_make(p, OP_CONST, 0, 0,
+				 op_apply(op, na->value, binary ? nb->value : 0));
+
+	switch (op) {
+	case OP_ADD: // e + 0 = 0 + e = e.
+		if (node_is(p, b, 0))
+			return a;
+		if (node_is(p, a, 0))
+			return b;
+		break;
+	case OP_SUB: // e - 0 = e; 0 - e = -e.
+		if (node_is(p, b, 0))
+			return a;
+		if (node_is(p, a, 0))
+			return node_make(p, OP_NEG, b, 0, 0);
+		break;
+	case OP_MUL: // e · 1 = 1 · e = e.
+		if (node_is(p, b, 1))
+			return a;
+		if (node_is(p, a, 1))
+			return b;
+		break;
+	case OP_DIV: // e / 1 = e.
+		if (node_is(p, b, 1))
+			return a;
+		break;
+	case OP_NEG: // -(-e) = e.
+		if (na->op == OP_NEG)
+			return na->a;
+		break;
+	case OP_POW: {
+		// Expoentes inteiros pequenos viram multiplicações, por
+		// quadrados sucessivos, o que expõe potências intermediárias à
+		// eliminação de subexpressões comuns.
+		double e = nb->op == OP_CONST ? nb->value : NAN;
+		if (e == trunc(e) && fabs(e) <= EXPR_MAX_POWI) {
+			uint32_t base = a, res = node_make(p, OP_CONST, 0, 0, 1);
+			for (unsigned n = (unsigned)fabs(e); n > 0; n >>= 1) {
+				if (n & 1)
+					res = node_make(p, OP_MUL, res, base, 0);
+				if (n > 1)
+					base = node_make(p, OP_MUL, base, base,
+							 0);
+			}
+			if (e < 0)
+				res = node_make(p, OP_DIV,
+						node_make(p, OP_CONST, 0, 0, 1),
+						res, 0);
+			return res;
+		}
+		break;
+	}
+	default:
+		break;
+	}
+
+	// Operações comutativas têm operandos em ordem canônica.
+	if ((op == OP_ADD || op == OP_MUL) && a > b) {
+		uint32_t t = a;
+		a = b;
+		b = t;
+	}
+
+	return node_intern(p, (Node){ op, a, binary ? b : 0, 0 });
+}
+
+// Alocação de registradores e geração do programa.
+
+/**
+ * @brief Gera o programa de uma expressão a partir do seu grafo.
+ *
+ * @param expr Expressão onde o programa será escrito.
+ * @param p Estado do analisador, com o grafo completo.
+ * @param root Índice do nó raiz.
+ * @return `true` em caso de sucesso, `false` se faltou memória.
+ */
+static bool expression_compile(Expression *expr, const Parser *p,
+			       uint32_t root)
+{
+	size_t n = p->count;
+	// Para cada nó: último uso, registrador atribuído, e se é alcançável.
+	size_t *last = calloc(n, sizeof(*last));
+	uint32_t *reg = calloc(n, sizeof(*reg));
+	bool *live = calloc(n, sizeof(*live));
+	bool *busy = calloc(n + 2, sizeof(*busy));
+	expr->code = malloc((n + 1) * sizeof(*expr->code));
+	ERRNOCHECK(last == nullptr || reg == nullptr || live == nullptr ||
+			   busy == nullptr || expr->code == nullptr,
+		   "Falha ao alocar compilador", cleanup);
+
+	// Marca os nós alcançáveis e o último uso de cada um. Os operandos
+	// sempre precedem os nós que os usam.
+	live[root] = true;
+	last[root] = n;
+	for (size_t i = n; i-- > 0;) {
+		const Node *m = &p->nodes[i];
+		if (!live[i] || m->op == OP_CONST || m->op == OP_X)
+			continue;
+		live[m->a] = true;
+		if (last[m->a] < i)
+			last[m->a] = i;
+		if (op_binary(m->op)) {
+			live[m->b] = true;
+			if (last[m->b] < i)
+				last[m->b] = i;
+		}
+	}
+
+	// O registrador 0 é sempre x.
+	busy[0] = true;
+	expr->regs = 1;
+	expr->length = 0;
+
+	for (size_t i = 0; i < n; ++i) {
+		const Node *m = &p->nodes[i];
+		if (!live[i] || m->op == OP_X ||
+		    (m->op == OP_CONST && i != root))
+			continue;
+
+		Instr in = { m->op, 0, 0, 0, m->value };
+		if (m->op != OP_CONST) {
+			const Node *ma = &p->nodes[m->a];
+			const Node *mb = &p->nodes[m->b];
+			in.a = reg[m->a];
+			in.b = reg[m->b];
+
+			// Embute um operando constante na instrução.
+			if (op_binary(m->op) && mb->op == OP_CONST) {
+				static const Op k_ops[] = {
+					[OP_ADD] = OP_ADDK, [OP_SUB] = OP_SUBK,
+					[OP_MUL] = OP_MULK, [OP_DIV] = OP_DIVK,
+					[OP_POW] = OP_POWK,
+				};
+				in.op = k_ops[m->op];
+				in.k = mb->value;
+			} else if (op_binary(m->op) && ma->op == OP_CONST) {
+				static const Op k_ops[] = {
+					[OP_ADD] = OP_ADDK, [OP_SUB] = OP_KSUB,
+					[OP_MUL] = OP_MULK, [OP_DIV] = OP_KDIV,
+					[OP_POW] = OP_KPOW,
+				};
+				in.op = k_ops[m->op];
+				in.a = in.b;
+				in.k = ma->value;
+			}
+
+			// Libera os registradores dos operandos usados aqui pela
+			// última vez, para que o destino possa reaproveitá-los.
+			// O registrador 0 (\f$x\f$) nunca é liberado.
+			if (ma->op != OP_CONST && last[m->a] == i)
+				busy[reg[m->a]] = false;
+			if (op_binary(m->op) && mb->op != OP_CONST &&
+			    last[m->b] == i)
+				busy[reg[m->b]] = false;
+			busy[0] = true;
+		}
+
+		// Atribui o menor registrador livre ao destino.
+		uint32_t r = 1;
+		while (busy[r])
+			++r;
+		busy[r] = true;
+		reg[i] = in.dst = r;
+		if (r + 1 > expr->regs)
+			expr->regs = r + 1;
+
+		expr->code[expr->length++] = in;
+	}
+
+	expr->result = reg[root];
+	errno = E2BIG;
+	ERRNOCHECK(expr->regs > EXPR_MAX_REGS,
+		   "Expressão exige registradores demais", cleanup);
+
+	free(busy);
+	free(live);
+	free(reg);
+	free(last);
+	return true;
+
+cleanup:
+	free(busy);
+	free(live);
+	free(reg);
+	free(last);
+	return false;
+}
\ No newline at end of file
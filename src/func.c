@@ -18,36 +18,113 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "elementary.h"
+#include "expr.h"
 #include "func.h"
+#include "plugin.h"
+#include "simd.h"
+#include "tabulated.h"
 #include "util.h"
 
-// Definições dos tipos de funções.
+/**
+ * @brief Alinhamento, em bytes, dos blocos alocados para funções.
+ */
+#define FUNCTION_ALIGN 64
 
 /**
- * @brief Estrutura que define um polinômio clássico de grau arbitrário.
+ * @brief Função polinomial alocada num único bloco.
  *
- * @details A estrutura `Polynomial` é usada para representar um polinômio de
- * grau arbitrário. Os coeficientes dos termos do polinômio são armazenados em
- * ordem crescente de grau. Isso significa que o coeficiente do termo constante
- * (grau 0) vem primeiro, seguido pelo coeficiente do termo de grau 1, e assim
- * por diante.
+ * @details O objeto função, o polinômio e os coeficientes ficam contíguos
+ * na memória, numa só alocação. Os coeficientes ficam num membro flexível
+ * alinhado a `FUNCTION_ALIGN` bytes, para que os núcleos vetoriais os
+ * carreguem sem atravessar linhas de cache, e `poly.coefficients` aponta
+ * para ele.
+ */
+typedef struct {
+	Function func; /**< O objeto função, no início do bloco. */
+	Polynomial poly; /**< O polinômio referenciado por `func.impl`. */
+	alignas(FUNCTION_ALIGN) double data[]; /**< Os coeficientes. */
+} PolynomialBlock;
+
+/**
+ * @brief Termo de um polinômio esparso.
+ */
+typedef struct {
+	size_t exponent; /**< O expoente de \f$x\f$. */
+	double coefficient; /**< O coeficiente, não nulo. */
+} SparseTerm;
+
+/**
+ * @brief Polinômio na representação esparsa.
  *
- * Por exemplo, para um polinômio \f$f(x) = 1 + 2x^2 + 3x^4\f$, o grau será 4,
- * e o arranjo dos coeficientes será: \f$\{1, 0, 2, 0, 3\}\f$.
+ * @details Guarda somente os termos de coeficiente não nulo, em ordem
+ * crescente de expoente. A potência de cada termo é obtida da potência do
+ * termo anterior, multiplicando-a por \f$x\f$ elevado à diferença entre os
+ * expoentes, que é calculada por quadrados sucessivos. Diferenças repetidas
+ * (como em \f$1 + x^{100} + x^{200}\f$) reaproveitam a potência já calculada.
+ * Assim, o custo por ponto é de \f$O(t \log(\text{grau} / t))\f$
+ * multiplicações para \f$t\f$ termos, e não de \f$O(\text{grau})\f$.
  */
 typedef struct {
-	size_t degree; /**< O grau do polinômio, que é o maior expoente com um
-                        * coeficiente não zero. */
-	double *coefficients; /**< Um ponteiro para um array de coeficientes
-			       * dos termos do polinômio, armazenados em ordem
-			       * crescente de grau. O comprimento deste array é
-			       * \f$\text{degree} + 1\f$. */
-} Polynomial;
+	size_t degree; /**< O grau dado na criação. */
+	size_t count; /**< Número de termos. */
+	SparseTerm *terms; /**< Os termos, em ordem crescente de expoente. */
+} SparsePolynomial;
+
+/**
+ * @brief Função polinomial esparsa alocada num único bloco.
+ */
+typedef struct {
+	Function func; /**< O objeto função, no início do bloco. */
+	SparsePolynomial poly; /**< O polinômio referenciado por `func.impl`. */
+	alignas(FUNCTION_ALIGN) SparseTerm data[]; /**< Os termos. */
+} SparseBlock;
+
+/**
+ * @brief Bloco de memória de uma arena.
+ */
+typedef struct ArenaBlock {
+	struct ArenaBlock *next; /**< O próximo bloco da arena. */
+	size_t size; /**< Número de bytes disponíveis em `data`. */
+	alignas(FUNCTION_ALIGN) unsigned char data[]; /**< A memória. */
+} ArenaBlock;
+
+/**
+ * @brief Estrutura que define uma arena de funções.
+ *
+ * @details A arena é uma lista de blocos, percorrida em ordem. As alocações
+ * avançam um deslocamento dentro do bloco atual; quando ele se esgota, passa
+ * ao próximo bloco, alocando-o se preciso. Reiniciar a arena apenas volta ao
+ * primeiro bloco, sem liberar nenhum, de modo que os blocos são reaproveitados
+ * pelo lote seguinte.
+ */
+struct FunctionArena {
+	ArenaBlock *head; /**< O primeiro bloco. */
+	ArenaBlock *current; /**< O bloco de onde se aloca. */
+	size_t used; /**< Bytes já usados de `current`. */
+	size_t block_size; /**< Tamanho dos novos blocos, em bytes. */
+};
 
 // Declarações internas.
-static Polynomial *polynomial_new(size_t degree, double *coeffs);
-static void polynomial_free(Polynomial *ptr);
+static Function *function_vnew(FunctionArena *arena, FunctionType type,
+			       va_list args);
+static void *function_alloc(FunctionArena *arena, size_t size);
+static Function *polynomial_new(FunctionArena *arena, size_t degree,
+				const double *coeffs);
+static Function *sparse_new(FunctionArena *arena, size_t degree,
+			    const double *coeffs, size_t count);
+static double sparse_pow(double x, size_t n);
+static void digest_mix(uint64_t digest[2], uint64_t word);
 extern double polynomial_eval(double x, Polynomial *ptr);
+static inline double polynomial_estrin(double x, const double *c,
+					size_t degree);
+static eval_ptr_t polynomial_kernel(size_t degree);
+static double polynomial_eval_estrin(double x, Polynomial *ptr);
+extern void polynomial_eval_batch(const double *x, double *y, size_t count,
+				  Polynomial *ptr);
+extern double sparse_eval(double x, SparsePolynomial *ptr);
+extern void sparse_eval_batch(const double *x, double *y, size_t count,
+			      SparsePolynomial *ptr);
 
 // Instancia uma função arbitrária a partir de um tipo e de n parâmetros.
 [[nodiscard("Ignorar retorno pode causar vazamento de memória")]]
@@ -55,37 +132,23 @@ Function *function_new(FunctionType type, ...) // Recebe n + 1 parâmetros.
 {
 	va_list args; // Lista de parâmetros dinâmicos da função.
 
-	// Aloca memória para o objeto função e verifica se houve erro.
-	Function *func = malloc(sizeof(typeof(*func)));
-	ERRNOCHECK(func == nullptr, "Falha ao alocar memória para função",
-		   cleanup);
+	va_start(args, type); // Inicializa os parâmetros.
+	Function *func = function_vnew(nullptr, type, args);
+	va_end(args); // Libera a lista de parâmetros.
 
-	switch (type) {
-	case POLYNOMIAL: // Se o parâmetro `type` for `POLYNOMIAL`:
-		va_start(args, type); // Inicializa os parâmetros.
-		size_t degrees = va_arg(args, size_t); // Extrai 1º parâmetro.
-		double *coeffs = va_arg(args, double *); // Extrai o 2º.
-		va_end(args); // Libera a lista de parâmetros.
-
-		// Define a implementação da função como um objeto “polinômio”.
-		func->impl = polynomial_new(degrees, coeffs);
-		// Define o endereço da função que avalia o polinômio.
-		func->eval = (eval_ptr_t)&polynomial_eval;
-		break;
-	default: // Se `type` for desconhecido:
-		fprintf(stderr, "Tipo de função desconhecido: %d\n", type);
-		goto cleanup; // Pula para a seção `cleanup` abaixo.
-	}
+	return func;
+}
 
-	// Verifica se houve erro ao instanciar o objeto implementação.
-	ERRNOCHECK(func->impl == nullptr, "func->impl é NULL", cleanup);
+// Instancia uma função arbitrária dentro de uma arena.
+Function *function_new_in(FunctionArena *arena, FunctionType type, ...)
+{
+	va_list args;
 
-	func->type = type; // Caso contrário, define o tipo da função.
-	return func; // Retorna a referência ao objeto.
+	va_start(args, type);
+	Function *func = function_vnew(arena, type, args);
+	va_end(args);
 
-cleanup: // Se algum erro de alocação ocorreu, libera os recursos e retorna.
-	free(func);
-	return nullptr;
+	return func;
 }
 
 // Libera uma função arbitrária.
@@ -93,9 +156,24 @@ void function_free(Function *func)
 {
 	// Invoca o método de liberação apropriado ao tipo da função.
 	switch (func->type) {
-	case POLYNOMIAL:
-		polynomial_free(func->impl);
+	case POLYNOMIAL: // O polinômio e os termos estão no mesmo bloco.
 		break;
+	case EXPRESSION:
+		expression_free(func->impl);
+		break;
+	case TABULATED:
+		tabulated_free(func->impl);
+		break;
+	case PLUGIN: // A função está no bloco do plugin.
+		plugin_free(func);
+		return;
+	case EXPONENTIAL: // As funções elementares também ocupam um bloco só.
+	case LOGARITHM:
+	case SINUSOID:
+	case RATIONAL:
+	case SUM:
+		elementary_free(func);
+		return;
 	default: // Se o tipo for desconhecido, precisamos lançar erro fatal.
 		fprintf(stderr, "FATAL: impossível liberar %d\n", func->type);
 		exit(EXIT_FAILURE); // Termina programa com código de erro.
@@ -104,60 +182,354 @@ void function_free(Function *func)
 	free(func);
 }
 
+// Cria uma arena de funções.
+[[nodiscard("Ignorar retorno pode causar vazamento de memória")]]
+FunctionArena *function_arena_new(size_t block_size)
+{
+	FunctionArena *arena = malloc(sizeof(*arena));
+	ERRNOCHECK(arena == nullptr, "Falha ao alocar memória para arena", ret);
+
+	*arena = (FunctionArena){
+		.block_size = block_size > 0 ? block_size : FUNCTION_ARENA_BLOCK,
+	};
+	return arena;
+
+ret:
+	return nullptr;
+}
+
+// Descarta todas as funções de uma arena, mantendo a sua memória.
+void function_arena_reset(FunctionArena *arena)
+{
+	arena->current = arena->head;
+	arena->used = 0;
+}
+
+// Libera uma arena e todas as suas funções.
+void function_arena_free(FunctionArena *arena)
+{
+	for (ArenaBlock *b = arena->head, *next; b != nullptr; b = next) {
+		next = b->next;
+		free(b);
+	}
+	free(arena);
+}
+
+// Obtém o domínio de uma função definida somente num intervalo.
+bool function_domain(const Function *func, double *min, double *max)
+{
+	if (func->type != TABULATED)
+		return false;
+
+	tabulated_domain(func->impl, min, max);
+	return true;
+}
+
+// Calcula um resumo de 128 bits do conteúdo de uma função.
+bool function_digest(const Function *func, uint64_t digest[2])
+{
+	size_t degree;
+	const double *c = function_polynomial(func, &degree);
+	uint64_t bits;
+
+	digest[0] = 0x243f6a8885a308d3; // Dígitos de pi, como sementes.
+	digest[1] = 0x13198a2e03707344;
+	digest_mix(digest, func->type);
+
+	if (c != nullptr) {
+		for (size_t k = 0; k <= degree; ++k) {
+			if (c[k] == 0)
+				continue;
+			memcpy(&bits, &c[k], sizeof(bits));
+			digest_mix(digest, k);
+			digest_mix(digest, bits);
+		}
+	} else if (func->type == POLYNOMIAL) {
+		const SparsePolynomial *p = func->impl;
+		for (size_t t = 0; t < p->count; ++t) {
+			memcpy(&bits, &p->terms[t].coefficient, sizeof(bits));
+			digest_mix(digest, p->terms[t].exponent);
+			digest_mix(digest, bits);
+		}
+	} else if (func->type == EXPRESSION) {
+		const char *src = expression_source(func->impl);
+		size_t len = strlen(src);
+		for (size_t i = 0; i < len; i += sizeof(bits)) {
+			bits = 0;
+			memcpy(&bits, src + i,
+			       len - i < sizeof(bits) ? len - i : sizeof(bits));
+			digest_mix(digest, bits);
+		}
+		digest_mix(digest, len);
+	} else {
+		return false;
+	}
+	return true;
+}
+
+// Inicializa uma visão polinomial sobre coeficientes externos.
+Function *function_view_init(FunctionView *view, size_t degree,
+			     const double *coeffs)
+{
+	view->poly.degree = degree;
+	view->poly.coefficients = (double *)coeffs;
+	view->func.type = POLYNOMIAL;
+	view->func.eval = polynomial_kernel(degree);
+	view->func.eval_batch = (batch_ptr_t)&polynomial_eval_batch;
+	view->func.impl = &view->poly;
+	return &view->func;
+}
+
+// Acessa os coeficientes de uma função polinomial densa.
+const double *function_polynomial(const Function *func, size_t *degree)
+{
+	if (func->type != POLYNOMIAL ||
+	    func->eval_batch != (batch_ptr_t)&polynomial_eval_batch)
+		return nullptr;
+
+	const Polynomial *p = func->impl;
+	*degree = p->degree;
+	return p->coefficients;
+}
+
+// Verifica se uma função é um dado polinômio, em qualquer representação.
+bool function_polynomial_equal(const Function *func, size_t degree,
+			       const double *coeffs)
+{
+	size_t d;
+	const double *c = function_polynomial(func, &d);
+
+	if (c != nullptr)
+		return d == degree &&
+		       memcmp(c, coeffs, (degree + 1) * sizeof(*c)) == 0;
+	if (func->type != POLYNOMIAL)
+		return false;
+
+	// Os termos guardados devem coincidir bit a bit, e os omitidos devem
+	// ser nulos.
+	const SparsePolynomial *p = func->impl;
+	if (p->degree != degree)
+		return false;
+	for (size_t k = 0, t = 0; k <= degree; ++k) {
+		if (t < p->count && p->terms[t].exponent == k) {
+			if (memcmp(&p->terms[t++].coefficient, &coeffs[k],
+				   sizeof(*coeffs)) != 0)
+				return false;
+		} else if (coeffs[k] != 0) {
+			return false;
+		}
+	}
+	return true;
+}
+
 // Implementação dos diferentes tipos de função.
 // Funções de tipo polinômio:
 
 /**
- * @brief Instancia um objeto que implementa uma função de tipo polinômio.
+ * @brief Instancia uma função a partir do tipo e da lista de parâmetros.
  *
- * Recebe um grau (número natural) e um arranjo com os coeficientes, em ordem
- * crescente. Ex.: Para um \f$f(x) = 1 + 2x^2 + 3x^4\f$, o grau será 4, e o
- * arranjo será: \f${1, 0, 2, 0, 3}\f$.
+ * @param arena A arena de onde alocar, ou `nullptr` para usar o heap.
+ * @param type O tipo da função.
+ * @param args Os parâmetros variáveis, conforme `function_new()`.
+ * @return Ponteiro para a função criada, ou `nullptr` em caso de erro.
+ */
+static Function *function_vnew(FunctionArena *arena, FunctionType type,
+			       va_list args)
+{
+	Function *func = nullptr;
+
+	switch (type) {
+	case POLYNOMIAL: // Se o parâmetro `type` for `POLYNOMIAL`:
+		size_t degree = va_arg(args, size_t); // Extrai 1º parâmetro.
+		double *coeffs = va_arg(args, double *); // Extrai o 2º.
+
+		// Aloca função, polinômio e coeficientes num bloco só.
+		return polynomial_new(arena, degree, coeffs);
+	case EXPRESSION: // Se o parâmetro `type` for `EXPRESSION`:
+	case TABULATED: // Ou `TABULATED`:
+		// A expressão compilada e o mapeamento das amostras têm
+		// alocações próprias, que a arena não teria como liberar.
+		if (arena != nullptr) {
+			fprintf(stderr, "Tipo de função não suportado em "
+					"arenas: %d\n",
+				type);
+			return nullptr;
+		}
+
+		func = malloc(sizeof(typeof(*func)));
+		ERRNOCHECK(func == nullptr,
+			   "Falha ao alocar memória para função", ret);
+
+		func->type = type;
+		if (type == EXPRESSION) {
+			// Compila a expressão e define as funções que a avaliam.
+			func->impl = expression_new(va_arg(args, const char *));
+			func->eval = (eval_ptr_t)&expression_eval;
+			func->eval_batch =
+				(batch_ptr_t)&expression_eval_batch;
+		} else {
+			// Mapeia as amostras. O enum é promovido a `int`.
+			const char *path = va_arg(args, const char *);
+			TabulatedInterp interp = va_arg(args, int);
+			func->impl = tabulated_open(path, interp);
+			func->eval = (eval_ptr_t)&tabulated_eval;
+			func->eval_batch = (batch_ptr_t)&tabulated_eval_batch;
+		}
+		// Os construtores já informam os seus erros.
+		if (func->impl == nullptr)
+			goto cleanup;
+		return func;
+	case PLUGIN: // Se o parâmetro `type` for `PLUGIN`:
+		// O objeto carregado não pode ser descarregado pela arena.
+		if (arena != nullptr) {
+			fprintf(stderr, "Tipo de função não suportado em "
+					"arenas: %d\n",
+				type);
+			return nullptr;
+		}
+
+		const char *path = va_arg(args, const char *);
+		const char *params = va_arg(args, const char *);
+		return plugin_open(path, params);
+	case EXPONENTIAL: // Se for uma das funções elementares:
+	case LOGARITHM:
+	case SINUSOID:
+	case RATIONAL:
+	case SUM:
+		// Os termos de uma soma são liberados um a um, o que a arena
+		// não faz; os demais tipos elementares seguem a mesma regra.
+		if (arena != nullptr) {
+			fprintf(stderr, "Tipo de função não suportado em "
+					"arenas: %d\n",
+				type);
+			return nullptr;
+		}
+
+		return elementary_new(type, args);
+	default: // Se `type` for desconhecido:
+		fprintf(stderr, "Tipo de função desconhecido: %d\n", type);
+		return nullptr;
+	}
+
+cleanup: // Se algum erro de alocação ocorreu, libera os recursos e retorna.
+	free(func);
+ret:
+	return nullptr;
+}
+
+/**
+ * @brief Aloca um bloco alinhado a `FUNCTION_ALIGN` bytes.
  *
- * @param degree O grau do polinômio.
- * @param coeffs Arranjo com os coeficientes do polinômio. Seu tamanho deve ser
- * no mínimo \f$\left(\text{grau}- 1\right)\f$.
- * @return Ponteiro para o objeto polinômio criado.
+ * @details Sem arena, usa `aligned_alloc()`. Com arena, avança pelos blocos
+ * da arena (que, após uma reinicialização, já estão alocados) até encontrar
+ * um com espaço, e só então aloca um bloco novo ao final da lista.
+ *
+ * @param arena A arena de onde alocar, ou `nullptr` para usar o heap.
+ * @param size O tamanho, em bytes.
+ * @return Ponteiro para o bloco, ou `nullptr` se faltar memória.
  */
-static Polynomial *polynomial_new(size_t degree, double *coeffs)
+static void *function_alloc(FunctionArena *arena, size_t size)
 {
-	// Aloca memória para o objeto e verifica se houve erro.
-	Polynomial *p = malloc(sizeof(Polynomial));
-	ERRNOCHECK(p == nullptr, "Falha ao alocar memória para polinômio", ret);
+	// Arredonda para que os blocos seguintes também fiquem alinhados (e
+	// porque `aligned_alloc()` exige um múltiplo do alinhamento).
+	size = (size + FUNCTION_ALIGN - 1) / FUNCTION_ALIGN * FUNCTION_ALIGN;
+	if (arena == nullptr)
+		return aligned_alloc(FUNCTION_ALIGN, size);
 
-	p->degree = degree; // Define o grau do polinômio.
+	while (arena->current != nullptr &&
+	       arena->used + size > arena->current->size &&
+	       arena->current->next != nullptr) {
+		arena->current = arena->current->next;
+		arena->used = 0;
+	}
 
-	// Aloca memória para o arranjo de coeficientes e verifica erro.
-	p->coefficients = malloc((degree + 1) * sizeof(double));
-	ERRNOCHECK(p->coefficients == nullptr,
-		   "Falha ao alocar memória para os coeficientes", cleanup);
+	if (arena->current == nullptr ||
+	    arena->used + size > arena->current->size) {
+		size_t bytes = size > arena->block_size ? size :
+							  arena->block_size;
+		bytes = (bytes + FUNCTION_ALIGN - 1) / FUNCTION_ALIGN *
+			FUNCTION_ALIGN;
+		ArenaBlock *block =
+			aligned_alloc(FUNCTION_ALIGN, sizeof(*block) + bytes);
+		ERRNOCHECK(block == nullptr,
+			   "Falha ao alocar memória para arena", ret);
 
-	// Eficientemente copia os coeficientes recebidos para o objeto.
-	memcpy(p->coefficients, coeffs, (degree + 1) * sizeof(typeof(*coeffs)));
+		block->next = nullptr;
+		block->size = bytes;
+		if (arena->current == nullptr)
+			arena->head = block;
+		else
+			arena->current->next = block;
+		arena->current = block;
+		arena->used = 0;
+	}
 
-	return p; // Retorna a referência ao objeto.
+	void *ptr = arena->current->data + arena->used;
+	arena->used += size;
+	return ptr;
 
-cleanup:
-	free(p);
 ret:
 	return nullptr;
 }
 
 /**
- * @brief Libera um objeto que implementa uma função de tipo polinômio.
+ * @brief Instancia uma função de tipo polinômio.
+ *
+ * Recebe um grau (número natural) e um arranjo com os coeficientes, em ordem
+ * crescente. Ex.: Para um \f$f(x) = 1 + 2x^2 + 3x^4\f$, o grau será 4, e o
+ * arranjo será: \f${1, 0, 2, 0, 3}\f$. A função, o polinômio e uma cópia dos
+ * coeficientes são alocados num único `PolynomialBlock`, ou, se houver poucos
+ * termos num grau alto, num `SparseBlock` (ver `sparse_new()`).
  *
- * @param ptr Ponteiro para o objeto polinômio a ser liberado.
+ * @param arena A arena de onde alocar, ou `nullptr` para usar o heap.
+ * @param degree O grau do polinômio.
+ * @param coeffs Arranjo com os coeficientes do polinômio. Seu tamanho deve ser
+ * no mínimo \f$\left(\text{grau} + 1\right)\f$.
+ * @return Ponteiro para a função criada, ou `nullptr` em caso de erro.
  */
-static void polynomial_free(Polynomial *ptr)
+static Function *polynomial_new(FunctionArena *arena, size_t degree,
+				const double *coeffs)
 {
-	free(ptr->coefficients); // Libera arranjo dos coeficientes.
-	free(ptr); // Libera o objeto em si.
+	size_t size = (degree + 1) * sizeof(*coeffs);
+
+	// Se houver poucos termos num grau alto, usa a representação esparsa.
+	if (degree >= FUNCTION_SPARSE_MIN_DEGREE) {
+		size_t count = 0;
+		for (size_t k = 0; k <= degree; ++k)
+			count += coeffs[k] != 0;
+		if (count * FUNCTION_SPARSE_MAX_FILL <= degree + 1)
+			return sparse_new(arena, degree, coeffs, count);
+	}
+
+	// Aloca memória para o bloco e verifica se houve erro.
+	PolynomialBlock *p = function_alloc(arena, sizeof(*p) + size);
+	ERRNOCHECK(p == nullptr, "Falha ao alocar memória para polinômio", ret);
+
+	// Copia os coeficientes para dentro do bloco.
+	p->poly.degree = degree;
+	p->poly.coefficients = p->data;
+	memcpy(p->data, coeffs, size);
+
+	// Define o tipo e as funções que avaliam o polinômio.
+	p->func.type = POLYNOMIAL;
+	p->func.eval = polynomial_kernel(degree);
+	p->func.eval_batch = (batch_ptr_t)&polynomial_eval_batch;
+	p->func.impl = &p->poly;
+	return &p->func;
+
+ret:
+	return nullptr;
 }
 
 /**
  * @brief Avalia um dado objeto polinômio passado pela referência `ptr` em um
  * dado `x`.
  *
+ * @details É a avaliação de referência, para qualquer grau. Os polinômios
+ * densos usam, em `Function::eval`, o núcleo de Estrin escolhido por
+ * `polynomial_kernel()`, que difere desta em no máximo
+ * `SIMD_POLY_ERROR_BOUND`.
+ *
  * @param x O valor em que o polinômio será avaliado.
  * @param ptr Ponteiro para o objeto polinômio.
  * @return O valor do polinômio avaliado em `x`.
@@ -175,4 +547,357 @@ extern double polynomial_eval(double x, Polynomial *ptr)
 		res += ptr->coefficients[i] * x_pow;
 
 	return res; // Retorna a resposta calculada.
+}
+
+/**
+ * @brief Avalia um polinômio pelo esquema de Estrin em blocos.
+ *
+ * @details Os coeficientes que sobram acima do último bloco completo de
+ * `FUNCTION_ESTRIN_BLOCK` são reduzidos primeiro, pela regra de Horner em
+ * \f$x\f$; em seguida, os blocos, de cima para baixo, pela regra de Horner
+ * em \f$x^4\f$. O valor de cada bloco não depende do acumulador, e o
+ * processador o calcula enquanto as operações anteriores da cadeia terminam.
+ * Quando `degree` é uma constante, os dois laços são desenrolados.
+ *
+ * @param x O valor em que o polinômio será avaliado.
+ * @param c Os `degree + 1` coeficientes, em ordem crescente de grau.
+ * @param degree O grau do polinômio.
+ * @return O valor do polinômio avaliado em `x`.
+ */
+static inline double polynomial_estrin(double x, const double *c,
+				       size_t degree)
+{
+	size_t b = (degree + 1) / FUNCTION_ESTRIN_BLOCK;
+	size_t top = b * FUNCTION_ESTRIN_BLOCK;
+	double x2 = x * x, x4 = x2 * x2, acc;
+
+	// O acumulador começa no coeficiente mais alto, ou no bloco mais alto
+	// se não sobrar nenhum, e não em zero: uma multiplicação a menos na
+	// cadeia, o que pesa nos graus pequenos.
+	if (top <= degree) {
+		acc = c[degree];
+		for (size_t k = degree; k-- > top;)
+			acc = acc * x + c[k];
+	} else {
+		const double *q = c + --b * FUNCTION_ESTRIN_BLOCK;
+		acc = (q[0] + q[1] * x) + (q[2] + q[3] * x) * x2;
+	}
+
+	while (b-- > 0) {
+		const double *q = c + b * FUNCTION_ESTRIN_BLOCK;
+		acc = acc * x4 + ((q[0] + q[1] * x) + (q[2] + q[3] * x) * x2);
+	}
+	return acc;
+}
+
+/**
+ * @brief Define um núcleo de Estrin para um grau fixo.
+ *
+ * @details Com o grau constante, `polynomial_estrin()` é desenrolada, e o
+ * grau não é lido do polinômio. O resultado é o do núcleo de grau alto
+ * (`polynomial_eval_estrin()`), e difere do de `polynomial_eval()` em no
+ * máximo `SIMD_POLY_ERROR_BOUND`.
+ *
+ * @param n O grau.
+ */
+#define POLYNOMIAL_EVAL_FIXED(n)                                              \
+	static double polynomial_eval_##n(double x, void *impl)               \
+	{                                                                     \
+		const double *c = ((const Polynomial *)impl)->coefficients;   \
+		return polynomial_estrin(x, c, (n));                          \
+	}
+
+// Núcleos de grau fixo, de 0 a `FUNCTION_FIXED_MAX_DEGREE`.
+POLYNOMIAL_EVAL_FIXED(0)
+POLYNOMIAL_EVAL_FIXED(1)
+POLYNOMIAL_EVAL_FIXED(2)
+POLYNOMIAL_EVAL_FIXED(3)
+POLYNOMIAL_EVAL_FIXED(4)
+POLYNOMIAL_EVAL_FIXED(5)
+POLYNOMIAL_EVAL_FIXED(6)
+POLYNOMIAL_EVAL_FIXED(7)
+POLYNOMIAL_EVAL_FIXED(8)
+POLYNOMIAL_EVAL_FIXED(9)
+POLYNOMIAL_EVAL_FIXED(10)
+POLYNOMIAL_EVAL_FIXED(11)
+POLYNOMIAL_EVAL_FIXED(12)
+POLYNOMIAL_EVAL_FIXED(13)
+POLYNOMIAL_EVAL_FIXED(14)
+POLYNOMIAL_EVAL_FIXED(15)
+POLYNOMIAL_EVAL_FIXED(16)
+
+/**
+ * @brief Escolhe a versão de `Function::eval` para um polinômio denso.
+ *
+ * @param degree O grau do polinômio.
+ * @return O núcleo de Estrin de grau fixo, até `FUNCTION_FIXED_MAX_DEGREE`,
+ * ou o de grau qualquer acima dele.
+ */
+static eval_ptr_t polynomial_kernel(size_t degree)
+{
+	static const eval_ptr_t fixed[FUNCTION_FIXED_MAX_DEGREE + 1] = {
+		&polynomial_eval_0,  &polynomial_eval_1,  &polynomial_eval_2,
+		&polynomial_eval_3,  &polynomial_eval_4,  &polynomial_eval_5,
+		&polynomial_eval_6,  &polynomial_eval_7,  &polynomial_eval_8,
+		&polynomial_eval_9,  &polynomial_eval_10, &polynomial_eval_11,
+		&polynomial_eval_12, &polynomial_eval_13, &polynomial_eval_14,
+		&polynomial_eval_15, &polynomial_eval_16,
+	};
+
+	if (degree <= FUNCTION_FIXED_MAX_DEGREE)
+		return fixed[degree];
+	return (eval_ptr_t)&polynomial_eval_estrin;
+}
+
+/**
+ * @brief Avalia um polinômio de grau alto pelo esquema de Estrin em blocos.
+ *
+ * @param x O valor em que o polinômio será avaliado.
+ * @param ptr Ponteiro para o objeto polinômio, de grau maior que
+ * `FUNCTION_FIXED_MAX_DEGREE`.
+ * @return O valor do polinômio avaliado em `x`.
+ */
+static double polynomial_eval_estrin(double x, Polynomial *ptr)
+{
+	return polynomial_estrin(x, ptr->coefficients, ptr->degree);
+}
+
+/**
+ * @brief Avalia um dado objeto polinômio passado pela referência `ptr` em
+ * vários pontos de uma só vez.
+ *
+ * @details Se o processador suportar algum conjunto de instruções vetoriais,
+ * delega ao núcleo selecionado em `simd.h`, que aplica a regra de Horner a
+ * vários pontos por instrução. O resultado então difere do de
+ * `polynomial_eval()` em no máximo `SIMD_POLY_ERROR_BOUND`.
+ *
+ * Caso contrário, o laço externo percorre os graus do polinômio e o interno
+ * percorre os pontos, de modo que as operações sobre pontos diferentes são
+ * independentes entre si e o compilador pode vetorizá-las. Para cada ponto, a
+ * sequência de operações é exatamente a mesma de `polynomial_eval()`, logo o
+ * resultado é idêntico bit a bit.
+ *
+ * @param x Arranjo com os pontos em que o polinômio será avaliado.
+ * @param y Arranjo onde os resultados serão escritos.
+ * @param count Número de pontos a avaliar.
+ * @param ptr Ponteiro para o objeto polinômio.
+ * @note Essa função é definida com vinculação externa pois não é invocada
+ * nessa unidade de compilação.
+ */
+extern void polynomial_eval_batch(const double *x, double *y, size_t count,
+				  Polynomial *ptr)
+{
+	// Se houver um núcleo vetorizado, usa-o.
+	if (simd_level() != SIMD_SCALAR) {
+		simd_poly_horner(ptr->coefficients, ptr->degree, x, y, count);
+		return;
+	}
+
+	// Processa os pontos em blocos para que as potências de cada bloco
+	// caibam na pilha (e no cache L1).
+	constexpr size_t block = 256;
+	double x_pow[block];
+
+	for (size_t start = 0; start < count; start += block) {
+		size_t len = count - start < block ? count - start : block;
+		const double *xb = x + start;
+		double *yb = y + start;
+
+		// Inicializa as respostas e as potências de grau 0.
+		for (size_t j = 0; j < len; ++j) {
+			yb[j] = 0;
+			x_pow[j] = 1;
+		}
+
+		// Acumula cada termo do polinômio em todos os pontos do bloco.
+		for (size_t i = 0; i <= ptr->degree; ++i) {
+			double c = ptr->coefficients[i];
+			for (size_t j = 0; j < len; ++j) {
+				yb[j] += c * x_pow[j];
+				x_pow[j] *= xb[j];
+			}
+		}
+	}
+}
+
+// Funções de tipo polinômio esparso:
+
+/**
+ * @brief Instancia um polinômio na representação esparsa.
+ *
+ * @param arena A arena de onde alocar, ou `nullptr` para usar o heap.
+ * @param degree O grau do polinômio.
+ * @param coeffs Arranjo denso com os `degree + 1` coeficientes.
+ * @param count Número de coeficientes não nulos em `coeffs`.
+ * @return Ponteiro para a função criada, ou `nullptr` em caso de erro.
+ */
+static Function *sparse_new(FunctionArena *arena, size_t degree,
+			    const double *coeffs, size_t count)
+{
+	SparseBlock *p = function_alloc(arena, sizeof(*p) +
+						       count * sizeof(*p->data));
+	ERRNOCHECK(p == nullptr, "Falha ao alocar memória para polinômio", ret);
+
+	// Copia somente os termos não nulos, em ordem crescente de expoente.
+	size_t t = 0;
+	for (size_t k = 0; k <= degree; ++k)
+		if (coeffs[k] != 0)
+			p->data[t++] = (SparseTerm){ k, coeffs[k] };
+
+	p->poly.degree = degree;
+	p->poly.count = count;
+	p->poly.terms = p->data;
+
+	p->func.type = POLYNOMIAL;
+	p->func.eval = (eval_ptr_t)&sparse_eval;
+	p->func.eval_batch = (batch_ptr_t)&sparse_eval_batch;
+	p->func.impl = &p->poly;
+	return &p->func;
+
+ret:
+	return nullptr;
+}
+
+/**
+ * @brief Eleva um número a uma potência natural por quadrados sucessivos.
+ *
+ * @details Percorre os bits do expoente do menos para o mais significativo,
+ * com \f$\lfloor \log_2 n \rfloor\f$ quadrados e no máximo outras tantas
+ * multiplicações. `sparse_eval_batch()` repete exatamente esta sequência.
+ *
+ * @param x A base.
+ * @param n O expoente.
+ * @return \f$x^n\f$.
+ */
+static double sparse_pow(double x, size_t n)
+{
+	double res = 1;
+
+	for (;;) {
+		if (n & 1)
+			res *= x;
+		n >>= 1;
+		if (n == 0)
+			return res;
+		x *= x;
+	}
+}
+
+/**
+ * @brief Avalia um polinômio esparso em um dado `x`.
+ *
+ * @param x O valor em que o polinômio será avaliado.
+ * @param ptr Ponteiro para o polinômio esparso.
+ * @return O valor do polinômio avaliado em `x`.
+ * @note Essa função é definida com vinculação externa pois não é invocada
+ * nessa unidade de compilação.
+ */
+extern double sparse_eval(double x, SparsePolynomial *ptr)
+{
+	double res = 0, x_pow = 1, x_gap = 1;
+	size_t prev = 0, gap_prev = 0;
+
+	for (size_t i = 0; i < ptr->count; ++i) {
+		// Avança a potência até o expoente do termo, reaproveitando a
+		// potência da diferença anterior se ela se repetir.
+		size_t gap = ptr->terms[i].exponent - prev;
+		if (gap != gap_prev) {
+			x_gap = sparse_pow(x, gap);
+			gap_prev = gap;
+		}
+		x_pow *= x_gap;
+		res += ptr->terms[i].coefficient * x_pow;
+		prev = ptr->terms[i].exponent;
+	}
+
+	return res;
+}
+
+/**
+ * @brief Avalia um polinômio esparso em vários pontos de uma só vez.
+ *
+ * @details Como em `polynomial_eval_batch()`, o laço externo percorre os
+ * termos e os internos percorrem os pontos de um bloco, que são independentes
+ * entre si e vetorizados pelo compilador. Cada ponto segue exatamente a
+ * sequência de operações de `sparse_eval()`, de modo que o resultado é
+ * idêntico bit a bit.
+ *
+ * @param x Arranjo com os pontos em que o polinômio será avaliado.
+ * @param y Arranjo onde os resultados serão escritos.
+ * @param count Número de pontos a avaliar.
+ * @param ptr Ponteiro para o polinômio esparso.
+ * @note Essa função é definida com vinculação externa pois não é invocada
+ * nessa unidade de compilação.
+ */
+extern void sparse_eval_batch(const double *x, double *y, size_t count,
+			      SparsePolynomial *ptr)
+{
+	constexpr size_t block = 256;
+	double x_pow[block], x_gap[block], base[block];
+
+	for (size_t start = 0; start < count; start += block) {
+		size_t len = count - start < block ? count - start : block;
+		const double *xb = x + start;
+		double *yb = y + start;
+		size_t prev = 0, gap_prev = 0;
+
+		for (size_t j = 0; j < len; ++j) {
+			yb[j] = 0;
+			x_pow[j] = 1;
+			x_gap[j] = 1;
+		}
+
+		for (size_t i = 0; i < ptr->count; ++i) {
+			size_t gap = ptr->terms[i].exponent - prev;
+			double c = ptr->terms[i].coefficient;
+
+			// Calcula x^gap em todos os pontos, como `sparse_pow()`.
+			if (gap != gap_prev) {
+				for (size_t j = 0; j < len; ++j) {
+					x_gap[j] = 1;
+					base[j] = xb[j];
+				}
+				for (size_t n = gap;;) {
+					if (n & 1)
+						for (size_t j = 0; j < len; ++j)
+							x_gap[j] *= base[j];
+					n >>= 1;
+					if (n == 0)
+						break;
+					for (size_t j = 0; j < len; ++j)
+						base[j] *= base[j];
+				}
+				gap_prev = gap;
+			}
+
+			for (size_t j = 0; j < len; ++j) {
+				x_pow[j] *= x_gap[j];
+				yb[j] += c * x_pow[j];
+			}
+			prev = ptr->terms[i].exponent;
+		}
+	}
+}
+
+/**
+ * @brief Incorpora uma palavra a um resumo de 128 bits.
+ *
+ * @details Cada metade do resumo é uma cadeia independente da função de
+ * mistura do SplitMix64, com constantes aditivas distintas, de modo que as
+ * duas metades não colidem juntas por acaso.
+ *
+ * @param digest O resumo a atualizar.
+ * @param word A palavra.
+ */
+static void digest_mix(uint64_t digest[2], uint64_t word)
+{
+	static const uint64_t step[2] = { 0x9e3779b97f4a7c15,
+					  0xd1b54a32d192ed03 };
+
+	for (size_t i = 0; i < 2; ++i) {
+		uint64_t h = (digest[i] ^ word) + step[i];
+		h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9;
+		h = (h ^ (h >> 27)) * 0x94d049bb133111eb;
+		digest[i] = h ^ (h >> 31);
+	}
 }
\ No newline at end of file
@@ -0,0 +1,360 @@
+// SPDX-License-Identifier: ISC
+
+/**
+ * @file func2d.c
+ * @brief Implementações das funções de duas variáveis.
+ *
+ * @details Este arquivo contém a criação, a avaliação e a liberação das
+ * funções de duas variáveis declaradas em `func2d.h`: os polinômios em
+ * \f$x\f$ e \f$y\f$ e os produtos de duas funções de uma variável.
+ */
+
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "func2d.h"
+#include "simd.h"
+#include "util.h"
+
+/**
+ * @brief Alinhamento, em bytes, dos blocos alocados para funções.
+ */
+#define FUNCTION2D_ALIGN 64
+
+/**
+ * @brief Número de pontos de cada bloco da avaliação em linha de um
+ * polinômio, e maior número de coeficientes reduzidos de uma só vez.
+ */
+#define FUNCTION2D_ROW_BLOCK 256
+
+/**
+ * @brief Polinômio em duas variáveis alocado num único bloco.
+ *
+ * @details Como `PolynomialBlock` em `func.c`: o objeto função, o polinômio
+ * e a matriz de coeficientes ficam contíguos, e a matriz fica alinhada a
+ * `FUNCTION2D_ALIGN` bytes.
+ */
+typedef struct {
+	Function2D func; /**< O objeto função, no início do bloco. */
+	Bipolynomial poly; /**< O polinômio referenciado por `func.impl`. */
+	alignas(FUNCTION2D_ALIGN) double data[]; /**< Os coeficientes. */
+} BipolynomialBlock;
+
+/**
+ * @brief Produto de duas funções de uma variável.
+ */
+typedef struct {
+	Function *fx; /**< A função de \f$x\f$. */
+	Function *fy; /**< A função de \f$y\f$. */
+} Separable;
+
+/**
+ * @brief Função separável alocada num único bloco.
+ */
+typedef struct {
+	Function2D func; /**< O objeto função, no início do bloco. */
+	Separable sep; /**< Os fatores referenciados por `func.impl`. */
+} SeparableBlock;
+
+// Declarações internas.
+static Function2D *bipolynomial_new(size_t degree_x, size_t degree_y,
+				    const double *coeffs);
+static Function2D *separable_new(Function *fx, Function *fy);
+static double bipolynomial_reduce(const Bipolynomial *ptr, size_t i,
+				  double y);
+extern double bipolynomial_eval(double x, double y, Bipolynomial *ptr);
+extern void bipolynomial_eval_row(const double *x, size_t count, double y,
+				  double *out, Bipolynomial *ptr);
+extern double separable_eval(double x, double y, Separable *ptr);
+extern void separable_eval_row(const double *x, size_t count, double y,
+			       double *out, Separable *ptr);
+
+// Instancia uma função de duas variáveis a partir de um tipo e de n
+// parâmetros.
+[[nodiscard("Ignorar retorno pode causar vazamento de memória")]]
+Function2D *function2d_new(Function2DType type, ...)
+{
+	va_list args;
+	Function2D *func = nullptr;
+
+	va_start(args, type);
+	switch (type) {
+	case BIPOLYNOMIAL:
+		size_t degree_x = va_arg(args, size_t);
+		size_t degree_y = va_arg(args, size_t);
+		const double *coeffs = va_arg(args, const double *);
+		func = bipolynomial_new(degree_x, degree_y, coeffs);
+		break;
+	case SEPARABLE:
+		Function *fx = va_arg(args, Function *);
+		Function *fy = va_arg(args, Function *);
+		func = separable_new(fx, fy);
+		break;
+	default:
+		fprintf(stderr, "Tipo de função desconhecido: %d\n", type);
+	}
+	va_end(args);
+
+	return func;
+}
+
+// Libera uma função de duas variáveis. Os objetos de todos os tipos estão no
+// mesmo bloco da função.
+void function2d_free(Function2D *func)
+{
+	free(func);
+}
+
+// Acessa os coeficientes de um polinômio em duas variáveis.
+const double *function2d_bipolynomial(const Function2D *func,
+				      size_t *degree_x, size_t *degree_y)
+{
+	if (func->type != BIPOLYNOMIAL)
+		return nullptr;
+
+	const Bipolynomial *p = func->impl;
+	*degree_x = p->degree_x;
+	*degree_y = p->degree_y;
+	return p->coefficients;
+}
+
+// Acessa os fatores de uma função separável.
+bool function2d_separable(const Function2D *func, Function **fx,
+			  Function **fy)
+{
+	if (func->type != SEPARABLE)
+		return false;
+
+	const Separable *s = func->impl;
+	*fx = s->fx;
+	*fy = s->fy;
+	return true;
+}
+
+/**
+ * @brief Instancia um polinômio em duas variáveis.
+ *
+ * @param degree_x O grau em \f$x\f$.
+ * @param degree_y O grau em \f$y\f$.
+ * @param coeffs A matriz de \f$(d_y + 1) \times (d_x + 1)\f$ coeficientes,
+ * linha após linha.
+ * @return Ponteiro para a função criada, ou `nullptr` em caso de erro.
+ */
+static Function2D *bipolynomial_new(size_t degree_x, size_t degree_y,
+				    const double *coeffs)
+{
+	// Verifica se o tamanho da matriz é representável.
+	if (degree_x >= SIZE_MAX / sizeof(*coeffs) ||
+	    degree_y >= SIZE_MAX / sizeof(*coeffs) / (degree_x + 1)) {
+		fprintf(stderr, "Graus grandes demais: %zu e %zu\n", degree_x,
+			degree_y);
+		return nullptr;
+	}
+
+	size_t size = (degree_x + 1) * (degree_y + 1) * sizeof(*coeffs);
+	size_t bytes = sizeof(BipolynomialBlock) + size;
+	bytes = (bytes + FUNCTION2D_ALIGN - 1) / FUNCTION2D_ALIGN *
+		FUNCTION2D_ALIGN;
+	BipolynomialBlock *p = aligned_alloc(FUNCTION2D_ALIGN, bytes);
+	ERRNOCHECK(p == nullptr, "Falha ao alocar memória para polinômio", ret);
+
+	p->poly.degree_x = degree_x;
+	p->poly.degree_y = degree_y;
+	p->poly.coefficients = p->data;
+	memcpy(p->data, coeffs, size);
+
+	p->func.type = BIPOLYNOMIAL;
+	p->func.eval = (eval2d_ptr_t)&bipolynomial_eval;
+	p->func.eval_row = (row_ptr_t)&bipolynomial_eval_row;
+	p->func.impl = &p->poly;
+	return &p->func;
+
+ret:
+	return nullptr;
+}
+
+/**
+ * @brief Instancia o produto de duas funções de uma variável.
+ *
+ * @param fx A função de \f$x\f$.
+ * @param fy A função de \f$y\f$.
+ * @return Ponteiro para a função criada, ou `nullptr` em caso de erro.
+ */
+static Function2D *separable_new(Function *fx, Function *fy)
+{
+	if (fx == nullptr || fy == nullptr) {
+		fprintf(stderr, "Fatores nulos na função separável\n");
+		return nullptr;
+	}
+
+	size_t bytes = (sizeof(SeparableBlock) + FUNCTION2D_ALIGN - 1) /
+		       FUNCTION2D_ALIGN * FUNCTION2D_ALIGN;
+	SeparableBlock *s = aligned_alloc(FUNCTION2D_ALIGN, bytes);
+	ERRNOCHECK(s == nullptr, "Falha ao alocar memória para função", ret);
+
+	s->sep = (Separable){ fx, fy };
+	s->func.type = SEPARABLE;
+	s->func.eval = (eval2d_ptr_t)&separable_eval;
+	s->func.eval_row = (row_ptr_t)&separable_eval_row;
+	s->func.impl = &s->sep;
+	return &s->func;
+
+ret:
+	return nullptr;
+}
+
+/**
+ * @brief Reduz uma coluna da matriz de um polinômio em duas variáveis a um
+ * coeficiente em \f$x\f$.
+ *
+ * @param ptr Ponteiro para o polinômio.
+ * @param i A potência de \f$x\f$.
+ * @param y A ordenada.
+ * @return \f$r_i = \sum_j c_{j,i} y^j\f$, pela regra de Horner em \f$y\f$.
+ */
+static double bipolynomial_reduce(const Bipolynomial *ptr, size_t i,
+				  double y)
+{
+	size_t stride = ptr->degree_x + 1;
+	const double *c = ptr->coefficients + i;
+	double r = c[ptr->degree_y * stride];
+
+	for (size_t j = ptr->degree_y; j-- > 0;)
+		r = r * y + c[j * stride];
+	return r;
+}
+
+/**
+ * @brief Avalia um polinômio em duas variáveis num ponto.
+ *
+ * @param x A abscissa do ponto.
+ * @param y A ordenada do ponto.
+ * @param ptr Ponteiro para o polinômio.
+ * @return O valor do polinômio no ponto.
+ * @note Essa função é definida com vinculação externa pois não é invocada
+ * nessa unidade de compilação.
+ */
+extern double bipolynomial_eval(double x, double y, Bipolynomial *ptr)
+{
+	double res = 0, x_pow = 1;
+
+	for (size_t i = 0; i <= ptr->degree_x; ++i, x_pow *= x)
+		res += bipolynomial_reduce(ptr, i, y) * x_pow;
+	return res;
+}
+
+/**
+ * @brief Avalia um polinômio em duas variáveis numa linha de pontos.
+ *
+ * @details Se houver um núcleo vetorizado e o grau em \f$x\f$ for menor que
+ * `FUNCTION2D_ROW_BLOCK`, todos os coeficientes \f$r_i\f$ são reduzidos de
+ * uma vez (com a regra de Horner em \f$y\f$ vetorizada sobre \f$i\f$, na
+ * mesma sequência de operações de `bipolynomial_reduce()`), e o polinômio em
+ * \f$x\f$ resultante é avaliado em todos os pontos por `simd_poly_horner()`.
+ * O resultado então difere do de `bipolynomial_eval()` em no máximo
+ * `SIMD_POLY_ERROR_BOUND` do polinômio reduzido.
+ *
+ * Caso contrário, os pontos são processados em blocos de
+ * `FUNCTION2D_ROW_BLOCK`, como em `polynomial_eval_batch()`: o laço externo
+ * percorre as potências de \f$x\f$, cujo coeficiente \f$r_i\f$ é reduzido
+ * uma vez por bloco, e o interno percorre os pontos, de modo que o compilador
+ * pode vetorizá-lo. Para cada ponto, a sequência de operações é a mesma de
+ * `bipolynomial_eval()`.
+ *
+ * @param x Arranjo com as abscissas dos pontos.
+ * @param count Número de pontos.
+ * @param y A ordenada comum a todos os pontos.
+ * @param out Arranjo onde os resultados serão escritos.
+ * @param ptr Ponteiro para o polinômio.
+ * @note Essa função é definida com vinculação externa pois não é invocada
+ * nessa unidade de compilação.
+ */
+extern void bipolynomial_eval_row(const double *x, size_t count, double y,
+				  double *out, Bipolynomial *ptr)
+{
+	double x_pow[FUNCTION2D_ROW_BLOCK];
+
+	// Se houver um núcleo vetorizado, reduz os coeficientes e usa-o.
+	if (simd_level() != SIMD_SCALAR &&
+	    ptr->degree_x < FUNCTION2D_ROW_BLOCK) {
+		size_t terms = ptr->degree_x + 1;
+		const double *c = ptr->coefficients;
+		double red[FUNCTION2D_ROW_BLOCK];
+
+		memcpy(red, c + ptr->degree_y * terms, terms * sizeof(*red));
+		for (size_t j = ptr->degree_y; j-- > 0;)
+			for (size_t i = 0; i < terms; ++i)
+				red[i] = red[i] * y + c[j * terms + i];
+		simd_poly_horner(red, ptr->degree_x, x, out, count);
+		return;
+	}
+
+	for (size_t start = 0; start < count; start += FUNCTION2D_ROW_BLOCK) {
+		size_t len = count - start < FUNCTION2D_ROW_BLOCK ?
+				     count - start :
+				     FUNCTION2D_ROW_BLOCK;
+		const double *xb = x + start;
+		double *ob = out + start;
+
+		for (size_t t = 0; t < len; ++t) {
+			ob[t] = 0;
+			x_pow[t] = 1;
+		}
+		for (size_t i = 0; i <= ptr->degree_x; ++i) {
+			double r = bipolynomial_reduce(ptr, i, y);
+			for (size_t t = 0; t < len; ++t) {
+				ob[t] += r * x_pow[t];
+				x_pow[t] *= xb[t];
+			}
+		}
+	}
+}
+
+/**
+ * @brief Avalia uma função separável num ponto.
+ *
+ * @param x A abscissa do ponto.
+ * @param y A ordenada do ponto.
+ * @param ptr Ponteiro para os fatores.
+ * @return \f$f(x) g(y)\f$.
+ * @note Essa função é definida com vinculação externa pois não é invocada
+ * nessa unidade de compilação.
+ */
+extern double separable_eval(double x, double y, Separable *ptr)
+{
+	return ptr->fx->eval(x, ptr->fx->impl) *
+	       ptr->fy->eval(y, ptr->fy->impl);
+}
+
+/**
+ * @brief Avalia uma função separável numa linha de pontos.
+ *
+ * @details Avalia \f$f\f$ em lote, se possível, e multiplica todos os
+ * valores por \f$g(y)\f$, calculado uma só vez.
+ *
+ * @param x Arranjo com as abscissas dos pontos.
+ * @param count Número de pontos.
+ * @param y A ordenada comum a todos os pontos.
+ * @param out Arranjo onde os resultados serão escritos.
+ * @param ptr Ponteiro para os fatores.
+ * @note Essa função é definida com vinculação externa pois não é invocada
+ * nessa unidade de compilação.
+ */
+extern void separable_eval_row(const double *x, size_t count, double y,
+			       double *out, Separable *ptr)
+{
+	Function *fx = ptr->fx;
+	double g = ptr->fy->eval(y, ptr->fy->impl);
+
+	if (fx->eval_batch != nullptr)
+		fx->eval_batch(x, out, count, fx->impl);
+	else
+		for (size_t t = 0; t < count; ++t)
+			out[t] = fx->eval(x[t], fx->impl);
+
+	for (size_t t = 0; t < count; ++t)
+		out[t] *= g;
+}
\ No newline at end of file
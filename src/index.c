@@ -0,0 +1,372 @@
+// SPDX-License-Identifier: ISC
+
+/**
+ * @file index.c
+ * @brief Implementação do índice de somas prefixadas.
+ *
+ * @details O índice ocupa um único bloco de memória com o mesmo formato do
+ * arquivo: o cabeçalho, seguido das \f$n + 2\f$ somas prefixadas
+ * \f$P_0 = 0, P_1, \ldots, P_{n+1}\f$. Um índice construído fica num bloco
+ * alocado no heap; um índice aberto de um arquivo fica num mapeamento
+ * compartilhado somente para leitura.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <fcntl.h>
+#include <float.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "func.h"
+#include "index.h"
+#include "pool.h"
+#include "riemann.h"
+#include "util.h"
+
+/**
+ * @brief Número de pontos avaliados por chamada à avaliação em lote.
+ */
+#define INDEX_CHUNK 512
+
+/**
+ * @brief Distância máxima, em múltiplos de \f$\varepsilon\f$ relativos à
+ * posição, para que um extremo seja considerado um ponto da grade.
+ */
+#define INDEX_SNAP (64 * DBL_EPSILON)
+
+/**
+ * @brief Identificação de um arquivo de índice.
+ */
+static const char index_magic[8] = { 'R', 'I', 'E', 'M', 'I', 'N', 'D', 'X' };
+
+/**
+ * @brief Estrutura que define um índice.
+ */
+struct RiemannIndex {
+	void *base; /**< Início do bloco ou do mapeamento. */
+	size_t size; /**< Tamanho do bloco ou do mapeamento, em bytes. */
+	bool mapped; /**< Se o índice foi mapeado de um arquivo. */
+	const IndexHeader *header; /**< O cabeçalho, no início do bloco. */
+	const IndexPrefix *prefix; /**< As \f$n + 2\f$ somas prefixadas. */
+};
+
+/**
+ * @brief Contexto compartilhado pelas tarefas que constroem o índice.
+ */
+typedef struct {
+	double a; /**< Limite inferior do domínio. */
+	double dx; /**< Largura de cada retângulo. */
+	Function *func; /**< A função. */
+	size_t count; /**< Número de pontos da grade (\f$n + 1\f$). */
+	IndexPrefix *prefix; /**< As somas prefixadas, a partir de \f$P_0\f$. */
+	IndexPrefix *totals; /**< O total de cada bloco e, depois, a soma dos
+			      * totais dos blocos anteriores. */
+} BuildCtx;
+
+// Declarações internas.
+static void index_scan_task(size_t index, void *ctx);
+static void index_offset_task(size_t index, void *ctx);
+static void index_point(const RiemannIndex *idx, double x, size_t shift,
+			double *sum, double *comp);
+
+// Constrói o índice de uma função numa grade.
+[[nodiscard("Ignorar retorno pode causar vazamento de memória")]]
+RiemannIndex *index_new(double min, double max, Function *func, size_t n,
+			unsigned threads)
+{
+	errno = EINVAL;
+	ERRNOCHECK(n == 0 || n > SIZE_MAX / (2 * sizeof(IndexPrefix)),
+		   "Número de retângulos inválido para o índice", ret);
+
+	RiemannIndex *idx = malloc(sizeof(*idx));
+	ERRNOCHECK(idx == nullptr, "Falha ao alocar índice", ret);
+
+	// Aloca o cabeçalho e as somas num bloco só, no formato do arquivo.
+	size_t size = sizeof(IndexHeader) + (n + 2) * sizeof(IndexPrefix);
+	size = (size + 63) / 64 * 64;
+	IndexHeader *h = aligned_alloc(64, size);
+	ERRNOCHECK(h == nullptr, "Falha ao alocar somas do índice", free_idx);
+
+	*h = (IndexHeader){
+		.version = INDEX_VERSION,
+		.byte_order = INDEX_BYTE_ORDER,
+		.header_size = sizeof(IndexHeader),
+		.entry_size = sizeof(IndexPrefix),
+		.n = n,
+		.min = min,
+		.max = max,
+	};
+	memcpy(h->magic, index_magic, sizeof(index_magic));
+	*idx = (RiemannIndex){ h, size, false, h, (IndexPrefix *)(h + 1) };
+
+	// Divide os pontos em blocos, e calcula as somas locais de cada um.
+	size_t count = n + 1;
+	size_t blocks = (count + RIEMANN_BLOCK - 1) / RIEMANN_BLOCK;
+	IndexPrefix *totals = calloc(blocks, sizeof(*totals));
+	ERRNOCHECK(totals == nullptr, "Falha ao alocar totais dos blocos",
+		   free_block);
+
+	IndexPrefix *prefix = (IndexPrefix *)(h + 1);
+	BuildCtx ctx = { min, (max - min) / n, func, count, prefix, totals };
+	if (threads == 0)
+		threads = pool_cpu_count();
+	Pool *pool = threads > 1 && blocks > 1 ? pool_global(threads) :
+						 nullptr;
+
+	prefix[0] = (IndexPrefix){ 0, 0 };
+	if (pool != nullptr)
+		pool_run(pool, blocks, threads, &index_scan_task, &ctx);
+	else
+		for (size_t i = 0; i < blocks; ++i)
+			index_scan_task(i, &ctx);
+
+	// Acumula os totais em ordem, substituindo cada um pela soma dos
+	// anteriores, e soma-a às entradas de cada bloco.
+	double sum = 0, comp = 0;
+	for (size_t i = 0; i < blocks; ++i) {
+		IndexPrefix t = totals[i];
+		totals[i] = (IndexPrefix){ sum, comp };
+		neumaier_add(&sum, &comp, t.sum);
+		neumaier_add(&sum, &comp, t.comp);
+	}
+	if (pool != nullptr)
+		pool_run(pool, blocks - 1, threads, &index_offset_task, &ctx);
+	else
+		for (size_t i = 0; i < blocks - 1; ++i)
+			index_offset_task(i, &ctx);
+
+	free(totals);
+	return idx;
+
+free_block:
+	free(h);
+free_idx:
+	free(idx);
+ret:
+	return nullptr;
+}
+
+// Mapeia um índice gravado, somente para leitura.
+[[nodiscard("Ignorar retorno pode causar vazamento de memória")]]
+RiemannIndex *index_open(const char *path)
+{
+	struct stat st;
+
+	RiemannIndex *idx = malloc(sizeof(*idx));
+	ERRNOCHECK(idx == nullptr, "Falha ao alocar índice", ret);
+	int fd = open(path, O_RDONLY);
+	ERRNOCHECK(fd < 0, path, free_idx);
+	ERRNOCHECK(fstat(fd, &st) != 0, path, close_fd);
+
+	errno = EINVAL;
+	ERRNOCHECK((uintmax_t)st.st_size < sizeof(IndexHeader) ||
+			   (uintmax_t)st.st_size > SIZE_MAX,
+		   "Tamanho inválido do arquivo de índice", close_fd);
+	idx->size = st.st_size;
+	idx->base = mmap(nullptr, idx->size, PROT_READ, MAP_SHARED, fd, 0);
+	ERRNOCHECK(idx->base == MAP_FAILED, "Falha ao mapear o índice",
+		   close_fd);
+
+	// Verifica o cabeçalho e se as somas cabem no arquivo.
+	const IndexHeader *h = idx->base;
+	size_t entries = (idx->size - sizeof(IndexHeader)) / sizeof(IndexPrefix);
+	errno = EINVAL;
+	ERRNOCHECK(memcmp(h->magic, index_magic, sizeof(index_magic)) != 0 ||
+			   h->version != INDEX_VERSION ||
+			   h->byte_order != INDEX_BYTE_ORDER ||
+			   h->header_size != sizeof(IndexHeader) ||
+			   h->entry_size != sizeof(IndexPrefix),
+		   "Formato inválido do arquivo de índice", unmap);
+	ERRNOCHECK(h->n == 0 || entries < 2 || h->n > entries - 2,
+		   "Arquivo de índice truncado", unmap);
+
+	idx->mapped = true;
+	idx->header = h;
+	idx->prefix = (const IndexPrefix *)(h + 1);
+	close(fd);
+	return idx;
+
+unmap:
+	munmap(idx->base, idx->size);
+close_fd:
+	close(fd);
+free_idx:
+	free(idx);
+ret:
+	return nullptr;
+}
+
+// Grava um índice num arquivo.
+bool index_save(const RiemannIndex *idx, const char *path)
+{
+	size_t size = sizeof(IndexHeader) +
+		      (idx->header->n + 2) * sizeof(IndexPrefix);
+
+	FILE *out = fopen(path, "wb");
+	ERRNOCHECK(out == nullptr, path, ret);
+	ERRNOCHECK(fwrite(idx->base, 1, size, out) != size,
+		   "Falha ao gravar o índice", close_out);
+	ERRNOCHECK(fclose(out) != 0, "Falha ao gravar o índice", ret);
+	return true;
+
+close_out:
+	fclose(out);
+ret:
+	return false;
+}
+
+// Libera um índice, ou desfaz o seu mapeamento.
+void index_free(RiemannIndex *idx)
+{
+	if (idx->mapped)
+		munmap(idx->base, idx->size);
+	else
+		free(idx->base);
+	free(idx);
+}
+
+// Retorna o cabeçalho de um índice.
+const IndexHeader *index_header(const RiemannIndex *idx)
+{
+	return idx->header;
+}
+
+// Calcula a soma de Riemann de um subintervalo a partir do índice.
+double index_query(const RiemannIndex *idx, double a, double b, SumType type)
+{
+	const IndexHeader *h = idx->header;
+	double sa, ca, sb, cb;
+	size_t shift;
+
+	switch (type) {
+	case DIREITA: // A soma até x_k inclui f(x_k), e não f(x_0).
+		shift = 1;
+		break;
+	case ESQUERDA: // A soma até x_k inclui f(x_0), e não f(x_k).
+		shift = 0;
+		break;
+	case MEIO: // Os pontos médios não estão na grade do índice.
+		return NAN;
+	default:
+		fprintf(stderr, "FATAL: tipo de soma inexistente: %d\n", type);
+		exit(EXIT_FAILURE);
+	}
+
+	if (!(a >= h->min && a <= h->max && b >= h->min && b <= h->max))
+		return NAN;
+
+	index_point(idx, a, shift, &sa, &ca);
+	index_point(idx, b, shift, &sb, &cb);
+	return ((sb - sa) + (cb - ca)) * ((h->max - h->min) / h->n);
+}
+
+/**
+ * @brief Tarefa que calcula as somas prefixadas locais de um bloco.
+ *
+ * @details Escreve em \f$P_{i+1}\f$ a soma dos valores do início do bloco até
+ * o ponto \f$i\f$, e o total do bloco em `totals`.
+ *
+ * @param index O índice do bloco.
+ * @param ctx Ponteiro para o contexto (`BuildCtx`).
+ */
+static void index_scan_task(size_t index, void *ctx)
+{
+	BuildCtx *c = ctx;
+	Function *func = c->func;
+	size_t first = index * RIEMANN_BLOCK;
+	size_t last = c->count - first < RIEMANN_BLOCK ? c->count :
+							  first + RIEMANN_BLOCK;
+	double x[INDEX_CHUNK], y[INDEX_CHUNK];
+	double sum = 0, comp = 0;
+
+	for (size_t i = first; i < last; i += INDEX_CHUNK) {
+		size_t len = last - i < INDEX_CHUNK ? last - i : INDEX_CHUNK;
+
+		// Avalia o pedaço com os mesmos pontos de `riemann()`.
+		for (size_t j = 0; j < len; ++j)
+			x[j] = c->a + (i + j) * c->dx;
+		if (func->eval_batch != nullptr)
+			func->eval_batch(x, y, len, func->impl);
+		else
+			for (size_t j = 0; j < len; ++j)
+				y[j] = func->eval(x[j], func->impl);
+
+		for (size_t j = 0; j < len; ++j) {
+			neumaier_add(&sum, &comp, y[j]);
+			c->prefix[i + j + 1] = (IndexPrefix){ sum, comp };
+		}
+	}
+
+	c->totals[index] = (IndexPrefix){ sum, comp };
+}
+
+/**
+ * @brief Tarefa que soma aos valores de um bloco o total dos anteriores.
+ *
+ * @details Chamada para os blocos a partir do segundo (o primeiro não tem
+ * deslocamento). A soma é feita com a transformação TwoSum, cujo erro vai
+ * para a compensação.
+ *
+ * @param index O índice do bloco, menos um.
+ * @param ctx Ponteiro para o contexto (`BuildCtx`).
+ */
+static void index_offset_task(size_t index, void *ctx)
+{
+	BuildCtx *c = ctx;
+	size_t first = (index + 1) * RIEMANN_BLOCK;
+	size_t last = c->count - first < RIEMANN_BLOCK ? c->count :
+							  first + RIEMANN_BLOCK;
+	IndexPrefix off = c->totals[index + 1];
+
+	for (size_t i = first + 1; i <= last; ++i) {
+		IndexPrefix *p = &c->prefix[i];
+		double t = p->sum + off.sum;
+		double z = t - p->sum;
+		double err = (p->sum - (t - z)) + (off.sum - z);
+		p->sum = t;
+		p->comp += off.comp + err;
+	}
+}
+
+/**
+ * @brief Calcula a soma prefixada num ponto qualquer do domínio.
+ *
+ * @details Se \f$x\f$ estiver no retângulo \f$k\f$, a uma fração \f$\theta\f$
+ * da sua largura, o resultado é \f$P_{k+s} + \theta f(x_{k+s})\f$, onde
+ * \f$s\f$ é o deslocamento do tipo de soma. O valor \f$f(x_{k+s})\f$ é obtido
+ * da diferença entre duas somas prefixadas consecutivas.
+ *
+ * @param idx Ponteiro para o índice.
+ * @param x O ponto, dentro do domínio.
+ * @param shift 1 para a soma pela direita, 0 para a soma pela esquerda.
+ * @param sum Ponteiro onde a soma será escrita.
+ * @param comp Ponteiro onde a compensação será escrita.
+ */
+static void index_point(const RiemannIndex *idx, double x, size_t shift,
+			double *sum, double *comp)
+{
+	const IndexHeader *h = idx->header;
+	double t = (x - h->min) / (h->max - h->min) * h->n;
+	double k = nearbyint(t), frac = 0;
+
+	// Fora da tolerância de um ponto da grade, interpola no retângulo.
+	if (fabs(t - k) > INDEX_SNAP * fmax(1, t)) {
+		k = floor(t);
+		frac = t - k;
+	}
+	if (k > h->n)
+		k = h->n;
+
+	const IndexPrefix *p = &idx->prefix[(size_t)k + shift];
+	*sum = p->sum;
+	*comp = p->comp;
+	if (frac > 0)
+		*comp += frac * ((p[1].sum - p->sum) + (p[1].comp - p->comp));
+}
\ No newline at end of file
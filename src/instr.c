@@ -0,0 +1,482 @@
+// SPDX-License-Identifier: ISC
+
+/**
+ * @file instr.c
+ * @brief Implementação da instrumentação opcional dos integradores.
+ *
+ * @details Cada thread que passa por um ponto de instrumentação recebe, na
+ * primeira vez, uma estrutura própria de contadores, registrada numa lista
+ * global. Os contadores só são escritos pela thread dona, e por isso dispensam
+ * operações atômicas de leitura-modificação-escrita; eles são atômicos apenas
+ * para que `instr_snapshot()` possa lê-los de outra thread. Quando a thread
+ * termina, os seus contadores são acumulados num total global e a estrutura é
+ * liberada.
+ *
+ * Os ciclos e as instruções vêm de um grupo de contadores de hardware aberto
+ * por thread com `perf_event_open()` (somente no Linux), lido com uma única
+ * chamada a `read()`. Se o grupo não puder ser aberto (por falta de permissão,
+ * por exemplo), os ciclos vêm de `rdtsc` em x86, e as instruções ficam
+ * zeradas.
+ */
+
+#define _GNU_SOURCE
+
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#define INSTR_PERF 1
+#else
+#define INSTR_PERF 0
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define INSTR_TSC 1
+#else
+#define INSTR_TSC 0
+#endif
+
+#include "instr.h"
+#include "util.h"
+
+/**
+ * @brief Origem da contagem de ciclos.
+ */
+typedef enum {
+	SOURCE_NONE, /**< Nenhuma thread foi instrumentada ainda. */
+	SOURCE_PERF, /**< Contadores de hardware (`perf_event_open()`). */
+	SOURCE_TSC, /**< Contador de tempo do processador (`rdtsc`). */
+	SOURCE_CLOCK /**< Nenhum contador de ciclos disponível. */
+} CycleSource;
+
+/**
+ * @brief Contadores de um local, legíveis por outras threads.
+ */
+typedef struct {
+	_Atomic uint64_t calls; /**< Número de chamadas. */
+	_Atomic uint64_t evals; /**< Número de avaliações da função. */
+	_Atomic uint64_t nanoseconds; /**< Tempo decorrido. */
+	_Atomic uint64_t cycles; /**< Ciclos do processador. */
+	_Atomic uint64_t instructions; /**< Instruções executadas. */
+} SiteCounters;
+
+/**
+ * @brief Estado de instrumentação de uma thread.
+ */
+typedef struct ThreadInstr {
+	struct ThreadInstr *next; /**< Próxima thread na lista global. */
+	struct ThreadInstr **prev; /**< Ponteiro que aponta para esta. */
+	int perf[2]; /**< Descritores do grupo de contadores (líder e membro),
+		      * ou -1. */
+	SiteCounters sites[INSTR_SITES]; /**< Contadores acumulados. */
+	InstrCounters last[INSTR_SITES]; /**< Última chamada de cada local. */
+} ThreadInstr;
+
+/**
+ * @brief Leitura de um grupo de contadores (`PERF_FORMAT_GROUP`).
+ */
+typedef struct {
+	uint64_t nr; /**< Número de contadores lidos. */
+	uint64_t values[2]; /**< Ciclos e instruções. */
+} PerfGroup;
+
+// Declarações internas.
+static ThreadInstr *instr_thread(void);
+static void instr_thread_exit(void *arg);
+static void instr_perf_open(int fds[2]);
+static void instr_read(const ThreadInstr *self, uint64_t *cycles,
+		       uint64_t *instructions);
+static uint64_t instr_clock(void);
+static void instr_add(_Atomic uint64_t *counter, uint64_t value);
+static void instr_fold(InstrCounters *out, const SiteCounters *in);
+static void instr_atexit(void);
+static void *instr_periodic(void *arg);
+
+// Indica se a instrumentação está ativa.
+bool instr_enabled = false;
+
+// Estado da thread atual, e chave cujo destrutor a retira da lista global.
+static thread_local ThreadInstr *instr_self = nullptr;
+static pthread_key_t instr_key;
+
+// Lista das threads vivas e totais das threads já terminadas, protegidos
+// pelo mutex.
+static pthread_mutex_t instr_lock = PTHREAD_MUTEX_INITIALIZER;
+static ThreadInstr *instr_threads = nullptr;
+static InstrCounters instr_retired[INSTR_SITES];
+
+// Origem dos ciclos, definida pela primeira thread instrumentada.
+static _Atomic CycleSource instr_source = SOURCE_NONE;
+
+/**
+ * @brief Ativa a instrumentação na inicialização do programa, conforme a
+ * variável de ambiente `RIEMANN_INSTR`.
+ */
+[[gnu::constructor]] static void instr_init(void)
+{
+	const char *env = getenv("RIEMANN_INSTR");
+	double period = 0;
+
+	if (env == nullptr || *env == '\0' || strcmp(env, "0") == 0)
+		return;
+	if (strncmp(env, "periodic:", 9) == 0) {
+		char *end;
+		period = strtod(env + 9, &end);
+		if (end == env + 9 || *end != '\0' || !(period > 0)) {
+			fprintf(stderr, "Período inválido em RIEMANN_INSTR: "
+					"%s\n", env);
+			return;
+		}
+	} else if (strcmp(env, "1") != 0 && strcmp(env, "summary") != 0) {
+		fprintf(stderr, "Valor inválido em RIEMANN_INSTR: %s\n", env);
+		return;
+	}
+
+	if (pthread_key_create(&instr_key, &instr_thread_exit) != 0)
+		return;
+	instr_enabled = true;
+	atexit(&instr_atexit);
+
+	if (period > 0) {
+		static double seconds;
+		pthread_t thread;
+
+		seconds = period;
+		if (pthread_create(&thread, nullptr, &instr_periodic,
+				   &seconds) == 0)
+			pthread_detach(thread);
+	}
+}
+
+// Inicia uma chamada instrumentada.
+InstrScope instr_begin(InstrSite site)
+{
+	ThreadInstr *self = instr_thread();
+	InstrScope scope = { .site = site };
+
+	if (self == nullptr)
+		return scope;
+
+	scope.evals = atomic_load_explicit(&self->sites[site].evals,
+					   memory_order_relaxed);
+	instr_read(self, &scope.cycles, &scope.instructions);
+	scope.nanoseconds = instr_clock();
+	return scope;
+}
+
+// Termina uma chamada instrumentada.
+void instr_end(const InstrScope *scope)
+{
+	ThreadInstr *self = instr_self;
+
+	if (self == nullptr)
+		return;
+
+	uint64_t ns = instr_clock();
+	uint64_t cycles, instructions;
+	instr_read(self, &cycles, &instructions);
+
+	SiteCounters *site = &self->sites[scope->site];
+	InstrCounters call = {
+		.calls = 1,
+		.evals = atomic_load_explicit(&site->evals,
+					      memory_order_relaxed) -
+			 scope->evals,
+		.nanoseconds = ns - scope->nanoseconds,
+		.cycles = cycles - scope->cycles,
+		.instructions = instructions - scope->instructions,
+	};
+
+	self->last[scope->site] = call;
+	instr_add(&site->calls, 1);
+	instr_add(&site->nanoseconds, call.nanoseconds);
+	instr_add(&site->cycles, call.cycles);
+	instr_add(&site->instructions, call.instructions);
+}
+
+// Contabiliza avaliações da função.
+void instr_evals(InstrSite site, uint64_t count)
+{
+	ThreadInstr *self = instr_thread();
+
+	if (self != nullptr)
+		instr_add(&self->sites[site].evals, count);
+}
+
+// Retorna os contadores da última chamada da thread atual num local.
+InstrCounters instr_last(InstrSite site)
+{
+	return instr_self != nullptr ? instr_self->last[site] :
+				       (InstrCounters){ 0 };
+}
+
+// Soma os contadores de todas as threads.
+void instr_snapshot(InstrCounters out[INSTR_SITES])
+{
+	pthread_mutex_lock(&instr_lock);
+	memcpy(out, instr_retired, INSTR_SITES * sizeof(*out));
+	for (ThreadInstr *t = instr_threads; t != nullptr; t = t->next)
+		for (size_t s = 0; s < INSTR_SITES; ++s)
+			instr_fold(&out[s], &t->sites[s]);
+	pthread_mutex_unlock(&instr_lock);
+}
+
+// Exibe um resumo dos contadores de todas as threads.
+void instr_dump(FILE *out)
+{
+	static const char *const sources[] = {
+		[SOURCE_NONE] = "nenhum",
+		[SOURCE_PERF] = "perf_event",
+		[SOURCE_TSC] = "rdtsc",
+		[SOURCE_CLOCK] = "indisponível",
+	};
+	InstrCounters c[INSTR_SITES];
+
+	instr_snapshot(c);
+	fprintf(out, "instrumentação (ciclos: %s)\n",
+		sources[atomic_load(&instr_source)]);
+	fprintf(out, "%-8s %10s %14s %12s %10s %10s %8s\n", "local",
+		"chamadas", "avaliações", "tempo (s)", "ns/aval", "ciclos/av",
+		"instr/c");
+	for (InstrSite s = 0; s < INSTR_SITES; ++s) {
+		double evals = c[s].evals > 0 ? (double)c[s].evals : NAN;
+		double cycles = c[s].cycles > 0 ? (double)c[s].cycles : NAN;
+
+		fprintf(out, "%-8s %10llu %14llu %12.6f %10.3f %10.3f %8.3f\n",
+			instr_site_name(s), (unsigned long long)c[s].calls,
+			(unsigned long long)c[s].evals,
+			c[s].nanoseconds * 1e-9, c[s].nanoseconds / evals,
+			c[s].cycles / evals, c[s].instructions / cycles);
+	}
+	fflush(out);
+}
+
+// Retorna o nome legível de um local.
+const char *instr_site_name(InstrSite site)
+{
+	static const char *const names[] = {
+		[INSTR_RIEMANN] = "riemann",
+		[INSTR_SWEEP] = "sweep",
+		[INSTR_QUAD] = "quad",
+		[INSTR_RIEMANN2D] = "riemann2d",
+	};
+
+	return site < INSTR_SITES ? names[site] : "desconhecido";
+}
+
+/**
+ * @brief Obtém o estado de instrumentação da thread atual, criando-o na
+ * primeira chamada.
+ *
+ * @return Ponteiro para o estado, ou `nullptr` se faltou memória.
+ */
+static ThreadInstr *instr_thread(void)
+{
+	ThreadInstr *self = instr_self;
+
+	if (self != nullptr)
+		return self;
+
+	self = calloc(1, sizeof(*self));
+	ERRNOCHECK(self == nullptr, "Falha ao alocar contadores da thread",
+		   ret);
+	instr_perf_open(self->perf);
+
+	CycleSource source = self->perf[0] >= 0 ? SOURCE_PERF :
+			     INSTR_TSC	     ? SOURCE_TSC :
+					       SOURCE_CLOCK;
+	CycleSource none = SOURCE_NONE;
+	atomic_compare_exchange_strong(&instr_source, &none, source);
+
+	pthread_mutex_lock(&instr_lock);
+	self->next = instr_threads;
+	self->prev = &instr_threads;
+	if (instr_threads != nullptr)
+		instr_threads->prev = &self->next;
+	instr_threads = self;
+	pthread_mutex_unlock(&instr_lock);
+
+	pthread_setspecific(instr_key, self);
+	instr_self = self;
+	return self;
+
+ret:
+	return nullptr;
+}
+
+/**
+ * @brief Retira da lista global o estado de uma thread que terminou.
+ *
+ * @details Os contadores da thread são acumulados nos totais das threads já
+ * terminadas, para que continuem aparecendo nos resumos.
+ *
+ * @param arg Ponteiro para o estado da thread.
+ */
+static void instr_thread_exit(void *arg)
+{
+	ThreadInstr *self = arg;
+
+	pthread_mutex_lock(&instr_lock);
+	*self->prev = self->next;
+	if (self->next != nullptr)
+		self->next->prev = self->prev;
+	for (size_t s = 0; s < INSTR_SITES; ++s)
+		instr_fold(&instr_retired[s], &self->sites[s]);
+	pthread_mutex_unlock(&instr_lock);
+
+	for (size_t i = 0; i < 2; ++i)
+		if (self->perf[i] >= 0)
+			close(self->perf[i]);
+	free(self);
+}
+
+/**
+ * @brief Abre o grupo de contadores de hardware da thread atual.
+ *
+ * @details O líder do grupo conta ciclos e o membro conta instruções, ambos
+ * somente no espaço de usuário. O grupo é lido de uma vez, para que as duas
+ * leituras correspondam ao mesmo instante.
+ *
+ * @param fds Arranjo onde os descritores do líder e do membro serão escritos,
+ * ou -1 se não foi possível abrir o grupo.
+ */
+static void instr_perf_open(int fds[2])
+{
+	fds[0] = fds[1] = -1;
+#if INSTR_PERF
+	struct perf_event_attr attr = {
+		.type = PERF_TYPE_HARDWARE,
+		.size = sizeof(attr),
+		.config = PERF_COUNT_HW_CPU_CYCLES,
+		.read_format = PERF_FORMAT_GROUP,
+		.exclude_kernel = 1,
+		.exclude_hv = 1,
+	};
+	int leader = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+	if (leader < 0)
+		return;
+
+	attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+	int member = syscall(SYS_perf_event_open, &attr, 0, -1, leader, 0);
+	if (member < 0) {
+		close(leader);
+		return;
+	}
+
+	fds[0] = leader;
+	fds[1] = member;
+#endif
+}
+
+/**
+ * @brief Lê os ciclos e as instruções da thread atual.
+ *
+ * @param self Ponteiro para o estado da thread.
+ * @param cycles Ponteiro onde os ciclos serão escritos.
+ * @param instructions Ponteiro onde as instruções serão escritas (0 se não
+ * houver contadores de hardware).
+ */
+static void instr_read(const ThreadInstr *self, uint64_t *cycles,
+		       uint64_t *instructions)
+{
+	PerfGroup group;
+
+	if (self->perf[0] >= 0 &&
+	    read(self->perf[0], &group, sizeof(group)) == sizeof(group)) {
+		*cycles = group.values[0];
+		*instructions = group.values[1];
+		return;
+	}
+
+	*instructions = 0;
+#if INSTR_TSC
+	*cycles = __rdtsc();
+#else
+	*cycles = 0;
+#endif
+}
+
+/**
+ * @brief Lê o relógio monotônico.
+ *
+ * @return O instante atual, em nanossegundos.
+ */
+static uint64_t instr_clock(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @brief Soma um valor a um contador escrito somente pela thread atual.
+ *
+ * @details Como não há outras threads escrevendo, uma leitura seguida de uma
+ * escrita basta, sem o custo de uma operação atômica de
+ * leitura-modificação-escrita.
+ *
+ * @param counter Ponteiro para o contador.
+ * @param value O valor a somar.
+ */
+static void instr_add(_Atomic uint64_t *counter, uint64_t value)
+{
+	uint64_t old = atomic_load_explicit(counter, memory_order_relaxed);
+	atomic_store_explicit(counter, old + value, memory_order_relaxed);
+}
+
+/**
+ * @brief Acumula os contadores de um local de uma thread.
+ *
+ * @param out Ponteiro para o acumulador.
+ * @param in Ponteiro para os contadores da thread.
+ */
+static void instr_fold(InstrCounters *out, const SiteCounters *in)
+{
+	out->calls += atomic_load_explicit(&in->calls, memory_order_relaxed);
+	out->evals += atomic_load_explicit(&in->evals, memory_order_relaxed);
+	out->nanoseconds +=
+		atomic_load_explicit(&in->nanoseconds, memory_order_relaxed);
+	out->cycles += atomic_load_explicit(&in->cycles, memory_order_relaxed);
+	out->instructions +=
+		atomic_load_explicit(&in->instructions, memory_order_relaxed);
+}
+
+/**
+ * @brief Exibe o resumo final na saída de erro.
+ */
+static void instr_atexit(void)
+{
+	instr_dump(stderr);
+}
+
+/**
+ * @brief Exibe um resumo na saída de erro periodicamente.
+ *
+ * @param arg Ponteiro para o período, em segundos.
+ * @return Nunca retorna; a thread termina junto com o programa.
+ */
+static void *instr_periodic(void *arg)
+{
+	double period = *(const double *)arg;
+	struct timespec ts = {
+		.tv_sec = (time_t)period,
+		.tv_nsec = (long)((period - (time_t)period) * 1e9),
+	};
+
+	for (;;) {
+		nanosleep(&ts, nullptr);
+		instr_dump(stderr);
+	}
+	return nullptr;
+}
\ No newline at end of file
@@ -0,0 +1,472 @@
+// SPDX-License-Identifier: ISC
+
+/**
+ * @file jobfile.c
+ * @brief Implementação do formato binário de trabalhos e resultados.
+ *
+ * @details Os dois arquivos são mapeados com `mmap()`: o de trabalhos somente
+ * para leitura, e o de resultados para leitura e escrita, compartilhado, de
+ * modo que cada resultado escrito na memória chega ao arquivo mesmo que o
+ * processo termine de forma anormal. O estado de cada resultado é escrito
+ * atomicamente, com semântica de liberação, depois do valor; um resultado
+ * marcado como pronto, portanto, nunca tem valor incompleto.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <fcntl.h>
+#include <math.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "func.h"
+#include "jobfile.h"
+#include "jobs.h"
+#include "pool.h"
+#include "riemann.h"
+#include "util.h"
+
+/**
+ * @brief Número de trabalhos calculados por tarefa do conjunto de threads.
+ */
+#define JOBFILE_CHUNK 256
+
+/**
+ * @brief Valor inicial do hash FNV-1a de 64 bits.
+ */
+#define JOBFILE_HASH_SEED 0xcbf29ce484222325
+
+/**
+ * @brief Identificação de um arquivo de trabalhos.
+ */
+static const char job_magic[8] = { 'R', 'I', 'E', 'M', 'J', 'O', 'B', 'S' };
+
+/**
+ * @brief Identificação de um arquivo de resultados.
+ */
+static const char result_magic[8] = { 'R', 'I', 'E', 'M', 'R', 'S', 'L', 'T' };
+
+/**
+ * @brief Contexto compartilhado pelas tarefas de `jobfile_run()`.
+ */
+typedef struct {
+	const JobFile *jobs; /**< O arquivo de trabalhos. */
+	ResultFile *results; /**< O arquivo de resultados. */
+	atomic_size_t computed; /**< Número de trabalhos calculados. */
+} RunCtx;
+
+// Declarações internas.
+static bool jobfile_fits(size_t size, uint64_t offset, uint64_t count,
+			 size_t elem);
+static uint64_t jobfile_align(uint64_t offset);
+static uint64_t jobfile_hash(uint64_t hash, const void *data, size_t size);
+static void jobfile_task(size_t index, void *ctx);
+
+// Mapeia e valida um arquivo de trabalhos.
+bool jobfile_open(JobFile *file, const char *path)
+{
+	struct stat st;
+
+	*file = (JobFile){ 0 };
+	int fd = open(path, O_RDONLY);
+	ERRNOCHECK(fd < 0, path, ret);
+	ERRNOCHECK(fstat(fd, &st) != 0, path, close_fd);
+
+	errno = EINVAL;
+	ERRNOCHECK((uintmax_t)st.st_size < sizeof(JobFileHeader) ||
+			   (uintmax_t)st.st_size > SIZE_MAX,
+		   "Tamanho inválido do arquivo de trabalhos", close_fd);
+	file->size = st.st_size;
+	file->base = mmap(nullptr, file->size, PROT_READ, MAP_SHARED, fd, 0);
+	ERRNOCHECK(file->base == MAP_FAILED,
+		   "Falha ao mapear o arquivo de trabalhos", close_fd);
+	posix_madvise(file->base, file->size, POSIX_MADV_SEQUENTIAL);
+
+	// Verifica o cabeçalho e se as seções cabem no arquivo.
+	const JobFileHeader *h = file->base;
+	errno = EINVAL;
+	ERRNOCHECK(memcmp(h->magic, job_magic, sizeof(job_magic)) != 0 ||
+			   h->version != JOBFILE_VERSION ||
+			   h->byte_order != JOBFILE_BYTE_ORDER ||
+			   h->header_size != sizeof(JobFileHeader) ||
+			   h->record_size != sizeof(JobRecord),
+		   "Formato inválido do arquivo de trabalhos", unmap);
+	ERRNOCHECK(h->records % JOBFILE_ALIGN != 0 ||
+			   h->pool % JOBFILE_ALIGN != 0 ||
+			   !jobfile_fits(file->size, h->records, h->count,
+					 sizeof(JobRecord)) ||
+			   !jobfile_fits(file->size, h->pool, h->pool_count,
+					 sizeof(double)),
+		   "Arquivo de trabalhos truncado", unmap);
+
+	file->header = h;
+	file->records = (const JobRecord *)((const char *)file->base +
+					    h->records);
+	file->pool = (const double *)((const char *)file->base + h->pool);
+	close(fd);
+	return true;
+
+unmap:
+	munmap(file->base, file->size);
+close_fd:
+	close(fd);
+ret:
+	*file = (JobFile){ 0 };
+	return false;
+}
+
+// Desfaz o mapeamento de um arquivo de trabalhos.
+void jobfile_close(JobFile *file)
+{
+	if (file->base != nullptr)
+		munmap(file->base, file->size);
+	*file = (JobFile){ 0 };
+}
+
+// Constrói a função de um trabalho como uma visão sobre o mapeamento.
+Function *jobfile_function(const JobFile *file, size_t index,
+			   FunctionView *view)
+{
+	const JobRecord *r = &file->records[index];
+	uint64_t pool_count = file->header->pool_count;
+
+	if (r->n == 0 || r->method > MEIO ||
+	    r->coeffs >= pool_count || r->degree >= pool_count - r->coeffs)
+		return nullptr;
+
+	return function_view_init(view, r->degree, file->pool + r->coeffs);
+}
+
+// Converte trabalhos do formato textual para o binário.
+long jobfile_encode(FILE *in, const char *path)
+{
+	JobFileHeader h = {
+		.version = JOBFILE_VERSION,
+		.byte_order = JOBFILE_BYTE_ORDER,
+		.header_size = sizeof(JobFileHeader),
+		.record_size = sizeof(JobRecord),
+		.records = jobfile_align(sizeof(JobFileHeader)),
+		.content = JOBFILE_HASH_SEED,
+	};
+	memcpy(h.magic, job_magic, sizeof(job_magic));
+
+	char *line = nullptr;
+	size_t len = 0, lineno = 0;
+	long skipped = 0, ret = -1;
+	Job job;
+	const char *err;
+
+	FILE *out = fopen(path, "wb");
+	ERRNOCHECK(out == nullptr, path, ret);
+	FILE *tmp = tmpfile();
+	ERRNOCHECK(tmp == nullptr, "Falha ao criar arquivo temporário",
+		   close_out);
+
+	// Escreve os registros logo após o espaço do cabeçalho, e os
+	// coeficientes no arquivo temporário.
+	ERRNOCHECK(fseek(out, h.records, SEEK_SET) != 0,
+		   "Falha ao escrever o arquivo de trabalhos", close_tmp);
+	while (getline(&line, &len, in) != -1) {
+		++lineno;
+		int r = job_parse(line, &job, &err);
+		if (r == 0)
+			continue;
+		if (r < 0) {
+			fprintf(stderr, "Linha %zu descartada: %s\n", lineno,
+				err);
+			++skipped;
+			continue;
+		}
+
+		JobRecord rec = {
+			.id = job.id,
+			.min = job.min,
+			.max = job.max,
+			.n = job.n,
+			.coeffs = h.pool_count,
+			.degree = job.degree,
+			.method = job.method,
+		};
+		size_t ncoeffs = job.degree + 1;
+		ERRNOCHECK(fwrite(&rec, sizeof(rec), 1, out) != 1 ||
+				   fwrite(job.coeffs, sizeof(double), ncoeffs,
+					  tmp) != ncoeffs,
+			   "Falha ao escrever o arquivo de trabalhos", close_tmp);
+		h.content = jobfile_hash(h.content, &rec, sizeof(rec));
+		h.pool_count += ncoeffs;
+		++h.count;
+	}
+	ERRNOCHECK(ferror(in), "Falha ao ler os trabalhos", close_tmp);
+
+	// Anexa os coeficientes numa posição alinhada, e então o cabeçalho.
+	h.pool = jobfile_align(h.records + h.count * sizeof(JobRecord));
+	ERRNOCHECK(fseek(out, h.pool, SEEK_SET) != 0 || fflush(tmp) != 0 ||
+			   fseek(tmp, 0, SEEK_SET) != 0,
+		   "Falha ao escrever o arquivo de trabalhos", close_tmp);
+	double buf[1 << 10];
+	size_t got;
+	while ((got = fread(buf, sizeof(*buf), sizeof(buf) / sizeof(*buf),
+			    tmp)) > 0) {
+		ERRNOCHECK(fwrite(buf, sizeof(*buf), got, out) != got,
+			   "Falha ao escrever o arquivo de trabalhos",
+			   close_tmp);
+		h.content = jobfile_hash(h.content, buf, got * sizeof(*buf));
+	}
+	ERRNOCHECK(ferror(tmp) || fseek(out, 0, SEEK_SET) != 0 ||
+			   fwrite(&h, sizeof(h), 1, out) != 1,
+		   "Falha ao escrever o arquivo de trabalhos", close_tmp);
+	ret = skipped;
+
+close_tmp:
+	fclose(tmp);
+close_out:
+	if (fclose(out) != 0 && ret >= 0) {
+		perror(path);
+		ret = -1;
+	}
+ret:
+	free(line);
+	return ret;
+}
+
+// Converte trabalhos do formato binário para o textual.
+long jobfile_decode(const JobFile *file, FILE *out)
+{
+	long invalid = 0;
+	FunctionView view;
+	Job job;
+
+	for (size_t i = 0; i < file->header->count; ++i) {
+		const JobRecord *r = &file->records[i];
+
+		// O formato textual não admite graus acima de JOB_MAX_DEGREE.
+		if (jobfile_function(file, i, &view) == nullptr ||
+		    r->degree > JOB_MAX_DEGREE) {
+			++invalid;
+			continue;
+		}
+
+		job.id = r->id;
+		job.min = r->min;
+		job.max = r->max;
+		job.n = r->n;
+		job.method = r->method;
+		job.degree = r->degree;
+		memcpy(job.coeffs, file->pool + r->coeffs,
+		       (job.degree + 1) * sizeof(double));
+		job_print(out, &job);
+	}
+
+	return invalid;
+}
+
+// Abre ou cria o arquivo de resultados de um arquivo de trabalhos.
+bool resultfile_open(ResultFile *file, const char *path, const JobFile *jobs)
+{
+	ResultFileHeader h = {
+		.version = JOBFILE_VERSION,
+		.byte_order = JOBFILE_BYTE_ORDER,
+		.header_size = sizeof(ResultFileHeader),
+		.record_size = sizeof(ResultRecord),
+		.count = jobs->header->count,
+		.records = jobfile_align(sizeof(ResultFileHeader)),
+		.source = jobs->header->content,
+	};
+	memcpy(h.magic, result_magic, sizeof(result_magic));
+	size_t size = h.records + h.count * sizeof(ResultRecord);
+	struct stat st;
+
+	*file = (ResultFile){ 0 };
+	int fd = open(path, O_RDWR | O_CREAT, 0644);
+	ERRNOCHECK(fd < 0, path, ret);
+	ERRNOCHECK(fstat(fd, &st) != 0, path, close_fd);
+
+	// Um arquivo vazio é criado com todos os registros zerados, ou seja,
+	// pendentes; um existente precisa ter exatamente o tamanho esperado.
+	bool fresh = st.st_size == 0;
+	if (fresh) {
+		ERRNOCHECK(ftruncate(fd, size) != 0, path, close_fd);
+	} else {
+		errno = EINVAL;
+		ERRNOCHECK((uintmax_t)st.st_size != size,
+			   "Arquivo de resultados não corresponde aos trabalhos",
+			   close_fd);
+	}
+
+	file->size = size;
+	file->base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd,
+			  0);
+	ERRNOCHECK(file->base == MAP_FAILED,
+		   "Falha ao mapear o arquivo de resultados", close_fd);
+
+	if (fresh) {
+		memcpy(file->base, &h, sizeof(h));
+	} else {
+		errno = EINVAL;
+		ERRNOCHECK(memcmp(file->base, &h, sizeof(h)) != 0,
+			   "Arquivo de resultados não corresponde aos trabalhos",
+			   unmap);
+	}
+
+	file->header = file->base;
+	file->records = (ResultRecord *)((char *)file->base + h.records);
+	close(fd);
+	return true;
+
+unmap:
+	munmap(file->base, file->size);
+close_fd:
+	close(fd);
+ret:
+	*file = (ResultFile){ 0 };
+	return false;
+}
+
+// Grava e desfaz o mapeamento de um arquivo de resultados.
+void resultfile_close(ResultFile *file)
+{
+	if (file->base != nullptr) {
+		msync(file->base, file->size, MS_SYNC);
+		munmap(file->base, file->size);
+	}
+	*file = (ResultFile){ 0 };
+}
+
+// Calcula os trabalhos pendentes de um arquivo de trabalhos.
+size_t jobfile_run(const JobFile *jobs, ResultFile *results, unsigned threads)
+{
+	RunCtx ctx = { .jobs = jobs, .results = results };
+	size_t count = jobs->header->count;
+	size_t chunks = (count + JOBFILE_CHUNK - 1) / JOBFILE_CHUNK;
+
+	if (threads == 0)
+		threads = pool_cpu_count();
+	Pool *pool = threads > 1 ? pool_global(threads) : nullptr;
+	if (pool != nullptr)
+		pool_run(pool, chunks, threads, &jobfile_task, &ctx);
+	else
+		for (size_t i = 0; i < chunks; ++i)
+			jobfile_task(i, &ctx);
+
+	return atomic_load(&ctx.computed);
+}
+
+// Escreve os resultados já calculados no formato textual escolhido.
+long resultfile_print(const ResultFile *file, FILE *out, JobsFormat format)
+{
+	long errors = 0;
+
+	jobs_print_header(out, format);
+	for (size_t i = 0; i < file->header->count; ++i) {
+		const ResultRecord *r = &file->records[i];
+		switch (atomic_load_explicit(&r->status, memory_order_acquire)) {
+		case RESULT_DONE:
+			jobs_print_result(out, format, r->id, r->value,
+					  nullptr);
+			break;
+		case RESULT_INVALID:
+			jobs_print_result(out, format, r->id, r->value,
+					  "trabalho inválido");
+			++errors;
+			break;
+		default: // Pendente.
+			break;
+		}
+	}
+
+	return errors;
+}
+
+/**
+ * @brief Verifica se uma seção cabe num arquivo.
+ *
+ * @param size Tamanho do arquivo, em bytes.
+ * @param offset Posição da seção, em bytes.
+ * @param count Número de elementos da seção.
+ * @param elem Tamanho de cada elemento, em bytes.
+ * @return `true` se a seção inteira estiver dentro do arquivo.
+ */
+static bool jobfile_fits(size_t size, uint64_t offset, uint64_t count,
+			 size_t elem)
+{
+	return offset <= size && count <= (size - offset) / elem;
+}
+
+/**
+ * @brief Arredonda uma posição para cima, até o próximo múltiplo de
+ * `JOBFILE_ALIGN`.
+ *
+ * @param offset A posição, em bytes.
+ * @return A posição alinhada.
+ */
+static uint64_t jobfile_align(uint64_t offset)
+{
+	return (offset + JOBFILE_ALIGN - 1) / JOBFILE_ALIGN * JOBFILE_ALIGN;
+}
+
+/**
+ * @brief Acumula bytes no hash FNV-1a do conteúdo de um arquivo de
+ * trabalhos.
+ *
+ * @param hash O hash dos bytes anteriores, ou `JOBFILE_HASH_SEED`.
+ * @param data Os bytes.
+ * @param size Número de bytes.
+ * @return O hash atualizado.
+ */
+static uint64_t jobfile_hash(uint64_t hash, const void *data, size_t size)
+{
+	const unsigned char *bytes = data;
+	for (size_t i = 0; i < size; ++i)
+		hash = (hash ^ bytes[i]) * 0x100000001b3;
+	return hash;
+}
+
+/**
+ * @brief Calcula os trabalhos pendentes de um bloco de `JOBFILE_CHUNK`.
+ *
+ * @param index Índice do bloco.
+ * @param ctx Ponteiro para o `RunCtx`.
+ */
+static void jobfile_task(size_t index, void *ctx)
+{
+	RunCtx *c = ctx;
+	size_t first = index * JOBFILE_CHUNK;
+	size_t last = first + JOBFILE_CHUNK;
+	if (last > c->jobs->header->count)
+		last = c->jobs->header->count;
+
+	// Cada soma usa uma só thread: as tarefas já ocupam o conjunto global.
+	const RiemannOptions opts = { .threads = 1 };
+	size_t computed = 0;
+	FunctionView view;
+
+	for (size_t i = first; i < last; ++i) {
+		ResultRecord *res = &c->results->records[i];
+		if (atomic_load_explicit(&res->status, memory_order_acquire) !=
+		    RESULT_PENDING)
+			continue;
+
+		const JobRecord *job = &c->jobs->records[i];
+		Function *func = jobfile_function(c->jobs, i, &view);
+		uint32_t status = RESULT_INVALID;
+		res->id = job->id;
+		res->value = NAN;
+		if (func != nullptr) {
+			res->value = riemann_opts(job->min, job->max, func,
+						  job->n, job->method, &opts);
+			status = RESULT_DONE;
+		}
+
+		atomic_store_explicit(&res->status, status,
+				      memory_order_release);
+		++computed;
+	}
+
+	atomic_fetch_add(&c->computed, computed);
+}
\ No newline at end of file
@@ -0,0 +1,554 @@
+// SPDX-License-Identifier: ISC
+
+/**
+ * @file jobs.c
+ * @brief Implementação do processamento em fluxo de trabalhos de integração.
+ *
+ * @details O pipeline usa um arranjo fixo de posições (`Slot`), cada uma com
+ * espaço para um trabalho e o seu resultado. A thread leitora retira uma
+ * posição livre, analisa a próxima linha nela, e a coloca na fila de
+ * trabalho; as threads de cálculo retiram posições dessa fila em pequenos
+ * lotes e marcam-nas como prontas; a thread de escrita serializa as posições
+ * prontas e devolve-as à lista de livres. Quando não há posição livre, a
+ * leitora espera, o que limita o número de trabalhos em andamento e, com ele,
+ * o uso de memória.
+ *
+ * Na saída ordenada, a escrita segue o número de sequência de cada trabalho;
+ * na não ordenada, segue uma fila de posições prontas. Cada thread de cálculo
+ * mantém uma pequena tabela de funções já construídas, indexada por um hash
+ * dos coeficientes, para reaproveitá-las entre trabalhos com o mesmo
+ * polinômio.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <ctype.h>
+#include <inttypes.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cache.h"
+#include "func.h"
+#include "jobs.h"
+#include "pool.h"
+#include "ring.h"
+#include "riemann.h"
+#include "util.h"
+
+/**
+ * @brief Número padrão de trabalhos em andamento.
+ */
+#define JOBS_QUEUE 4096
+
+/**
+ * @brief Número máximo de trabalhos retirados de uma fila de uma só vez.
+ */
+#define JOBS_BATCH 32
+
+/**
+ * @brief Número de entradas da tabela de funções de cada thread de cálculo
+ * (potência de dois).
+ */
+#define JOBS_CACHE 64
+
+/**
+ * @brief Uma posição do pipeline, com um trabalho e o seu resultado.
+ */
+typedef struct {
+	Job job; /**< O trabalho. */
+	double value; /**< O valor da integral calculada. */
+	const char *err; /**< Descrição do erro, ou `nullptr` se não houver. */
+	bool done; /**< Indica que o resultado está pronto. */
+} Slot;
+
+/**
+ * @brief Estado compartilhado entre os estágios do pipeline.
+ */
+typedef struct {
+	pthread_mutex_t lock; /**< Protege os campos abaixo. */
+	pthread_cond_t can_read; /**< Sinaliza que há posição livre. */
+	pthread_cond_t can_work; /**< Sinaliza trabalho novo ou o fim. */
+	pthread_cond_t can_write; /**< Sinaliza resultado pronto ou o fim. */
+	Slot *slots; /**< Arranjo com as posições. */
+	size_t capacity; /**< Número de posições. */
+	size_t *free_slots; /**< Pilha de posições livres. */
+	size_t num_free; /**< Número de posições livres. */
+	Ring work; /**< Fila de posições a calcular. */
+	Ring done; /**< Fila de posições prontas (saída não ordenada). */
+	size_t *order; /**< Posição de cada número de sequência em andamento,
+			* módulo `capacity` (saída ordenada). */
+	size_t produced; /**< Número de trabalhos lidos. */
+	size_t written; /**< Número de resultados escritos. */
+	bool eof; /**< Indica que a entrada terminou. */
+	unsigned workers; /**< Número de threads de cálculo. */
+	JobsOptions opts; /**< Opções do processamento. */
+	FILE *out; /**< Arquivo de saída. */
+	long errors; /**< Número de trabalhos com erro. */
+} Pipeline;
+
+/**
+ * @brief Uma entrada da tabela de funções de uma thread de cálculo.
+ */
+typedef struct {
+	uint64_t hash; /**< Hash dos coeficientes. */
+	Function *func; /**< A função, ou `nullptr` se a entrada estiver vazia. */
+} CacheEntry;
+
+// Declarações internas.
+static const char *job_token(const char *p);
+static bool job_end(const char *p);
+static void *jobs_worker(void *arg);
+static void *jobs_writer(void *arg);
+static void jobs_compute(Slot *slot, CacheEntry *cache,
+			 ResultCache *results);
+static Function *jobs_function(CacheEntry *cache, const Job *job);
+static size_t jobs_ready(Pipeline *p, size_t *batch);
+static void jobs_print(Pipeline *p, const Slot *slot);
+
+// Analisa uma linha no formato textual de trabalhos.
+int job_parse(const char *line, Job *job, const char **err)
+{
+	const char *p = job_token(line);
+	char *end;
+
+	// Ignora linhas vazias e comentários.
+	if (*p == '\0' || *p == '#')
+		return 0;
+
+	job->id = 0;
+	*err = "identificador inválido";
+	if (!isdigit((unsigned char)*p))
+		return -1;
+	errno = 0;
+	job->id = strtoull(p, &end, 10);
+	if (errno != 0 || !job_end(end))
+		return -1;
+
+	*err = "limite inferior inválido";
+	p = job_token(end);
+	job->min = strtod(p, &end);
+	if (end == p || !job_end(end) || !isfinite(job->min))
+		return -1;
+
+	*err = "limite superior inválido";
+	p = job_token(end);
+	job->max = strtod(p, &end);
+	if (end == p || !job_end(end) || !isfinite(job->max))
+		return -1;
+
+	*err = "número de retângulos inválido";
+	p = job_token(end);
+	if (!isdigit((unsigned char)*p))
+		return -1;
+	errno = 0;
+	unsigned long long n = strtoull(p, &end, 10);
+	if (errno != 0 || !job_end(end) || n == 0 || n > SIZE_MAX)
+		return -1;
+	job->n = n;
+
+	*err = "método inválido";
+	p = job_token(end);
+	size_t len = strcspn(p, " \t\r\n\v\f");
+	if (len == 7 && strncmp(p, "direita", len) == 0)
+		job->method = DIREITA;
+	else if (len == 8 && strncmp(p, "esquerda", len) == 0)
+		job->method = ESQUERDA;
+	else if (len == 4 && strncmp(p, "meio", len) == 0)
+		job->method = MEIO;
+	else
+		return -1;
+
+	// Lê os coeficientes até o fim da linha.
+	size_t count = 0;
+	for (p = job_token(p + len); *p != '\0'; p = job_token(end)) {
+		*err = "grau do polinômio maior que o suportado";
+		if (count > JOB_MAX_DEGREE)
+			return -1;
+		*err = "coeficiente inválido";
+		job->coeffs[count] = strtod(p, &end);
+		if (end == p || !job_end(end))
+			return -1;
+		++count;
+	}
+
+	*err = "nenhum coeficiente";
+	if (count == 0)
+		return -1;
+	job->degree = count - 1;
+
+	*err = nullptr;
+	return 1;
+}
+
+// Escreve um trabalho no formato textual.
+void job_print(FILE *out, const Job *job)
+{
+	static const char *const methods[] = {
+		[DIREITA] = "direita",
+		[ESQUERDA] = "esquerda",
+		[MEIO] = "meio",
+	};
+
+	fprintf(out, "%" PRIu64 " %.17g %.17g %zu %s", job->id, job->min,
+		job->max, job->n, methods[job->method]);
+	for (size_t i = 0; i <= job->degree; ++i)
+		fprintf(out, " %.17g", job->coeffs[i]);
+	putc('\n', out);
+}
+
+// Escreve o cabeçalho da saída, se o formato tiver um.
+void jobs_print_header(FILE *out, JobsFormat format)
+{
+	if (format == JOBS_CSV)
+		fputs("id,valor,erro\n", out);
+}
+
+// Escreve o resultado de um trabalho no formato escolhido. Valores não finitos
+// são escritos como `null` em JSONL, que não admite `inf` nem `nan`.
+void jobs_print_result(FILE *out, JobsFormat format, uint64_t id, double value,
+		       const char *err)
+{
+	if (err != nullptr) {
+		if (format == JOBS_CSV)
+			fprintf(out, "%" PRIu64 ",,%s\n", id, err);
+		else
+			fprintf(out, "{\"id\":%" PRIu64 ",\"erro\":\"%s\"}\n",
+				id, err);
+	} else if (format == JOBS_CSV) {
+		fprintf(out, "%" PRIu64 ",%.17g,\n", id, value);
+	} else if (isfinite(value)) {
+		fprintf(out, "{\"id\":%" PRIu64 ",\"valor\":%.17g}\n", id,
+			value);
+	} else {
+		fprintf(out, "{\"id\":%" PRIu64 ",\"valor\":null}\n", id);
+	}
+}
+
+// Processa em fluxo os trabalhos de um arquivo.
+long jobs_run(FILE *in, FILE *out, const JobsOptions *opts)
+{
+	Pipeline p = { 0 };
+	pthread_t *threads = nullptr;
+	unsigned started = 0;
+	char *line = nullptr;
+	size_t len = 0;
+	long ret = -1;
+
+	p.opts = opts != nullptr ? *opts : (JobsOptions){ 0 };
+	p.workers = p.opts.threads > 0 ? p.opts.threads : pool_cpu_count();
+	p.capacity = p.opts.queue > 0 ? p.opts.queue : JOBS_QUEUE;
+	p.out = out;
+
+	// Aloca todas as posições e filas de uma vez; nada mais é alocado
+	// durante o processamento, exceto o buffer de linha.
+	p.slots = calloc(p.capacity, sizeof(*p.slots));
+	p.free_slots = malloc(p.capacity * sizeof(*p.free_slots));
+	p.order = malloc(p.capacity * sizeof(*p.order));
+	p.work.data = malloc(p.capacity * sizeof(*p.work.data));
+	p.done.data = malloc(p.capacity * sizeof(*p.done.data));
+	threads = malloc((p.workers + 1) * sizeof(*threads));
+	ERRNOCHECK(p.slots == nullptr || p.free_slots == nullptr ||
+			   p.order == nullptr || p.work.data == nullptr ||
+			   p.done.data == nullptr || threads == nullptr,
+		   "Falha ao alocar o pipeline de trabalhos", cleanup);
+	p.work.capacity = p.done.capacity = p.capacity;
+	for (size_t i = 0; i < p.capacity; ++i)
+		p.free_slots[i] = p.capacity - 1 - i;
+	p.num_free = p.capacity;
+
+	pthread_mutex_init(&p.lock, nullptr);
+	pthread_cond_init(&p.can_read, nullptr);
+	pthread_cond_init(&p.can_work, nullptr);
+	pthread_cond_init(&p.can_write, nullptr);
+
+	// Inicia a thread de escrita e as de cálculo.
+	for (; started <= p.workers; ++started) {
+		int err = pthread_create(&threads[started], nullptr,
+					 started == 0 ? jobs_writer :
+							jobs_worker,
+					 &p);
+		errno = err;
+		ERRNOCHECK(err != 0, "Falha ao criar thread de trabalho",
+			   stop);
+	}
+
+	// Lê a entrada. A posição é retirada antes da análise, para que a
+	// linha seja lida diretamente nela; linhas ignoradas não a consomem.
+	size_t slot = SIZE_MAX;
+	while (getline(&line, &len, in) != -1) {
+		if (slot == SIZE_MAX) {
+			pthread_mutex_lock(&p.lock);
+			while (p.num_free == 0)
+				pthread_cond_wait(&p.can_read, &p.lock);
+			slot = p.free_slots[--p.num_free];
+			pthread_mutex_unlock(&p.lock);
+		}
+
+		Slot *s = &p.slots[slot];
+		if (job_parse(line, &s->job, &s->err) == 0)
+			continue;
+		s->done = false;
+
+		pthread_mutex_lock(&p.lock);
+		p.order[p.produced++ % p.capacity] = slot;
+		ring_push(&p.work, slot);
+		pthread_cond_signal(&p.can_work);
+		pthread_mutex_unlock(&p.lock);
+		slot = SIZE_MAX;
+	}
+	ERRNOCHECK(ferror(in), "Falha ao ler os trabalhos", stop);
+	ret = 0;
+
+stop: // Sinaliza o fim da entrada e espera as threads terminarem.
+	pthread_mutex_lock(&p.lock);
+	p.eof = true;
+	pthread_cond_broadcast(&p.can_work);
+	pthread_cond_broadcast(&p.can_write);
+	pthread_mutex_unlock(&p.lock);
+	for (unsigned i = 0; i < started; ++i)
+		pthread_join(threads[i], nullptr);
+	if (ret == 0)
+		ret = started > p.workers ? p.errors : -1;
+
+	pthread_cond_destroy(&p.can_write);
+	pthread_cond_destroy(&p.can_work);
+	pthread_cond_destroy(&p.can_read);
+	pthread_mutex_destroy(&p.lock);
+
+cleanup:
+	free(line);
+	free(threads);
+	free(p.done.data);
+	free(p.work.data);
+	free(p.order);
+	free(p.free_slots);
+	free(p.slots);
+	return ret;
+}
+
+/**
+ * @brief Pula os espaços em branco de uma string.
+ *
+ * @param p Ponteiro para a posição atual.
+ * @return Ponteiro para o primeiro caractere que não é espaço.
+ */
+static const char *job_token(const char *p)
+{
+	while (isspace((unsigned char)*p))
+		++p;
+	return p;
+}
+
+/**
+ * @brief Verifica se um campo terminou corretamente.
+ *
+ * @param p Ponteiro para o caractere seguinte ao campo.
+ * @return `true` se o caractere for espaço ou o fim da string.
+ */
+static bool job_end(const char *p)
+{
+	return *p == '\0' || isspace((unsigned char)*p);
+}
+
+/**
+ * @brief Laço de uma thread de cálculo.
+ *
+ * @details Retira da fila de trabalho um lote proporcional ao tamanho da fila
+ * dividido pelo número de threads (até `JOBS_BATCH`), de modo que a fila se
+ * distribui entre todas as threads mesmo quando é curta.
+ *
+ * @param arg Ponteiro para o `Pipeline`.
+ * @return Sempre `nullptr`.
+ */
+static void *jobs_worker(void *arg)
+{
+	Pipeline *p = arg;
+	CacheEntry cache[JOBS_CACHE] = { 0 };
+	size_t batch[JOBS_BATCH];
+
+	pthread_mutex_lock(&p->lock);
+	for (;;) {
+		while (p->work.size == 0 && !p->eof)
+			pthread_cond_wait(&p->can_work, &p->lock);
+		if (p->work.size == 0)
+			break;
+
+		size_t count = p->work.size / p->workers + 1;
+		if (count > JOBS_BATCH)
+			count = JOBS_BATCH;
+		if (count > p->work.size)
+			count = p->work.size;
+		for (size_t i = 0; i < count; ++i)
+			batch[i] = ring_pop(&p->work);
+		pthread_mutex_unlock(&p->lock);
+
+		for (size_t i = 0; i < count; ++i)
+			jobs_compute(&p->slots[batch[i]], cache,
+				     p->opts.cache);
+
+		pthread_mutex_lock(&p->lock);
+		for (size_t i = 0; i < count; ++i) {
+			p->slots[batch[i]].done = true;
+			if (p->opts.unordered)
+				ring_push(&p->done, batch[i]);
+		}
+		pthread_cond_signal(&p->can_write);
+	}
+	pthread_mutex_unlock(&p->lock);
+
+	for (size_t i = 0; i < JOBS_CACHE; ++i)
+		if (cache[i].func != nullptr)
+			function_free(cache[i].func);
+	return nullptr;
+}
+
+/**
+ * @brief Laço da thread de escrita.
+ *
+ * @param arg Ponteiro para o `Pipeline`.
+ * @return Sempre `nullptr`.
+ */
+static void *jobs_writer(void *arg)
+{
+	Pipeline *p = arg;
+	size_t batch[JOBS_BATCH];
+
+	jobs_print_header(p->out, p->opts.format);
+
+	pthread_mutex_lock(&p->lock);
+	for (;;) {
+		size_t count = jobs_ready(p, batch);
+		if (count == 0) {
+			if (p->eof && p->written == p->produced)
+				break;
+			pthread_cond_wait(&p->can_write, &p->lock);
+			continue;
+		}
+		pthread_mutex_unlock(&p->lock);
+
+		// Escreve fora da seção crítica, e então devolve as posições.
+		for (size_t i = 0; i < count; ++i)
+			jobs_print(p, &p->slots[batch[i]]);
+
+		pthread_mutex_lock(&p->lock);
+		for (size_t i = 0; i < count; ++i)
+			p->free_slots[p->num_free++] = batch[i];
+		p->written += count;
+		pthread_cond_signal(&p->can_read);
+	}
+	pthread_mutex_unlock(&p->lock);
+
+	fflush(p->out);
+	return nullptr;
+}
+
+/**
+ * @brief Calcula o resultado de um trabalho.
+ *
+ * @details A soma usa uma única thread: o paralelismo do pipeline já está nos
+ * trabalhos, e cada thread de cálculo usar o conjunto global de threads só
+ * serializaria as chamadas.
+ *
+ * @param slot Ponteiro para a posição com o trabalho.
+ * @param cache Tabela de funções da thread de cálculo.
+ * @param results Cache de resultados compartilhado, ou `nullptr`.
+ */
+static void jobs_compute(Slot *slot, CacheEntry *cache,
+			 ResultCache *results)
+{
+	const Job *job = &slot->job;
+	if (slot->err != nullptr)
+		return;
+
+	Function *func = jobs_function(cache, job);
+	if (func == nullptr) {
+		slot->err = "falha ao criar a função";
+		return;
+	}
+
+	const RiemannOptions opts = { .threads = 1, .cache = results };
+	slot->value = riemann_opts(job->min, job->max, func, job->n,
+				   job->method, &opts);
+}
+
+/**
+ * @brief Obtém a função de um trabalho, reaproveitando a da tabela se os
+ * coeficientes forem idênticos.
+ *
+ * @details A tabela é de mapeamento direto: o hash FNV-1a dos coeficientes
+ * escolhe a entrada, e uma função diferente que caia na mesma entrada
+ * substitui a anterior.
+ *
+ * @param cache Tabela de funções da thread de cálculo.
+ * @param job Ponteiro para o trabalho.
+ * @return Ponteiro para a função (pertencente à tabela), ou `nullptr` se
+ * houver falha de alocação.
+ */
+static Function *jobs_function(CacheEntry *cache, const Job *job)
+{
+	const unsigned char *bytes = (const unsigned char *)job->coeffs;
+	size_t size = (job->degree + 1) * sizeof(*job->coeffs);
+	uint64_t hash = 0xcbf29ce484222325;
+	for (size_t i = 0; i < size; ++i)
+		hash = (hash ^ bytes[i]) * 0x100000001b3;
+
+	CacheEntry *e = &cache[hash & (JOBS_CACHE - 1)];
+	if (e->func != nullptr && e->hash == hash &&
+	    function_polynomial_equal(e->func, job->degree, job->coeffs))
+		return e->func;
+
+	if (e->func != nullptr)
+		function_free(e->func);
+	e->hash = hash;
+	e->func = function_new(POLYNOMIAL, job->degree, (double *)job->coeffs);
+	return e->func;
+}
+
+/**
+ * @brief Coleta as posições prontas para escrita.
+ *
+ * @details Deve ser chamada com a trava do pipeline adquirida.
+ *
+ * @param p Ponteiro para o pipeline.
+ * @param batch Arranjo de `JOBS_BATCH` elementos onde os índices das posições
+ * serão escritos.
+ * @return O número de posições coletadas.
+ */
+static size_t jobs_ready(Pipeline *p, size_t *batch)
+{
+	size_t count = 0;
+
+	if (p->opts.unordered) {
+		while (count < JOBS_BATCH && p->done.size > 0)
+			batch[count++] = ring_pop(&p->done);
+		return count;
+	}
+
+	// Na saída ordenada, só avança enquanto o próximo da sequência estiver
+	// pronto.
+	while (count < JOBS_BATCH && p->written + count < p->produced) {
+		size_t slot = p->order[(p->written + count) % p->capacity];
+		if (!p->slots[slot].done)
+			break;
+		batch[count++] = slot;
+	}
+	return count;
+}
+
+/**
+ * @brief Escreve o resultado de uma posição no formato escolhido.
+ *
+ * @param p Ponteiro para o pipeline.
+ * @param slot Ponteiro para a posição.
+ */
+static void jobs_print(Pipeline *p, const Slot *slot)
+{
+	if (slot->err != nullptr)
+		++p->errors;
+	jobs_print_result(p->out, p->opts.format, slot->job.id, slot->value,
+			  slot->err);
+}
\ No newline at end of file
@@ -15,13 +15,32 @@
  * O programa calcula a integral desses polinômios nos intervalos especificados
  * utilizando a soma de Riemann pela direita e pela esquerda com diferentes
  * quantidades de retângulos: 100, 300, 600, 1000, 1500 e 2000.
+ *
+ * Com a opção `--jobs`, o programa processa em fluxo trabalhos de integração
+ * lidos de um arquivo ou da entrada padrão, no formato descrito em `jobs.h`.
+ * As opções `--encode`, `--decode`, `--run` e `--results` convertem e
+ * processam trabalhos no formato binário descrito em `jobfile.h`. A opção
+ * `--serve` executa o servidor de `server.h`, e `--client`, `--stats` e
+ * `--shutdown` comunicam-se com ele. Com `--memo`, `--jobs` e `--serve`
+ * memorizam os resultados num arquivo, reaproveitado entre execuções (ver
+ * `cache.h`). A opção `--plugin` integra a função de um plugin (ver
+ * `plugin.h`).
  */
 
+#include <errno.h>
+#include <inttypes.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
+#include "cache.h"
 #include "func.h"
+#include "jobfile.h"
+#include "jobs.h"
+#include "plugin.h"
+#include "pool.h"
 #include "riemann.h"
+#include "server.h"
 
 /**
  * @brief Estrutura que representa os limites de integração.
@@ -31,9 +50,52 @@ typedef struct {
 	double b; /**< Limite superior de integração */
 } Limites;
 
+// Declarações internas.
+static int demo(void);
+static int jobs(int argc, char **argv);
+static int binary(int argc, char **argv);
+static int server(int argc, char **argv);
+static int plugin(int argc, char **argv);
+static ResultCache *memo_open(const char *path);
+static bool memo_close(ResultCache *cache, const char *path);
+static int usage(const char *prog);
+
 /**
  * @brief Função principal do programa.
  *
+ * @details Sem argumentos, executa a demonstração com os polinômios fixos.
+ * Com `--jobs`, processa trabalhos de integração em fluxo; com `--serve`,
+ * `--client`, `--stats` e `--shutdown`, executa ou usa o servidor; com
+ * `--plugin`, integra a função de um plugin; com as demais opções, trabalha
+ * com o formato binário.
+ *
+ * @param argc Número de argumentos.
+ * @param argv Arranjo com os argumentos.
+ * @return EXIT_SUCCESS em caso de sucesso.
+ */
+int main(int argc, char **argv)
+{
+	if (argc < 2)
+		return demo();
+	if (strcmp(argv[1], "--jobs") == 0)
+		return jobs(argc, argv);
+	if (strcmp(argv[1], "--encode") == 0 ||
+	    strcmp(argv[1], "--decode") == 0 ||
+	    strcmp(argv[1], "--run") == 0 || strcmp(argv[1], "--results") == 0)
+		return binary(argc, argv);
+	if (strcmp(argv[1], "--serve") == 0 ||
+	    strcmp(argv[1], "--client") == 0 ||
+	    strcmp(argv[1], "--stats") == 0 ||
+	    strcmp(argv[1], "--shutdown") == 0)
+		return server(argc, argv);
+	if (strcmp(argv[1], "--plugin") == 0)
+		return plugin(argc, argv);
+	return usage(argv[0]);
+}
+
+/**
+ * @brief Executa a demonstração.
+ *
  * @details Esta função define os polinômios e seus limites de integração,
  * calcula as integrais utilizando somas de Riemann pela direita e pela
  * esquerda, e exibe os resultados. Os polinômios considerados são:
@@ -44,7 +106,7 @@ typedef struct {
  *
  * @return EXIT_SUCCESS em caso de sucesso.
  */
-int main(void)
+static int demo(void)
 {
 	// Definições das funções e dos limites de cada questão.
 	constexpr int num_questoes = 4;
@@ -98,22 +160,32 @@ int main(void)
 		       l.b);
 	}
 
-	// Executa todas as somas.
+	// Executa todas as somas. Para cada polinômio, uma única varredura
+	// calcula as somas pela direita e pela esquerda para todos os valores,
+	// reaproveitando as avaliações entre eles.
+	RiemannSweep somas[num_questoes][num_valores];
+	for (int i = 0; i < num_questoes; ++i) {
+		Limites l = limites[i];
+		if (!riemann_sweep(l.a, l.b, questoes[i], valores, num_valores,
+				   false, somas[i]))
+			return EXIT_FAILURE;
+	}
+
+	// Exibe os resultados.
 	for (int i = 0; i < num_tipos; ++i) {
 		SumType t = tipos[i];
 		printf("\nCalculando somas de Riemann pela %s:\n",
 		       t == DIREITA ? "direita" : "esquerda");
 
-		for (int i = 0; i < num_valores; ++i) {
-			size_t n = valores[i];
-			printf("n = %4ju:", n);
+		for (int j = 0; j < num_valores; ++j) {
+			printf("n = %4ju:", valores[j]);
 
-			for (int i = 0; i < num_questoes; ++i) {
-				Function *f = questoes[i];
-				Limites l = limites[i];
-				double res = riemann(l.a, l.b, f, n, t);
+			for (int k = 0; k < num_questoes; ++k) {
+				RiemannSweep *s = &somas[k][j];
+				double res = t == DIREITA ? s->direita :
+							    s->esquerda;
 
-				printf("\t%c) %g", i + 'a', res);
+				printf("\t%c) %g", k + 'a', res);
 			}
 
 			putchar('\n');
@@ -123,4 +195,387 @@ int main(void)
 	for (int i = 0; i < num_questoes; ++i)
 		function_free(questoes[i]);
 	return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Processa trabalhos de integração em fluxo.
+ *
+ * @details Aceita as opções `--format csv|jsonl`, `--unordered`,
+ * `--threads N`, `--queue N` e `--memo ARQUIVO`, e no máximo um arquivo de
+ * entrada (`-` ou nenhum para a entrada padrão). Os resultados vão para a
+ * saída padrão.
+ *
+ * @param argc Número de argumentos.
+ * @param argv Arranjo com os argumentos, sendo `argv[1]` igual a `--jobs`.
+ * @return EXIT_SUCCESS se todos os trabalhos tiveram sucesso.
+ */
+static int jobs(int argc, char **argv)
+{
+	JobsOptions opts = { 0 };
+	const char *path = nullptr, *memo = nullptr;
+
+	for (int i = 2; i < argc; ++i) {
+		const char *arg = argv[i];
+		const char *val = i + 1 < argc ? argv[i + 1] : nullptr;
+
+		if (strcmp(arg, "--unordered") == 0) {
+			opts.unordered = true;
+		} else if (strcmp(arg, "--format") == 0 && val != nullptr) {
+			if (strcmp(val, "csv") == 0)
+				opts.format = JOBS_CSV;
+			else if (strcmp(val, "jsonl") == 0)
+				opts.format = JOBS_JSONL;
+			else
+				return usage(argv[0]);
+			++i;
+		} else if (strcmp(arg, "--threads") == 0 && val != nullptr) {
+			if (!pool_parse_threads(val, &opts.threads))
+				return usage(argv[0]);
+			++i;
+		} else if (strcmp(arg, "--queue") == 0 && val != nullptr) {
+			opts.queue = strtoull(val, nullptr, 10);
+			++i;
+		} else if (strcmp(arg, "--memo") == 0 && val != nullptr) {
+			memo = val;
+			++i;
+		} else if (path == nullptr && (arg[0] != '-' || arg[1] == '\0')) {
+			path = arg;
+		} else {
+			return usage(argv[0]);
+		}
+	}
+
+	FILE *in = stdin;
+	if (path != nullptr && strcmp(path, "-") != 0) {
+		in = fopen(path, "r");
+		if (in == nullptr) {
+			perror(path);
+			return EXIT_FAILURE;
+		}
+	}
+	if (memo != nullptr && (opts.cache = memo_open(memo)) == nullptr) {
+		if (in != stdin)
+			fclose(in);
+		return EXIT_FAILURE;
+	}
+
+	long errors = jobs_run(in, stdout, &opts);
+	if (in != stdin)
+		fclose(in);
+	if (memo != nullptr && !memo_close(opts.cache, memo))
+		errors = errors < 0 ? errors : errors + 1;
+	if (errors < 0)
+		fputs("Falha ao processar os trabalhos\n", stderr);
+	else if (errors > 0)
+		fprintf(stderr, "%ld trabalhos com erro\n", errors);
+	return errors == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * @brief Converte e processa trabalhos no formato binário.
+ *
+ * @details Os modos são:
+ * - `--encode [ENTRADA|-] SAÍDA`: converte do formato textual para o binário;
+ * - `--decode TRABALHOS`: converte do formato binário para o textual;
+ * - `--run TRABALHOS RESULTADOS [--threads N]`: calcula os trabalhos ainda
+ *   pendentes no arquivo de resultados, criando-o se necessário;
+ * - `--results TRABALHOS RESULTADOS [--format csv|jsonl]`: exibe os
+ *   resultados já calculados.
+ *
+ * @param argc Número de argumentos.
+ * @param argv Arranjo com os argumentos, sendo `argv[1]` o modo.
+ * @return EXIT_SUCCESS em caso de sucesso.
+ */
+static int binary(int argc, char **argv)
+{
+	const char *mode = argv[1];
+	JobFile file;
+	ResultFile results;
+	int ret = EXIT_FAILURE;
+
+	if (strcmp(mode, "--encode") == 0) {
+		if (argc != 3 && argc != 4)
+			return usage(argv[0]);
+		FILE *in = stdin;
+		if (argc == 4 && strcmp(argv[2], "-") != 0) {
+			in = fopen(argv[2], "r");
+			if (in == nullptr) {
+				perror(argv[2]);
+				return EXIT_FAILURE;
+			}
+		}
+		long skipped = jobfile_encode(in, argv[argc - 1]);
+		if (in != stdin)
+			fclose(in);
+		return skipped == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
+	if (strcmp(mode, "--decode") == 0) {
+		if (argc != 3)
+			return usage(argv[0]);
+		if (!jobfile_open(&file, argv[2]))
+			return EXIT_FAILURE;
+		long invalid = jobfile_decode(&file, stdout);
+		if (invalid > 0)
+			fprintf(stderr, "%ld registros inválidos\n", invalid);
+		jobfile_close(&file);
+		return invalid == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
+	// Os modos restantes recebem os dois arquivos e opções.
+	if (argc < 4)
+		return usage(argv[0]);
+	unsigned threads = 0;
+	JobsFormat format = JOBS_CSV;
+	for (int i = 4; i < argc; ++i) {
+		if (i + 1 < argc && strcmp(argv[i], "--threads") == 0) {
+			if (!pool_parse_threads(argv[++i], &threads))
+				return usage(argv[0]);
+		} else if (i + 1 < argc && strcmp(argv[i], "--format") == 0) {
+			format = strcmp(argv[++i], "jsonl") == 0 ? JOBS_JSONL :
+								   JOBS_CSV;
+		} else {
+			return usage(argv[0]);
+		}
+	}
+
+	if (!jobfile_open(&file, argv[2]))
+		return EXIT_FAILURE;
+	if (!resultfile_open(&results, argv[3], &file))
+		goto close_jobs;
+
+	if (strcmp(mode, "--run") == 0) {
+		size_t computed = jobfile_run(&file, &results, threads);
+		fprintf(stderr, "%zu trabalhos calculados\n", computed);
+		ret = EXIT_SUCCESS;
+	} else {
+		long errors = resultfile_print(&results, stdout, format);
+		ret = errors == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
+	resultfile_close(&results);
+close_jobs:
+	jobfile_close(&file);
+	return ret;
+}
+
+/**
+ * @brief Executa o servidor de integração ou comunica-se com ele.
+ *
+ * @details Os modos são:
+ * - `--serve SOCKET [--threads N] [--window US] [--cache N] [--queue N]
+ *   [--memo ARQUIVO]`: executa o servidor até `SIGINT`, `SIGTERM` ou
+ *   `--shutdown`;
+ * - `--client SOCKET [--format csv|jsonl] [ARQUIVO|-]`: envia os trabalhos
+ *   no formato textual e exibe os resultados, na ordem em que chegam;
+ * - `--stats SOCKET`: exibe as estatísticas do servidor;
+ * - `--shutdown SOCKET`: pede ao servidor que termine.
+ *
+ * @param argc Número de argumentos.
+ * @param argv Arranjo com os argumentos, sendo `argv[1]` o modo.
+ * @return EXIT_SUCCESS em caso de sucesso.
+ */
+static int server(int argc, char **argv)
+{
+	const char *mode = argv[1];
+	ServerOptions opts = { 0 };
+	JobsFormat format = JOBS_CSV;
+	const char *path = nullptr, *memo = nullptr;
+
+	if (argc < 3)
+		return usage(argv[0]);
+	const char *socket = argv[2];
+
+	if (strcmp(mode, "--stats") == 0 || strcmp(mode, "--shutdown") == 0) {
+		if (argc != 3)
+			return usage(argv[0]);
+		if (strcmp(mode, "--shutdown") == 0)
+			return server_shutdown(socket) ? EXIT_SUCCESS :
+							 EXIT_FAILURE;
+
+		ServerStats st;
+		if (!server_stats(socket, &st))
+			return EXIT_FAILURE;
+		printf("pedidos: %" PRIu64 "\n"
+		       "erros: %" PRIu64 "\n"
+		       "conexões: %" PRIu64 "\n"
+		       "lotes: %" PRIu64 "\n"
+		       "cache: %" PRIu64 " acertos, %" PRIu64 " faltas\n"
+		       "latência: p50 %.1f µs, p99 %.1f µs\n",
+		       st.requests, st.errors, st.connections, st.batches,
+		       st.cache_hits, st.cache_misses, st.p50_us, st.p99_us);
+		return EXIT_SUCCESS;
+	}
+
+	bool serve = strcmp(mode, "--serve") == 0;
+	for (int i = 3; i < argc; ++i) {
+		const char *arg = argv[i];
+		const char *val = i + 1 < argc ? argv[i + 1] : nullptr;
+
+		if (!serve && path == nullptr &&
+		    (arg[0] != '-' || arg[1] == '\0')) {
+			path = arg;
+			continue;
+		}
+		if (val == nullptr)
+			return usage(argv[0]);
+		if (serve && strcmp(arg, "--threads") == 0) {
+			if (!pool_parse_threads(val, &opts.threads))
+				return usage(argv[0]);
+		} else if (serve && strcmp(arg, "--window") == 0) {
+			opts.window_us = strtoul(val, nullptr, 10);
+		} else if (serve && strcmp(arg, "--cache") == 0) {
+			opts.cache = strtoull(val, nullptr, 10);
+		} else if (serve && strcmp(arg, "--queue") == 0) {
+			opts.queue = strtoull(val, nullptr, 10);
+		} else if (serve && strcmp(arg, "--memo") == 0) {
+			memo = val;
+		} else if (!serve && strcmp(arg, "--format") == 0) {
+			format = strcmp(val, "jsonl") == 0 ? JOBS_JSONL :
+							     JOBS_CSV;
+		} else {
+			return usage(argv[0]);
+		}
+		++i;
+	}
+
+	if (serve) {
+		if (memo != nullptr &&
+		    (opts.results = memo_open(memo)) == nullptr)
+			return EXIT_FAILURE;
+		bool ok = server_run(socket, &opts);
+		if (memo != nullptr)
+			ok = memo_close(opts.results, memo) && ok;
+		return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
+	FILE *in = stdin;
+	if (path != nullptr && strcmp(path, "-") != 0) {
+		in = fopen(path, "r");
+		if (in == nullptr) {
+			perror(path);
+			return EXIT_FAILURE;
+		}
+	}
+
+	long errors = server_client(socket, in, stdout, format);
+	if (in != stdin)
+		fclose(in);
+	if (errors < 0)
+		fputs("Falha ao processar os trabalhos\n", stderr);
+	else if (errors > 0)
+		fprintf(stderr, "%ld trabalhos com erro\n", errors);
+	return errors == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * @brief Integra a função de um plugin.
+ *
+ * @details Carrega o plugin com os parâmetros dados e exibe as suas somas de
+ * Riemann pela direita, pela esquerda e pelo ponto médio em
+ * \f$[A, B]\f$, com \f$N\f$ retângulos. O número de threads segue a
+ * variável de ambiente `RIEMANN_THREADS`.
+ *
+ * @param argc Número de argumentos.
+ * @param argv Arranjo com os argumentos, a partir de `--plugin`.
+ * @return EXIT_SUCCESS em caso de sucesso.
+ */
+static int plugin(int argc, char **argv)
+{
+	static const char *const nomes[] = { "direita", "esquerda", "meio" };
+
+	if (argc != 6 && argc != 7)
+		return usage(argv[0]);
+
+	char *end_a, *end_b, *end_n;
+	double a = strtod(argv[3], &end_a), b = strtod(argv[4], &end_b);
+	size_t n = strtoull(argv[5], &end_n, 10);
+	if (*end_a != '\0' || *end_b != '\0' || *end_n != '\0' || n == 0)
+		return usage(argv[0]);
+
+	Function *f = function_new(PLUGIN, argv[2], argc == 7 ? argv[6] :
+							   nullptr);
+	if (f == nullptr)
+		return EXIT_FAILURE;
+
+	printf("∫ %s em [%g, %g], com %zu retângulos:\n", plugin_name(f), a, b,
+	       n);
+	for (SumType type = DIREITA; type <= MEIO; ++type)
+		printf("\t%-8s %.15g\n", nomes[type],
+		       riemann(a, b, f, n, type));
+
+	function_free(f);
+	return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Cria um cache de resultados e carrega nele um arquivo.
+ *
+ * @details A ausência do arquivo não é um erro: ele será criado por
+ * `memo_close()`.
+ *
+ * @param path O caminho do arquivo.
+ * @return Ponteiro para o cache, ou `nullptr` em caso de erro.
+ */
+static ResultCache *memo_open(const char *path)
+{
+	ResultCache *cache = cache_new(0);
+	if (cache == nullptr)
+		return nullptr;
+
+	if (cache_load(cache, path) < 0 && errno != ENOENT) {
+		cache_free(cache);
+		return nullptr;
+	}
+	return cache;
+}
+
+/**
+ * @brief Exibe os contadores de um cache de resultados, grava-o num arquivo e
+ * o libera.
+ *
+ * @param cache Ponteiro para o cache.
+ * @param path O caminho do arquivo.
+ * @return `true` em caso de sucesso, `false` se a gravação falhou.
+ */
+static bool memo_close(ResultCache *cache, const char *path)
+{
+	CacheStats st;
+
+	cache_stats(cache, &st);
+	fprintf(stderr,
+		"memo: %" PRIu64 " acertos, %" PRIu64 " faltas, %" PRIu64
+		" descartes, %zu de %zu resultados\n",
+		st.hits, st.misses, st.evictions, st.size, st.capacity);
+	bool ok = cache_save(cache, path);
+	cache_free(cache);
+	return ok;
+}
+
+/**
+ * @brief Exibe a forma de uso do programa.
+ *
+ * @param prog O nome do programa.
+ * @return Sempre EXIT_FAILURE.
+ */
+static int usage(const char *prog)
+{
+	fprintf(stderr,
+		"Uso: %s\n"
+		"     %s --jobs [--format csv|jsonl] [--unordered]\n"
+		"          [--threads N] [--queue N] [--memo ARQUIVO]\n"
+		"          [ARQUIVO|-]\n"
+		"     %s --encode [ARQUIVO|-] TRABALHOS\n"
+		"     %s --decode TRABALHOS\n"
+		"     %s --run TRABALHOS RESULTADOS [--threads N]\n"
+		"     %s --results TRABALHOS RESULTADOS [--format csv|jsonl]\n"
+		"     %s --serve SOCKET [--threads N] [--window US]\n"
+		"          [--cache N] [--queue N] [--memo ARQUIVO]\n"
+		"     %s --client SOCKET [--format csv|jsonl] [ARQUIVO|-]\n"
+		"     %s --stats SOCKET\n"
+		"     %s --shutdown SOCKET\n"
+		"     %s --plugin PLUGIN A B N [PARÂMETROS]\n",
+		prog, prog, prog, prog, prog, prog, prog, prog, prog, prog,
+		prog);
+	return EXIT_FAILURE;
 }
\ No newline at end of file
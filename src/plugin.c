@@ -0,0 +1,137 @@
+// SPDX-License-Identifier: ISC
+
+/**
+ * @file plugin.c
+ * @brief Implementação do carregamento de plugins de funções.
+ *
+ * @details A função de um plugin ocupa um bloco com o objeto `Function` no
+ * início, seguido do identificador do objeto carregado e de uma cópia da
+ * tabela do plugin. O campo `impl` da função é o estado criado pelo próprio
+ * plugin, de modo que `eval` e `eval_batch` apontam diretamente para o
+ * código do plugin.
+ */
+
+#include <dlfcn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "plugin.h"
+#include "util.h"
+
+/**
+ * @brief Função de um plugin alocada num único bloco.
+ */
+typedef struct {
+	Function func; /**< O objeto função, no início do bloco. */
+	void *handle; /**< O objeto compartilhado, aberto por `dlopen()`. */
+	RiemannPlugin table; /**< Cópia da tabela do plugin, com os campos
+			      * desconhecidos por ele anulados. */
+	char path[]; /**< O caminho do objeto, para mensagens. */
+} PluginBlock;
+
+// Declarações internas.
+static bool plugin_table(PluginBlock *p, const RiemannPlugin *table);
+
+// Carrega um plugin e instancia a sua função.
+[[nodiscard("Ignorar retorno pode causar vazamento de memória")]]
+Function *plugin_open(const char *path, const char *params)
+{
+	size_t len = strlen(path);
+	PluginBlock *p = malloc(sizeof(*p) + len + 1);
+	ERRNOCHECK(p == nullptr, "Falha ao alocar plugin", ret);
+	memcpy(p->path, path, len + 1);
+
+	// Resolve todos os símbolos já no carregamento, para que um plugin
+	// incompleto falhe aqui, e não no meio de uma soma.
+	p->handle = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+	if (p->handle == nullptr) {
+		fprintf(stderr, "Falha ao carregar plugin: %s\n", dlerror());
+		goto free_p;
+	}
+
+	const RiemannPlugin *table = dlsym(p->handle, RIEMANN_PLUGIN_SYMBOL);
+	if (table == nullptr) {
+		fprintf(stderr, "Plugin %s não exporta %s\n", path,
+			RIEMANN_PLUGIN_SYMBOL);
+		goto close;
+	}
+	if (!plugin_table(p, table))
+		goto close;
+
+	void *state = nullptr;
+	if (p->table.init != nullptr && p->table.init(params, &state) != 0) {
+		fprintf(stderr, "Plugin %s rejeitou os parâmetros: %s\n",
+			plugin_name(&p->func), params ? params : "(nenhum)");
+		goto close;
+	}
+
+	p->func.eval = p->table.eval;
+	p->func.eval_batch = p->table.eval_batch;
+	p->func.impl = state;
+	return (Function *)p;
+
+close:
+	dlclose(p->handle);
+free_p:
+	free(p);
+ret:
+	return nullptr;
+}
+
+// Libera a função de um plugin e descarrega o objeto.
+void plugin_free(Function *func)
+{
+	PluginBlock *p = (PluginBlock *)func;
+
+	if (p->table.destroy != nullptr)
+		p->table.destroy(func->impl);
+	dlclose(p->handle);
+	free(p);
+}
+
+// Retorna o nome da função de um plugin.
+const char *plugin_name(const Function *func)
+{
+	const PluginBlock *p = (const PluginBlock *)func;
+	return p->table.name != nullptr ? p->table.name : p->path;
+}
+
+/**
+ * @brief Valida e copia a tabela de um plugin.
+ *
+ * @details A tabela é copiada até o tamanho declarado pelo plugin, e os
+ * campos além dele (acrescentados depois da versão com que o plugin foi
+ * compilado) ficam nulos. Os campos obrigatórios (até `eval`) devem estar
+ * dentro desse tamanho.
+ *
+ * @param p Ponteiro para o bloco da função, com `path` preenchido.
+ * @param table Ponteiro para a tabela exportada pelo plugin.
+ * @return `true` se a tabela for válida, `false` caso contrário (e o motivo é
+ * exibido na saída de erro).
+ */
+static bool plugin_table(PluginBlock *p, const RiemannPlugin *table)
+{
+	constexpr size_t required = offsetof(RiemannPlugin, eval) +
+				    sizeof(eval_ptr_t);
+
+	if (table->abi != RIEMANN_PLUGIN_ABI || table->size < required) {
+		fprintf(stderr,
+			"Plugin %s incompatível: versão %u (esperada %d), "
+			"tabela de %u bytes\n",
+			p->path, table->abi, RIEMANN_PLUGIN_ABI, table->size);
+		return false;
+	}
+
+	size_t size = table->size < sizeof(p->table) ? table->size :
+						       sizeof(p->table);
+	p->table = (RiemannPlugin){ 0 };
+	memcpy(&p->table, table, size);
+	p->func = (Function){ .type = PLUGIN };
+
+	if (p->table.eval == nullptr) {
+		fprintf(stderr, "Plugin %s não define eval\n", p->path);
+		return false;
+	}
+	return true;
+}
\ No newline at end of file
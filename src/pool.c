@@ -0,0 +1,322 @@
+// SPDX-License-Identifier: ISC
+
+/**
+ * @file pool.c
+ * @brief Implementação do conjunto reutilizável de threads de trabalho.
+ *
+ * @details As threads de trabalho dormem numa variável de condição até que
+ * `pool_run()` publique um novo lote de tarefas, identificado por um número de
+ * geração. As tarefas são distribuídas dinamicamente por um contador atômico,
+ * de modo que threads mais rápidas pegam mais tarefas. A thread chamadora
+ * também executa tarefas, e só retorna depois que todas as threads envolvidas
+ * no lote tiverem terminado.
+ */
+
+#include <ctype.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "pool.h"
+#include "util.h"
+
+/**
+ * @brief Estrutura que define um conjunto de threads de trabalho.
+ */
+struct Pool {
+	pthread_mutex_t lock; /**< Protege os campos abaixo. */
+	pthread_cond_t wake; /**< Sinaliza um novo lote ou o término. */
+	pthread_cond_t done; /**< Sinaliza que as threads do lote acabaram. */
+	pthread_mutex_t run_lock; /**< Serializa chamadas a `pool_run()`. */
+	pthread_t *threads; /**< Arranjo com as threads de trabalho. */
+	unsigned workers; /**< Número de threads de trabalho. */
+	unsigned limit; /**< Número máximo de threads de trabalho, reduzido
+			 * quando o crescimento falha. */
+	unsigned long generation; /**< Número do lote atual. */
+	bool stop; /**< Indica que as threads devem terminar. */
+	pool_task_t task; /**< Função que executa cada tarefa do lote. */
+	void *ctx; /**< Contexto repassado às tarefas do lote. */
+	size_t count; /**< Número de tarefas do lote. */
+	unsigned active; /**< Threads de trabalho que participam do lote. */
+	unsigned running; /**< Threads do lote que ainda não terminaram. */
+	atomic_size_t next; /**< Índice da próxima tarefa a ser executada. */
+};
+
+/**
+ * @brief Argumentos repassados a cada thread de trabalho.
+ */
+typedef struct {
+	Pool *pool; /**< O conjunto ao qual a thread pertence. */
+	unsigned id; /**< Índice da thread no conjunto. */
+	unsigned long generation; /**< Último lote visto pela thread. */
+} WorkerArgs;
+
+// Declarações internas.
+static void *pool_worker(void *arg);
+static void pool_work(Pool *pool);
+static bool pool_grow(Pool *pool, unsigned workers);
+
+// Instancia um conjunto de threads.
+[[nodiscard("Ignorar retorno pode causar vazamento de memória")]]
+Pool *pool_new(unsigned workers)
+{
+	Pool *pool = calloc(1, sizeof(typeof(*pool)));
+	ERRNOCHECK(pool == nullptr, "Falha ao alocar conjunto de threads", ret);
+
+	pthread_mutex_init(&pool->lock, nullptr);
+	pthread_mutex_init(&pool->run_lock, nullptr);
+	pthread_cond_init(&pool->wake, nullptr);
+	pthread_cond_init(&pool->done, nullptr);
+	pool->limit = UINT_MAX;
+
+	if (!pool_grow(pool, workers)) {
+		pool_free(pool);
+		return nullptr;
+	}
+
+	return pool;
+
+ret:
+	return nullptr;
+}
+
+// Termina as threads de um conjunto e o libera.
+void pool_free(Pool *pool)
+{
+	pthread_mutex_lock(&pool->lock);
+	pool->stop = true;
+	pthread_cond_broadcast(&pool->wake);
+	pthread_mutex_unlock(&pool->lock);
+
+	for (unsigned i = 0; i < pool->workers; ++i)
+		pthread_join(pool->threads[i], nullptr);
+
+	pthread_cond_destroy(&pool->done);
+	pthread_cond_destroy(&pool->wake);
+	pthread_mutex_destroy(&pool->run_lock);
+	pthread_mutex_destroy(&pool->lock);
+	free(pool->threads);
+	free(pool);
+}
+
+// O conjunto global e o controle da sua inicialização.
+static Pool *global = nullptr;
+static pthread_once_t global_once = PTHREAD_ONCE_INIT;
+
+/**
+ * @brief Cria o conjunto global, inicialmente sem threads de trabalho.
+ */
+static void pool_global_init(void)
+{
+	global = pool_new(0);
+}
+
+// Retorna o conjunto global de threads, criando-o na primeira chamada.
+Pool *pool_global(unsigned threads)
+{
+	pthread_once(&global_once, &pool_global_init);
+	if (global == nullptr)
+		return nullptr;
+
+	// Cresce o conjunto se houver menos threads do que o pedido. Se
+	// falhar, continua com as que já existem.
+	if (threads > 1) {
+		pthread_mutex_lock(&global->run_lock);
+		pool_grow(global, threads - 1);
+		pthread_mutex_unlock(&global->run_lock);
+	}
+
+	return global;
+}
+
+// Executa um lote de tarefas e aguarda o término de todas.
+void pool_run(Pool *pool, size_t count, unsigned threads, pool_task_t task,
+	      void *ctx)
+{
+	pthread_mutex_lock(&pool->run_lock);
+
+	// Publica o lote para as threads de trabalho. O número de threads
+	// participantes é limitado pelo pedido e pelo número de tarefas.
+	pthread_mutex_lock(&pool->lock);
+	unsigned active = threads > 0 ? threads - 1 : 0;
+	if (active > pool->workers)
+		active = pool->workers;
+	if (active > count)
+		active = (unsigned)count;
+	pool->task = task;
+	pool->ctx = ctx;
+	pool->count = count;
+	pool->active = active;
+	pool->running = active;
+	atomic_store(&pool->next, 0);
+	++pool->generation;
+	if (active > 0)
+		pthread_cond_broadcast(&pool->wake);
+	pthread_mutex_unlock(&pool->lock);
+
+	// Participa da execução, e então espera as demais threads.
+	pool_work(pool);
+
+	pthread_mutex_lock(&pool->lock);
+	while (pool->running > 0)
+		pthread_cond_wait(&pool->done, &pool->lock);
+	pthread_mutex_unlock(&pool->lock);
+
+	pthread_mutex_unlock(&pool->run_lock);
+}
+
+// Retorna o número de processadores disponíveis.
+unsigned pool_cpu_count(void)
+{
+	long n = sysconf(_SC_NPROCESSORS_ONLN);
+	return n > 0 ? (unsigned)n : 1;
+}
+
+// Interpreta um número de threads dado pelo usuário.
+bool pool_parse_threads(const char *str, unsigned *threads)
+{
+	unsigned limit = POOL_THREADS_PER_CPU * pool_cpu_count();
+
+	if (strcmp(str, "auto") == 0) {
+		*threads = pool_cpu_count();
+		return true;
+	}
+
+	// `strtoul()` aceitaria espaços e sinais, e converteria os negativos
+	// sem erro.
+	if (!isdigit((unsigned char)*str))
+		goto invalid;
+	char *end;
+	errno = 0;
+	unsigned long n = strtoul(str, &end, 10);
+	if (*end != '\0')
+		goto invalid;
+
+	*threads = errno == ERANGE || n > limit ? limit : (unsigned)n;
+	return true;
+
+invalid:
+	errno = EINVAL;
+	return false;
+}
+
+/**
+ * @brief Executa tarefas do lote atual até que não reste nenhuma.
+ *
+ * @param pool Ponteiro para o conjunto.
+ */
+static void pool_work(Pool *pool)
+{
+	size_t i;
+
+	while ((i = atomic_fetch_add(&pool->next, 1)) < pool->count)
+		pool->task(i, pool->ctx);
+}
+
+/**
+ * @brief Laço principal de uma thread de trabalho.
+ *
+ * @param arg Ponteiro para os argumentos da thread (`WorkerArgs`), que são
+ * liberados por ela ao terminar.
+ * @return Sempre `nullptr`.
+ */
+static void *pool_worker(void *arg)
+{
+	WorkerArgs *args = arg;
+	Pool *pool = args->pool;
+
+	pthread_mutex_lock(&pool->lock);
+	for (;;) {
+		// Dorme até que haja um novo lote ou um pedido de término. Uma
+		// thread além de `workers` foi desfeita por `pool_grow()`.
+		while (!pool->stop && args->id < pool->workers &&
+		       pool->generation == args->generation)
+			pthread_cond_wait(&pool->wake, &pool->lock);
+		if (pool->stop || args->id >= pool->workers)
+			break;
+		args->generation = pool->generation;
+
+		// Threads além do número pedido não participam do lote.
+		if (args->id >= pool->active)
+			continue;
+
+		pthread_mutex_unlock(&pool->lock);
+		pool_work(pool);
+		pthread_mutex_lock(&pool->lock);
+
+		if (--pool->running == 0)
+			pthread_cond_signal(&pool->done);
+	}
+	pthread_mutex_unlock(&pool->lock);
+
+	free(args);
+	return nullptr;
+}
+
+/**
+ * @brief Cria threads de trabalho até que o conjunto tenha o número pedido.
+ *
+ * @details Deve ser chamada sem lotes em execução (isto é, com `run_lock`
+ * adquirido, ou antes de o conjunto ser publicado). O crescimento é
+ * completo ou desfeito: se faltar memória ou uma thread não puder ser
+ * criada, as threads criadas nesta chamada são terminadas, e o conjunto
+ * passa a não crescer além do número que tinha.
+ *
+ * @param pool Ponteiro para o conjunto.
+ * @param workers Número desejado de threads de trabalho.
+ * @return `true` em caso de sucesso, `false` caso contrário.
+ */
+static bool pool_grow(Pool *pool, unsigned workers)
+{
+	unsigned old = pool->workers;
+
+	if (workers <= old)
+		return true;
+	if (old >= pool->limit)
+		return false;
+
+	pthread_t *threads = realloc(pool->threads, workers * sizeof(*threads));
+	ERRNOCHECK(threads == nullptr, "Falha ao alocar threads", rollback);
+	pool->threads = threads;
+
+	while (pool->workers < workers) {
+		WorkerArgs *args = malloc(sizeof(typeof(*args)));
+		ERRNOCHECK(args == nullptr, "Falha ao alocar argumentos",
+			   rollback);
+
+		// A thread é contada antes de criada, para que não se veja
+		// além de `workers`.
+		pthread_mutex_lock(&pool->lock);
+		unsigned id = pool->workers++;
+		*args = (WorkerArgs){ pool, id, pool->generation };
+		pthread_mutex_unlock(&pool->lock);
+
+		errno = pthread_create(&threads[id], nullptr, &pool_worker,
+				       args);
+		if (errno != 0) {
+			free(args);
+			pthread_mutex_lock(&pool->lock);
+			--pool->workers;
+			pthread_mutex_unlock(&pool->lock);
+		}
+		ERRNOCHECK(errno != 0, "Falha ao criar thread", rollback);
+	}
+
+	return true;
+
+rollback: // Termina as threads criadas nesta chamada.
+	pthread_mutex_lock(&pool->lock);
+	unsigned created = pool->workers;
+	pool->workers = old;
+	pool->limit = old;
+	pthread_cond_broadcast(&pool->wake);
+	pthread_mutex_unlock(&pool->lock);
+	for (unsigned i = old; i < created; ++i)
+		pthread_join(pool->threads[i], nullptr);
+	return false;
+}
\ No newline at end of file
@@ -0,0 +1,298 @@
+// SPDX-License-Identifier: ISC
+
+/**
+ * @file quad.c
+ * @brief Implementação do integrador adaptativo de Gauss–Kronrod.
+ *
+ * @details Os nós e pesos da regra G7-K15 são os do QUADPACK. Os
+ * subintervalos ficam num heap binário de máximo, ordenado pelo erro
+ * estimado, guardado num arranjo que cresce por duplicação. A integral e o
+ * erro totais são mantidos incrementalmente: ao dividir um subintervalo, suas
+ * contribuições são subtraídas e as das duas metades, somadas.
+ */
+
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "quad.h"
+#include "func.h"
+#include "instr.h"
+#include "util.h"
+
+/**
+ * @brief Abscissas da regra de Kronrod de 15 pontos em \f$[-1, 1]\f$.
+ *
+ * @details Somente as não negativas, em ordem decrescente. As de índice ímpar
+ * são também as abscissas da regra de Gauss de 7 pontos.
+ */
+static const double xgk[8] = {
+	0.991455371120812639206854697526329, 0.949107912342758524526189684047851,
+	0.864864423359769072789712788640926, 0.741531185599394439863864773280788,
+	0.586087235467691130294144845693013, 0.405845151377397166906606412076961,
+	0.207784955007898467600689403773245, 0.000000000000000000000000000000000,
+};
+
+/**
+ * @brief Pesos da regra de Kronrod de 15 pontos, na ordem de `xgk`.
+ */
+static const double wgk[8] = {
+	0.022935322010529224963732008058970, 0.063092092629978553290700663189204,
+	0.104790010322250183839876322541518, 0.140653259715525918745189590510238,
+	0.169004726639267902826583426598550, 0.190350578064785409913256402421014,
+	0.204432940075298892414161999234649, 0.209482141084727828012999174891714,
+};
+
+/**
+ * @brief Pesos da regra de Gauss de 7 pontos, para as abscissas `xgk[1]`,
+ * `xgk[3]`, `xgk[5]` e `xgk[7]`.
+ */
+static const double wg[4] = {
+	0.129484966168869693270611432679082,
+	0.279705391489276667901467771423780,
+	0.381830050505118944950369775488975,
+	0.417959183673469387755102040816327,
+};
+
+/**
+ * @brief Um subintervalo da integração adaptativa.
+ */
+typedef struct {
+	double a; /**< Limite inferior do subintervalo. */
+	double b; /**< Limite superior do subintervalo. */
+	double value; /**< Estimativa da integral no subintervalo. */
+	double error; /**< Estimativa do erro no subintervalo. */
+} Interval;
+
+/**
+ * @brief Heap binário de máximo de subintervalos, ordenado pelo erro.
+ */
+typedef struct {
+	Interval *data; /**< Arranjo com os subintervalos. */
+	size_t size; /**< Número de subintervalos no heap. */
+	size_t capacity; /**< Capacidade alocada de `data`. */
+} Heap;
+
+// Declarações internas.
+static Interval quad_rule(double a, double b, Function *func);
+static bool heap_reserve(Heap *heap, size_t size);
+static bool heap_push(Heap *heap, Interval iv);
+static Interval heap_pop(Heap *heap);
+
+// Integra uma função com a regra adaptativa de Gauss–Kronrod G7-K15.
+QuadResult quad_gk(double min, double max, Function *func, double epsabs,
+		   double epsrel, size_t max_evals)
+{
+	QuadResult res = { 0 };
+	Heap heap = { 0 };
+	INSTR_BEGIN(scope, INSTR_QUAD);
+
+	// Aplica a regra ao intervalo inteiro.
+	Interval first = quad_rule(min, max, func);
+	res.value = first.value;
+	res.error = first.error;
+	res.evals = QUAD_POINTS;
+	res.status = isfinite(first.error) ? QUAD_OK : QUAD_NONFINITE;
+	if (!heap_push(&heap, first)) {
+		res.status = QUAD_NOMEM;
+		goto done;
+	}
+
+	// Enquanto o erro estiver acima da tolerância, divide o pior intervalo.
+	while (res.status == QUAD_OK &&
+	       res.error > fmax(epsabs, epsrel * fabs(res.value))) {
+		if (res.evals + 2 * QUAD_POINTS > max_evals) {
+			res.status = QUAD_MAX_EVALS;
+			break;
+		}
+
+		// Reserva o espaço das duas metades antes de retirar o pior
+		// intervalo, para que nenhuma contribuição se perca.
+		if (!heap_reserve(&heap, heap.size + 1)) {
+			res.status = QUAD_NOMEM;
+			break;
+		}
+
+		Interval worst = heap_pop(&heap);
+		double mid = 0.5 * (worst.a + worst.b);
+
+		// Se o ponto médio não estiver estritamente dentro do intervalo,
+		// não é mais possível dividi-lo.
+		if (!(worst.a < mid && mid < worst.b)) {
+			heap_push(&heap, worst);
+			res.status = QUAD_ROUNDOFF;
+			break;
+		}
+
+		Interval left = quad_rule(worst.a, mid, func);
+		Interval right = quad_rule(mid, worst.b, func);
+		res.evals += 2 * QUAD_POINTS;
+		res.value += left.value + right.value - worst.value;
+		res.error += left.error + right.error - worst.error;
+		heap_push(&heap, left);
+		heap_push(&heap, right);
+		if (!isfinite(left.error) || !isfinite(right.error))
+			res.status = QUAD_NONFINITE;
+	}
+
+	// Recalcula a soma do zero, para descartar o erro acumulado pelas
+	// atualizações incrementais.
+	res.value = res.error = 0;
+	for (size_t i = 0; i < heap.size; ++i) {
+		res.value += heap.data[i].value;
+		res.error += heap.data[i].error;
+	}
+	res.intervals = heap.size;
+	if (res.status == QUAD_OK && !isfinite(res.error))
+		res.status = QUAD_NONFINITE;
+
+done:
+	free(heap.data);
+	INSTR_EVALS(INSTR_QUAD, res.evals);
+	INSTR_END(scope);
+	return res;
+}
+
+/**
+ * @brief Aplica a regra G7-K15 a um subintervalo.
+ *
+ * @details A estimativa do erro segue o QUADPACK: a diferença entre as regras
+ * de Gauss e de Kronrod é escalada por \f$(200 |G - K| / I_{abs})^{1.5}\f$,
+ * onde \f$I_{abs}\f$ é a integral de \f$|f - K / (b - a)|\f$, e é limitada
+ * inferiormente pelo erro de arredondamento de \f$\int |f|\f$.
+ *
+ * @param a Limite inferior do subintervalo.
+ * @param b Limite superior do subintervalo.
+ * @param func Ponteiro para a função.
+ * @return O subintervalo com a estimativa da integral e do erro.
+ */
+static Interval quad_rule(double a, double b, Function *func)
+{
+	double center = 0.5 * (a + b);
+	double half = 0.5 * (b - a);
+	double x[QUAD_POINTS], f[QUAD_POINTS];
+
+	// Os pontos são: o centro, e então os pares simétricos de `xgk`.
+	x[0] = center;
+	for (size_t i = 0; i < 7; ++i) {
+		x[1 + 2 * i] = center - half * xgk[i];
+		x[2 + 2 * i] = center + half * xgk[i];
+	}
+
+	if (func->eval_batch != nullptr)
+		func->eval_batch(x, f, QUAD_POINTS, func->impl);
+	else
+		for (size_t i = 0; i < QUAD_POINTS; ++i)
+			f[i] = func->eval(x[i], func->impl);
+
+	// Regras de Kronrod e de Gauss, e a integral de |f|.
+	double kronrod = wgk[7] * f[0];
+	double gauss = wg[3] * f[0];
+	double absint = fabs(kronrod);
+	for (size_t i = 0; i < 7; ++i) {
+		double pair = f[1 + 2 * i] + f[2 + 2 * i];
+		kronrod += wgk[i] * pair;
+		absint += wgk[i] * (fabs(f[1 + 2 * i]) + fabs(f[2 + 2 * i]));
+		if (i % 2 == 1)
+			gauss += wg[i / 2] * pair;
+	}
+
+	// Integral de |f - média|, para escalar o erro.
+	double mean = 0.5 * kronrod;
+	double asc = wgk[7] * fabs(f[0] - mean);
+	for (size_t i = 0; i < 7; ++i)
+		asc += wgk[i] *
+		       (fabs(f[1 + 2 * i] - mean) + fabs(f[2 + 2 * i] - mean));
+
+	kronrod *= half;
+	gauss *= half;
+	absint *= fabs(half);
+	asc *= fabs(half);
+
+	double err = fabs(kronrod - gauss);
+	if (asc != 0 && err != 0)
+		err = asc * fmin(1, pow(200 * err / asc, 1.5));
+	if (absint > DBL_MIN / (50 * DBL_EPSILON))
+		err = fmax(err, 50 * DBL_EPSILON * absint);
+
+	return (Interval){ a, b, kronrod, err };
+}
+
+/**
+ * @brief Garante que o heap comporte um número de subintervalos.
+ *
+ * @param heap Ponteiro para o heap.
+ * @param size O número de subintervalos.
+ * @return `true` em caso de sucesso, `false` se faltou memória.
+ */
+static bool heap_reserve(Heap *heap, size_t size)
+{
+	// Dobra a capacidade se necessário.
+	if (size > heap->capacity) {
+		size_t cap = heap->capacity ? 2 * heap->capacity : 64;
+		Interval *data = realloc(heap->data, cap * sizeof(*data));
+		ERRNOCHECK(data == nullptr, "Falha ao alocar subintervalos",
+			   ret);
+		heap->data = data;
+		heap->capacity = cap;
+	}
+	return true;
+
+ret:
+	return false;
+}
+
+/**
+ * @brief Insere um subintervalo no heap.
+ *
+ * @param heap Ponteiro para o heap.
+ * @param iv O subintervalo.
+ * @return `true` em caso de sucesso, `false` se faltou memória. Não falha
+ * se houver espaço reservado por `heap_reserve()`.
+ */
+static bool heap_push(Heap *heap, Interval iv)
+{
+	if (!heap_reserve(heap, heap->size + 1))
+		return false;
+
+	// Sobe o novo elemento até a sua posição.
+	size_t i = heap->size++;
+	while (i > 0 && heap->data[(i - 1) / 2].error < iv.error) {
+		heap->data[i] = heap->data[(i - 1) / 2];
+		i = (i - 1) / 2;
+	}
+	heap->data[i] = iv;
+	return true;
+}
+
+/**
+ * @brief Remove o subintervalo de maior erro do heap.
+ *
+ * @param heap Ponteiro para o heap, que não pode estar vazio.
+ * @return O subintervalo removido.
+ */
+static Interval heap_pop(Heap *heap)
+{
+	Interval top = heap->data[0];
+	Interval last = heap->data[--heap->size];
+	size_t i = 0;
+
+	// Desce o último elemento a partir da raiz até a sua posição.
+	for (;;) {
+		size_t child = 2 * i + 1;
+		if (child >= heap->size)
+			break;
+		if (child + 1 < heap->size &&
+		    heap->data[child + 1].error > heap->data[child].error)
+			++child;
+		if (heap->data[child].error <= last.error)
+			break;
+		heap->data[i] = heap->data[child];
+		i = child;
+	}
+	if (heap->size > 0)
+		heap->data[i] = last;
+
+	return top;
+}
\ No newline at end of file
@@ -6,41 +6,310 @@
  *
  * @details Este arquivo contém as implementações das funções para calcular a
  * integral de uma função genérica usando somas de Riemann. As somas podem ser
- * calculadas utilizando a extremidade direita ou esquerda dos retângulos. As
+ * calculadas utilizando a extremidade direita ou esquerda dos retângulos, ou o
+ * seu ponto médio. As
  * funções aqui definidas permitem a integração numérica de funções
  * encapsuladas na estrutura `Function`.
  */
 
+#include <float.h>
+#include <math.h>
+#include <stdatomic.h>
 #include <stdio.h>
+#include <stdlib.h>
 
 #include "riemann.h"
+#include "cache.h"
 #include "func.h"
+#include "instr.h"
+#include "pool.h"
+#include "simd.h"
+#include "util.h"
+
+/**
+ * @brief Número de pontos avaliados por chamada à avaliação em lote.
+ *
+ * @details Os pontos de cada bloco são gerados num arranjo na pilha, avaliados
+ * com uma única chamada a `Function::eval_batch`, e somados em seguida. O
+ * tamanho foi escolhido para que os arranjos de abscissas e de resultados
+ * caibam juntos no cache L1.
+ */
+#define RIEMANN_CHUNK 512
+
+/**
+ * @brief Número de funções por bloco de colunas no produto matriz-vetor de
+ * `riemann_multi()`.
+ *
+ * @details Os acumuladores de um bloco ficam no cache L1 enquanto todas as
+ * linhas (potências) da matriz são percorridas.
+ */
+#define RIEMANN_MULTI_TILE 256
+
+/**
+ * @brief Contexto compartilhado pelas tarefas que somam os blocos da grade.
+ */
+typedef struct {
+	double a; /**< Limite inferior da integração. */
+	double dx; /**< Largura de cada retângulo. */
+	Function *func; /**< Função a ser integrada. */
+	size_t first; /**< Índice do primeiro ponto da grade. */
+	size_t last; /**< Índice seguinte ao último ponto da grade. */
+	RiemannPrecision precision; /**< Precisão da soma. */
+	double *sums; /**< Arranjo onde a soma de cada bloco é escrita. */
+	double *lows; /**< Arranjo onde a parte baixa da soma de cada bloco é
+		       * escrita, em `RIEMANN_DOUBLE_DOUBLE`. */
+} BlockCtx;
+
+/**
+ * @brief Contexto compartilhado pelas tarefas que somam as potências dos
+ * blocos da grade, em `riemann_multi()`.
+ */
+typedef struct {
+	double a; /**< Limite inferior da integração. */
+	double dx; /**< Largura de cada retângulo. */
+	size_t degree; /**< Maior potência a somar. */
+	size_t first; /**< Índice do primeiro ponto da grade. */
+	size_t last; /**< Índice seguinte ao último ponto da grade. */
+	double *sums; /**< Arranjo onde as `degree + 1` somas de cada bloco são
+		       * escritas, bloco após bloco. */
+} PowersCtx;
+
+/**
+ * @brief Números de Bernoulli \f$B_j^+\f$, com \f$B_1 = +1/2\f$, até o índice
+ * `RIEMANN_CLOSED_MAX_DEGREE`.
+ */
+static const double bernoulli[RIEMANN_CLOSED_MAX_DEGREE + 1] = {
+	1.0,
+	1.0 / 2,
+	1.0 / 6,
+	0,
+	-1.0 / 30,
+	0,
+	1.0 / 42,
+	0,
+	-1.0 / 30,
+	0,
+	5.0 / 66,
+	0,
+	-691.0 / 2730,
+	0,
+	7.0 / 6,
+	0,
+	-3617.0 / 510,
+	0,
+	43867.0 / 798,
+	0,
+	-174611.0 / 330,
+	0,
+	854513.0 / 138,
+	0,
+	-236364091.0 / 2730,
+	0,
+	8553103.0 / 6,
+	0,
+	-23749461029.0 / 870,
+	0,
+	8615841276005.0 / 14322,
+	0,
+	-7709321041217.0 / 510,
+};
 
 // Declarações internas.
-static double riemann_esq(double a, Function *func, size_t n, double dx);
-static double riemann_dir(double a, Function *func, size_t n, double dx);
+static double riemann_esq(double a, Function *func, size_t n, double dx,
+			  const RiemannOptions *opts);
+static double riemann_dir(double a, Function *func, size_t n, double dx,
+			  const RiemannOptions *opts);
+static double riemann_reduce(double a, Function *func, size_t first,
+			     size_t last, double dx,
+			     const RiemannOptions *opts);
+static bool riemann_closed(double a, Function *func, size_t first,
+			   size_t last, double dx, double *res);
+static double riemann_sum(double a, Function *func, size_t first,
+			  size_t last, double dx);
+static double riemann_sum_f32(double a, Function *func, size_t first,
+			      size_t last, double dx);
+static void riemann_sum_dd(double a, Function *func, size_t first,
+			   size_t last, double dx, double sum[2]);
+static void riemann_tree_dd(const double *hi, const double *lo, size_t count,
+			    double sum[2]);
+static bool riemann_powers(double a, size_t first, size_t last, double dx,
+			   size_t degree, unsigned threads, double *sums);
+static double riemann_tree_strided(const double *sums, size_t count,
+				   size_t stride);
 
 // Método público. Determina os limites de integração [min, max] a partir dos
 // parâmetros, e executa a soma de Riemann da função dada pela referência
 // `func` nesse intervalo, usando `num` retângulos. O parâmetro `type` indica
 // se o cálculo da função será com x na extremidade direita ou esquerda dos
-// retângulos.
+// retângulos, ou no seu ponto médio.
 double riemann(double min, double max, Function *func, size_t num, SumType type)
+{
+	return riemann_opts(min, max, func, num, type, nullptr);
+}
+
+// Calcula uma soma de Riemann com opções explícitas.
+double riemann_opts(double min, double max, Function *func, size_t num,
+		    SumType type, const RiemannOptions *opts)
 {
 	// Calcula o Δx a partir do intervalo e do número de retângulos.
 	double dx = (max - min) / num;
+	// Copia as opções (ou usa as padrão), e determina quantas threads usar.
+	RiemannOptions o = opts != nullptr ? *opts : (RiemannOptions){ 0 };
+	o.threads = riemann_threads(opts);
+	double res;
+
+	// Consulta o cache de resultados, se houver um e a função puder ser
+	// resumida.
+	CacheKey key;
+	bool memo = o.cache != nullptr &&
+		    cache_key(&key, func, min, max, num, type, &o);
+	if (memo && cache_lookup(o.cache, &key, &res))
+		return res;
+	INSTR_BEGIN(scope, INSTR_RIEMANN);
 
 	// Dependendo de se a soma for pela esquerda ou pela direita, invoca a
-	// implementação apropriada.
+	// implementação apropriada. A do ponto médio é a soma pela esquerda
+	// numa grade deslocada de meio retângulo.
 	switch (type) {
 	case DIREITA:
-		return riemann_dir(min, func, num, dx);
+		res = riemann_dir(min, func, num, dx, &o);
+		break;
 	case ESQUERDA:
-		return riemann_esq(min, func, num, dx);
-	default: // Se não for direita nem esquerda, termina programa com erro.
+		res = riemann_esq(min, func, num, dx, &o);
+		break;
+	case MEIO:
+		res = riemann_esq(min + dx / 2, func, num, dx, &o);
+		break;
+	default: // Se não for um tipo conhecido, termina programa com erro.
 		fprintf(stderr, "FATAL: tipo de soma inexistente: %d\n", type);
 		exit(EXIT_FAILURE);
 	}
+
+	INSTR_END(scope);
+	if (memo)
+		cache_insert(o.cache, &key, res);
+	return res;
+}
+
+// Calcula as somas de Riemann de vários polinômios na mesma grade.
+bool riemann_multi(double min, double max, Function *const *funcs,
+		   size_t count, size_t num, SumType type,
+		   const RiemannOptions *opts, double *out)
+{
+	double dx = (max - min) / num;
+	RiemannOptions o = opts != nullptr ? *opts : (RiemannOptions){ 0 };
+	o.threads = riemann_threads(opts);
+
+	// Mesma grade de `riemann_opts()`.
+	double a = min;
+	size_t first;
+	switch (type) {
+	case DIREITA:
+		first = 1;
+		break;
+	case ESQUERDA:
+		first = 0;
+		break;
+	case MEIO:
+		a = min + dx / 2;
+		first = 0;
+		break;
+	default:
+		fprintf(stderr, "FATAL: tipo de soma inexistente: %d\n", type);
+		exit(EXIT_FAILURE);
+	}
+	size_t last = first + num;
+	bool ok = false;
+
+	// Valida todas as funções antes de qualquer cálculo.
+	errno = EINVAL;
+	for (size_t i = 0; i < count; ++i)
+		ERRNOCHECK(funcs[i]->type != POLYNOMIAL,
+			   "Função não é um polinômio", ret);
+
+	size_t *grid = malloc(count * sizeof(*grid));
+	ERRNOCHECK(count > 0 && grid == nullptr,
+		   "Falha ao alocar índices das funções", ret);
+
+	// Os polinômios que não cabem na grade são somados um a um, fora do
+	// escopo instrumentado, pois `riemann_opts()` tem o seu.
+	size_t pending = 0;
+	for (size_t i = 0; i < count; ++i) {
+		size_t d;
+		if (function_polynomial(funcs[i], &d) == nullptr ||
+		    d > SIMD_POWERS_MAX_DEGREE ||
+		    o.precision != RIEMANN_DOUBLE)
+			out[i] = riemann_opts(min, max, funcs[i], num, type, &o);
+		else
+			grid[pending++] = i;
+	}
+	INSTR_BEGIN(scope, INSTR_RIEMANN);
+
+	// Resolve os que admitem a fórmula fechada, e separa os demais.
+	size_t grid_count = 0, degree = 0;
+	for (size_t j = 0; j < pending; ++j) {
+		size_t i = grid[j], d;
+		function_polynomial(funcs[i], &d);
+		if (!o.brute_force &&
+		    riemann_closed(a, funcs[i], first, last, dx, &out[i])) {
+			out[i] *= dx;
+		} else {
+			grid[grid_count++] = i;
+			degree = d > degree ? d : degree;
+		}
+	}
+
+	if (grid_count == 0)
+		goto done;
+
+	// Matriz de coeficientes: uma linha por potência, uma coluna por
+	// função, com as linhas alinhadas e completadas com zeros.
+	size_t stride = (grid_count + 7) & ~(size_t)7;
+	double *matrix = aligned_alloc(64, (degree + 2) * stride *
+						   sizeof(*matrix));
+	ERRNOCHECK(matrix == nullptr, "Falha ao alocar matriz de coeficientes",
+		   end);
+	double *s = matrix + (degree + 1) * stride;
+	for (size_t j = 0; j < grid_count; ++j) {
+		size_t d;
+		const double *c = function_polynomial(funcs[grid[j]], &d);
+		for (size_t k = 0; k <= degree; ++k)
+			matrix[k * stride + j] = k <= d ? c[k] : 0;
+	}
+
+	// Uma única passada pela grade, e o produto matriz-vetor por blocos de
+	// colunas.
+	if (!riemann_powers(a, first, last, dx, degree, o.threads, s)) {
+		free(matrix);
+		goto end;
+	}
+	INSTR_EVALS(INSTR_RIEMANN, grid_count * (last - first));
+
+	double acc[RIEMANN_MULTI_TILE];
+	for (size_t t = 0; t < grid_count; t += RIEMANN_MULTI_TILE) {
+		size_t len = grid_count - t < RIEMANN_MULTI_TILE ?
+				     grid_count - t :
+				     RIEMANN_MULTI_TILE;
+
+		for (size_t j = 0; j < len; ++j)
+			acc[j] = 0;
+		for (size_t k = 0; k <= degree; ++k) {
+			const double *row = matrix + k * stride + t;
+			for (size_t j = 0; j < len; ++j)
+				acc[j] += row[j] * s[k];
+		}
+		for (size_t j = 0; j < len; ++j)
+			out[grid[t + j]] = acc[j] * dx;
+	}
+	free(matrix);
+
+done:
+	ok = true;
+end:
+	INSTR_END(scope);
+	free(grid);
+ret:
+	return ok;
 }
 
 /**
@@ -56,17 +325,15 @@ double riemann(double min, double max, Function *func, size_t num, SumType type)
  * @param func Ponteiro para a função a ser integrada.
  * @param n Número de retângulos.
  * @param dx Largura de cada retângulo.
+ * @param opts Opções do cálculo, com o número de threads já determinado.
  * @return O valor aproximado da integral.
  */
-static double riemann_dir(double a, Function *func, size_t n, double dx)
+static double riemann_dir(double a, Function *func, size_t n, double dx,
+			  const RiemannOptions *opts)
 {
-	double res = 0; // Acumula resultado das somas.
-
-	for (size_t i = 1; i <= n; ++i)
-		res += func->eval(a + i * dx, func->impl);
-
-	// Retorna o resultado multiplicado pela base dos retângulos (Δx).
-	return res * dx;
+	// Soma os valores nos pontos de 1 a n e multiplica o resultado pela
+	// base dos retângulos (Δx).
+	return riemann_reduce(a, func, 1, n + 1, dx, opts) * dx;
 }
 
 /**
@@ -82,14 +349,513 @@ static double riemann_dir(double a, Function *func, size_t n, double dx)
  * @param func Ponteiro para a função a ser integrada.
  * @param n Número de retângulos.
  * @param dx Largura de cada retângulo.
+ * @param opts Opções do cálculo, com o número de threads já determinado.
  * @return O valor aproximado da integral.
  */
-static double riemann_esq(double a, Function *func, size_t n, double dx)
+static double riemann_esq(double a, Function *func, size_t n, double dx,
+			  const RiemannOptions *opts)
+{
+	return riemann_reduce(a, func, 0, n, dx, opts) * dx;
+}
+
+/**
+ * @brief Soma uma faixa de blocos de forma recursiva, pela metade.
+ *
+ * @details A árvore de soma depende apenas do número de blocos, e não da
+ * ordem em que foram calculados, o que torna o resultado determinístico. A
+ * soma em pares também acumula menos erro de arredondamento que a sequencial.
+ *
+ * @param sums Arranjo com as somas dos blocos.
+ * @param count Número de blocos.
+ * @return A soma de todos os blocos.
+ */
+static double riemann_tree(const double *sums, size_t count)
+{
+	if (count == 1)
+		return sums[0];
+
+	size_t half = count / 2;
+	return riemann_tree(sums, half) + riemann_tree(sums + half, count - half);
+}
+
+/**
+ * @brief Tarefa que soma um bloco da grade.
+ *
+ * @param index O índice do bloco.
+ * @param ctx Ponteiro para o contexto (`BlockCtx`).
+ */
+static void riemann_block_task(size_t index, void *ctx)
+{
+	BlockCtx *c = ctx;
+	size_t first = c->first + index * RIEMANN_BLOCK;
+	size_t last = c->last - first < RIEMANN_BLOCK ? c->last :
+							 first + RIEMANN_BLOCK;
+
+	double dd[2];
+
+	switch (c->precision) {
+	case RIEMANN_FLOAT:
+		c->sums[index] = riemann_sum_f32(c->a, c->func, first, last,
+						 c->dx);
+		break;
+	case RIEMANN_DOUBLE_DOUBLE:
+		riemann_sum_dd(c->a, c->func, first, last, c->dx, dd);
+		c->sums[index] = dd[0];
+		c->lows[index] = dd[1];
+		break;
+	default:
+		c->sums[index] = riemann_sum(c->a, c->func, first, last, c->dx);
+	}
+}
+
+/**
+ * @brief Soma uma faixa de blocos com espaçamento entre os elementos.
+ *
+ * @details Igual a `riemann_tree()`, mas o elemento \f$i\f$ está na posição
+ * \f$i \cdot \text{stride}\f$ do arranjo.
+ *
+ * @param sums Arranjo com as somas dos blocos.
+ * @param count Número de blocos.
+ * @param stride Distância entre as somas de dois blocos consecutivos.
+ * @return A soma de todos os blocos.
+ */
+static double riemann_tree_strided(const double *sums, size_t count,
+				   size_t stride)
+{
+	if (count == 1)
+		return sums[0];
+
+	size_t half = count / 2;
+	return riemann_tree_strided(sums, half, stride) +
+	       riemann_tree_strided(sums + half * stride, count - half, stride);
+}
+
+/**
+ * @brief Tarefa que soma as potências dos pontos de um bloco da grade.
+ *
+ * @param index O índice do bloco.
+ * @param ctx Ponteiro para o contexto (`PowersCtx`).
+ */
+static void riemann_powers_task(size_t index, void *ctx)
+{
+	PowersCtx *c = ctx;
+	size_t first = c->first + index * RIEMANN_BLOCK;
+	size_t last = c->last - first < RIEMANN_BLOCK ? c->last :
+							 first + RIEMANN_BLOCK;
+
+	simd_power_sums(c->a, c->dx, first, last - first, c->degree,
+			c->sums + index * (c->degree + 1));
+}
+
+/**
+ * @brief Soma as potências dos pontos de uma grade uniforme, por blocos.
+ *
+ * @details Calcula \f$s_k = \sum_{i = \text{first}}^{\text{last} - 1}
+ * (a + i \Delta x)^k\f$ para \f$k\f$ de 0 a `degree`. A grade é dividida em
+ * blocos e as somas dos blocos são combinadas exatamente como em
+ * `riemann_reduce()`, de modo que o resultado não depende do número de
+ * threads.
+ *
+ * @param a Limite inferior da integração.
+ * @param first Índice do primeiro ponto da grade a ser somado.
+ * @param last Índice seguinte ao último ponto a ser somado.
+ * @param dx Largura de cada retângulo.
+ * @param degree Maior potência, até `SIMD_POWERS_MAX_DEGREE`.
+ * @param threads Número de threads.
+ * @param sums Arranjo de `degree + 1` posições onde as somas serão escritas.
+ * @return `true` em caso de sucesso, `false` se faltou memória.
+ */
+static bool riemann_powers(double a, size_t first, size_t last, double dx,
+			   size_t degree, unsigned threads, double *sums)
+{
+	if (last <= first) {
+		for (size_t k = 0; k <= degree; ++k)
+			sums[k] = 0;
+		return true;
+	}
+
+	size_t blocks = (last - first + RIEMANN_BLOCK - 1) / RIEMANN_BLOCK;
+	if (blocks == 1) {
+		simd_power_sums(a, dx, first, last - first, degree, sums);
+		return true;
+	}
+
+	double *partial = calloc(blocks * (degree + 1), sizeof(*partial));
+	ERRNOCHECK(partial == nullptr, "Falha ao alocar somas dos blocos", ret);
+
+	PowersCtx ctx = { a, dx, degree, first, last, partial };
+	Pool *pool = threads > 1 ? pool_global(threads) : nullptr;
+
+	if (pool != nullptr)
+		pool_run(pool, blocks, threads, &riemann_powers_task, &ctx);
+	else
+		for (size_t i = 0; i < blocks; ++i)
+			riemann_powers_task(i, &ctx);
+
+	for (size_t k = 0; k <= degree; ++k)
+		sums[k] = riemann_tree_strided(partial + k, blocks, degree + 1);
+	free(partial);
+	return true;
+
+ret:
+	return false;
+}
+
+/**
+ * @brief Soma os valores de uma função numa grade uniforme, por blocos.
+ *
+ * @details Se houver uma fórmula fechada para a soma e ela não tiver sido
+ * desabilitada em `opts`, usa-a. Caso contrário, divide os pontos de índice
+ * \f$[\text{first}, \text{last})\f$ em blocos de `RIEMANN_BLOCK` pontos, soma
+ * cada bloco com `riemann_sum()` (distribuindo os blocos entre
+ * `opts->threads` threads do conjunto global), e combina as somas com
+ * `riemann_tree()`. Se houver um só bloco, o resultado é idêntico ao da soma
+ * sequencial.
+ *
+ * @param a Limite inferior da integração.
+ * @param func Ponteiro para a função a ser integrada.
+ * @param first Índice do primeiro ponto da grade a ser somado.
+ * @param last Índice seguinte ao último ponto a ser somado.
+ * @param dx Largura de cada retângulo.
+ * @param opts Opções do cálculo, com o número de threads já determinado.
+ * @return A soma dos valores da função nos pontos da grade.
+ */
+static double riemann_reduce(double a, Function *func, size_t first,
+			     size_t last, double dx,
+			     const RiemannOptions *opts)
 {
+	unsigned threads = opts->threads;
+	double res;
+
+	if (last <= first)
+		return 0;
+	if (!opts->brute_force &&
+	    riemann_closed(a, func, first, last, dx, &res))
+		return res;
+
+	INSTR_EVALS(INSTR_RIEMANN, last - first);
+	size_t blocks = (last - first + RIEMANN_BLOCK - 1) / RIEMANN_BLOCK;
+	if (blocks == 1 && opts->precision == RIEMANN_DOUBLE)
+		return riemann_sum(a, func, first, last, dx);
+
+	// Em dupla-dupla, as partes baixas ficam após as altas.
+	bool dd = opts->precision == RIEMANN_DOUBLE_DOUBLE;
+	double *sums = malloc(blocks * (dd ? 2 : 1) * sizeof(*sums));
+	ERRNOCHECK(sums == nullptr, "Falha ao alocar somas dos blocos", fatal);
+
+	BlockCtx ctx = { a, dx, func, first, last, opts->precision, sums,
+			 sums + blocks };
+	Pool *pool = threads > 1 && blocks > 1 ? pool_global(threads) : nullptr;
+
+	// Se houver mais de uma thread, distribui os blocos. Caso contrário
+	// (ou se não foi possível obter o conjunto), soma-os nesta thread.
+	if (pool != nullptr)
+		pool_run(pool, blocks, threads, &riemann_block_task, &ctx);
+	else
+		for (size_t i = 0; i < blocks; ++i)
+			riemann_block_task(i, &ctx);
+
+	if (dd) {
+		double sum[2];
+		riemann_tree_dd(sums, sums + blocks, blocks, sum);
+		res = sum[0] + sum[1];
+	} else {
+		res = riemann_tree(sums, blocks);
+	}
+	free(sums);
+	return res;
+
+fatal:
+	exit(EXIT_FAILURE);
+}
+
+/**
+ * @brief Soma os valores de um polinômio numa grade uniforme por uma fórmula
+ * fechada.
+ *
+ * @details Seja \f$p\f$ o polinômio e \f$m = \text{last} - 1\f$. Primeiro,
+ * desloca-se \f$p\f$ para a origem em \f$a\f$ (deslocamento de Taylor, em
+ * \f$O(\text{grau}^2)\f$), obtendo \f$p(a + t) = \sum_k d_k t^k\f$. Então,
+ * \f[
+ * \sum_{i} p(a + i \Delta x) = \sum_k d_k \Delta x^k \sum_i i^k,
+ * \f]
+ * e cada soma de potências é dada pela fórmula de Faulhaber,
+ * \f[
+ * \sum_{i=1}^{m} i^k = \frac{m^{k+1}}{k+1} \sum_{j=0}^{k}
+ * \binom{k+1}{j} B_j^+ m^{-j}.
+ * \f]
+ * Para evitar overflow, o fator \f$\Delta x^k m^{k+1}\f$ é calculado como
+ * \f$(m \Delta x)^k m\f$. Os termos são acumulados com a soma compensada de
+ * Neumaier.
+ *
+ * Ao mesmo tempo, estima-se o erro de arredondamento absoluto da soma,
+ * acumulando os mesmos termos com os valores absolutos dos coeficientes e de
+ * \f$a\f$. Se o erro estimado, relativo ao resultado, exceder
+ * `RIEMANN_CLOSED_TOL`, a fórmula é descartada.
+ *
+ * @param a Limite inferior da integração.
+ * @param func Ponteiro para a função a ser integrada.
+ * @param first Índice do primeiro ponto da grade a ser somado (0 ou 1).
+ * @param last Índice seguinte ao último ponto a ser somado.
+ * @param dx Largura de cada retângulo.
+ * @param res Ponteiro onde a soma será escrita.
+ * @return `true` se a fórmula fechada foi aplicada, `false` se a soma deve ser
+ * feita ponto a ponto.
+ */
+static bool riemann_closed(double a, Function *func, size_t first,
+			   size_t last, double dx, double *res)
+{
+	size_t degree;
+	const double *c = function_polynomial(func, &degree);
+
+	// Verifica se a fórmula fechada se aplica.
+	if (c == nullptr || degree > RIEMANN_CLOSED_MAX_DEGREE || first > 1 ||
+	    last - first < RIEMANN_CLOSED_MIN_N)
+		return false;
+
+	// Deslocamento de Taylor: d[k] = p⁽ᵏ⁾(a) / k!. Em paralelo, calcula os
+	// mesmos coeficientes com valores absolutos, para estimar o erro.
+	double d[RIEMANN_CLOSED_MAX_DEGREE + 1], e[RIEMANN_CLOSED_MAX_DEGREE + 1];
+	for (size_t k = 0; k <= degree; ++k) {
+		d[k] = c[k];
+		e[k] = fabs(c[k]);
+	}
+	for (size_t i = 0; i < degree; ++i) {
+		for (size_t j = degree; j-- > i;) {
+			d[j] += a * d[j + 1];
+			e[j] += fabs(a) * e[j + 1];
+		}
+	}
+
+	double m = (double)(last - 1); // Último índice da grade.
+	double len = m * dx; // Fator (m Δx), elevado a k abaixo.
+	double len_k = 1; // (m Δx)ᵏ.
+	double sum = 0, comp = 0; // Soma compensada de Neumaier.
+	double err = 0; // Estimativa do erro absoluto.
+
+	for (size_t k = 0; k <= degree; ++k, len_k *= len) {
+		// Calcula o fator de Faulhaber, somando do menor ao maior termo.
+		double faulhaber = 0, binom = 1, inv_m_j = 1;
+		double terms[RIEMANN_CLOSED_MAX_DEGREE + 1];
+		for (size_t j = 0; j <= k; ++j) {
+			terms[j] = binom * bernoulli[j] * inv_m_j;
+			binom = binom * (k + 1 - j) / (j + 1);
+			inv_m_j /= m;
+		}
+		for (size_t j = k + 1; j-- > 0;)
+			faulhaber += terms[j];
+		faulhaber /= k + 1;
+
+		// Termo k da soma. Se a grade começa no 0, 0⁰ = 1 também conta.
+		double term = d[k] * len_k * m * faulhaber;
+		if (k == 0 && first == 0)
+			term += d[0];
+
+		// Acumula o termo com compensação.
+		neumaier_add(&sum, &comp, term);
+
+		err += (2 * degree + k + 8) * e[k] * fabs(len_k) * (m + 1) *
+		       fabs(faulhaber);
+	}
+
+	*res = sum + comp;
+	err *= DBL_EPSILON / 2;
+
+	// Descarta o resultado se não for finito ou se o erro for grande.
+	return isfinite(*res) && err <= RIEMANN_CLOSED_TOL * fabs(*res);
+}
+
+// Determina o número de threads a usar numa soma.
+unsigned riemann_threads(const RiemannOptions *opts)
+{
+	if (opts != nullptr && opts->threads > 0)
+		return opts->threads;
+
+	const char *env = getenv("RIEMANN_THREADS");
+	unsigned threads;
+	if (env == nullptr)
+		return 1;
+	if (pool_parse_threads(env, &threads))
+		return threads > 0 ? threads : 1;
+
+	// Avisa uma única vez, pois a variável é consultada a cada soma.
+	static atomic_flag warned = ATOMIC_FLAG_INIT;
+	if (!atomic_flag_test_and_set(&warned))
+		fprintf(stderr, "RIEMANN_THREADS inválida, usando 1: %s\n",
+			env);
+	return 1;
+}
+
+/**
+ * @brief Soma os valores de uma função nos pontos de uma grade uniforme.
+ *
+ * @details Calcula \f$\sum_{i = \text{first}}^{\text{last} - 1}
+ * f(a + i \cdot \Delta x)\f$. Se a função oferecer avaliação em lote
+ * (`Function::eval_batch`), os pontos são gerados e avaliados em blocos de
+ * `RIEMANN_CHUNK`, pagando uma única chamada indireta por bloco. Caso
+ * contrário, recorre à avaliação escalar (`Function::eval`). Em ambos os
+ * casos, os valores são acumulados na mesma ordem.
+ *
+ * @param a Limite inferior da integração.
+ * @param func Ponteiro para a função a ser integrada.
+ * @param first Índice do primeiro ponto da grade a ser somado.
+ * @param last Índice seguinte ao último ponto a ser somado.
+ * @param dx Largura de cada retângulo.
+ * @return A soma dos valores da função nos pontos da grade.
+ */
+static double riemann_sum(double a, Function *func, size_t first,
+			  size_t last, double dx)
+{
+	double res = 0; // Acumula resultado das somas.
+
+	// Se o tipo não oferece avaliação em lote, avalia ponto a ponto.
+	if (func->eval_batch == nullptr) {
+		for (size_t i = first; i < last; ++i)
+			res += func->eval(a + i * dx, func->impl);
+		return res;
+	}
+
+	double x[RIEMANN_CHUNK], y[RIEMANN_CHUNK];
+	for (size_t i = first; i < last; i += RIEMANN_CHUNK) {
+		size_t len = last - i < RIEMANN_CHUNK ? last - i : RIEMANN_CHUNK;
+
+		// Gera as abscissas do bloco, avalia, e acumula os resultados.
+		for (size_t j = 0; j < len; ++j)
+			x[j] = a + (i + j) * dx;
+		func->eval_batch(x, y, len, func->impl);
+		for (size_t j = 0; j < len; ++j)
+			res += y[j];
+	}
+
+	return res;
+}
+
+/**
+ * @brief Soma os valores de uma função nos pontos de uma grade uniforme em
+ * precisão simples.
+ *
+ * @details Se a função for um polinômio denso de grau até
+ * `SIMD_SUM_MAX_DEGREE` com coeficientes representáveis em `float`, os
+ * pontos são somados em trechos de `RIEMANN_CHUNK` por
+ * `simd_poly_sum_f32()`, e as somas dos trechos, acumuladas em `double`. O
+ * primeiro ponto de cada trecho é calculado em `double` e arredondado, de
+ * modo que o erro das abscissas não cresce ao longo da grade. Caso contrário,
+ * recorre a `riemann_sum()`.
+ *
+ * @param a Limite inferior da integração.
+ * @param func Ponteiro para a função a ser integrada.
+ * @param first Índice do primeiro ponto da grade a ser somado.
+ * @param last Índice seguinte ao último ponto a ser somado.
+ * @param dx Largura de cada retângulo.
+ * @return A soma dos valores da função nos pontos da grade.
+ */
+static double riemann_sum_f32(double a, Function *func, size_t first,
+			      size_t last, double dx)
+{
+	float c[SIMD_SUM_MAX_DEGREE + 1];
+	size_t degree;
+	const double *coeffs = function_polynomial(func, &degree);
+
+	if (coeffs == nullptr || degree > SIMD_SUM_MAX_DEGREE)
+		return riemann_sum(a, func, first, last, dx);
+	for (size_t k = 0; k <= degree; ++k) {
+		c[k] = (float)coeffs[k];
+		if (isinf(c[k]) && !isinf(coeffs[k]))
+			return riemann_sum(a, func, first, last, dx);
+	}
+
 	double res = 0;
+	for (size_t i = first; i < last; i += RIEMANN_CHUNK) {
+		size_t len = last - i < RIEMANN_CHUNK ? last - i : RIEMANN_CHUNK;
+		res += simd_poly_sum_f32(c, degree, (float)(a + i * dx),
+					 (float)dx, len);
+	}
+	return res;
+}
+
+/**
+ * @brief Soma os valores de uma função nos pontos de uma grade uniforme em
+ * precisão dupla-dupla.
+ *
+ * @details Se a função for um polinômio denso de grau até
+ * `SIMD_SUM_MAX_DEGREE`, usa `simd_poly_sum_dd()`. Caso contrário, avalia a
+ * função como `riemann_sum()`, em `double`, e acumula os valores com a
+ * transformação TwoSum, guardando o erro de cada soma numa segunda parcela.
+ *
+ * @param a Limite inferior da integração.
+ * @param func Ponteiro para a função a ser integrada.
+ * @param first Índice do primeiro ponto da grade a ser somado.
+ * @param last Índice seguinte ao último ponto a ser somado.
+ * @param dx Largura de cada retângulo.
+ * @param sum Arranjo onde a soma será escrita, como a parte alta seguida da
+ * parte baixa.
+ */
+static void riemann_sum_dd(double a, Function *func, size_t first,
+			   size_t last, double dx, double sum[2])
+{
+	size_t degree;
+	const double *coeffs = function_polynomial(func, &degree);
+
+	if (coeffs != nullptr && degree <= SIMD_SUM_MAX_DEGREE) {
+		simd_poly_sum_dd(coeffs, degree, a, dx, first, last - first,
+				 sum);
+		return;
+	}
+
+	double hi = 0, lo = 0, x[RIEMANN_CHUNK], y[RIEMANN_CHUNK];
+	for (size_t i = first; i < last; i += RIEMANN_CHUNK) {
+		size_t len = last - i < RIEMANN_CHUNK ? last - i : RIEMANN_CHUNK;
+
+		for (size_t j = 0; j < len; ++j)
+			x[j] = a + (i + j) * dx;
+		if (func->eval_batch != nullptr)
+			func->eval_batch(x, y, len, func->impl);
+		else
+			for (size_t j = 0; j < len; ++j)
+				y[j] = func->eval(x[j], func->impl);
+
+		for (size_t j = 0; j < len; ++j) {
+			double s = hi + y[j];
+			double z = s - hi;
+			lo += (hi - (s - z)) + (y[j] - z);
+			hi = s;
+		}
+	}
+
+	sum[0] = hi + lo;
+	sum[1] = lo - (sum[0] - hi);
+}
+
+/**
+ * @brief Soma uma faixa de blocos em precisão dupla-dupla.
+ *
+ * @details Percorre a mesma árvore de `riemann_tree()`, mas cada soma é de
+ * dois pares dupla-dupla: as partes altas são somadas com TwoSum, e o erro,
+ * junto das partes baixas, forma a nova parte baixa.
+ *
+ * @param hi Arranjo com as partes altas das somas dos blocos.
+ * @param lo Arranjo com as partes baixas das somas dos blocos.
+ * @param count Número de blocos.
+ * @param sum Arranjo onde a soma será escrita, como a parte alta seguida da
+ * parte baixa.
+ */
+static void riemann_tree_dd(const double *hi, const double *lo, size_t count,
+			    double sum[2])
+{
+	if (count == 1) {
+		sum[0] = hi[0];
+		sum[1] = lo[0];
+		return;
+	}
 
-	for (size_t i = 0; i < n; ++i)
-		res += func->eval(a + i * dx, func->impl);
+	double l[2], r[2];
+	size_t half = count / 2;
+	riemann_tree_dd(hi, lo, half, l);
+	riemann_tree_dd(hi + half, lo + half, count - half, r);
 
-	return res * dx;
+	double s = l[0] + r[0];
+	double z = s - l[0];
+	double e = (l[0] - (s - z)) + (r[0] - z) + l[1] + r[1];
+	sum[0] = s + e;
+	sum[1] = e - (sum[0] - s);
 }
\ No newline at end of file
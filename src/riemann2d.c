@@ -0,0 +1,336 @@
+// SPDX-License-Identifier: ISC
+
+/**
+ * @file riemann2d.c
+ * @brief Implementação das somas de Riemann de funções de duas variáveis.
+ *
+ * @details Este arquivo contém o integrador declarado em `riemann2d.h`. A
+ * soma ponto a ponto percorre a grade em ladrilhos, distribuídos entre as
+ * threads do conjunto global; as funções separáveis e os polinômios de grau
+ * baixo são reduzidos a somas de uma variável, calculadas por
+ * `riemann_opts()`.
+ */
+
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "riemann2d.h"
+#include "func.h"
+#include "func2d.h"
+#include "instr.h"
+#include "pool.h"
+#include "simd.h"
+#include "util.h"
+
+/**
+ * @brief Contexto compartilhado pelas tarefas que somam os ladrilhos da
+ * grade.
+ */
+typedef struct {
+	Function2D *func; /**< Função a ser integrada. */
+	const double *coeffs; /**< Coeficientes, se `func` for um
+			       * `BIPOLYNOMIAL` somado pela tabela de
+			       * potências, ou `nullptr`. */
+	size_t degree_x; /**< Grau em \f$x\f$ de um `BIPOLYNOMIAL`. */
+	size_t degree_y; /**< Grau em \f$y\f$ de um `BIPOLYNOMIAL`. */
+	double ax; /**< Origem da grade em \f$x\f$. */
+	double ay; /**< Origem da grade em \f$y\f$. */
+	double dx; /**< Largura de cada retângulo. */
+	double dy; /**< Altura de cada retângulo. */
+	size_t first; /**< Índice do primeiro ponto em cada coordenada. */
+	size_t nx; /**< Número de colunas da grade. */
+	size_t ny; /**< Número de linhas da grade. */
+	size_t tile_x; /**< Número de colunas de cada ladrilho. */
+	size_t tiles_x; /**< Número de ladrilhos em cada faixa de linhas. */
+	double *sums; /**< Arranjo onde a soma de cada ladrilho é escrita. */
+} TileCtx;
+
+// Declarações internas.
+static bool riemann2d_separable(double xmin, double xmax, double ymin,
+				double ymax, Function2D *func, size_t nx,
+				size_t ny, SumType type,
+				const RiemannOptions *opts, double *res);
+static double riemann2d_tiles(TileCtx *ctx, unsigned threads);
+static void riemann2d_tile_task(size_t index, void *ctx);
+static double riemann2d_tree(const double *sums, size_t count);
+
+// Calcula uma soma de Riemann de uma função de duas variáveis num retângulo.
+double riemann2d(double xmin, double xmax, double ymin, double ymax,
+		 Function2D *func, size_t nx, size_t ny, SumType type,
+		 const RiemannOptions *opts)
+{
+	double dx = (xmax - xmin) / nx, dy = (ymax - ymin) / ny;
+	RiemannOptions o = opts != nullptr ? *opts : (RiemannOptions){ 0 };
+	o.threads = riemann_threads(opts);
+	double res;
+
+	if (nx == 0 || ny == 0)
+		return 0;
+	INSTR_BEGIN(scope, INSTR_RIEMANN2D);
+
+	// Mesmas grades de `riemann_opts()`, nas duas coordenadas.
+	TileCtx ctx = {
+		.func = func,
+		.ax = xmin,
+		.ay = ymin,
+		.dx = dx,
+		.dy = dy,
+		.nx = nx,
+		.ny = ny,
+	};
+	switch (type) {
+	case DIREITA:
+		ctx.first = 1;
+		break;
+	case ESQUERDA:
+		ctx.first = 0;
+		break;
+	case MEIO:
+		ctx.ax += dx / 2;
+		ctx.ay += dy / 2;
+		ctx.first = 0;
+		break;
+	default:
+		fprintf(stderr, "FATAL: tipo de soma inexistente: %d\n", type);
+		exit(EXIT_FAILURE);
+	}
+
+	if (o.brute_force || !riemann2d_separable(xmin, xmax, ymin, ymax, func,
+						  nx, ny, type, &o, &res)) {
+		INSTR_EVALS(INSTR_RIEMANN2D, nx * ny);
+		res = riemann2d_tiles(&ctx, o.threads) * dx * dy;
+	}
+
+	INSTR_END(scope);
+	return res;
+}
+
+/**
+ * @brief Soma uma função de duas variáveis por meio de somas de uma variável.
+ *
+ * @details Uma função separável \f$f(x) g(y)\f$ tem como soma o produto das
+ * somas de \f$f\f$ e de \f$g\f$. Um polinômio com linhas \f$p_j(x)\f$ na
+ * matriz de coeficientes tem como soma \f$\sum_j R_j S_j\f$, onde \f$R_j\f$ é
+ * a soma de \f$p_j\f$ e \f$S_j\f$, a de \f$y^j\f$; os termos são acumulados
+ * com a soma compensada de Neumaier, e o erro de arredondamento do
+ * acúmulo é estimado a partir de \f$\sum_j |R_j S_j|\f$. Se ele exceder
+ * `RIEMANN_CLOSED_TOL` do resultado, ou se os graus excederem
+ * `RIEMANN_CLOSED_MAX_DEGREE` (acima do qual as somas de uma variável
+ * seriam feitas ponto a ponto, uma vez por linha), a redução é descartada.
+ *
+ * @param xmin O limite inferior em \f$x\f$.
+ * @param xmax O limite superior em \f$x\f$.
+ * @param ymin O limite inferior em \f$y\f$.
+ * @param ymax O limite superior em \f$y\f$.
+ * @param func Ponteiro para a função a ser integrada.
+ * @param nx O número de retângulos em \f$x\f$.
+ * @param ny O número de retângulos em \f$y\f$.
+ * @param type O tipo de soma de Riemann.
+ * @param opts Opções do cálculo, com o número de threads já determinado.
+ * @param res Ponteiro onde a soma, já multiplicada por \f$\Delta x \Delta
+ * y\f$, será escrita.
+ * @return `true` se a redução foi aplicada, `false` se a soma deve ser feita
+ * ponto a ponto.
+ */
+static bool riemann2d_separable(double xmin, double xmax, double ymin,
+				double ymax, Function2D *func, size_t nx,
+				size_t ny, SumType type,
+				const RiemannOptions *opts, double *res)
+{
+	Function *fx, *fy;
+	size_t degree_x, degree_y;
+
+	if (function2d_separable(func, &fx, &fy)) {
+		*res = riemann_opts(xmin, xmax, fx, nx, type, opts) *
+		       riemann_opts(ymin, ymax, fy, ny, type, opts);
+		return true;
+	}
+
+	const double *c = function2d_bipolynomial(func, &degree_x, &degree_y);
+	if (c == nullptr || degree_x > RIEMANN_CLOSED_MAX_DEGREE ||
+	    degree_y > RIEMANN_CLOSED_MAX_DEGREE)
+		return false;
+
+	// Uma visão para cada linha da matriz, e outra para o monômio yʲ.
+	double unit[RIEMANN_CLOSED_MAX_DEGREE + 1] = { 0 };
+	double sum = 0, comp = 0, mag = 0;
+	FunctionView row, mono;
+
+	for (size_t j = 0; j <= degree_y; ++j) {
+		Function *p = function_view_init(&row, degree_x,
+						 c + j * (degree_x + 1));
+		unit[j] = 1;
+		Function *m = function_view_init(&mono, j, unit);
+		double term = riemann_opts(xmin, xmax, p, nx, type, opts) *
+			      riemann_opts(ymin, ymax, m, ny, type, opts);
+		unit[j] = 0;
+
+		neumaier_add(&sum, &comp, term);
+		mag += fabs(term);
+	}
+
+	*res = sum + comp;
+	return isfinite(*res) &&
+	       mag * (degree_y + 2) * (DBL_EPSILON / 2) <=
+		       RIEMANN_CLOSED_TOL * fabs(*res);
+}
+
+/**
+ * @brief Soma os valores de uma função de duas variáveis na grade, por
+ * ladrilhos.
+ *
+ * @details Um `BIPOLYNOMIAL` é somado pela tabela de potências somente se
+ * não houver núcleo vetorizado (`SIMD_SCALAR`); caso contrário, a sua
+ * avaliação em linha, que usa o núcleo, é mais rápida. Determina a largura
+ * dos ladrilhos (limitada, com a tabela, pelo seu tamanho), distribui os
+ * ladrilhos entre as threads e combina as suas somas com
+ * `riemann2d_tree()`. A largura depende somente do grau e do nível de SIMD,
+ * e não do número de threads.
+ *
+ * @param ctx Ponteiro para o contexto, com a função e a grade definidas.
+ * @param threads Número de threads.
+ * @return A soma dos valores da função nos pontos da grade.
+ */
+static double riemann2d_tiles(TileCtx *ctx, unsigned threads)
+{
+	ctx->tile_x = RIEMANN2D_TILE_X;
+	if (simd_level() == SIMD_SCALAR)
+		ctx->coeffs = function2d_bipolynomial(ctx->func, &ctx->degree_x,
+						      &ctx->degree_y);
+	if (ctx->coeffs != nullptr) {
+		size_t fit = RIEMANN2D_TABLE_BYTES / sizeof(double) /
+			     (ctx->degree_x + 1) / 8 * 8;
+		if (fit < ctx->tile_x)
+			ctx->tile_x = fit < 8 ? 8 : fit;
+	}
+
+	ctx->tiles_x = (ctx->nx + ctx->tile_x - 1) / ctx->tile_x;
+	size_t tiles_y = (ctx->ny + RIEMANN2D_TILE_Y - 1) / RIEMANN2D_TILE_Y;
+	size_t tiles = ctx->tiles_x * tiles_y;
+
+	ctx->sums = malloc(tiles * sizeof(*ctx->sums));
+	ERRNOCHECK(ctx->sums == nullptr, "Falha ao alocar somas dos ladrilhos",
+		   fatal);
+
+	Pool *pool = threads > 1 && tiles > 1 ? pool_global(threads) : nullptr;
+	if (pool != nullptr)
+		pool_run(pool, tiles, threads, &riemann2d_tile_task, ctx);
+	else
+		for (size_t i = 0; i < tiles; ++i)
+			riemann2d_tile_task(i, ctx);
+
+	double res = riemann2d_tree(ctx->sums, tiles);
+	free(ctx->sums);
+	return res;
+
+fatal:
+	exit(EXIT_FAILURE);
+}
+
+/**
+ * @brief Tarefa que soma um ladrilho da grade.
+ *
+ * @details Os ladrilhos são numerados linha após linha. As abscissas do
+ * ladrilho são geradas uma vez. Com a tabela de potências, monta-se também a
+ * tabela das potências \f$x^i\f$ das abscissas, e cada linha reduz os
+ * coeficientes a \f$r_i = \sum_j c_{j,i} y^j\f$ (pela regra de Horner,
+ * vetorizada sobre \f$i\f$) e acumula \f$\sum_i r_i x^i\f$ termo a termo, na
+ * mesma sequência de operações de `Function2D::eval`. Sem ela, cada linha é
+ * avaliada por `Function2D::eval_row`. Em ambos os casos, os valores de cada
+ * coluna são somados ao seu acumulador, e os acumuladores, somados em ordem
+ * no final.
+ *
+ * @param index O índice do ladrilho.
+ * @param ctx Ponteiro para o contexto (`TileCtx`).
+ */
+static void riemann2d_tile_task(size_t index, void *ctx)
+{
+	TileCtx *c = ctx;
+	size_t tile_x = c->tile_x;
+	size_t col = index % c->tiles_x * tile_x;
+	size_t row = index / c->tiles_x * RIEMANN2D_TILE_Y;
+	size_t cols = c->nx - col < tile_x ? c->nx - col : tile_x;
+	size_t rows = c->ny - row < RIEMANN2D_TILE_Y ? c->ny - row :
+						       RIEMANN2D_TILE_Y;
+	size_t terms = c->coeffs != nullptr ? c->degree_x + 1 : 0;
+
+	// Abscissas, valores de uma linha, acumuladores, tabela de potências e
+	// coeficientes reduzidos, num só arranjo.
+	double *x = malloc(((3 + terms) * tile_x + terms) * sizeof(*x));
+	ERRNOCHECK(x == nullptr, "Falha ao alocar ladrilho", fatal);
+	double *vals = x + tile_x, *acc = vals + tile_x;
+	double *table = acc + tile_x, *red = table + terms * tile_x;
+
+	for (size_t t = 0; t < cols; ++t) {
+		x[t] = c->ax + (c->first + col + t) * c->dx;
+		acc[t] = 0;
+	}
+	if (terms > 0) {
+		for (size_t t = 0; t < cols; ++t)
+			table[t] = 1;
+		for (size_t i = 1; i < terms; ++i)
+			for (size_t t = 0; t < cols; ++t)
+				table[i * tile_x + t] =
+					table[(i - 1) * tile_x + t] * x[t];
+	}
+
+	for (size_t r = 0; r < rows; ++r) {
+		double y = c->ay + (c->first + row + r) * c->dy;
+
+		if (terms == 0) {
+			c->func->eval_row(x, cols, y, vals, c->func->impl);
+			for (size_t t = 0; t < cols; ++t)
+				acc[t] += vals[t];
+			continue;
+		}
+
+		const double *m = c->coeffs;
+		memcpy(red, m + c->degree_y * terms, terms * sizeof(*red));
+		for (size_t j = c->degree_y; j-- > 0;)
+			for (size_t i = 0; i < terms; ++i)
+				red[i] = red[i] * y + m[j * terms + i];
+
+		for (size_t t = 0; t < cols; ++t)
+			vals[t] = 0;
+		for (size_t i = 0; i < terms; ++i) {
+			const double *pow = table + i * tile_x;
+			for (size_t t = 0; t < cols; ++t)
+				vals[t] += red[i] * pow[t];
+		}
+		for (size_t t = 0; t < cols; ++t)
+			acc[t] += vals[t];
+	}
+
+	double sum = 0;
+	for (size_t t = 0; t < cols; ++t)
+		sum += acc[t];
+	c->sums[index] = sum;
+	free(x);
+	return;
+
+fatal:
+	exit(EXIT_FAILURE);
+}
+
+/**
+ * @brief Soma uma faixa de ladrilhos de forma recursiva, pela metade.
+ *
+ * @details Como `riemann_tree()` em `riemann.c`: a árvore depende apenas do
+ * número de ladrilhos, o que torna o resultado determinístico.
+ *
+ * @param sums Arranjo com as somas dos ladrilhos.
+ * @param count Número de ladrilhos.
+ * @return A soma de todos os ladrilhos.
+ */
+static double riemann2d_tree(const double *sums, size_t count)
+{
+	if (count == 1)
+		return sums[0];
+
+	size_t half = count / 2;
+	return riemann2d_tree(sums, half) +
+	       riemann2d_tree(sums + half, count - half);
+}
\ No newline at end of file
@@ -0,0 +1,1117 @@
+// SPDX-License-Identifier: ISC
+
+/**
+ * @file server.c
+ * @brief Implementação do servidor de integração por socket Unix.
+ *
+ * @details A thread principal aceita conexões e cria, para cada uma, uma
+ * thread leitora, que decodifica os pedidos. Como em `jobs.c`, os trabalhos
+ * ocupam posições (`Slot`) de um arranjo fixo: a leitora retira uma posição
+ * livre, preenche-a e coloca-a na fila de trabalho, e as threads de trabalho
+ * retiram lotes dessa fila, calculam-nos, respondem e devolvem as posições.
+ * Quando não há posição livre, a leitora espera, o que limita os trabalhos em
+ * andamento.
+ *
+ * Uma thread de trabalho que encontra menos de `SERVER_BATCH` trabalhos na
+ * fila espera até que o mais antigo complete a janela de agrupamento, a
+ * menos que a fila se encha antes.
+ *
+ * Cada conexão tem um contador de referências (da leitora e de cada trabalho
+ * em andamento), e só é fechada quando a última referência é liberada.
+ * Assim, no término, basta fechar o lado de leitura das conexões: as
+ * leitoras terminam, os trabalhos já recebidos são calculados e respondidos,
+ * e as conexões são fechadas ao fim.
+ *
+ * As escritas nos sockets têm prazo de `SERVER_SEND_TIMEOUT_MS`: um cliente
+ * que deixa de ler as respostas tem a conexão marcada como quebrada e
+ * encerrada, e os seus trabalhos seguem sem resposta, devolvendo as posições.
+ * Assim, nem as threads de trabalho nem o término ficam presos nele.
+ */
+
+#define _GNU_SOURCE
+
+#include <fcntl.h>
+#include <inttypes.h>
+#include <math.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "func.h"
+#include "jobs.h"
+#include "pool.h"
+#include "ring.h"
+#include "riemann.h"
+#include "server.h"
+#include "util.h"
+
+/**
+ * @brief Tamanho máximo de um pedido, em bytes.
+ */
+#define SERVER_MAX_REQUEST \
+	(sizeof(ServerRequest) + (JOB_MAX_DEGREE + 1) * sizeof(double))
+
+/**
+ * @brief Prazo, em milissegundos, de cada escrita num socket de cliente.
+ */
+#define SERVER_SEND_TIMEOUT_MS 5000
+
+/**
+ * @brief Uma conexão com um cliente.
+ */
+typedef struct Conn {
+	int fd; /**< O socket da conexão. */
+	pthread_mutex_t write_lock; /**< Serializa as escritas no socket. */
+	bool broken; /**< Indica que uma escrita falhou (protegido por
+		      * `write_lock`). */
+	unsigned refs; /**< Referências da leitora e dos trabalhos em
+			* andamento (protegido pela trava do servidor). */
+	struct Conn *prev; /**< Conexão anterior na lista de leitoras ativas. */
+	struct Conn *next; /**< Próxima conexão na lista de leitoras ativas. */
+	struct Server *server; /**< O servidor da conexão. */
+} Conn;
+
+/**
+ * @brief Uma posição do servidor, com um trabalho em andamento.
+ */
+typedef struct {
+	Job job; /**< O trabalho. */
+	Conn *conn; /**< A conexão que pediu o trabalho. */
+	uint64_t arrival; /**< Instante da chegada, em nanossegundos. */
+	ServerResult result; /**< A resposta. */
+} Slot;
+
+/**
+ * @brief Uma função no cache.
+ */
+typedef struct CacheNode {
+	uint64_t hash; /**< Hash do grau e dos coeficientes. */
+	Function *func; /**< A função. */
+	unsigned refs; /**< Número de lotes usando a função. */
+	struct CacheNode *chain; /**< Próximo nó na mesma posição da tabela. */
+	struct CacheNode *prev; /**< Nó usado mais recentemente que este. */
+	struct CacheNode *next; /**< Nó usado menos recentemente que este. */
+} CacheNode;
+
+/**
+ * @brief Cache LRU de funções, compartilhado entre as threads de trabalho.
+ *
+ * @details Uma tabela de dispersão encadeada encontra as funções pelo hash,
+ * e uma lista duplamente encadeada as ordena pelo uso mais recente. Ao
+ * exceder a capacidade, descarta-se a função usada há mais tempo que não
+ * esteja em uso por algum lote.
+ */
+typedef struct {
+	pthread_mutex_t lock; /**< Protege os campos abaixo. */
+	CacheNode **buckets; /**< A tabela de dispersão. */
+	size_t mask; /**< Número de posições da tabela, menos um. */
+	CacheNode lru; /**< Sentinela da lista: `lru.next` é o mais recente. */
+	size_t count; /**< Número de funções no cache. */
+	size_t capacity; /**< Número máximo de funções fora de uso. */
+	uint64_t hits; /**< Funções encontradas. */
+	uint64_t misses; /**< Funções construídas. */
+} FunctionCache;
+
+/**
+ * @brief Estado do servidor.
+ */
+typedef struct Server {
+	pthread_mutex_t lock; /**< Protege os campos abaixo. */
+	pthread_cond_t can_read; /**< Sinaliza que há posição livre. */
+	pthread_cond_t can_work; /**< Sinaliza trabalho novo ou o fim. */
+	pthread_cond_t idle; /**< Sinaliza que a última leitora terminou. */
+	Slot *slots; /**< Arranjo com as posições. */
+	size_t capacity; /**< Número de posições. */
+	size_t *free_slots; /**< Pilha de posições livres. */
+	size_t num_free; /**< Número de posições livres. */
+	Ring work; /**< Fila de posições a calcular. */
+	bool eof; /**< Indica que não haverá mais trabalhos. */
+	unsigned workers; /**< Número de threads de trabalho. */
+	uint64_t window; /**< Janela de agrupamento, em nanossegundos. */
+	Conn conns; /**< Sentinela da lista de conexões com leitora ativa. */
+	size_t readers; /**< Número de leitoras ativas. */
+	uint64_t *samples; /**< As `SERVER_SAMPLES` latências mais recentes. */
+	uint64_t num_samples; /**< Número total de latências registradas. */
+	ServerStats stats; /**< Contadores das estatísticas. */
+	FunctionCache cache; /**< O cache de funções. */
+	ResultCache *results; /**< O cache de resultados, ou `nullptr`. */
+	int wake[2]; /**< Pipe que acorda a thread principal para terminar. */
+} Server;
+
+/**
+ * @brief Lado de escrita do pipe do servidor em execução, para o tratador de
+ * sinais.
+ */
+static volatile sig_atomic_t server_wake_fd = -1;
+
+// Declarações internas.
+static void server_signal(int sig);
+static uint64_t server_now(void);
+static void *server_reader(void *arg);
+static void *server_worker(void *arg);
+static void server_accept(Server *s, int fd);
+static bool server_integrate(Server *s, Conn *conn, const unsigned char *buf,
+			     size_t len, uint64_t arrival);
+static void server_respond(Slot *slots, const size_t *batch, size_t count);
+static void server_fill_stats(Server *s, ServerStats *stats);
+static void server_unref(Conn *conn);
+static int server_read(int fd, void *buf, size_t len);
+static bool server_write(int fd, const void *buf, size_t len);
+static bool server_send(int fd, const void *msg, uint32_t len);
+static void server_break(Conn *conn);
+static int server_connect(const char *path);
+static bool server_call(const char *path, uint32_t type, void *reply,
+			uint32_t len);
+static long server_collect(int fd, FILE *out, JobsFormat format,
+			   size_t count);
+static bool fcache_init(FunctionCache *c, size_t capacity);
+static void fcache_destroy(FunctionCache *c);
+static CacheNode *fcache_acquire(FunctionCache *c, const Job *job);
+static int compare_u64(const void *a, const void *b);
+
+// Executa o servidor até receber um sinal ou um pedido de término.
+bool server_run(const char *path, const ServerOptions *opts)
+{
+	ServerOptions o = opts != nullptr ? *opts : (ServerOptions){ 0 };
+	Server s = { 0 };
+	struct sockaddr_un addr = { .sun_family = AF_UNIX };
+	struct sigaction sa = { .sa_handler = &server_signal }, old_int,
+			 old_term;
+	pthread_condattr_t attr;
+	pthread_t *threads = nullptr;
+	unsigned started = 0;
+	bool ret = false;
+	int fd = -1;
+
+	errno = ENAMETOOLONG;
+	ERRNOCHECK(strlen(path) >= sizeof(addr.sun_path), path, cleanup);
+	strcpy(addr.sun_path, path);
+
+	s.workers = o.threads > 0 ? o.threads : pool_cpu_count();
+	s.window = (uint64_t)(o.window_us > 0 ? o.window_us :
+						SERVER_WINDOW_US) * 1000;
+	s.capacity = o.queue > 0 ? o.queue : SERVER_QUEUE;
+	s.results = o.results;
+	s.conns.prev = s.conns.next = &s.conns;
+	s.wake[0] = s.wake[1] = -1;
+
+	// Aloca todas as posições e filas de uma vez.
+	s.slots = calloc(s.capacity, sizeof(*s.slots));
+	s.free_slots = malloc(s.capacity * sizeof(*s.free_slots));
+	s.work.data = malloc(s.capacity * sizeof(*s.work.data));
+	s.samples = malloc(SERVER_SAMPLES * sizeof(*s.samples));
+	threads = malloc(s.workers * sizeof(*threads));
+	ERRNOCHECK(s.slots == nullptr || s.free_slots == nullptr ||
+			   s.work.data == nullptr || s.samples == nullptr ||
+			   threads == nullptr,
+		   "Falha ao alocar o servidor", cleanup);
+	s.work.capacity = s.capacity;
+	for (size_t i = 0; i < s.capacity; ++i)
+		s.free_slots[i] = s.capacity - 1 - i;
+	s.num_free = s.capacity;
+	if (!fcache_init(&s.cache, o.cache > 0 ? o.cache : SERVER_CACHE))
+		goto cleanup;
+
+	// Cria o socket, substituindo somente um socket antigo no caminho.
+	struct stat st;
+	if (lstat(path, &st) == 0 && S_ISSOCK(st.st_mode))
+		unlink(path);
+	fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	ERRNOCHECK(fd < 0, "Falha ao criar o socket", free_cache);
+	ERRNOCHECK(bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0, path,
+		   close_fd);
+	ERRNOCHECK(listen(fd, SOMAXCONN) != 0, path, unlink_path);
+	ERRNOCHECK(pipe2(s.wake, O_CLOEXEC | O_NONBLOCK) != 0,
+		   "Falha ao criar o pipe do servidor", unlink_path);
+
+	// A janela de agrupamento é medida no relógio monotônico.
+	pthread_mutex_init(&s.lock, nullptr);
+	pthread_condattr_init(&attr);
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+	pthread_cond_init(&s.can_work, &attr);
+	pthread_condattr_destroy(&attr);
+	pthread_cond_init(&s.can_read, nullptr);
+	pthread_cond_init(&s.idle, nullptr);
+
+	for (; started < s.workers; ++started) {
+		int err = pthread_create(&threads[started], nullptr,
+					 &server_worker, &s);
+		errno = err;
+		ERRNOCHECK(err != 0, "Falha ao criar thread de trabalho", stop);
+	}
+
+	server_wake_fd = s.wake[1];
+	sigemptyset(&sa.sa_mask);
+	sigaction(SIGINT, &sa, &old_int);
+	sigaction(SIGTERM, &sa, &old_term);
+	fprintf(stderr, "Servidor ouvindo em %s\n", path);
+
+	// Aceita conexões até que o pipe seja escrito.
+	for (;;) {
+		struct pollfd fds[2] = { { fd, POLLIN, 0 },
+					 { s.wake[0], POLLIN, 0 } };
+		if (poll(fds, 2, -1) < 0) {
+			if (errno == EINTR)
+				continue;
+			perror("Falha ao aguardar conexões");
+			break;
+		}
+		if (fds[1].revents != 0)
+			break;
+		if (fds[0].revents != 0) {
+			int client = accept4(fd, nullptr, nullptr,
+					     SOCK_CLOEXEC);
+			if (client >= 0)
+				server_accept(&s, client);
+		}
+	}
+
+	sigaction(SIGTERM, &old_term, nullptr);
+	sigaction(SIGINT, &old_int, nullptr);
+	server_wake_fd = -1;
+	ret = true;
+
+stop: // Encerra a leitura de todas as conexões e espera as leitoras.
+	pthread_mutex_lock(&s.lock);
+	for (Conn *c = s.conns.next; c != &s.conns; c = c->next)
+		shutdown(c->fd, SHUT_RD);
+	while (s.readers > 0)
+		pthread_cond_wait(&s.idle, &s.lock);
+
+	// Então, as threads de trabalho esvaziam a fila e terminam.
+	s.eof = true;
+	pthread_cond_broadcast(&s.can_work);
+	pthread_mutex_unlock(&s.lock);
+	for (unsigned i = 0; i < started; ++i)
+		pthread_join(threads[i], nullptr);
+	if (ret)
+		fprintf(stderr, "Servidor terminado: %" PRIu64 " pedidos\n",
+			s.stats.requests);
+
+	pthread_cond_destroy(&s.idle);
+	pthread_cond_destroy(&s.can_read);
+	pthread_cond_destroy(&s.can_work);
+	pthread_mutex_destroy(&s.lock);
+	close(s.wake[0]);
+	close(s.wake[1]);
+unlink_path:
+	unlink(path);
+close_fd:
+	close(fd);
+free_cache:
+	fcache_destroy(&s.cache);
+cleanup:
+	free(threads);
+	free(s.samples);
+	free(s.work.data);
+	free(s.free_slots);
+	free(s.slots);
+	return ret;
+}
+
+// Envia ao servidor os trabalhos de um arquivo e escreve as respostas.
+long server_client(const char *path, FILE *in, FILE *out, JobsFormat format)
+{
+	unsigned char msg[SERVER_MAX_REQUEST];
+	char *line = nullptr;
+	size_t len = 0, pending = 0;
+	long errors = 0, ret = -1;
+	Job job;
+	const char *err;
+
+	int fd = server_connect(path);
+	if (fd < 0)
+		return -1;
+
+	jobs_print_header(out, format);
+	while (getline(&line, &len, in) != -1) {
+		int parsed = job_parse(line, &job, &err);
+		if (parsed == 0)
+			continue;
+		if (parsed < 0) {
+			jobs_print_result(out, format, job.id, 0, err);
+			++errors;
+			continue;
+		}
+
+		ServerRequest req = {
+			.type = SERVER_INTEGRATE,
+			.degree = job.degree,
+			.id = job.id,
+			.min = job.min,
+			.max = job.max,
+			.n = job.n,
+			.method = job.method,
+		};
+		size_t size = (job.degree + 1) * sizeof(*job.coeffs);
+		memcpy(msg, &req, sizeof(req));
+		memcpy(msg + sizeof(req), job.coeffs, size);
+		ERRNOCHECK(!server_send(fd, msg, sizeof(req) + size),
+			   "Falha ao enviar o pedido ao servidor", cleanup);
+
+		// Lê as respostas de um grupo antes de enviar o próximo.
+		if (++pending == SERVER_PIPELINE) {
+			long e = server_collect(fd, out, format, pending);
+			if (e < 0)
+				goto cleanup;
+			errors += e;
+			pending = 0;
+		}
+	}
+	ERRNOCHECK(ferror(in), "Falha ao ler os trabalhos", cleanup);
+
+	long e = server_collect(fd, out, format, pending);
+	if (e >= 0)
+		ret = errors + e;
+
+cleanup:
+	fflush(out);
+	free(line);
+	close(fd);
+	return ret;
+}
+
+// Obtém as estatísticas de um servidor.
+bool server_stats(const char *path, ServerStats *stats)
+{
+	return server_call(path, SERVER_STATS, stats, sizeof(*stats));
+}
+
+// Pede a um servidor que termine.
+bool server_shutdown(const char *path)
+{
+	ServerResult res;
+
+	return server_call(path, SERVER_SHUTDOWN, &res, sizeof(res)) &&
+	       res.status == SERVER_OK;
+}
+
+/**
+ * @brief Tratador de `SIGINT` e `SIGTERM`: acorda a thread principal.
+ *
+ * @param sig O sinal recebido.
+ */
+static void server_signal(int sig)
+{
+	int errsv = errno;
+
+	(void)sig;
+	if (server_wake_fd >= 0) {
+		ssize_t r = write(server_wake_fd, "", 1);
+		(void)r; // O pipe cheio já acordará a thread principal.
+	}
+	errno = errsv;
+}
+
+/**
+ * @brief Lê o relógio monotônico.
+ *
+ * @return O instante atual, em nanossegundos.
+ */
+static uint64_t server_now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/**
+ * @brief Registra uma conexão aceita e cria a sua thread leitora.
+ *
+ * @param s Ponteiro para o servidor.
+ * @param fd O socket da conexão.
+ */
+static void server_accept(Server *s, int fd)
+{
+	const struct timeval timeout = {
+		.tv_sec = SERVER_SEND_TIMEOUT_MS / 1000,
+		.tv_usec = SERVER_SEND_TIMEOUT_MS % 1000 * 1000,
+	};
+	pthread_attr_t attr;
+	pthread_t thread;
+
+	ERRNOCHECK(setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout,
+			      sizeof(timeout)) < 0,
+		   "Falha ao configurar prazo de escrita", close_fd);
+	Conn *conn = malloc(sizeof(*conn));
+	ERRNOCHECK(conn == nullptr, "Falha ao alocar conexão", close_fd);
+	*conn = (Conn){ .fd = fd, .refs = 1, .server = s };
+	pthread_mutex_init(&conn->write_lock, nullptr);
+
+	pthread_mutex_lock(&s->lock);
+	conn->prev = &s->conns;
+	conn->next = s->conns.next;
+	s->conns.next->prev = conn;
+	s->conns.next = conn;
+	++s->readers;
+	++s->stats.connections;
+	pthread_mutex_unlock(&s->lock);
+
+	// A leitora é destacada: o término espera por ela com `readers`.
+	pthread_attr_init(&attr);
+	pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+	int err = pthread_create(&thread, &attr, &server_reader, conn);
+	pthread_attr_destroy(&attr);
+	if (err != 0) {
+		errno = err;
+		perror("Falha ao criar thread leitora");
+
+		pthread_mutex_lock(&s->lock);
+		conn->prev->next = conn->next;
+		conn->next->prev = conn->prev;
+		--s->readers;
+		server_unref(conn);
+		pthread_mutex_unlock(&s->lock);
+	}
+	return;
+
+close_fd:
+	close(fd);
+}
+
+/**
+ * @brief Laço da thread leitora de uma conexão.
+ *
+ * @details Lê quadros até o fim da conexão ou um erro de protocolo. Os
+ * pedidos de integração vão para a fila de trabalho; os demais são
+ * respondidos aqui mesmo.
+ *
+ * @param arg Ponteiro para a conexão (`Conn`).
+ * @return Sempre `nullptr`.
+ */
+static void *server_reader(void *arg)
+{
+	Conn *conn = arg;
+	Server *s = conn->server;
+	unsigned char buf[SERVER_MAX_REQUEST];
+	uint32_t len, type;
+
+	while (server_read(conn->fd, &len, sizeof(len)) > 0 &&
+	       len >= sizeof(type) && len <= sizeof(buf) &&
+	       server_read(conn->fd, buf, len) > 0) {
+		uint64_t arrival = server_now();
+		memcpy(&type, buf, sizeof(type));
+
+		if (type == SERVER_INTEGRATE &&
+		    server_integrate(s, conn, buf, len, arrival))
+			continue;
+
+		ServerResult res = { type, SERVER_OK, 0, NAN };
+		ServerStats stats;
+		const void *msg = &res;
+		uint32_t size = sizeof(res);
+
+		switch (type) {
+		case SERVER_INTEGRATE: // Pedido inválido.
+			res.status = SERVER_ERROR;
+			if (len >= sizeof(ServerRequest))
+				memcpy(&res.id,
+				       buf + offsetof(ServerRequest, id),
+				       sizeof(res.id));
+			pthread_mutex_lock(&s->lock);
+			++s->stats.requests;
+			++s->stats.errors;
+			pthread_mutex_unlock(&s->lock);
+			break;
+		case SERVER_STATS:
+			server_fill_stats(s, &stats);
+			msg = &stats;
+			size = sizeof(stats);
+			break;
+		case SERVER_SHUTDOWN:
+			if (write(s->wake[1], "", 1) < 0 && errno != EAGAIN)
+				res.status = SERVER_ERROR;
+			break;
+		default:
+			res.status = SERVER_ERROR;
+		}
+
+		pthread_mutex_lock(&conn->write_lock);
+		if (!conn->broken && !server_send(conn->fd, msg, size))
+			server_break(conn);
+		pthread_mutex_unlock(&conn->write_lock);
+	}
+
+	pthread_mutex_lock(&s->lock);
+	conn->prev->next = conn->next;
+	conn->next->prev = conn->prev;
+	if (--s->readers == 0)
+		pthread_cond_signal(&s->idle);
+	server_unref(conn);
+	pthread_mutex_unlock(&s->lock);
+	return nullptr;
+}
+
+/**
+ * @brief Valida um pedido de integração e coloca-o na fila de trabalho.
+ *
+ * @param s Ponteiro para o servidor.
+ * @param conn A conexão que fez o pedido.
+ * @param buf O conteúdo do quadro.
+ * @param len O tamanho do quadro, em bytes.
+ * @param arrival O instante da chegada, em nanossegundos.
+ * @return `true` se o trabalho foi enfileirado, `false` se o pedido for
+ * inválido.
+ */
+static bool server_integrate(Server *s, Conn *conn, const unsigned char *buf,
+			     size_t len, uint64_t arrival)
+{
+	ServerRequest req;
+
+	if (len < sizeof(req))
+		return false;
+	memcpy(&req, buf, sizeof(req));
+	if (req.degree > JOB_MAX_DEGREE ||
+	    len != sizeof(req) + (req.degree + 1) * sizeof(double) ||
+	    !isfinite(req.min) || !isfinite(req.max) || req.n == 0 ||
+	    req.n > SIZE_MAX ||
+	    req.method > MEIO || req.reserved != 0)
+		return false;
+
+	// Espera uma posição livre e preenche-a fora da seção crítica.
+	pthread_mutex_lock(&s->lock);
+	while (s->num_free == 0)
+		pthread_cond_wait(&s->can_read, &s->lock);
+	size_t slot = s->free_slots[--s->num_free];
+	++conn->refs;
+	pthread_mutex_unlock(&s->lock);
+
+	Slot *p = &s->slots[slot];
+	p->job = (Job){
+		.id = req.id,
+		.min = req.min,
+		.max = req.max,
+		.n = req.n,
+		.method = req.method,
+		.degree = req.degree,
+	};
+	memcpy(p->job.coeffs, buf + sizeof(req),
+	       (req.degree + 1) * sizeof(double));
+	p->conn = conn;
+	p->arrival = arrival;
+
+	pthread_mutex_lock(&s->lock);
+	++s->stats.requests;
+	ring_push(&s->work, slot);
+	pthread_cond_signal(&s->can_work);
+	pthread_mutex_unlock(&s->lock);
+	return true;
+}
+
+/**
+ * @brief Laço de uma thread de trabalho.
+ *
+ * @details Espera até que haja `SERVER_BATCH` trabalhos na fila ou que o mais
+ * antigo complete a janela de agrupamento, e retira então um lote. As
+ * funções do lote são obtidas do cache numa só travessia, as somas são
+ * calculadas com uma thread cada (o paralelismo está nos lotes), e as
+ * respostas são enviadas agrupadas por conexão.
+ *
+ * @param arg Ponteiro para o servidor.
+ * @return Sempre `nullptr`.
+ */
+static void *server_worker(void *arg)
+{
+	Server *s = arg;
+	size_t batch[SERVER_BATCH];
+	CacheNode *nodes[SERVER_BATCH];
+	const RiemannOptions opts = { .threads = 1, .cache = s->results };
+
+	pthread_mutex_lock(&s->lock);
+	for (;;) {
+		while (s->work.size == 0 && !s->eof)
+			pthread_cond_wait(&s->can_work, &s->lock);
+		if (s->work.size == 0)
+			break;
+
+		// Aguarda a janela do trabalho mais antigo, a menos que o lote
+		// já esteja cheio ou que o servidor esteja terminando.
+		if (s->work.size < SERVER_BATCH && !s->eof) {
+			size_t head = s->work.data[s->work.head];
+			uint64_t deadline = s->slots[head].arrival + s->window;
+			if (server_now() < deadline) {
+				struct timespec ts = {
+					.tv_sec = deadline / 1000000000,
+					.tv_nsec = deadline % 1000000000,
+				};
+				pthread_cond_timedwait(&s->can_work, &s->lock,
+						       &ts);
+				continue;
+			}
+		}
+
+		size_t count = s->work.size < SERVER_BATCH ? s->work.size :
+							     SERVER_BATCH;
+		for (size_t i = 0; i < count; ++i)
+			batch[i] = ring_pop(&s->work);
+		++s->stats.batches;
+		pthread_mutex_unlock(&s->lock);
+
+		// Obtém as funções de todo o lote de uma vez.
+		pthread_mutex_lock(&s->cache.lock);
+		for (size_t i = 0; i < count; ++i)
+			nodes[i] = fcache_acquire(&s->cache,
+						  &s->slots[batch[i]].job);
+		pthread_mutex_unlock(&s->cache.lock);
+
+		for (size_t i = 0; i < count; ++i) {
+			Slot *p = &s->slots[batch[i]];
+			const Job *job = &p->job;
+
+			p->result = (ServerResult){ SERVER_INTEGRATE, SERVER_OK,
+						    job->id, NAN };
+			if (nodes[i] == nullptr)
+				p->result.status = SERVER_ERROR;
+			else
+				p->result.value = riemann_opts(job->min,
+							       job->max,
+							       nodes[i]->func,
+							       job->n,
+							       job->method,
+							       &opts);
+		}
+
+		// Libera as funções, que voltam a poder ser descartadas.
+		pthread_mutex_lock(&s->cache.lock);
+		for (size_t i = 0; i < count; ++i)
+			if (nodes[i] != nullptr)
+				--nodes[i]->refs;
+		pthread_mutex_unlock(&s->cache.lock);
+
+		server_respond(s->slots, batch, count);
+		uint64_t now = server_now();
+
+		// Registra as latências e devolve as posições.
+		pthread_mutex_lock(&s->lock);
+		for (size_t i = 0; i < count; ++i) {
+			Slot *p = &s->slots[batch[i]];
+			s->samples[s->num_samples++ % SERVER_SAMPLES] =
+				now - p->arrival;
+			s->stats.errors += p->result.status != SERVER_OK;
+			s->free_slots[s->num_free++] = batch[i];
+			server_unref(p->conn);
+		}
+		pthread_cond_broadcast(&s->can_read);
+	}
+	pthread_mutex_unlock(&s->lock);
+	return nullptr;
+}
+
+/**
+ * @brief Envia as respostas de um lote, numa escrita por conexão.
+ *
+ * @param slots O arranjo de posições do servidor.
+ * @param batch Os índices das posições do lote.
+ * @param count O número de posições do lote.
+ */
+static void server_respond(Slot *slots, const size_t *batch, size_t count)
+{
+	constexpr size_t frame = sizeof(uint32_t) + sizeof(ServerResult);
+	unsigned char buf[SERVER_BATCH * frame];
+	bool sent[SERVER_BATCH] = { false };
+
+	for (size_t i = 0; i < count; ++i) {
+		Conn *conn = slots[batch[i]].conn;
+		size_t len = 0;
+
+		if (sent[i])
+			continue;
+
+		// Junta as respostas desta conexão que estão no lote.
+		for (size_t j = i; j < count; ++j) {
+			if (sent[j] || slots[batch[j]].conn != conn)
+				continue;
+			uint32_t size = sizeof(ServerResult);
+			memcpy(buf + len, &size, sizeof(size));
+			memcpy(buf + len + sizeof(size),
+			       &slots[batch[j]].result, sizeof(ServerResult));
+			len += frame;
+			sent[j] = true;
+		}
+
+		pthread_mutex_lock(&conn->write_lock);
+		if (!conn->broken && !server_write(conn->fd, buf, len))
+			server_break(conn);
+		pthread_mutex_unlock(&conn->write_lock);
+	}
+}
+
+/**
+ * @brief Preenche as estatísticas do servidor.
+ *
+ * @details Os percentis são calculados por ordem nas `SERVER_SAMPLES`
+ * latências mais recentes.
+ *
+ * @param s Ponteiro para o servidor.
+ * @param stats Ponteiro onde as estatísticas serão escritas.
+ */
+static void server_fill_stats(Server *s, ServerStats *stats)
+{
+	uint64_t samples[SERVER_SAMPLES];
+
+	pthread_mutex_lock(&s->lock);
+	*stats = s->stats;
+	size_t count = s->num_samples < SERVER_SAMPLES ? s->num_samples :
+							 SERVER_SAMPLES;
+	memcpy(samples, s->samples, count * sizeof(*samples));
+	pthread_mutex_unlock(&s->lock);
+
+	pthread_mutex_lock(&s->cache.lock);
+	stats->cache_hits = s->cache.hits;
+	stats->cache_misses = s->cache.misses;
+	pthread_mutex_unlock(&s->cache.lock);
+
+	stats->type = SERVER_STATS;
+	stats->p50_us = stats->p99_us = NAN;
+	if (count > 0) {
+		qsort(samples, count, sizeof(*samples), &compare_u64);
+		stats->p50_us = samples[(count - 1) / 2] / 1e3;
+		stats->p99_us = samples[(count * 99 + 99) / 100 - 1] / 1e3;
+	}
+}
+
+/**
+ * @brief Libera uma referência a uma conexão, fechando-a se for a última.
+ *
+ * @details Deve ser chamada com a trava do servidor adquirida.
+ *
+ * @param conn A conexão.
+ */
+static void server_unref(Conn *conn)
+{
+	if (--conn->refs > 0)
+		return;
+
+	close(conn->fd);
+	pthread_mutex_destroy(&conn->write_lock);
+	free(conn);
+}
+
+/**
+ * @brief Marca uma conexão como quebrada, após uma escrita que falhou ou
+ * excedeu o prazo.
+ *
+ * @details Deve ser chamada com `write_lock` adquirida. Como parte de um
+ * quadro pode já ter sido enviada, nada mais é escrito na conexão, e ela é
+ * encerrada nos dois sentidos, para que a leitora termine. As respostas
+ * seguintes são descartadas, e as posições, devolvidas normalmente.
+ *
+ * @param conn A conexão.
+ */
+static void server_break(Conn *conn)
+{
+	conn->broken = true;
+	shutdown(conn->fd, SHUT_RDWR);
+}
+
+/**
+ * @brief Lê exatamente um número de bytes de um socket.
+ *
+ * @param fd O socket.
+ * @param buf Onde os bytes serão escritos.
+ * @param len O número de bytes.
+ * @return 1 em caso de sucesso, 0 se a conexão terminou, ou -1 em caso de
+ * erro.
+ */
+static int server_read(int fd, void *buf, size_t len)
+{
+	unsigned char *p = buf;
+
+	while (len > 0) {
+		ssize_t r = read(fd, p, len);
+		if (r < 0 && errno == EINTR)
+			continue;
+		if (r <= 0)
+			return r < 0 ? -1 : 0;
+		p += r;
+		len -= r;
+	}
+	return 1;
+}
+
+/**
+ * @brief Escreve exatamente um número de bytes num socket.
+ *
+ * @details Usa `MSG_NOSIGNAL`, para que um cliente que fechou a conexão não
+ * termine o processo com `SIGPIPE`. Nos sockets de clientes do servidor, o
+ * prazo de `SO_SNDTIMEO` faz `send()` falhar com `EAGAIN`, e a escrita
+ * falha.
+ *
+ * @param fd O socket.
+ * @param buf Os bytes.
+ * @param len O número de bytes.
+ * @return `true` em caso de sucesso, `false` em caso de erro.
+ */
+static bool server_write(int fd, const void *buf, size_t len)
+{
+	const unsigned char *p = buf;
+
+	while (len > 0) {
+		ssize_t r = send(fd, p, len, MSG_NOSIGNAL);
+		if (r < 0 && errno == EINTR)
+			continue;
+		if (r < 0)
+			return false;
+		p += r;
+		len -= r;
+	}
+	return true;
+}
+
+/**
+ * @brief Envia uma mensagem num quadro, numa só escrita.
+ *
+ * @param fd O socket.
+ * @param msg O conteúdo da mensagem.
+ * @param len O tamanho do conteúdo, em bytes (até `SERVER_MAX_REQUEST`).
+ * @return `true` em caso de sucesso, `false` em caso de erro.
+ */
+static bool server_send(int fd, const void *msg, uint32_t len)
+{
+	unsigned char buf[sizeof(len) + SERVER_MAX_REQUEST];
+
+	memcpy(buf, &len, sizeof(len));
+	memcpy(buf + sizeof(len), msg, len);
+	return server_write(fd, buf, sizeof(len) + len);
+}
+
+/**
+ * @brief Conecta-se a um servidor.
+ *
+ * @param path O caminho do socket.
+ * @return O socket conectado, ou -1 em caso de erro.
+ */
+static int server_connect(const char *path)
+{
+	struct sockaddr_un addr = { .sun_family = AF_UNIX };
+
+	errno = ENAMETOOLONG;
+	ERRNOCHECK(strlen(path) >= sizeof(addr.sun_path), path, ret);
+	strcpy(addr.sun_path, path);
+
+	int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	ERRNOCHECK(fd < 0, "Falha ao criar o socket", ret);
+	ERRNOCHECK(connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0,
+		   path, close_fd);
+	return fd;
+
+close_fd:
+	close(fd);
+ret:
+	return -1;
+}
+
+/**
+ * @brief Envia um pedido sem conteúdo e lê a resposta.
+ *
+ * @param path O caminho do socket.
+ * @param type O tipo do pedido.
+ * @param reply Onde a resposta será escrita.
+ * @param len O tamanho esperado da resposta, em bytes.
+ * @return `true` em caso de sucesso, `false` se a comunicação falhou.
+ */
+static bool server_call(const char *path, uint32_t type, void *reply,
+			uint32_t len)
+{
+	uint32_t size;
+	bool ret = false;
+
+	int fd = server_connect(path);
+	if (fd < 0)
+		return false;
+
+	errno = EPROTO;
+	ERRNOCHECK(!server_send(fd, &type, sizeof(type)) ||
+			   server_read(fd, &size, sizeof(size)) <= 0 ||
+			   size != len || server_read(fd, reply, len) <= 0,
+		   "Falha na comunicação com o servidor", close_fd);
+	ret = true;
+
+close_fd:
+	close(fd);
+	return ret;
+}
+
+/**
+ * @brief Lê e escreve as respostas de um grupo de pedidos de integração.
+ *
+ * @param fd O socket.
+ * @param out O arquivo onde os resultados serão escritos.
+ * @param format O formato da saída.
+ * @param count O número de respostas a ler.
+ * @return O número de respostas com erro, ou -1 se a comunicação falhou.
+ */
+static long server_collect(int fd, FILE *out, JobsFormat format,
+			   size_t count)
+{
+	ServerResult res;
+	uint32_t size;
+	long errors = 0;
+
+	for (size_t i = 0; i < count; ++i) {
+		errno = EPROTO;
+		ERRNOCHECK(server_read(fd, &size, sizeof(size)) <= 0 ||
+				   size != sizeof(res) ||
+				   server_read(fd, &res, sizeof(res)) <= 0,
+			   "Falha na comunicação com o servidor", ret);
+
+		const char *err = nullptr;
+		if (res.status != SERVER_OK) {
+			err = "pedido rejeitado pelo servidor";
+			++errors;
+		}
+		jobs_print_result(out, format, res.id, res.value, err);
+	}
+	return errors;
+
+ret:
+	return -1;
+}
+
+/**
+ * @brief Inicializa um cache de funções vazio.
+ *
+ * @param c Ponteiro para o cache.
+ * @param capacity O número de funções fora de uso a manter.
+ * @return `true` em caso de sucesso, `false` se faltou memória.
+ */
+static bool fcache_init(FunctionCache *c, size_t capacity)
+{
+	size_t size = 1;
+
+	while (size < 2 * capacity)
+		size <<= 1;
+	*c = (FunctionCache){ .mask = size - 1, .capacity = capacity };
+	c->buckets = calloc(size, sizeof(*c->buckets));
+	ERRNOCHECK(c->buckets == nullptr, "Falha ao alocar o cache", ret);
+	c->lru.prev = c->lru.next = &c->lru;
+	pthread_mutex_init(&c->lock, nullptr);
+	return true;
+
+ret:
+	return false;
+}
+
+/**
+ * @brief Libera um cache de funções e todas as suas funções.
+ *
+ * @param c Ponteiro para o cache.
+ */
+static void fcache_destroy(FunctionCache *c)
+{
+	if (c->buckets == nullptr)
+		return;
+	for (CacheNode *n = c->lru.next, *next; n != &c->lru; n = next) {
+		next = n->next;
+		function_free(n->func);
+		free(n);
+	}
+	free(c->buckets);
+	pthread_mutex_destroy(&c->lock);
+}
+
+/**
+ * @brief Obtém a função de um trabalho do cache, construindo-a se preciso.
+ *
+ * @details Deve ser chamada com a trava do cache adquirida. O nó fica
+ * marcado como em uso até que quem chama decremente `refs` (também com a
+ * trava), e não é descartado enquanto isso. Se o cache exceder a
+ * capacidade, descarta as funções fora de uso usadas há mais tempo.
+ *
+ * @param c Ponteiro para o cache.
+ * @param job O trabalho.
+ * @return O nó com a função, ou `nullptr` se faltou memória.
+ */
+static CacheNode *fcache_acquire(FunctionCache *c, const Job *job)
+{
+	// Hash FNV-1a do grau e dos coeficientes.
+	const unsigned char *bytes = (const unsigned char *)job->coeffs;
+	size_t size = (job->degree + 1) * sizeof(*job->coeffs);
+	uint64_t hash = (0xcbf29ce484222325 ^ job->degree) * 0x100000001b3;
+	for (size_t i = 0; i < size; ++i)
+		hash = (hash ^ bytes[i]) * 0x100000001b3;
+
+	CacheNode **bucket = &c->buckets[hash & c->mask];
+	CacheNode *n = *bucket;
+	while (n != nullptr &&
+	       (n->hash != hash ||
+		!function_polynomial_equal(n->func, job->degree, job->coeffs)))
+		n = n->chain;
+
+	if (n != nullptr) {
+		++c->hits;
+		n->prev->next = n->next;
+		n->next->prev = n->prev;
+	} else {
+		++c->misses;
+		n = malloc(sizeof(*n));
+		ERRNOCHECK(n == nullptr, "Falha ao alocar o cache", ret);
+		n->func = function_new(POLYNOMIAL, job->degree,
+				       (double *)job->coeffs);
+		ERRNOCHECK(n->func == nullptr, "Falha ao criar a função",
+			   free_node);
+		n->hash = hash;
+		n->refs = 0;
+		n->chain = *bucket;
+		*bucket = n;
+		++c->count;
+	}
+
+	// Coloca o nó no início da lista, como o mais recente.
+	n->prev = &c->lru;
+	n->next = c->lru.next;
+	c->lru.next->prev = n;
+	c->lru.next = n;
+	++n->refs;
+
+	// Descarta do fim da lista as funções fora de uso excedentes.
+	for (CacheNode *v = c->lru.prev, *prev;
+	     c->count > c->capacity && v != &c->lru; v = prev) {
+		prev = v->prev;
+		if (v->refs > 0)
+			continue;
+
+		CacheNode **link = &c->buckets[v->hash & c->mask];
+		while (*link != v)
+			link = &(*link)->chain;
+		*link = v->chain;
+		v->prev->next = v->next;
+		v->next->prev = v->prev;
+		function_free(v->func);
+		free(v);
+		--c->count;
+	}
+	return n;
+
+free_node:
+	free(n);
+ret:
+	return nullptr;
+}
+
+/**
+ * @brief Compara dois inteiros sem sinal de 64 bits, para `qsort()`.
+ *
+ * @param a Ponteiro para o primeiro inteiro.
+ * @param b Ponteiro para o segundo inteiro.
+ * @return Negativo, zero ou positivo, se o primeiro for menor, igual ou
+ * maior que o segundo.
+ */
+static int compare_u64(const void *a, const void *b)
+{
+	uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+
+	return (x > y) - (x < y);
+}
\ No newline at end of file
@@ -0,0 +1,1150 @@
+// SPDX-License-Identifier: ISC
+
+/**
+ * @file simd.c
+ * @brief Implementação dos núcleos vetorizados e do despacho em tempo de
+ * execução.
+ *
+ * @details Cada núcleo é compilado com o atributo `target` do GCC/Clang para o
+ * seu conjunto de instruções, de modo que o restante do programa continua
+ * compilado para a arquitetura base. Na inicialização, um construtor consulta
+ * o processador via `__builtin_cpu_supports()` e escolhe o núcleo mais largo
+ * disponível. Em arquiteturas que não são x86, somente o nível escalar existe.
+ */
+
+#include <float.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "simd.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SIMD_X86 1
+#else
+#define SIMD_X86 0
+#endif
+
+/**
+ * @brief Tipo de ponteiro para um núcleo de avaliação de polinômios.
+ */
+typedef void (*poly_kernel_t)(const double *coeffs, size_t degree,
+			      const double *x, double *y, size_t count);
+
+/**
+ * @brief Tipo de ponteiro para um núcleo de soma de potências.
+ */
+typedef void (*powers_kernel_t)(double a, double dx, size_t first,
+				size_t count, size_t degree, double *sums);
+
+/**
+ * @brief Tipo de ponteiro para um núcleo de soma em precisão simples.
+ */
+typedef float (*sum_f32_kernel_t)(const float *coeffs, size_t degree,
+				  float x0, float dx, size_t count);
+
+/**
+ * @brief Tipo de ponteiro para um núcleo de soma em precisão dupla-dupla.
+ */
+typedef void (*sum_dd_kernel_t)(const double *coeffs, size_t degree,
+				double a, double dx, size_t first,
+				size_t count, double sum[2]);
+
+/**
+ * @brief Tipo de ponteiro para um núcleo de função elementar.
+ */
+typedef void (*math_kernel_t)(const double *x, double *y, size_t count);
+
+/**
+ * @brief Funções elementares com núcleos vetorizados.
+ */
+typedef enum {
+	MATH_EXP, /**< `simd_exp()`. */
+	MATH_LOG, /**< `simd_log()`. */
+	MATH_SIN, /**< `simd_sin()`. */
+	MATH_OPS /**< Número de funções. */
+} MathOp;
+
+// Declarações internas.
+static SimdLevel simd_detect(void);
+static poly_kernel_t simd_poly_kernel(SimdLevel level);
+static powers_kernel_t simd_powers_kernel(SimdLevel level);
+static sum_f32_kernel_t simd_sum_f32_kernel(SimdLevel level);
+static sum_dd_kernel_t simd_sum_dd_kernel(SimdLevel level);
+static math_kernel_t simd_math_kernel(SimdLevel level, MathOp op);
+static void dd_lanes(double *hi, double *lo, double sum[2]);
+
+// Nível selecionado e núcleos correspondentes. Definidos pelo construtor.
+static SimdLevel level_current = SIMD_SCALAR;
+static poly_kernel_t poly_kernel = nullptr;
+static powers_kernel_t powers_kernel = nullptr;
+static sum_f32_kernel_t sum_f32_kernel = nullptr;
+static sum_dd_kernel_t sum_dd_kernel = nullptr;
+static math_kernel_t math_kernels[MATH_OPS] = { nullptr };
+
+/**
+ * @brief \f$1{,}5 \cdot 2^{52}\f$. Somado a um `double` de módulo menor que
+ * \f$2^{51}\f$, arredonda-o para o inteiro mais próximo, que fica nos bits
+ * baixos da mantissa; subtraído, devolve o inteiro como `double`.
+ */
+static const double math_round = 0x1.8p52;
+
+/**
+ * @brief Coeficientes de \f$e^r\f$, de \f$1/13!\f$ a \f$1/1!\f$, em ordem
+ * decrescente de grau.
+ */
+static const double exp_coeffs[] = {
+	1.0 / 6227020800.0, 1.0 / 479001600.0, 1.0 / 39916800.0,
+	1.0 / 3628800.0,    1.0 / 362880.0,    1.0 / 40320.0,
+	1.0 / 5040.0,	    1.0 / 720.0,       1.0 / 120.0,
+	1.0 / 24.0,	    1.0 / 6.0,	       1.0 / 2.0,
+	1.0,
+};
+
+/**
+ * @brief Coeficientes \f$L_7, \ldots, L_1\f$ de
+ * \f$R(z) = \sum_i L_i z^i\f$, a aproximação de
+ * \f$2 \operatorname{atanh}(s) / s - 2\f$ em \f$z = s^2\f$ da fdlibm.
+ */
+static const double log_coeffs[] = {
+	1.479819860511658591e-01, 1.531383769920937332e-01,
+	1.818357216161805012e-01, 2.222219843214978396e-01,
+	2.857142874366239149e-01, 3.999999999940941908e-01,
+	6.666666666666735130e-01,
+};
+
+/**
+ * @brief Coeficientes \f$S_6, \ldots, S_1\f$ do seno da fdlibm,
+ * \f$\sin r \approx r + r z \sum_i S_i z^{i-1}\f$, com \f$z = r^2\f$.
+ */
+static const double sin_coeffs[] = {
+	1.58969099521155010221e-10, -2.50507602534068634195e-08,
+	2.75573137070700676789e-06, -1.98412698298579493134e-04,
+	8.33333333332248946124e-03, -1.66666666666666324348e-01,
+};
+
+/**
+ * @brief Coeficientes \f$C_6, \ldots, C_1\f$ do cosseno da fdlibm,
+ * \f$\cos r \approx 1 - z/2 + z^2 \sum_i C_i z^{i-1}\f$.
+ */
+static const double cos_coeffs[] = {
+	-1.13596475577881948265e-11, 2.08757232129817482790e-09,
+	-2.75573143513906633035e-07, 2.48015872894767294178e-05,
+	-1.38888888888741095749e-03, 4.16666666666666019037e-02,
+};
+
+/**
+ * @brief Seleciona o núcleo na inicialização do programa.
+ *
+ * @details Detecta o nível mais largo suportado e o limita ao valor da
+ * variável de ambiente `RIEMANN_SIMD`, se definida.
+ */
+[[gnu::constructor]] static void simd_init(void)
+{
+	SimdLevel level = simd_detect();
+	const char *env = getenv("RIEMANN_SIMD");
+
+	if (env != nullptr) {
+		for (SimdLevel l = SIMD_SCALAR; l <= SIMD_AVX512; ++l) {
+			if (strcmp(env, simd_level_name(l)) == 0) {
+				level = l;
+				break;
+			}
+		}
+	}
+
+	simd_set_level(level);
+}
+
+// Retorna o nível de vetorização usado atualmente pelos núcleos.
+SimdLevel simd_level(void)
+{
+	return level_current;
+}
+
+// Força o uso de um nível, limitado ao suportado pelo processador.
+SimdLevel simd_set_level(SimdLevel level)
+{
+	SimdLevel max = simd_detect();
+
+	level_current = level < max ? level : max;
+	poly_kernel = simd_poly_kernel(level_current);
+	powers_kernel = simd_powers_kernel(level_current);
+	sum_f32_kernel = simd_sum_f32_kernel(level_current);
+	sum_dd_kernel = simd_sum_dd_kernel(level_current);
+	for (MathOp op = MATH_EXP; op < MATH_OPS; ++op)
+		math_kernels[op] = simd_math_kernel(level_current, op);
+	return level_current;
+}
+
+// Retorna o nome legível de um nível de vetorização.
+const char *simd_level_name(SimdLevel level)
+{
+	switch (level) {
+	case SIMD_SCALAR:
+		return "scalar";
+	case SIMD_SSE2:
+		return "sse2";
+	case SIMD_AVX2:
+		return "avx2";
+	case SIMD_AVX512:
+		return "avx512";
+	default:
+		return "?";
+	}
+}
+
+// Avalia um polinômio em vários pontos usando o núcleo selecionado.
+void simd_poly_horner(const double *coeffs, size_t degree, const double *x,
+		      double *y, size_t count)
+{
+	poly_kernel(coeffs, degree, x, y, count);
+}
+
+// Soma as potências dos pontos de uma grade usando o núcleo selecionado.
+void simd_power_sums(double a, double dx, size_t first, size_t count,
+		     size_t degree, double *sums)
+{
+	powers_kernel(a, dx, first, count, degree, sums);
+}
+
+// Soma um polinômio numa grade em precisão simples com o núcleo selecionado.
+float simd_poly_sum_f32(const float *coeffs, size_t degree, float x0,
+			float dx, size_t count)
+{
+	return sum_f32_kernel(coeffs, degree, x0, dx, count);
+}
+
+// Soma um polinômio numa grade em precisão dupla-dupla com o núcleo
+// selecionado.
+void simd_poly_sum_dd(const double *coeffs, size_t degree, double a,
+		      double dx, size_t first, size_t count, double sum[2])
+{
+	sum_dd_kernel(coeffs, degree, a, dx, first, count, sum);
+}
+
+// Calcula a exponencial de vários pontos usando o núcleo selecionado.
+void simd_exp(const double *x, double *y, size_t count)
+{
+	math_kernels[MATH_EXP](x, y, count);
+}
+
+// Calcula o logaritmo natural de vários pontos usando o núcleo selecionado.
+void simd_log(const double *x, double *y, size_t count)
+{
+	math_kernels[MATH_LOG](x, y, count);
+}
+
+// Calcula o seno de vários pontos usando o núcleo selecionado.
+void simd_sin(const double *x, double *y, size_t count)
+{
+	math_kernels[MATH_SIN](x, y, count);
+}
+
+/**
+ * @brief Núcleo escalar da regra de Horner.
+ *
+ * @details Usado somente quando nenhum conjunto vetorial está disponível mas
+ * `simd_poly_horner()` é chamada mesmo assim.
+ */
+static void poly_horner_scalar(const double *coeffs, size_t degree,
+			       const double *x, double *y, size_t count)
+{
+	for (size_t j = 0; j < count; ++j) {
+		double acc = coeffs[degree];
+		for (size_t k = degree; k-- > 0;)
+			acc = acc * x[j] + coeffs[k];
+		y[j] = acc;
+	}
+}
+
+/**
+ * @brief Corpo comum dos núcleos de soma de potências.
+ *
+ * @details Os pontos são processados em grupos de `SIMD_POWERS_LANES`, e cada
+ * lane acumula as suas somas separadamente, de modo que os laços internos não
+ * têm dependências entre lanes e são vetorizados pelo compilador com o
+ * conjunto de instruções de quem o incorpora. As lanes da cauda recebem peso
+ * zero. Como cada lane faz a mesma sequência de operações em todos os níveis,
+ * o resultado não depende do nível.
+ */
+[[gnu::always_inline]]
+static inline void power_sums(double a, double dx, size_t first,
+			      size_t count, size_t degree, double *sums)
+{
+	constexpr size_t lanes = SIMD_POWERS_LANES;
+	double acc[SIMD_POWERS_MAX_DEGREE + 1][SIMD_POWERS_LANES];
+
+	for (size_t k = 0; k <= degree; ++k)
+		for (size_t w = 0; w < lanes; ++w)
+			acc[k][w] = 0;
+
+	for (size_t i = 0; i < count; i += lanes) {
+		double x[SIMD_POWERS_LANES], p[SIMD_POWERS_LANES];
+		for (size_t w = 0; w < lanes; ++w) {
+			x[w] = a + (double)(first + i + w) * dx;
+			p[w] = i + w < count ? 1 : 0;
+		}
+		for (size_t k = 0; k <= degree; ++k) {
+			for (size_t w = 0; w < lanes; ++w) {
+				acc[k][w] += p[w];
+				p[w] *= x[w];
+			}
+		}
+	}
+
+	for (size_t k = 0; k <= degree; ++k) {
+		double s = 0;
+		for (size_t w = 0; w < lanes; ++w)
+			s += acc[k][w];
+		sums[k] = s;
+	}
+}
+
+/**
+ * @brief Núcleo de soma de potências para a arquitetura base.
+ */
+static void power_sums_scalar(double a, double dx, size_t first, size_t count,
+			      size_t degree, double *sums)
+{
+	power_sums(a, dx, first, count, degree, sums);
+}
+
+/**
+ * @brief Define um núcleo de soma em precisão simples.
+ *
+ * @details Os `SIMD_F32_LANES` pontos de cada iteração ficam em vetores
+ * genéricos do GCC de `width` bytes, a largura dos registradores do nível, e
+ * cada lane acumula a soma dos seus pontos. Os vetores de 64 bytes não são
+ * usados nos níveis mais estreitos porque o GCC os divide mal; por isso, o
+ * corpo é gerado por esta macro para cada largura, e não compartilhado por
+ * uma função em linha como em `power_sums()`. O ponto \f$j\f$ de cada
+ * iteração está sempre na lane \f$j\f$, e as lanes fazem a mesma sequência
+ * de operações em todos os níveis, de modo que o resultado não depende do
+ * nível.
+ *
+ * Os índices dos pontos são mantidos em `float` (exatos abaixo de
+ * \f$2^{24}\f$), para que a conversão também seja vetorial. As lanes da
+ * cauda são descartadas por máscara, e não por multiplicação, para que um
+ * valor infinito nelas não contamine a soma. As somas das lanes são
+ * combinadas em árvore.
+ *
+ * @param name O nome da função.
+ * @param width A largura dos vetores, em bytes.
+ */
+#define POLY_SUM_F32(name, width)                                              \
+	static float name(const float *coeffs, size_t degree, float x0,        \
+			  float dx, size_t count)                              \
+	{                                                                      \
+		typedef float vec [[gnu::vector_size(width)]];                 \
+		typedef int32_t mask [[gnu::vector_size(width)]];              \
+		enum { per = (width) / sizeof(float) };                        \
+		enum { groups = SIMD_F32_LANES / per };                        \
+		const vec zero = { 0 };                                        \
+		vec acc[groups], idx[groups], end = zero + (float)count;       \
+		float lanes[SIMD_F32_LANES];                                   \
+                                                                               \
+		for (size_t g = 0; g < groups; ++g) {                          \
+			acc[g] = idx[g] = zero;                                \
+			for (size_t w = 0; w < per; ++w)                       \
+				idx[g][w] = (float)(g * per + w);              \
+		}                                                              \
+                                                                               \
+		for (size_t i = 0; i < count; i += SIMD_F32_LANES) {           \
+			vec x[groups], y[groups];                              \
+			for (size_t g = 0; g < groups; ++g) {                  \
+				x[g] = x0 + idx[g] * dx;                       \
+				y[g] = zero + coeffs[degree];                  \
+			}                                                      \
+			for (size_t k = degree; k-- > 0;)                      \
+				for (size_t g = 0; g < groups; ++g)            \
+					y[g] = y[g] * x[g] + coeffs[k];        \
+			for (size_t g = 0; g < groups; ++g) {                  \
+				acc[g] += (vec)((mask)y[g] & (idx[g] < end));  \
+				idx[g] += (float)SIMD_F32_LANES;               \
+			}                                                      \
+		}                                                              \
+                                                                               \
+		for (size_t g = 0; g < groups; ++g)                            \
+			for (size_t w = 0; w < per; ++w)                       \
+				lanes[g * per + w] = acc[g][w];                \
+		for (size_t h = SIMD_F32_LANES / 2; h > 0; h /= 2)             \
+			for (size_t w = 0; w < h; ++w)                         \
+				lanes[w] += lanes[w + h];                      \
+		return lanes[0];                                               \
+	}
+
+/**
+ * @brief Define um núcleo de soma em precisão dupla-dupla.
+ *
+ * @details Organizado como `POLY_SUM_F32()`, com `SIMD_DD_LANES` lanes. Para
+ * cada ponto \f$x\f$, a regra de Horner compensada mantém o valor \f$r\f$
+ * e a correção \f$c\f$: a cada passo, \f$r \cdot x = p + \pi\f$
+ * (TwoProduct) e \f$p + c_k = r' + \sigma\f$ (TwoSum), exatamente, e
+ * \f$c' = c \cdot x + (\pi + \sigma)\f$. O TwoProduct usa a divisão de
+ * Dekker de cada fator em duas metades de 26 bits, calculada uma só vez para
+ * \f$x\f$; ela vale enquanto os valores ficarem abaixo de \f$2^{996}\f$. O
+ * par \f$(r, c)\f$ é então somado ao acumulador dupla-dupla da lane, e os
+ * acumuladores são combinados por `dd_lanes()`.
+ *
+ * As transformações exatas dependem de que cada operação seja arredondada
+ * separadamente: o compilador não pode contraí-las em FMA, o que o padrão
+ * ISO do C (`-std=c23`) já garante.
+ *
+ * @param name O nome da função.
+ * @param width A largura dos vetores, em bytes.
+ */
+#define POLY_SUM_DD(name, width)                                               \
+	static void name(const double *coeffs, size_t degree, double a,        \
+			 double dx, size_t first, size_t count, double sum[2]) \
+	{                                                                      \
+		typedef double vec [[gnu::vector_size(width)]];                \
+		typedef int64_t mask [[gnu::vector_size(width)]];              \
+		enum { per = (width) / sizeof(double) };                       \
+		enum { groups = SIMD_DD_LANES / per };                         \
+		const double split = 134217729.0; /* 2^27 + 1. */              \
+		const vec zero = { 0 };                                        \
+		vec hi[groups], lo[groups], idx[groups];                       \
+		vec end = zero + (double)(first + count);                      \
+		double lh[SIMD_DD_LANES], ll[SIMD_DD_LANES];                   \
+                                                                               \
+		for (size_t g = 0; g < groups; ++g) {                          \
+			hi[g] = lo[g] = idx[g] = zero;                         \
+			for (size_t w = 0; w < per; ++w)                       \
+				idx[g][w] = (double)(first + g * per + w);     \
+		}                                                              \
+                                                                               \
+		for (size_t i = 0; i < count; i += SIMD_DD_LANES) {            \
+			for (size_t g = 0; g < groups; ++g) {                  \
+				vec x = a + idx[g] * dx, t = split * x;        \
+				vec xh = t - (t - x), xl = x - xh;             \
+				vec r = zero + coeffs[degree], c = zero;       \
+				for (size_t k = degree; k-- > 0;) {            \
+					/* TwoProduct: r * x = p + pe. */      \
+					vec p = r * x;                         \
+					t = split * r;                         \
+					vec rh = t - (t - r), rl = r - rh;     \
+					vec pe = ((rh * xh - p) + rh * xl +    \
+						  rl * xh) + rl * xl;          \
+					/* TwoSum: p + c_k = s + se. */        \
+					vec s = p + coeffs[k], z = s - p;      \
+					vec se = (p - (s - z)) +               \
+						 (coeffs[k] - z);              \
+					c = c * x + (pe + se);                 \
+					r = s;                                 \
+				}                                              \
+				/* TwoSum no acumulador da lane. */            \
+				mask valid = idx[g] < end;                     \
+				r = (vec)((mask)r & valid);                    \
+				c = (vec)((mask)c & valid);                    \
+				vec s = hi[g] + r, z = s - hi[g];              \
+				lo[g] += ((hi[g] - (s - z)) + (r - z)) + c;    \
+				hi[g] = s;                                     \
+				idx[g] += (double)SIMD_DD_LANES;               \
+			}                                                      \
+		}                                                              \
+                                                                               \
+		for (size_t g = 0; g < groups; ++g) {                          \
+			for (size_t w = 0; w < per; ++w) {                     \
+				lh[g * per + w] = hi[g][w];                    \
+				ll[g * per + w] = lo[g][w];                    \
+			}                                                      \
+		}                                                              \
+		dd_lanes(lh, ll, sum);                                         \
+	}
+
+/**
+ * @brief Combina os acumuladores dupla-dupla das lanes de um núcleo
+ * `POLY_SUM_DD()`.
+ *
+ * @details Soma os pares em árvore, sempre na mesma ordem, e normaliza o
+ * resultado (FastTwoSum).
+ *
+ * @param hi As partes altas, uma por lane; é modificado.
+ * @param lo As partes baixas, uma por lane; é modificado.
+ * @param sum Arranjo onde a soma será escrita, como a parte alta seguida da
+ * parte baixa.
+ */
+static void dd_lanes(double *hi, double *lo, double sum[2])
+{
+	for (size_t half = SIMD_DD_LANES / 2; half > 0; half /= 2) {
+		for (size_t w = 0; w < half; ++w) {
+			double s = hi[w] + hi[w + half];
+			double z = s - hi[w];
+			double se = (hi[w] - (s - z)) + (hi[w + half] - z);
+			hi[w] = s;
+			lo[w] += lo[w + half] + se;
+		}
+	}
+
+	sum[0] = hi[0] + lo[0];
+	sum[1] = lo[0] - (sum[0] - hi[0]);
+}
+
+/**
+ * @brief Núcleo de soma em precisão simples para a arquitetura base, com
+ * vetores de 16 bytes (SSE2 em x86-64).
+ */
+POLY_SUM_F32(poly_sum_f32_scalar, 16)
+
+/**
+ * @brief Núcleo de soma em precisão dupla-dupla para a arquitetura base.
+ */
+POLY_SUM_DD(poly_sum_dd_scalar, 16)
+
+/**
+ * @brief Avalia um polinômio em cada lane pela regra de Horner.
+ *
+ * @details O laço externo percorre os coeficientes e o interno, as lanes,
+ * como em `power_sums()`, de modo que o interno é vetorizado.
+ *
+ * @param coeffs Os coeficientes, em ordem decrescente de grau.
+ * @param n Número de coeficientes.
+ * @param z Os pontos, um por lane.
+ * @param acc Arranjo onde os valores serão escritos, um por lane.
+ */
+[[gnu::always_inline]]
+static inline void math_horner(const double *coeffs, size_t n, const double *z,
+			       double *acc)
+{
+	for (size_t w = 0; w < SIMD_MATH_LANES; ++w)
+		acc[w] = coeffs[0];
+	for (size_t k = 1; k < n; ++k)
+		for (size_t w = 0; w < SIMD_MATH_LANES; ++w)
+			acc[w] = acc[w] * z[w] + coeffs[k];
+}
+
+/**
+ * @brief Calcula a exponencial de `SIMD_MATH_LANES` pontos.
+ *
+ * @details Com \f$k = \operatorname{round}(x / \ln 2)\f$, obtido pela soma de
+ * `math_round`, \f$e^x = 2^k e^r\f$, e \f$2^k\f$ é montado diretamente nos
+ * bits do expoente. As lanes com \f$|x| > 708\f$, onde \f$2^k\f$ sairia da
+ * faixa normal, ou \f$x\f$ não finito são recalculadas por `exp()`.
+ *
+ * @param in Os pontos.
+ * @param out Arranjo onde os resultados serão escritos; pode ser `in`.
+ */
+[[gnu::always_inline]]
+static inline void exp_lanes(const double *in, double *out)
+{
+	constexpr size_t lanes = SIMD_MATH_LANES;
+	const double log2e = 1.44269504088896338700e+00;
+	const double ln2_hi = 6.93147180369123816490e-01;
+	const double ln2_lo = 1.90821492927058770002e-10;
+	double x[SIMD_MATH_LANES], r[SIMD_MATH_LANES], p[SIMD_MATH_LANES];
+	uint64_t k[SIMD_MATH_LANES], round_bits;
+	int64_t bad[SIMD_MATH_LANES], any = 0;
+
+	memcpy(&round_bits, &math_round, sizeof(round_bits));
+	for (size_t w = 0; w < lanes; ++w)
+		x[w] = in[w];
+
+	for (size_t w = 0; w < lanes; ++w) {
+		double t = x[w] * log2e + math_round;
+		double kd = t - math_round;
+		memcpy(&k[w], &t, sizeof(t));
+		r[w] = (x[w] - kd * ln2_hi) - kd * ln2_lo;
+		bad[w] = !(fabs(x[w]) <= 708);
+		any |= bad[w];
+	}
+	math_horner(exp_coeffs, sizeof(exp_coeffs) / sizeof(*exp_coeffs), r,
+		    p);
+	for (size_t w = 0; w < lanes; ++w) {
+		uint64_t bits = (k[w] - round_bits + 1023) << 52;
+		double scale;
+		memcpy(&scale, &bits, sizeof(scale));
+		out[w] = (1 + p[w] * r[w]) * scale;
+	}
+
+	if (any)
+		for (size_t w = 0; w < lanes; ++w)
+			if (bad[w])
+				out[w] = exp(x[w]);
+}
+
+/**
+ * @brief Calcula o logaritmo natural de `SIMD_MATH_LANES` pontos.
+ *
+ * @details O expoente e a mantissa são separados pelos bits, e a mantissa,
+ * trazida para \f$[\sqrt{2}/2, \sqrt{2})\f$. As lanes com \f$x\f$ subnormal,
+ * não positivo ou não finito são recalculadas por `log()`.
+ *
+ * @param in Os pontos.
+ * @param out Arranjo onde os resultados serão escritos; pode ser `in`.
+ */
+[[gnu::always_inline]]
+static inline void log_lanes(const double *in, double *out)
+{
+	constexpr size_t lanes = SIMD_MATH_LANES;
+	const double ln2_hi = 6.93147180369123816490e-01;
+	const double ln2_lo = 1.90821492927058770002e-10;
+	double x[SIMD_MATH_LANES], kd[SIMD_MATH_LANES], f[SIMD_MATH_LANES];
+	double s[SIMD_MATH_LANES], z[SIMD_MATH_LANES], R[SIMD_MATH_LANES];
+	uint64_t round_bits;
+	int64_t bad[SIMD_MATH_LANES], any = 0;
+
+	memcpy(&round_bits, &math_round, sizeof(round_bits));
+	for (size_t w = 0; w < lanes; ++w)
+		x[w] = in[w];
+
+	for (size_t w = 0; w < lanes; ++w) {
+		uint64_t bits, mbits;
+		double m;
+		memcpy(&bits, &x[w], sizeof(bits));
+		int64_t e = (int64_t)(bits >> 52) - 1023;
+		mbits = (bits & 0x000fffffffffffff) | 0x3ff0000000000000;
+		memcpy(&m, &mbits, sizeof(m));
+
+		// Acima de raiz de 2, usa m / 2 e soma 1 ao expoente.
+		uint64_t big = m > 1.41421356237309504880;
+		mbits -= big << 52;
+		e += big;
+		memcpy(&m, &mbits, sizeof(m));
+
+		uint64_t ebits = (uint64_t)e + round_bits;
+		memcpy(&kd[w], &ebits, sizeof(kd[w]));
+		kd[w] -= math_round;
+		f[w] = m - 1;
+		s[w] = f[w] / (2 + f[w]);
+		z[w] = s[w] * s[w];
+		bad[w] = !((x[w] >= 0x1p-1022) & (x[w] <= DBL_MAX));
+		any |= bad[w];
+	}
+	math_horner(log_coeffs, sizeof(log_coeffs) / sizeof(*log_coeffs), z,
+		    R);
+	for (size_t w = 0; w < lanes; ++w) {
+		double hfsq = 0.5 * f[w] * f[w];
+		R[w] *= z[w];
+		out[w] = kd[w] * ln2_hi -
+			 ((hfsq - (s[w] * (hfsq + R[w]) + kd[w] * ln2_lo)) -
+			  f[w]);
+	}
+
+	if (any)
+		for (size_t w = 0; w < lanes; ++w)
+			if (bad[w])
+				out[w] = log(x[w]);
+}
+
+/**
+ * @brief Calcula o seno de `SIMD_MATH_LANES` pontos.
+ *
+ * @details Com \f$k = \operatorname{round}(2 x / \pi)\f$, o seno ou o cosseno
+ * de \f$r\f$ é escolhido por \f$k \bmod 2\f$, e o sinal é trocado por
+ * \f$k \bmod 4\f$, sempre com operações sobre os bits, para que o laço não
+ * tenha desvios. As lanes com \f$|x| < 2^{-26}\f$ recebem o próprio \f$x\f$,
+ * o que preserva o sinal de zero, e as com \f$|x| >\f$ `SIMD_SIN_MAX_ARG` ou
+ * \f$x\f$ não finito são recalculadas por `sin()`.
+ *
+ * @param in Os pontos.
+ * @param out Arranjo onde os resultados serão escritos; pode ser `in`.
+ */
+[[gnu::always_inline]]
+static inline void sin_lanes(const double *in, double *out)
+{
+	constexpr size_t lanes = SIMD_MATH_LANES;
+	constexpr size_t ns = sizeof(sin_coeffs) / sizeof(*sin_coeffs);
+	constexpr size_t nc = sizeof(cos_coeffs) / sizeof(*cos_coeffs);
+	const double inv_pio2 = 6.36619772367581382433e-01;
+	const double pio2_1 = 1.57079632673412561417e+00;
+	const double pio2_2 = 6.07710050630396597660e-11;
+	const double pio2_3 = 2.02226624871116645580e-21;
+	double x[SIMD_MATH_LANES], r[SIMD_MATH_LANES], z[SIMD_MATH_LANES];
+	double ps[SIMD_MATH_LANES], pc[SIMD_MATH_LANES];
+	uint64_t q[SIMD_MATH_LANES], round_bits;
+	int64_t bad[SIMD_MATH_LANES], any = 0;
+
+	memcpy(&round_bits, &math_round, sizeof(round_bits));
+	for (size_t w = 0; w < lanes; ++w)
+		x[w] = in[w];
+
+	for (size_t w = 0; w < lanes; ++w) {
+		double t = x[w] * inv_pio2 + math_round;
+		double kd = t - math_round;
+		memcpy(&q[w], &t, sizeof(t));
+		q[w] -= round_bits;
+		r[w] = ((x[w] - kd * pio2_1) - kd * pio2_2) - kd * pio2_3;
+		z[w] = r[w] * r[w];
+		bad[w] = !(fabs(x[w]) <= SIMD_SIN_MAX_ARG);
+		any |= bad[w];
+	}
+	math_horner(sin_coeffs, ns, z, ps);
+	math_horner(cos_coeffs, nc, z, pc);
+	for (size_t w = 0; w < lanes; ++w) {
+		double sn = r[w] + r[w] * z[w] * ps[w];
+		double hz = 0.5 * z[w], one = 1 - hz;
+		double cs = one + (((1 - one) - hz) + z[w] * z[w] * pc[w]);
+
+		uint64_t sbits, cbits, xbits, bits;
+		memcpy(&sbits, &sn, sizeof(sbits));
+		memcpy(&cbits, &cs, sizeof(cbits));
+		memcpy(&xbits, &x[w], sizeof(xbits));
+		uint64_t odd = -(q[w] & 1);
+		uint64_t tiny = -(uint64_t)(fabs(x[w]) < 0x1p-26);
+		bits = ((cbits & odd) | (sbits & ~odd)) ^ ((q[w] & 2) << 62);
+		bits = (xbits & tiny) | (bits & ~tiny);
+		memcpy(&out[w], &bits, sizeof(out[w]));
+	}
+
+	if (any)
+		for (size_t w = 0; w < lanes; ++w)
+			if (bad[w])
+				out[w] = sin(x[w]);
+}
+
+/**
+ * @brief Corpo comum dos núcleos de funções elementares.
+ *
+ * @details Aplica `lanes` aos grupos completos de `SIMD_MATH_LANES` pontos e,
+ * na cauda, a uma cópia completada com `pad`, um ponto dentro da faixa
+ * vetorizada.
+ *
+ * @param lanes A função que processa um grupo de pontos.
+ * @param pad O valor das lanes que sobram na cauda.
+ * @param x Arranjo com os pontos.
+ * @param y Arranjo onde os resultados serão escritos.
+ * @param count Número de pontos.
+ */
+[[gnu::always_inline]]
+static inline void math_map(void (*lanes)(const double *, double *),
+			    double pad, const double *x, double *y,
+			    size_t count)
+{
+	size_t i = 0;
+
+	for (; i + SIMD_MATH_LANES <= count; i += SIMD_MATH_LANES)
+		lanes(x + i, y + i);
+
+	if (i < count) {
+		double tail[SIMD_MATH_LANES];
+		for (size_t w = 0; w < SIMD_MATH_LANES; ++w)
+			tail[w] = i + w < count ? x[i + w] : pad;
+		lanes(tail, tail);
+		memcpy(y + i, tail, (count - i) * sizeof(*y));
+	}
+}
+
+/**
+ * @brief Núcleo de `simd_exp()` sem vetorização: `exp()` em cada ponto.
+ */
+static void math_exp_libm(const double *x, double *y, size_t count)
+{
+	for (size_t i = 0; i < count; ++i)
+		y[i] = exp(x[i]);
+}
+
+/**
+ * @brief Núcleo de `simd_log()` sem vetorização: `log()` em cada ponto.
+ */
+static void math_log_libm(const double *x, double *y, size_t count)
+{
+	for (size_t i = 0; i < count; ++i)
+		y[i] = log(x[i]);
+}
+
+/**
+ * @brief Núcleo de `simd_sin()` sem vetorização: `sin()` em cada ponto.
+ */
+static void math_sin_libm(const double *x, double *y, size_t count)
+{
+	for (size_t i = 0; i < count; ++i)
+		y[i] = sin(x[i]);
+}
+
+#if SIMD_X86
+/**
+ * @brief Detecta o nível de vetorização mais largo suportado pelo processador
+ * e pelo sistema operacional.
+ *
+ * @return O nível detectado.
+ */
+static SimdLevel simd_detect(void)
+{
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx512f"))
+		return SIMD_AVX512;
+	if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+		return SIMD_AVX2;
+	if (__builtin_cpu_supports("sse2"))
+		return SIMD_SSE2;
+	return SIMD_SCALAR;
+}
+
+/**
+ * @brief Núcleo SSE2 da regra de Horner.
+ *
+ * @details Avalia 4 pontos por iteração, em dois registradores independentes
+ * de 2 lanes cada, para esconder a latência da cadeia de dependências. A
+ * cauda é copiada para um bloco completo na pilha e avaliada da mesma forma,
+ * para que todos os pontos sigam a mesma sequência de operações.
+ */
+[[gnu::target("sse2")]]
+static void poly_horner_sse2(const double *coeffs, size_t degree,
+			     const double *x, double *y, size_t count)
+{
+	constexpr size_t width = 4;
+	size_t j = 0;
+	double xt[width], yt[width];
+
+	for (;;) {
+		const double *xs = x + j;
+		double *ys = y + j;
+		size_t rem = count - j;
+
+		// Se não houver um bloco completo, avalia a cauda num bloco
+		// temporário preenchido com zeros.
+		if (rem == 0)
+			break;
+		if (rem < width) {
+			memset(xt, 0, sizeof(xt));
+			memcpy(xt, xs, rem * sizeof(*xt));
+			xs = xt;
+			ys = yt;
+		}
+
+		__m128d x0 = _mm_loadu_pd(xs), x1 = _mm_loadu_pd(xs + 2);
+		__m128d a0 = _mm_set1_pd(coeffs[degree]), a1 = a0;
+		for (size_t k = degree; k-- > 0;) {
+			__m128d c = _mm_set1_pd(coeffs[k]);
+			a0 = _mm_add_pd(_mm_mul_pd(a0, x0), c);
+			a1 = _mm_add_pd(_mm_mul_pd(a1, x1), c);
+		}
+		_mm_storeu_pd(ys, a0);
+		_mm_storeu_pd(ys + 2, a1);
+
+		if (rem < width) {
+			memcpy(y + j, yt, rem * sizeof(*yt));
+			break;
+		}
+		j += width;
+	}
+}
+
+/**
+ * @brief Núcleo AVX2 da regra de Horner.
+ *
+ * @details Avalia 8 pontos por iteração, em dois registradores de 4 lanes,
+ * usando FMA. A cauda é tratada como em `poly_horner_sse2()`.
+ */
+[[gnu::target("avx2,fma")]]
+static void poly_horner_avx2(const double *coeffs, size_t degree,
+			     const double *x, double *y, size_t count)
+{
+	constexpr size_t width = 8;
+	size_t j = 0;
+	double xt[width], yt[width];
+
+	for (;;) {
+		const double *xs = x + j;
+		double *ys = y + j;
+		size_t rem = count - j;
+
+		if (rem == 0)
+			break;
+		if (rem < width) {
+			memset(xt, 0, sizeof(xt));
+			memcpy(xt, xs, rem * sizeof(*xt));
+			xs = xt;
+			ys = yt;
+		}
+
+		__m256d x0 = _mm256_loadu_pd(xs), x1 = _mm256_loadu_pd(xs + 4);
+		__m256d a0 = _mm256_set1_pd(coeffs[degree]), a1 = a0;
+		for (size_t k = degree; k-- > 0;) {
+			__m256d c = _mm256_set1_pd(coeffs[k]);
+			a0 = _mm256_fmadd_pd(a0, x0, c);
+			a1 = _mm256_fmadd_pd(a1, x1, c);
+		}
+		_mm256_storeu_pd(ys, a0);
+		_mm256_storeu_pd(ys + 4, a1);
+
+		if (rem < width) {
+			memcpy(y + j, yt, rem * sizeof(*yt));
+			break;
+		}
+		j += width;
+	}
+}
+
+/**
+ * @brief Núcleo AVX-512 da regra de Horner.
+ *
+ * @details Avalia 16 pontos por iteração, em dois registradores de 8 lanes,
+ * usando FMA. A cauda usa cargas e escritas mascaradas, sem cópia.
+ */
+[[gnu::target("avx512f")]]
+static void poly_horner_avx512(const double *coeffs, size_t degree,
+			       const double *x, double *y, size_t count)
+{
+	size_t j = 0;
+
+	for (; j + 16 <= count; j += 16) {
+		__m512d x0 = _mm512_loadu_pd(x + j);
+		__m512d x1 = _mm512_loadu_pd(x + j + 8);
+		__m512d a0 = _mm512_set1_pd(coeffs[degree]), a1 = a0;
+		for (size_t k = degree; k-- > 0;) {
+			__m512d c = _mm512_set1_pd(coeffs[k]);
+			a0 = _mm512_fmadd_pd(a0, x0, c);
+			a1 = _mm512_fmadd_pd(a1, x1, c);
+		}
+		_mm512_storeu_pd(y + j, a0);
+		_mm512_storeu_pd(y + j + 8, a1);
+	}
+
+	// Cauda de até 15 pontos, em até duas iterações mascaradas.
+	for (; j < count; j += 8) {
+		size_t rem = count - j < 8 ? count - j : 8;
+		__mmask8 m = (__mmask8)((1u << rem) - 1);
+		__m512d x0 = _mm512_maskz_loadu_pd(m, x + j);
+		__m512d a0 = _mm512_set1_pd(coeffs[degree]);
+		for (size_t k = degree; k-- > 0;)
+			a0 = _mm512_fmadd_pd(a0, x0, _mm512_set1_pd(coeffs[k]));
+		_mm512_mask_storeu_pd(y + j, m, a0);
+	}
+}
+
+/**
+ * @brief Núcleo AVX2 da soma de potências.
+ */
+[[gnu::target("avx2,fma")]]
+static void power_sums_avx2(double a, double dx, size_t first, size_t count,
+			    size_t degree, double *sums)
+{
+	power_sums(a, dx, first, count, degree, sums);
+}
+
+/**
+ * @brief Núcleo AVX-512 da soma de potências.
+ */
+[[gnu::target("avx512f")]]
+static void power_sums_avx512(double a, double dx, size_t first,
+			      size_t count, size_t degree, double *sums)
+{
+	power_sums(a, dx, first, count, degree, sums);
+}
+
+/**
+ * @brief Núcleo AVX2 da soma em precisão simples.
+ *
+ * @details Compilado sem FMA, para que o resultado seja o mesmo dos demais
+ * níveis.
+ */
+[[gnu::target("avx2")]]
+POLY_SUM_F32(poly_sum_f32_avx2, 32)
+
+/**
+ * @brief Núcleo AVX-512 da soma em precisão simples.
+ */
+[[gnu::target("avx512f")]]
+POLY_SUM_F32(poly_sum_f32_avx512, 64)
+
+/**
+ * @brief Núcleo AVX2 da soma em precisão dupla-dupla.
+ *
+ * @details Compilado sem FMA, como `poly_sum_f32_avx2()`.
+ */
+[[gnu::target("avx2")]]
+POLY_SUM_DD(poly_sum_dd_avx2, 32)
+
+/**
+ * @brief Núcleo AVX-512 da soma em precisão dupla-dupla.
+ */
+[[gnu::target("avx512f")]]
+POLY_SUM_DD(poly_sum_dd_avx512, 64)
+
+/**
+ * @brief Núcleo AVX2 de `simd_exp()`.
+ *
+ * @details Compilado sem FMA, como `poly_sum_f32_avx2()`, para que o
+ * resultado seja o mesmo do nível AVX-512.
+ */
+[[gnu::target("avx2")]]
+static void math_exp_avx2(const double *x, double *y, size_t count)
+{
+	math_map(&exp_lanes, 0, x, y, count);
+}
+
+/**
+ * @brief Núcleo AVX-512 de `simd_exp()`.
+ */
+[[gnu::target("avx512f")]]
+static void math_exp_avx512(const double *x, double *y, size_t count)
+{
+	math_map(&exp_lanes, 0, x, y, count);
+}
+
+/**
+ * @brief Núcleo AVX2 de `simd_log()`.
+ */
+[[gnu::target("avx2")]]
+static void math_log_avx2(const double *x, double *y, size_t count)
+{
+	math_map(&log_lanes, 1, x, y, count);
+}
+
+/**
+ * @brief Núcleo AVX-512 de `simd_log()`.
+ */
+[[gnu::target("avx512f")]]
+static void math_log_avx512(const double *x, double *y, size_t count)
+{
+	math_map(&log_lanes, 1, x, y, count);
+}
+
+/**
+ * @brief Núcleo AVX2 de `simd_sin()`.
+ */
+[[gnu::target("avx2")]]
+static void math_sin_avx2(const double *x, double *y, size_t count)
+{
+	math_map(&sin_lanes, 0, x, y, count);
+}
+
+/**
+ * @brief Núcleo AVX-512 de `simd_sin()`.
+ */
+[[gnu::target("avx512f")]]
+static void math_sin_avx512(const double *x, double *y, size_t count)
+{
+	math_map(&sin_lanes, 0, x, y, count);
+}
+
+/**
+ * @brief Retorna o núcleo correspondente a um nível de vetorização.
+ *
+ * @param level O nível.
+ * @return Ponteiro para o núcleo.
+ */
+static poly_kernel_t simd_poly_kernel(SimdLevel level)
+{
+	switch (level) {
+	case SIMD_AVX512:
+		return &poly_horner_avx512;
+	case SIMD_AVX2:
+		return &poly_horner_avx2;
+	case SIMD_SSE2:
+		return &poly_horner_sse2;
+	default:
+		return &poly_horner_scalar;
+	}
+}
+
+/**
+ * @brief Retorna o núcleo de soma de potências correspondente a um nível de
+ * vetorização. O nível SSE2 usa o núcleo da arquitetura base, que já o
+ * inclui.
+ *
+ * @param level O nível.
+ * @return Ponteiro para o núcleo.
+ */
+static powers_kernel_t simd_powers_kernel(SimdLevel level)
+{
+	switch (level) {
+	case SIMD_AVX512:
+		return &power_sums_avx512;
+	case SIMD_AVX2:
+		return &power_sums_avx2;
+	default:
+		return &power_sums_scalar;
+	}
+}
+
+/**
+ * @brief Retorna o núcleo de soma em precisão simples correspondente a um
+ * nível de vetorização. O nível SSE2 usa o núcleo da arquitetura base.
+ *
+ * @param level O nível.
+ * @return Ponteiro para o núcleo.
+ */
+static sum_f32_kernel_t simd_sum_f32_kernel(SimdLevel level)
+{
+	switch (level) {
+	case SIMD_AVX512:
+		return &poly_sum_f32_avx512;
+	case SIMD_AVX2:
+		return &poly_sum_f32_avx2;
+	default:
+		return &poly_sum_f32_scalar;
+	}
+}
+
+/**
+ * @brief Retorna o núcleo de soma em precisão dupla-dupla correspondente a um
+ * nível de vetorização. O nível SSE2 usa o núcleo da arquitetura base.
+ *
+ * @param level O nível.
+ * @return Ponteiro para o núcleo.
+ */
+static sum_dd_kernel_t simd_sum_dd_kernel(SimdLevel level)
+{
+	switch (level) {
+	case SIMD_AVX512:
+		return &poly_sum_dd_avx512;
+	case SIMD_AVX2:
+		return &poly_sum_dd_avx2;
+	default:
+		return &poly_sum_dd_scalar;
+	}
+}
+
+/**
+ * @brief Retorna o núcleo de uma função elementar correspondente a um nível
+ * de vetorização. Abaixo de AVX2, as lanes vetorizadas não são mais rápidas
+ * que a biblioteca padrão, que é usada.
+ *
+ * @param level O nível.
+ * @param op A função.
+ * @return Ponteiro para o núcleo.
+ */
+static math_kernel_t simd_math_kernel(SimdLevel level, MathOp op)
+{
+	static const math_kernel_t kernels[][MATH_OPS] = {
+		[SIMD_SCALAR] = { &math_exp_libm, &math_log_libm,
+				  &math_sin_libm },
+		[SIMD_SSE2] = { &math_exp_libm, &math_log_libm,
+				&math_sin_libm },
+		[SIMD_AVX2] = { &math_exp_avx2, &math_log_avx2,
+				&math_sin_avx2 },
+		[SIMD_AVX512] = { &math_exp_avx512, &math_log_avx512,
+				  &math_sin_avx512 },
+	};
+	return kernels[level][op];
+}
+#else
+// Fora de x86, não há núcleos vetorizados explícitos.
+static SimdLevel simd_detect(void)
+{
+	return SIMD_SCALAR;
+}
+
+static poly_kernel_t simd_poly_kernel(SimdLevel)
+{
+	return &poly_horner_scalar;
+}
+
+static powers_kernel_t simd_powers_kernel(SimdLevel)
+{
+	return &power_sums_scalar;
+}
+
+static sum_f32_kernel_t simd_sum_f32_kernel(SimdLevel)
+{
+	return &poly_sum_f32_scalar;
+}
+
+static sum_dd_kernel_t simd_sum_dd_kernel(SimdLevel)
+{
+	return &poly_sum_dd_scalar;
+}
+
+static math_kernel_t simd_math_kernel(SimdLevel, MathOp op)
+{
+	static const math_kernel_t kernels[MATH_OPS] = {
+		&math_exp_libm, &math_log_libm, &math_sin_libm
+	};
+	return kernels[op];
+}
+#endif
\ No newline at end of file
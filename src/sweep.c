@@ -0,0 +1,181 @@
+// SPDX-License-Identifier: ISC
+
+/**
+ * @file sweep.c
+ * @brief Implementação da varredura de somas de Riemann com reaproveitamento
+ * de avaliações.
+ *
+ * @details Este arquivo implementa `riemann_sweep()`, que calcula as somas de
+ * Riemann pela esquerda e pela direita para uma sequência de números de
+ * retângulos. Para cada grade, guarda-se apenas a soma dos valores da função
+ * nos pontos interiores; as somas pela esquerda e pela direita são obtidas
+ * acrescentando um dos extremos. Quando uma grade contém outra já calculada,
+ * a soma interior desta é reaproveitada, e somente os pontos novos são
+ * avaliados. Opcionalmente, as somas do trapézio resultantes são extrapoladas
+ * pelo método de Richardson.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "riemann.h"
+#include "func.h"
+#include "instr.h"
+#include "util.h"
+
+/**
+ * @brief Número de pontos avaliados por chamada à avaliação em lote.
+ */
+#define SWEEP_CHUNK 512
+
+// Declarações internas.
+static double sweep_sum(double a, Function *func, size_t n, double dx,
+			size_t skip);
+static void sweep_extrapolate(const size_t *ns, size_t j, double *prev,
+			      double *cur, RiemannSweep *out);
+
+// Calcula as somas de Riemann para vários valores de n.
+bool riemann_sweep(double min, double max, Function *func, const size_t *ns,
+		   size_t count, bool extrapolate, RiemannSweep *out)
+{
+	if (count == 0)
+		return true;
+
+	// Somas interiores de cada grade, e as duas últimas linhas da tabela de
+	// extrapolação.
+	double *interior = malloc(3 * count * sizeof(*interior));
+	ERRNOCHECK(interior == nullptr, "Falha ao alocar somas interiores", ret);
+	double *prev = interior + count, *cur = prev + count;
+	INSTR_BEGIN(scope, INSTR_SWEEP);
+
+	// Os extremos do intervalo são avaliados uma única vez.
+	double fa = func->eval(min, func->impl);
+	double fb = func->eval(max, func->impl);
+	INSTR_EVALS(INSTR_SWEEP, 2);
+
+	// A extrapolação exige valores positivos e estritamente crescentes.
+	for (size_t j = 0; extrapolate && j < count; ++j)
+		extrapolate = ns[j] > (j > 0 ? ns[j - 1] : 0);
+
+	for (size_t j = 0; j < count; ++j) {
+		size_t n = ns[j];
+		double dx = (max - min) / n;
+
+		out[j] = (RiemannSweep){ n, NAN, NAN, NAN };
+		if (n == 0)
+			continue;
+
+		// Procura a maior grade já calculada contida nesta.
+		size_t best = count;
+		for (size_t p = 0; p < j; ++p)
+			if (ns[p] > 0 && n % ns[p] == 0 &&
+			    (best == count || ns[p] > ns[best]))
+				best = p;
+
+		// Soma os pontos novos e, se houver, a grade reaproveitada.
+		if (best == count)
+			interior[j] = sweep_sum(min, func, n, dx, 0);
+		else if (ns[best] == n)
+			interior[j] = interior[best];
+		else
+			interior[j] = sweep_sum(min, func, n, dx, n / ns[best]) +
+				      interior[best];
+
+		out[j].esquerda = (fa + interior[j]) * dx;
+		out[j].direita = (interior[j] + fb) * dx;
+
+		if (extrapolate) {
+			cur[0] = (0.5 * fa + interior[j] + 0.5 * fb) * dx;
+			sweep_extrapolate(ns, j, prev, cur, out);
+			double *tmp = prev;
+			prev = cur;
+			cur = tmp;
+		}
+	}
+
+	free(interior);
+	INSTR_END(scope);
+	return true;
+
+ret:
+	return false;
+}
+
+/**
+ * @brief Soma os valores de uma função nos pontos interiores de uma grade,
+ * opcionalmente pulando os de uma grade contida nela.
+ *
+ * @details Soma \f$f(a + i \Delta x)\f$ para \f$i\f$ entre 1 e \f$n - 1\f$,
+ * exceto os múltiplos de `skip` (se `skip` for maior que 1). Os pontos são
+ * avaliados em blocos, com a avaliação em lote se disponível, e as somas dos
+ * blocos são acumuladas com compensação de Neumaier.
+ *
+ * @param a Limite inferior da integração.
+ * @param func Ponteiro para a função.
+ * @param n Número de retângulos da grade.
+ * @param dx Largura de cada retângulo.
+ * @param skip Razão entre esta grade e a contida nela, ou 0 se não houver.
+ * @return A soma dos valores nos pontos novos.
+ */
+static double sweep_sum(double a, Function *func, size_t n, double dx,
+			size_t skip)
+{
+	double x[SWEEP_CHUNK], y[SWEEP_CHUNK];
+	double sum = 0, comp = 0;
+	size_t len = 0;
+
+	for (size_t i = 1; i <= n; ++i) {
+		// Acumula o ponto, se for novo.
+		if (i < n && (skip < 2 || i % skip != 0))
+			x[len++] = a + i * dx;
+
+		// Se o bloco encheu, ou se acabaram os pontos, avalia-o.
+		if (len == SWEEP_CHUNK || (i == n && len > 0)) {
+			double block = 0;
+			INSTR_EVALS(INSTR_SWEEP, len);
+			if (func->eval_batch != nullptr) {
+				func->eval_batch(x, y, len, func->impl);
+				for (size_t k = 0; k < len; ++k)
+					block += y[k];
+			} else {
+				for (size_t k = 0; k < len; ++k)
+					block += func->eval(x[k], func->impl);
+			}
+
+			neumaier_add(&sum, &comp, block);
+			len = 0;
+		}
+	}
+
+	return sum + comp;
+}
+
+/**
+ * @brief Calcula uma linha da tabela de extrapolação de Richardson.
+ *
+ * @details Usa o esquema de Neville em \f$h^2\f$: com \f$h_j = 1 / n_j\f$,
+ * \f[
+ * R_{j,k} = R_{j,k-1} + \frac{R_{j,k-1} - R_{j-1,k-1}}
+ * {(n_j / n_{j-k})^2 - 1},
+ * \f]
+ * que elimina um termo par do erro da regra do trapézio a cada coluna. A
+ * estimativa da linha \f$j\f$ é \f$R_{j,j}\f$.
+ *
+ * @param ns Números de retângulos da varredura.
+ * @param j Índice da linha a calcular.
+ * @param prev Linha \f$j - 1\f$ da tabela.
+ * @param cur Linha \f$j\f$ da tabela, com \f$R_{j,0}\f$ já preenchido.
+ * @param out Arranjo de resultados, onde a estimativa é escrita.
+ */
+static void sweep_extrapolate(const size_t *ns, size_t j, double *prev,
+			      double *cur, RiemannSweep *out)
+{
+	for (size_t k = 1; k <= j; ++k) {
+		double ratio = (double)ns[j] / ns[j - k];
+		cur[k] = cur[k - 1] +
+			 (cur[k - 1] - prev[k - 1]) / (ratio * ratio - 1);
+	}
+
+	out[j].romberg = cur[j];
+}
\ No newline at end of file
@@ -0,0 +1,433 @@
+// SPDX-License-Identifier: ISC
+
+/**
+ * @file tabulated.c
+ * @brief Implementação das funções tabeladas.
+ *
+ * @details O arquivo é mapeado inteiro, somente para leitura, e as amostras
+ * são lidas diretamente do mapeamento, sem cópia. A avaliação localiza o
+ * intervalo \f$[x_i, x_{i+1}]\f$ que contém o ponto e interpola entre as
+ * amostras dos seus extremos. A cúbica de Hermite usa as derivadas
+ * \f$m_i = (y_{i+1} - y_{i-1}) / (x_{i+1} - x_{i-1})\f$ nas amostras
+ * interiores, e as diferenças unilaterais nas duas extremas.
+ */
+
+#define _GNU_SOURCE
+
+#include <fcntl.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "tabulated.h"
+#include "util.h"
+
+/**
+ * @brief Identificação de um arquivo de amostras.
+ */
+static const char tabulated_magic[8] = { 'R', 'I', 'E', 'M',
+					 'T', 'A', 'B', 'L' };
+
+/**
+ * @brief Estrutura que define uma função tabelada.
+ */
+struct Tabulated {
+	void *base; /**< Início do mapeamento. */
+	size_t size; /**< Tamanho do mapeamento, em bytes. */
+	const double *data; /**< As amostras, logo após o cabeçalho. */
+	size_t count; /**< Número de amostras. */
+	TabulatedLayout layout; /**< Leiaute das amostras. */
+	TabulatedInterp interp; /**< Método de interpolação. */
+	double x0; /**< Primeira abscissa, no leiaute uniforme. */
+	double dx; /**< Espaçamento, no leiaute uniforme. */
+	double min; /**< Primeira abscissa. */
+	double max; /**< Última abscissa. */
+};
+
+// Declarações internas.
+static bool tabulated_map(Tabulated *tab, const char *path);
+static bool tabulated_increasing(const Tabulated *tab);
+static double tabulated_x(const Tabulated *tab, size_t i);
+static double tabulated_y(const Tabulated *tab, size_t i);
+static double tabulated_slope(const Tabulated *tab, size_t i);
+static size_t tabulated_locate(const Tabulated *tab, double x, size_t hint);
+static double tabulated_interp(const Tabulated *tab, double x, size_t i);
+
+// Mapeia e valida um arquivo de amostras.
+[[nodiscard("Ignorar retorno pode causar vazamento de memória")]]
+Tabulated *tabulated_open(const char *path, TabulatedInterp interp)
+{
+	errno = EINVAL;
+	ERRNOCHECK(interp != TABULATED_LINEAR && interp != TABULATED_CUBIC,
+		   "Método de interpolação inexistente", ret);
+
+	Tabulated *tab = malloc(sizeof(*tab));
+	ERRNOCHECK(tab == nullptr, "Falha ao alocar função tabelada", ret);
+	if (!tabulated_map(tab, path))
+		goto free_tab;
+
+	// A busca binária e a interpolação supõem abscissas crescentes.
+	errno = EINVAL;
+	ERRNOCHECK(!tabulated_increasing(tab), "Abscissas não crescentes",
+		   unmap);
+
+	tab->interp = interp;
+	return tab;
+
+unmap:
+	munmap(tab->base, tab->size);
+free_tab:
+	free(tab);
+ret:
+	return nullptr;
+}
+
+// Desfaz o mapeamento e libera uma função tabelada.
+void tabulated_free(Tabulated *tab)
+{
+	munmap(tab->base, tab->size);
+	free(tab);
+}
+
+// Avalia uma função tabelada em um ponto.
+double tabulated_eval(double x, Tabulated *tab)
+{
+	if (isnan(x))
+		return x;
+	return tabulated_interp(tab, x, tabulated_locate(tab, x, 0));
+}
+
+// Avalia uma função tabelada em vários pontos.
+void tabulated_eval_batch(const double *x, double *y, size_t count,
+			  Tabulated *tab)
+{
+	size_t i = 0;
+
+	for (size_t j = 0; j < count; ++j) {
+		if (isnan(x[j])) {
+			y[j] = x[j];
+			continue;
+		}
+		i = tabulated_locate(tab, x[j], i);
+		y[j] = tabulated_interp(tab, x[j], i);
+	}
+}
+
+// Retorna o intervalo coberto pelas amostras.
+void tabulated_domain(const Tabulated *tab, double *min, double *max)
+{
+	*min = tab->min;
+	*max = tab->max;
+}
+
+// Grava amostras num arquivo.
+bool tabulated_save(const char *path, TabulatedLayout layout, double x0,
+		    double dx, const double *data, size_t count)
+{
+	size_t width = layout == TABULATED_PAIRS ? 2 : 1;
+	TabulatedHeader h = {
+		.version = TABULATED_VERSION,
+		.byte_order = TABULATED_BYTE_ORDER,
+		.header_size = sizeof(TabulatedHeader),
+		.layout = layout,
+		.count = count,
+		.x0 = layout == TABULATED_UNIFORM ? x0 : 0,
+		.dx = layout == TABULATED_UNIFORM ? dx : 0,
+	};
+	memcpy(h.magic, tabulated_magic, sizeof(tabulated_magic));
+
+	FILE *out = fopen(path, "wb");
+	ERRNOCHECK(out == nullptr, path, ret);
+	ERRNOCHECK(fwrite(&h, sizeof(h), 1, out) != 1,
+		   "Falha ao gravar as amostras", close_out);
+	ERRNOCHECK(fwrite(data, width * sizeof(*data), count, out) != count,
+		   "Falha ao gravar as amostras", close_out);
+	ERRNOCHECK(fclose(out) != 0, "Falha ao gravar as amostras", ret);
+	return true;
+
+close_out:
+	fclose(out);
+ret:
+	return false;
+}
+
+// Integra a interpolação de um arquivo de amostras numa passada sequencial.
+bool tabulated_integrate(const char *path, TabulatedInterp interp,
+			 double *out)
+{
+	Tabulated tab;
+
+	if (!tabulated_map(&tab, path))
+		return false;
+	tab.interp = interp;
+
+	// O mapeamento é percorrido uma vez, do início ao fim.
+	unsigned char *base = tab.base;
+	madvise(base, tab.size, MADV_SEQUENTIAL);
+
+	size_t width = tab.layout == TABULATED_PAIRS ? 2 : 1;
+	size_t per_window = TABULATED_WINDOW / (width * sizeof(double));
+	double sum = 0, comp = 0;
+	double m_prev = 0;
+
+	if (interp == TABULATED_CUBIC)
+		m_prev = tabulated_slope(&tab, 0);
+
+	for (size_t first = 0, w = 0; first < tab.count - 1;
+	     first += per_window, ++w) {
+		size_t last = tab.count - 1 - first < per_window ?
+				      tab.count - 1 :
+				      first + per_window;
+
+		// As amostras da janela w ocupam o fim da janela w do
+		// mapeamento (que é alinhado à página) e o início da w + 1,
+		// pois o cabeçalho as desloca. Antecipa a leitura da w + 1 e
+		// descarta a w - 1, cujas amostras não são mais lidas nem como
+		// vizinhas.
+		size_t next = (w + 1) * TABULATED_WINDOW;
+		if (next < tab.size)
+			madvise(base + next,
+				tab.size - next < TABULATED_WINDOW ?
+					tab.size - next :
+					TABULATED_WINDOW,
+				MADV_WILLNEED);
+		if (w >= 1)
+			madvise(base + (w - 1) * TABULATED_WINDOW,
+				TABULATED_WINDOW, MADV_DONTNEED);
+
+		for (size_t i = first; i < last; ++i) {
+			double h = tabulated_x(&tab, i + 1) -
+				   tabulated_x(&tab, i);
+			double y0 = tabulated_y(&tab, i);
+			double y1 = tabulated_y(&tab, i + 1);
+
+			errno = EINVAL;
+			ERRNOCHECK(!(h > 0), "Abscissas não crescentes", unmap);
+
+			// A integral da cúbica de Hermite no intervalo é a do
+			// trapézio mais h²(m_i - m_{i+1})/12.
+			neumaier_add(&sum, &comp, h * (y0 + y1) / 2);
+			if (interp == TABULATED_CUBIC) {
+				double m = tabulated_slope(&tab, i + 1);
+				neumaier_add(&sum, &comp,
+					     h * h * (m_prev - m) / 12);
+				m_prev = m;
+			}
+		}
+	}
+
+	munmap(tab.base, tab.size);
+	*out = sum + comp;
+	return true;
+
+unmap:
+	munmap(tab.base, tab.size);
+	return false;
+}
+
+/**
+ * @brief Mapeia um arquivo de amostras e valida o seu cabeçalho.
+ *
+ * @param tab Ponteiro para a função tabelada a preencher (exceto `interp`).
+ * @param path O caminho do arquivo.
+ * @return `true` em caso de sucesso, `false` caso contrário (sem deixar nada
+ * mapeado).
+ */
+static bool tabulated_map(Tabulated *tab, const char *path)
+{
+	struct stat st;
+
+	int fd = open(path, O_RDONLY);
+	ERRNOCHECK(fd < 0, path, ret);
+	ERRNOCHECK(fstat(fd, &st) != 0, path, close_fd);
+
+	errno = EINVAL;
+	ERRNOCHECK((uintmax_t)st.st_size < sizeof(TabulatedHeader) ||
+			   (uintmax_t)st.st_size > SIZE_MAX,
+		   "Tamanho inválido do arquivo de amostras", close_fd);
+	tab->size = st.st_size;
+	tab->base = mmap(nullptr, tab->size, PROT_READ, MAP_SHARED, fd, 0);
+	ERRNOCHECK(tab->base == MAP_FAILED, "Falha ao mapear as amostras",
+		   close_fd);
+
+	// Verifica o cabeçalho e se as amostras cabem no arquivo.
+	const TabulatedHeader *h = tab->base;
+	size_t width = h->layout == TABULATED_PAIRS ? 2 : 1;
+	size_t entries = (tab->size - sizeof(TabulatedHeader)) /
+			 (width * sizeof(double));
+	errno = EINVAL;
+	ERRNOCHECK(memcmp(h->magic, tabulated_magic,
+			  sizeof(tabulated_magic)) != 0 ||
+			   h->version != TABULATED_VERSION ||
+			   h->byte_order != TABULATED_BYTE_ORDER ||
+			   h->header_size != sizeof(TabulatedHeader) ||
+			   (h->layout != TABULATED_PAIRS &&
+			    h->layout != TABULATED_UNIFORM),
+		   "Formato inválido do arquivo de amostras", unmap);
+	ERRNOCHECK(h->count < 2 || h->count > entries,
+		   "Arquivo de amostras truncado", unmap);
+	ERRNOCHECK(h->layout == TABULATED_UNIFORM &&
+			   !(isfinite(h->x0) && isfinite(h->dx) && h->dx > 0),
+		   "Espaçamento inválido no arquivo de amostras", unmap);
+
+	tab->data = (const double *)(h + 1);
+	tab->count = h->count;
+	tab->layout = h->layout;
+	tab->x0 = h->x0;
+	tab->dx = h->dx;
+	tab->min = tabulated_x(tab, 0);
+	tab->max = tabulated_x(tab, tab->count - 1);
+	close(fd);
+	return true;
+
+unmap:
+	munmap(tab->base, tab->size);
+close_fd:
+	close(fd);
+ret:
+	return false;
+}
+
+/**
+ * @brief Verifica se as abscissas das amostras são estritamente crescentes.
+ *
+ * @details No leiaute uniforme, isso decorre de \f$\Delta x > 0\f$, já
+ * verificado por `tabulated_map()`. No de pares, percorre todas as amostras.
+ *
+ * @param tab Ponteiro para a função tabelada.
+ * @return `true` se forem crescentes, `false` caso contrário (ou se alguma
+ * for `NAN`).
+ */
+static bool tabulated_increasing(const Tabulated *tab)
+{
+	if (tab->layout == TABULATED_UNIFORM)
+		return true;
+
+	for (size_t i = 0; i < tab->count - 1; ++i)
+		if (!(tab->data[2 * i + 2] > tab->data[2 * i]))
+			return false;
+	return true;
+}
+
+/**
+ * @brief Retorna a abscissa de uma amostra.
+ *
+ * @param tab Ponteiro para a função tabelada.
+ * @param i O índice da amostra.
+ * @return \f$x_i\f$.
+ */
+static double tabulated_x(const Tabulated *tab, size_t i)
+{
+	if (tab->layout == TABULATED_UNIFORM)
+		return tab->x0 + i * tab->dx;
+	return tab->data[2 * i];
+}
+
+/**
+ * @brief Retorna a ordenada de uma amostra.
+ *
+ * @param tab Ponteiro para a função tabelada.
+ * @param i O índice da amostra.
+ * @return \f$y_i\f$.
+ */
+static double tabulated_y(const Tabulated *tab, size_t i)
+{
+	if (tab->layout == TABULATED_UNIFORM)
+		return tab->data[i];
+	return tab->data[2 * i + 1];
+}
+
+/**
+ * @brief Estima a derivada numa amostra, para a cúbica de Hermite.
+ *
+ * @param tab Ponteiro para a função tabelada.
+ * @param i O índice da amostra.
+ * @return A diferença centrada em \f$x_i\f$, ou a unilateral nos extremos.
+ */
+static double tabulated_slope(const Tabulated *tab, size_t i)
+{
+	size_t lo = i > 0 ? i - 1 : 0;
+	size_t hi = i < tab->count - 1 ? i + 1 : i;
+
+	return (tabulated_y(tab, hi) - tabulated_y(tab, lo)) /
+	       (tabulated_x(tab, hi) - tabulated_x(tab, lo));
+}
+
+/**
+ * @brief Localiza o intervalo entre amostras que contém um ponto.
+ *
+ * @details No leiaute uniforme, o índice sai diretamente da abscissa. No de
+ * pares, testa primeiro o intervalo `hint` e o seguinte, e só então faz uma
+ * busca binária. Pontos fora do domínio caem no primeiro ou no último
+ * intervalo.
+ *
+ * @param tab Ponteiro para a função tabelada.
+ * @param x O ponto, que não pode ser `NAN`.
+ * @param hint Um palpite para o intervalo (o do ponto anterior, por exemplo).
+ * @return O índice \f$i \le n - 2\f$ tal que \f$x_i \le x \le x_{i+1}\f$.
+ */
+static size_t tabulated_locate(const Tabulated *tab, double x, size_t hint)
+{
+	size_t last = tab->count - 2;
+
+	if (x <= tab->min)
+		return 0;
+	if (x >= tab->max)
+		return last;
+
+	if (tab->layout == TABULATED_UNIFORM) {
+		size_t i = (size_t)((x - tab->x0) / tab->dx);
+		return i < last ? i : last;
+	}
+
+	const double *d = tab->data;
+	if (hint <= last && d[2 * hint] <= x) {
+		if (x <= d[2 * hint + 2])
+			return hint;
+		if (hint < last && x <= d[2 * hint + 4])
+			return hint + 1;
+	}
+
+	// Busca o último x_i <= x, com x_0 <= x < x_{n-1}.
+	size_t lo = 0, hi = last;
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo + 1) / 2;
+		if (d[2 * mid] <= x)
+			lo = mid;
+		else
+			hi = mid - 1;
+	}
+	return lo;
+}
+
+/**
+ * @brief Interpola a função num ponto de um intervalo.
+ *
+ * @param tab Ponteiro para a função tabelada.
+ * @param x O ponto, que é limitado ao domínio.
+ * @param i O índice do intervalo que contém `x` (ver `tabulated_locate()`).
+ * @return O valor interpolado.
+ */
+static double tabulated_interp(const Tabulated *tab, double x, size_t i)
+{
+	double x0 = tabulated_x(tab, i), x1 = tabulated_x(tab, i + 1);
+	double y0 = tabulated_y(tab, i), y1 = tabulated_y(tab, i + 1);
+	double h = x1 - x0;
+	double t = (x - x0) / h;
+
+	t = t < 0 ? 0 : t > 1 ? 1 : t;
+	if (tab->interp == TABULATED_LINEAR)
+		return y0 + t * (y1 - y0);
+
+	// Bases de Hermite: h00 = 2t³ - 3t² + 1, h10 = t³ - 2t² + t,
+	// h01 = -2t³ + 3t², h11 = t³ - t².
+	double m0 = tabulated_slope(tab, i), m1 = tabulated_slope(tab, i + 1);
+	double t2 = t * t, t3 = t2 * t;
+	return (2 * t3 - 3 * t2 + 1) * y0 + (t3 - 2 * t2 + t) * h * m0 +
+	       (3 * t2 - 2 * t3) * y1 + (t3 - t2) * h * m1;
+}
\ No newline at end of file
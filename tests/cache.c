@@ -0,0 +1,188 @@
+// SPDX-License-Identifier: ISC
+
+/**
+ * @file cache.c
+ * @brief Verifica a chave canônica e a substituição do cache de resultados.
+ *
+ * @details Confere que um polinômio com coeficientes nulos à direita, ou na
+ * representação esparsa, tem a mesma chave que o denso equivalente, e que
+ * coeficientes, limites, número de retângulos, tipo de soma e opções mudam
+ * a chave. Depois, insere num cache pequeno muito mais chaves que a sua
+ * capacidade, consultando-as para exercitar a segunda chance do CLOCK, e
+ * verifica a cada três inserções que as chaves encontradas são exatamente
+ * as contadas pelo cache, com os seus valores: a remoção pelo algoritmo R
+ * não pode deixar chaves inalcançáveis na tabela de índices. Termina com
+ * erro se alguma verificação falhar.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cache.h"
+#include "func.h"
+#include "riemann.h"
+
+/**
+ * @brief Capacidade do cache pequeno, alguns registros por parte.
+ */
+#define TEST_CAPACITY (4 * CACHE_SHARDS)
+
+/**
+ * @brief Número de chaves distintas inseridas no cache pequeno.
+ */
+#define TEST_KEYS (16 * TEST_CAPACITY)
+
+/**
+ * @brief Confere se duas funções têm a mesma chave, com as mesmas opções.
+ *
+ * @param name O nome do caso.
+ * @param a A primeira função.
+ * @param b A segunda função.
+ * @param equal Se as chaves devem ser iguais.
+ * @return `true` se o resultado for o esperado.
+ */
+static bool test_key(const char *name, const Function *a, const Function *b,
+		     bool equal)
+{
+	RiemannOptions opts = { 0 };
+	CacheKey ka, kb;
+	bool ok = cache_key(&ka, a, 0, 1, 1000, MEIO, &opts) &&
+		  cache_key(&kb, b, 0, 1, 1000, MEIO, &opts) &&
+		  (memcmp(&ka, &kb, sizeof(ka)) == 0) == equal;
+
+	printf("%-14s %s\n", name, ok ? "ok" : "FALHOU");
+	return ok;
+}
+
+/**
+ * @brief Confere que uma mudança nos demais campos muda a chave.
+ *
+ * @param func A função.
+ * @return `true` se todas as chaves forem distintas da original.
+ */
+static bool test_fields(const Function *func)
+{
+	RiemannOptions opts = { 0 };
+	RiemannOptions brute = { .brute_force = true };
+	RiemannOptions dd = { .precision = RIEMANN_DOUBLE_DOUBLE };
+	CacheKey base, keys[6];
+
+	cache_key(&base, func, 0, 1, 1000, MEIO, &opts);
+	cache_key(&keys[0], func, -0.0, 1, 1000, MEIO, &opts);
+	cache_key(&keys[1], func, 0, 2, 1000, MEIO, &opts);
+	cache_key(&keys[2], func, 0, 1, 1001, MEIO, &opts);
+	cache_key(&keys[3], func, 0, 1, 1000, DIREITA, &opts);
+	cache_key(&keys[4], func, 0, 1, 1000, MEIO, &brute);
+	cache_key(&keys[5], func, 0, 1, 1000, MEIO, &dd);
+
+	bool ok = true;
+	for (size_t i = 0; i < sizeof(keys) / sizeof(*keys); ++i)
+		ok &= memcmp(&base, &keys[i], sizeof(base)) != 0;
+
+	printf("%-14s %s\n", "campos", ok ? "ok" : "FALHOU");
+	return ok;
+}
+
+/**
+ * @brief Enche um cache pequeno e confere a sua consistência.
+ *
+ * @details A chave de índice \f$i\f$ difere somente no número de
+ * retângulos, \f$i + 1\f$, que é também o valor inserido. Cada chave é
+ * consultada logo após a inserção, e todas são consultadas a cada três
+ * inserções, de modo que o CLOCK encontra bits de referência ligados e dá a
+ * segunda chance antes de descartar.
+ *
+ * @param func A função das chaves.
+ * @return `true` se o cache se mantiver consistente.
+ */
+static bool test_clock(const Function *func)
+{
+	RiemannOptions opts = { 0 };
+	CacheStats stats;
+	CacheKey key;
+	double value;
+	bool ok = true;
+
+	ResultCache *cache = cache_new(TEST_CAPACITY);
+	if (cache == nullptr)
+		return false;
+
+	for (size_t i = 0; i < TEST_KEYS && ok; ++i) {
+		cache_key(&key, func, 0, 1, i + 1, MEIO, &opts);
+		cache_insert(cache, &key, (double)(i + 1));
+		ok &= cache_lookup(cache, &key, &value) && value == i + 1;
+		if (i % 3 != 0)
+			continue;
+
+		// Todas as chaves ainda no cache devem ser encontradas, com o
+		// seu valor, e nenhuma além das contadas.
+		cache_stats(cache, &stats);
+		size_t found = 0;
+		for (size_t j = 0; j <= i; ++j) {
+			cache_key(&key, func, 0, 1, j + 1, MEIO, &opts);
+			if (!cache_lookup(cache, &key, &value))
+				continue;
+			++found;
+			ok &= value == j + 1;
+		}
+		ok &= found == stats.size && stats.size <= stats.capacity &&
+		      stats.insertions == i + 1 &&
+		      stats.evictions == stats.insertions - stats.size;
+	}
+
+	cache_stats(cache, &stats);
+	ok &= stats.size == stats.capacity;
+	printf("%-14s %zu de %zu, %llu descartes %s\n", "clock", stats.size,
+	       (size_t)TEST_KEYS, (unsigned long long)stats.evictions,
+	       ok ? "ok" : "FALHOU");
+	cache_free(cache);
+	return ok;
+}
+
+/**
+ * @brief Função principal do teste.
+ *
+ * @return EXIT_SUCCESS se todas as verificações passarem, EXIT_FAILURE caso
+ * contrário.
+ */
+int main(void)
+{
+	double coeffs[FUNCTION_SPARSE_MIN_DEGREE + 1] = { 1, 2, 0, 3 };
+	FunctionView view;
+	bool ok = true;
+
+	// 1 + 2x + 3x³, com e sem coeficientes nulos à direita.
+	Function *dense = function_new(POLYNOMIAL, (size_t)3, coeffs);
+	Function *padded = function_new(POLYNOMIAL, (size_t)8, coeffs);
+	coeffs[3] = 4;
+	Function *other = function_new(POLYNOMIAL, (size_t)3, coeffs);
+
+	// 1 + 5x⁶⁴, esparso pelo `function_new()`, e denso pela visão.
+	coeffs[1] = coeffs[3] = 0;
+	coeffs[FUNCTION_SPARSE_MIN_DEGREE] = 5;
+	Function *sparse = function_new(POLYNOMIAL,
+					(size_t)FUNCTION_SPARSE_MIN_DEGREE,
+					coeffs);
+	Function *full = function_view_init(&view, FUNCTION_SPARSE_MIN_DEGREE,
+					    coeffs);
+
+	if (dense == nullptr || padded == nullptr || other == nullptr ||
+	    sparse == nullptr)
+		return EXIT_FAILURE;
+
+	ok &= test_key("zeros", dense, padded, true);
+	ok &= test_key("esparso", sparse, full, true);
+	ok &= function_polynomial(sparse, &(size_t){ 0 }) == nullptr;
+	ok &= test_key("coeficientes", dense, other, false);
+	ok &= test_fields(dense);
+	ok &= test_clock(dense);
+
+	function_free(sparse);
+	function_free(other);
+	function_free(padded);
+	function_free(dense);
+
+	puts(ok ? "ok" : "FALHOU");
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
\ No newline at end of file
@@ -0,0 +1,225 @@
+// SPDX-License-Identifier: ISC
+
+/**
+ * @file expr.c
+ * @brief Verifica o analisador e a máquina virtual de expressões.
+ *
+ * @details Compara expressões que exercitam a precedência, a associatividade
+ * à direita de `^`, o menos unário e expoentes negativos com os valores
+ * calculados diretamente em C, verifica que a avaliação em lote coincide
+ * com a avaliação num ponto (inclusive no bloco incompleto do fim e com
+ * mais registradores que os da pilha), e que expressões malformadas ou com
+ * registradores demais são recusadas. Termina com erro se alguma
+ * verificação falhar.
+ */
+
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "expr.h"
+#include "func.h"
+
+/**
+ * @brief Número de pontos da avaliação em lote, que não é múltiplo de
+ * `EXPR_BLOCK`.
+ */
+#define TEST_COUNT (2 * EXPR_BLOCK + 45)
+
+/**
+ * @brief As expressões verificadas, na ordem de `test_reference()`.
+ */
+static const char *const cases[] = {
+	"1 + 2*3 - x/4", "2*3^2*x", "2^3^2 + x", "(2^3)^2 + x",
+	"1 - 2 - x - 8/4/2", "-x^2", "(-x)^2", "x^-1", "2^-x^2",
+	"x*-3 - -x", "sin(x)*exp(-x^2)+3",
+};
+
+/**
+ * @brief Calcula diretamente o valor esperado de uma expressão.
+ *
+ * @param index O índice da expressão em `cases`.
+ * @param x O ponto.
+ * @return O valor esperado.
+ */
+static double test_reference(size_t index, double x)
+{
+	switch (index) {
+	case 0: // Precedência de `*` e `/` sobre `+` e `-`.
+		return 1 + 2 * 3 - x / 4;
+	case 1: // `^` antes de `*`.
+		return 2 * pow(3, 2) * x;
+	case 2: // `^` é associativo à direita.
+		return pow(2, pow(3, 2)) + x;
+	case 3:
+		return pow(pow(2, 3), 2) + x;
+	case 4: // `-` e `/` são associativos à esquerda.
+		return 1 - 2 - x - 8 / 4.0 / 2;
+	case 5: // O menos unário vem depois de `^`.
+		return -(x * x);
+	case 6:
+		return (-x) * (-x);
+	case 7: // Expoente negativo, sem parênteses.
+		return 1 / x;
+	case 8:
+		return pow(2, -(x * x));
+	case 9:
+		return x * -3 - -x;
+	default:
+		return sin(x) * exp(-(x * x)) + 3;
+	}
+}
+
+/**
+ * @brief Expressões que devem ser recusadas.
+ */
+static const char *const invalid[] = { "", "x+", "(x", "2**x", "x 2" };
+
+/**
+ * @brief Verifica que dois valores são iguais, ou ambos `NaN`.
+ *
+ * @param a O primeiro valor.
+ * @param b O segundo valor.
+ * @return `true` se forem iguais.
+ */
+static bool test_same(double a, double b)
+{
+	return a == b || (isnan(a) && isnan(b));
+}
+
+/**
+ * @brief Verifica uma expressão nos pontos de amostra e em lote.
+ *
+ * @param index O índice da expressão em `cases`.
+ * @return `true` se todas as verificações passarem.
+ */
+static bool test_case(size_t index)
+{
+	const char *src = cases[index];
+	static const double points[] = { -2.5, -1, -0.5, 0.25, 1, 3 };
+	double x[TEST_COUNT], y[TEST_COUNT];
+	bool ok = true;
+
+	Expression *expr = expression_new(src);
+	if (expr == nullptr) {
+		fprintf(stderr, "FALHOU: \"%s\" foi recusada\n", src);
+		return false;
+	}
+
+	for (size_t i = 0; i < sizeof(points) / sizeof(*points); ++i) {
+		double v = expression_eval(points[i], expr);
+		double ref = test_reference(index, points[i]);
+		if (fabs(v - ref) <= 4 * DBL_EPSILON * fabs(ref))
+			continue;
+		fprintf(stderr, "FALHOU: \"%s\" em x = %g: %.17g, esperado "
+				"%.17g\n",
+			src, points[i], v, ref);
+		ok = false;
+	}
+
+	// O lote passa por zero, onde x^-1 não é finito.
+	for (size_t i = 0; i < TEST_COUNT; ++i)
+		x[i] = -3 + 6.0 * i / (TEST_COUNT - 1);
+	x[TEST_COUNT / 3] = 0;
+	expression_eval_batch(x, y, TEST_COUNT, expr);
+	for (size_t i = 0; i < TEST_COUNT; ++i) {
+		double v = expression_eval(x[i], expr);
+		if (test_same(y[i], v))
+			continue;
+		fprintf(stderr, "FALHOU: \"%s\" em x = %g: lote %.17g, ponto "
+				"%.17g\n",
+			src, x[i], y[i], v);
+		ok = false;
+		break;
+	}
+
+	expression_free(expr);
+	printf("%-22s %s\n", src, ok ? "ok" : "FALHOU");
+	return ok;
+}
+
+/**
+ * @brief Verifica o produto \f$\prod_{i=1}^{n} (x + i)\f$, escrito de modo
+ * que todos os fatores fiquem vivos ao mesmo tempo, com um registrador cada.
+ *
+ * @param terms O número de fatores.
+ * @return `true` se a expressão for aceita e avaliada corretamente, ou
+ * recusada, conforme precise ou não de mais de `EXPR_MAX_REGS`
+ * registradores.
+ */
+static bool test_product(size_t terms)
+{
+	static char src[16 * (EXPR_MAX_REGS + 16)];
+	double x[TEST_COUNT], y[TEST_COUNT];
+	size_t len = 0;
+	bool ok = true;
+
+	for (size_t i = 1; i <= terms; ++i)
+		len += snprintf(src + len, sizeof(src) - len, "%s(x+%zu)",
+				i > 1 ? "*(" : "", i);
+	for (size_t i = 1; i < terms; ++i)
+		len += snprintf(src + len, sizeof(src) - len, ")");
+
+	Expression *expr = expression_new(src);
+	if (expr == nullptr) {
+		ok = terms > EXPR_MAX_REGS;
+		printf("produto de %-10zu %s\n", terms,
+		       ok ? "recusado" : "FALHOU");
+		return ok;
+	}
+
+	for (size_t i = 0; i < TEST_COUNT; ++i)
+		x[i] = -1 + 2.0 * i / (TEST_COUNT - 1);
+	expression_eval_batch(x, y, TEST_COUNT, expr);
+	for (size_t i = 0; i < TEST_COUNT && ok; ++i) {
+		double ref = 1;
+		for (size_t j = terms; j >= 1; --j)
+			ref *= x[i] + j;
+		ok = test_same(y[i], expression_eval(x[i], expr)) &&
+		     fabs(y[i] - ref) <= 4 * terms * DBL_EPSILON * fabs(ref);
+	}
+	ok &= terms <= EXPR_MAX_REGS;
+
+	expression_free(expr);
+	printf("produto de %-10zu %s\n", terms, ok ? "ok" : "FALHOU");
+	return ok;
+}
+
+/**
+ * @brief Função principal do teste.
+ *
+ * @return EXIT_SUCCESS se todas as verificações passarem, EXIT_FAILURE caso
+ * contrário.
+ */
+int main(void)
+{
+	bool ok = true;
+
+	for (size_t i = 0; i < sizeof(cases) / sizeof(*cases); ++i)
+		ok &= test_case(i);
+	ok &= test_product(3 * EXPR_BLOCK / 16);
+
+	// As mensagens de erro abaixo são esperadas, uma por expressão.
+	for (size_t i = 0; i < sizeof(invalid) / sizeof(*invalid); ++i) {
+		Expression *expr = expression_new(invalid[i]);
+		if (expr == nullptr)
+			continue;
+		fprintf(stderr, "FALHOU: \"%s\" foi aceita\n", invalid[i]);
+		expression_free(expr);
+		ok = false;
+	}
+
+	ok &= test_product(EXPR_MAX_REGS + 8);
+
+	Function *f = function_new(EXPRESSION, "x+");
+	if (f != nullptr) {
+		fprintf(stderr, "FALHOU: function_new aceitou \"x+\"\n");
+		function_free(f);
+		ok = false;
+	}
+
+	puts(ok ? "ok" : "FALHOU");
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
\ No newline at end of file
@@ -0,0 +1,156 @@
+// SPDX-License-Identifier: ISC
+
+/**
+ * @file index.c
+ * @brief Verifica o índice de somas prefixadas e a sua gravação.
+ *
+ * @details Constrói o índice de uma função positiva numa grade de passo
+ * \f$2^{-10}\f$, em que os pontos são exatos, e compara consultas alinhadas
+ * à grade, pela esquerda e pela direita, com a soma ponto a ponto em
+ * dupla-dupla sobre o mesmo subintervalo. Verifica também o sinal trocado
+ * de \f$a > b\f$, o subintervalo vazio e as consultas recusadas. Por fim,
+ * grava o índice num arquivo temporário, mapeia-o com `index_open()` e
+ * verifica que o cabeçalho e as consultas são idênticos. Termina com erro
+ * se alguma verificação falhar.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "func.h"
+#include "index.h"
+#include "riemann.h"
+
+/**
+ * @brief Número de retângulos da grade, sobre \f$[0, 4]\f$.
+ */
+#define TEST_N 4096
+
+/**
+ * @brief Passo da grade, \f$2^{-10}\f$.
+ */
+#define TEST_DX (4.0 / TEST_N)
+
+/**
+ * @brief Maior diferença aceita para a soma ponto a ponto, em ulps do
+ * resultado.
+ */
+#define TEST_ULPS 4
+
+/**
+ * @brief Subintervalos consultados, em retângulos da grade.
+ */
+static const size_t queries[][2] = {
+	{ 0, TEST_N }, { 256, 3584 }, { 1024, 1025 }, { 1, TEST_N - 1 },
+	{ 3000, 3001 },
+};
+
+/**
+ * @brief Nomes dos tipos de soma, na ordem de `SumType`.
+ */
+static const char *const test_type[] = { "direita", "esquerda", "meio" };
+
+/**
+ * @brief Confere as consultas alinhadas de um índice.
+ *
+ * @param name O nome do caso.
+ * @param idx O índice.
+ * @param func A função do índice.
+ * @return `true` se todas as consultas coincidirem com a soma ponto a ponto.
+ */
+static bool test_queries(const char *name, const RiemannIndex *idx,
+			 Function *func)
+{
+	RiemannOptions brute = { .threads = 1, .brute_force = true,
+				 .precision = RIEMANN_DOUBLE_DOUBLE };
+	bool ok = true;
+
+	for (size_t i = 0; i < sizeof(queries) / sizeof(*queries); ++i) {
+		for (SumType type = DIREITA; type <= ESQUERDA; ++type) {
+			size_t n = queries[i][1] - queries[i][0];
+			double a = queries[i][0] * TEST_DX;
+			double b = queries[i][1] * TEST_DX;
+			double value = index_query(idx, a, b, type);
+			double exact = riemann_opts(a, b, func, n, type,
+						    &brute);
+			double ulps = fabs(value - exact) /
+				      (DBL_EPSILON * exact);
+			bool same = ulps <= TEST_ULPS &&
+				    index_query(idx, b, a, type) == -value;
+
+			printf("%-8s [%-9.6g %-9.6g] %-8s %.17g (%.2g ulps) "
+			       "%s\n",
+			       name, a, b, test_type[type], value, ulps,
+			       same ? "ok" : "FALHOU");
+			ok &= same;
+		}
+	}
+
+	return ok;
+}
+
+/**
+ * @brief Função principal do teste.
+ *
+ * @return EXIT_SUCCESS se todas as verificações passarem, EXIT_FAILURE caso
+ * contrário.
+ */
+int main(void)
+{
+	char path[] = "/tmp/riemann-index-XXXXXX";
+	bool ok = true;
+
+	Function *func = function_new(EXPRESSION, "sin(x)*exp(-x^2)+3");
+	if (func == nullptr)
+		return EXIT_FAILURE;
+	RiemannIndex *idx = index_new(0, 4, func, TEST_N, 3);
+	if (idx == nullptr)
+		return EXIT_FAILURE;
+
+	ok &= test_queries("memória", idx, func);
+
+	// Subintervalo vazio, tipo sem pontos na grade e extremo fora do
+	// domínio.
+	bool edges = index_query(idx, 2, 2, ESQUERDA) == 0 &&
+		     isnan(index_query(idx, 0, 4, MEIO)) &&
+		     isnan(index_query(idx, -1, 4, ESQUERDA)) &&
+		     isnan(index_query(idx, 0, 5, DIREITA));
+	printf("%-8s %s\n", "extremos", edges ? "ok" : "FALHOU");
+	ok &= edges;
+
+	// Grava, mapeia e compara bit a bit.
+	int fd = mkstemp(path);
+	if (fd < 0)
+		return EXIT_FAILURE;
+	close(fd);
+	RiemannIndex *mapped = index_save(idx, path) ? index_open(path) :
+							nullptr;
+	unlink(path);
+	bool same = mapped != nullptr &&
+		    memcmp(index_header(idx), index_header(mapped),
+			   sizeof(IndexHeader)) == 0;
+	for (size_t i = 0; same && i < sizeof(queries) / sizeof(*queries);
+	     ++i) {
+		double a = queries[i][0] * TEST_DX;
+		double b = queries[i][1] * TEST_DX;
+		for (SumType type = DIREITA; type <= ESQUERDA; ++type)
+			same &= index_query(idx, a, b, type) ==
+				index_query(mapped, a, b, type);
+	}
+	printf("%-8s %s\n", "arquivo", same ? "ok" : "FALHOU");
+	ok &= same;
+
+	if (mapped != nullptr)
+		index_free(mapped);
+	index_free(idx);
+	function_free(func);
+
+	puts(ok ? "ok" : "FALHOU");
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
\ No newline at end of file
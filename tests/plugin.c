@@ -0,0 +1,105 @@
+// SPDX-License-Identifier: ISC
+
+/**
+ * @file plugin.c
+ * @brief Verifica o carregamento de plugins de funções.
+ *
+ * @details Carrega `plugins/gauss.so` com \f$\sigma = 2\f$ e compara a soma
+ * pelo ponto médio em \f$[-8, 8]\f$, com \f$10^6\f$ retângulos, com
+ * \f$\sigma \sqrt{2 \pi} \operatorname{erf}(8 / (\sigma \sqrt{2}))\f$. O erro
+ * da regra é limitado por cerca de \f$4 \cdot 10^{-11}\f$, e a tolerância é
+ * `TEST_TOLERANCE`. Verifica também que são recusados os parâmetros
+ * inválidos, um arquivo inexistente, um objeto sem o símbolo
+ * `riemann_plugin_v1` e um com outra versão da interface (os plugins de
+ * `tests/plugins`).
+ *
+ * Uso: `plugin [diretório]`, onde o diretório é o de saída da compilação
+ * (`build`, por padrão).
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "func.h"
+#include "plugin.h"
+#include "riemann.h"
+
+/**
+ * @brief Diferença máxima aceita entre a soma e a integral exata.
+ */
+#define TEST_TOLERANCE 1e-9
+
+/**
+ * @brief Verifica que um plugin é recusado.
+ *
+ * @param dir O diretório de saída da compilação.
+ * @param file O caminho do plugin, relativo a `dir`.
+ * @param params Os parâmetros.
+ * @return `true` se `function_new()` falhar, como esperado.
+ */
+static bool test_rejected(const char *dir, const char *file,
+			  const char *params)
+{
+	char path[4096];
+	snprintf(path, sizeof(path), "%s/%s", dir, file);
+
+	Function *f = function_new(PLUGIN, path, params);
+	if (f == nullptr)
+		return true;
+
+	fprintf(stderr, "FALHOU: %s aceito com os parâmetros %s\n", path,
+		params ? params : "(nenhum)");
+	function_free(f);
+	return false;
+}
+
+/**
+ * @brief Função principal do teste.
+ *
+ * @param argc Número de argumentos.
+ * @param argv Argumentos: o diretório de saída da compilação.
+ * @return EXIT_SUCCESS se todas as verificações passarem, EXIT_FAILURE caso
+ * contrário.
+ */
+int main(int argc, char *argv[])
+{
+	const char *dir = argc > 1 ? argv[1] : "build";
+	const double sigma = 2, pi = 3.14159265358979323846;
+	char path[4096];
+	bool ok = true;
+
+	snprintf(path, sizeof(path), "%s/plugins/gauss.so", dir);
+	Function *f = function_new(PLUGIN, path, "sigma=2");
+	if (f == nullptr) {
+		fprintf(stderr, "FALHOU: %s não foi carregado\n", path);
+		return EXIT_FAILURE;
+	}
+
+	double sum = riemann(-8, 8, f, 1000000, MEIO);
+	double exact = sigma * sqrt(2 * pi) * erf(8 / (sigma * sqrt(2)));
+	printf("%s: %.15g (exata %.15g, diferença %.2g)\n", plugin_name(f),
+	       sum, exact, fabs(sum - exact));
+	if (!(fabs(sum - exact) <= TEST_TOLERANCE)) {
+		fprintf(stderr, "FALHOU: diferença acima de %g\n",
+			TEST_TOLERANCE);
+		ok = false;
+	}
+	if (strcmp(plugin_name(f), "gauss") != 0) {
+		fprintf(stderr, "FALHOU: nome %s\n", plugin_name(f));
+		ok = false;
+	}
+	function_free(f);
+
+	// As mensagens de erro abaixo são esperadas.
+	ok &= test_rejected(dir, "plugins/gauss.so", "sigma=-1");
+	ok &= test_rejected(dir, "plugins/gauss.so", "sigma");
+	ok &= test_rejected(dir, "plugins/gauss.so", "tau=1");
+	ok &= test_rejected(dir, "plugins/inexistente.so", nullptr);
+	ok &= test_rejected(dir, "tests/plugins/nosym.so", nullptr);
+	ok &= test_rejected(dir, "tests/plugins/abi.so", nullptr);
+
+	puts(ok ? "ok" : "FALHOU");
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
\ No newline at end of file
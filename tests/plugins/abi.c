@@ -0,0 +1,27 @@
+// SPDX-License-Identifier: ISC
+
+/**
+ * @file abi.c
+ * @brief Plugin de teste com uma versão de interface incompatível, que
+ * `plugin_open()` deve recusar.
+ */
+
+#include "plugin.h"
+
+/**
+ * @brief A função constante 1.
+ */
+static double one([[maybe_unused]] double x, [[maybe_unused]] void *state)
+{
+	return 1;
+}
+
+/**
+ * @brief Tabela com uma versão futura da interface.
+ */
+const RiemannPlugin riemann_plugin_v1 = {
+	.abi = RIEMANN_PLUGIN_ABI + 1,
+	.size = sizeof(RiemannPlugin),
+	.name = "abi",
+	.eval = &one,
+};
\ No newline at end of file
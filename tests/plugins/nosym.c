@@ -0,0 +1,27 @@
+// SPDX-License-Identifier: ISC
+
+/**
+ * @file nosym.c
+ * @brief Plugin de teste que não exporta `riemann_plugin_v1`, e que
+ * `plugin_open()` deve recusar.
+ */
+
+#include "plugin.h"
+
+/**
+ * @brief A função constante 1.
+ */
+static double one([[maybe_unused]] double x, [[maybe_unused]] void *state)
+{
+	return 1;
+}
+
+/**
+ * @brief Tabela com um nome de símbolo de outra versão.
+ */
+const RiemannPlugin riemann_plugin_v0 = {
+	.abi = RIEMANN_PLUGIN_ABI,
+	.size = sizeof(RiemannPlugin),
+	.name = "nosym",
+	.eval = &one,
+};
\ No newline at end of file
@@ -0,0 +1,140 @@
+// SPDX-License-Identifier: ISC
+
+/**
+ * @file quad.c
+ * @brief Verifica o integrador adaptativo de Gauss–Kronrod.
+ *
+ * @details Cobre a exatidão da regra G7-K15 para polinômios de grau até 22,
+ * a subdivisão adaptativa pelo heap numa função com derivada singular, e as
+ * saídas `QUAD_MAX_EVALS`, `QUAD_ROUNDOFF` e `QUAD_NONFINITE`. As funções
+ * sem avaliação em lote são montadas aqui, para exercitar também a avaliação
+ * ponto a ponto. Termina com erro se alguma verificação falhar.
+ */
+
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "func.h"
+#include "quad.h"
+
+/**
+ * @brief Nomes das situações finais, na ordem de `QuadStatus`.
+ */
+static const char *const test_status[] = { "ok", "max_evals", "roundoff",
+					   "nomem", "nonfinite" };
+
+/**
+ * @brief Avalia \f$\sqrt{x}\f$.
+ *
+ * @param x O ponto.
+ * @param impl Não usado.
+ * @return O valor.
+ */
+static double test_sqrt(double x, [[maybe_unused]] void *impl)
+{
+	return sqrt(x);
+}
+
+/**
+ * @brief Avalia \f$1 / x\f$.
+ *
+ * @param x O ponto.
+ * @param impl Não usado.
+ * @return O valor.
+ */
+static double test_inverse(double x, [[maybe_unused]] void *impl)
+{
+	return 1 / x;
+}
+
+/**
+ * @brief Confere o resultado de uma integração.
+ *
+ * @param name O nome do caso.
+ * @param res O resultado.
+ * @param status A situação final esperada.
+ * @param exact A integral exata, ou `NAN` para não conferir o valor.
+ * @param tol A diferença máxima aceita para `exact`.
+ * @return `true` se o resultado for o esperado.
+ */
+static bool test_check(const char *name, QuadResult res, QuadStatus status,
+		       double exact, double tol)
+{
+	bool ok = res.status == status &&
+		  (isnan(exact) || fabs(res.value - exact) <= tol);
+
+	printf("%-10s %-9s %.17g (erro %.2g, %zu avaliações, %zu "
+	       "subintervalos) %s\n",
+	       name, test_status[res.status], res.value, res.error, res.evals,
+	       res.intervals, ok ? "ok" : "FALHOU");
+	return ok;
+}
+
+/**
+ * @brief Função principal do teste.
+ *
+ * @return EXIT_SUCCESS se todas as verificações passarem, EXIT_FAILURE caso
+ * contrário.
+ */
+int main(void)
+{
+	Function root = { .type = EXPRESSION, .eval = &test_sqrt };
+	Function inverse = { .type = EXPRESSION, .eval = &test_inverse };
+	double coeffs[23] = { 0 };
+	bool ok = true;
+
+	// x²² + x⁷ + 1 em [-1, 2]: a regra de Kronrod é exata, mas a de Gauss
+	// não, e o orçamento de uma só aplicação impede a divisão.
+	coeffs[0] = coeffs[7] = coeffs[22] = 1;
+	Function *poly = function_new(POLYNOMIAL, (size_t)22, coeffs);
+	if (poly == nullptr)
+		return EXIT_FAILURE;
+	double exact = (pow(2, 23) + 1) / 23 + (pow(2, 8) - 1) / 8 + 3;
+	QuadResult res = quad_gk(-1, 2, poly, 0, 0, QUAD_POINTS);
+	ok &= test_check("kronrod", res, QUAD_MAX_EVALS, exact,
+			 8 * DBL_EPSILON * exact);
+	function_free(poly);
+
+	// x¹³ + 1 em [-1, 2]: as duas regras são exatas, e o erro estimado é
+	// só o de arredondamento.
+	coeffs[7] = coeffs[22] = 0;
+	coeffs[13] = 1;
+	poly = function_new(POLYNOMIAL, (size_t)13, coeffs);
+	if (poly == nullptr)
+		return EXIT_FAILURE;
+	exact = (pow(2, 14) - 1) / 14 + 3;
+	res = quad_gk(-1, 2, poly, 0, 1e-12, 1000);
+	ok &= test_check("g7-k15", res, QUAD_OK, exact,
+			 8 * DBL_EPSILON * exact);
+	ok &= res.evals == QUAD_POINTS && res.intervals == 1;
+	function_free(poly);
+
+	// √x em [0, 1]: a singularidade da derivada em 0 força a divisão
+	// repetida do subintervalo da esquerda, sempre o de maior erro.
+	res = quad_gk(0, 1, &root, 1e-12, 0, 100000);
+	ok &= test_check("heap", res, QUAD_OK, 2.0 / 3, 1e-12);
+	ok &= res.intervals > 10 && res.error <= 1e-12;
+
+	// A mesma integral, sem orçamento para atingir a tolerância.
+	res = quad_gk(0, 1, &root, 1e-15, 0, 100);
+	ok &= test_check("max_evals", res, QUAD_MAX_EVALS, 2.0 / 3, 1e-3);
+	ok &= res.evals <= 100 && res.evals + 2 * QUAD_POINTS > 100;
+
+	// Tolerância nula num intervalo de 4 ulps: as divisões param quando o
+	// ponto médio não é mais representável.
+	double b = nextafter(nextafter(nextafter(nextafter(1, 2), 2), 2), 2);
+	res = quad_gk(1, b, &root, 0, 0, 100000);
+	ok &= test_check("roundoff", res, QUAD_ROUNDOFF, (b - 1),
+			 4 * DBL_EPSILON * (b - 1));
+	ok &= res.intervals == 4;
+
+	// 1/x em [-1, 1]: o centro é avaliado em 0, e o erro é infinito ou
+	// NaN.
+	res = quad_gk(-1, 1, &inverse, 1e-12, 0, 100000);
+	ok &= test_check("nonfinite", res, QUAD_NONFINITE, NAN, 0);
+
+	puts(ok ? "ok" : "FALHOU");
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
\ No newline at end of file
@@ -0,0 +1,158 @@
+// SPDX-License-Identifier: ISC
+
+/**
+ * @file riemann.c
+ * @brief Verifica a soma de Riemann com várias threads e a fórmula fechada.
+ *
+ * @details Soma ponto a ponto, em várias dezenas de blocos de
+ * `RIEMANN_BLOCK` pontos (o último incompleto), um polinômio em cada
+ * precisão e uma expressão, pelos três tipos de soma, e verifica que o
+ * resultado com 3 e com 8 threads é idêntico bit a bit ao com uma. Compara
+ * também a fórmula fechada de Faulhaber, para polinômios de vários graus e
+ * vários valores de \f$n\f$, com a soma ponto a ponto em dupla-dupla. Os
+ * coeficientes e o intervalo são positivos, para que a soma não se cancele e
+ * a diferença possa ser medida em ulps do resultado. Termina com erro se
+ * alguma verificação falhar.
+ */
+
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "func.h"
+#include "riemann.h"
+
+/**
+ * @brief Número de retângulos, que não é múltiplo de `RIEMANN_BLOCK`.
+ */
+#define TEST_N (37 * RIEMANN_BLOCK + 123)
+
+/**
+ * @brief Maior diferença aceita entre a fórmula fechada e a soma ponto a
+ * ponto, em ulps do resultado.
+ */
+#define TEST_CLOSED_ULPS 4
+
+/**
+ * @brief Nomes dos tipos de soma, na ordem de `SumType`.
+ */
+static const char *const test_type[] = { "direita", "esquerda", "meio" };
+
+/**
+ * @brief Nomes das precisões, na ordem de `RiemannPrecision`.
+ */
+static const char *const test_precision[] = { "double", "float",
+					      "double-double" };
+
+/**
+ * @brief Confere que a soma não depende do número de threads.
+ *
+ * @param name O nome do caso.
+ * @param func A função.
+ * @param precision A precisão da soma.
+ * @return `true` se as somas com 1, 3 e 8 threads forem idênticas.
+ */
+static bool test_threads(const char *name, Function *func,
+			 RiemannPrecision precision)
+{
+	static const unsigned threads[] = { 3, 8 };
+	RiemannOptions opts = { .threads = 1, .brute_force = true,
+				.precision = precision };
+	bool ok = true;
+
+	for (SumType type = DIREITA; type <= MEIO; ++type) {
+		opts.threads = 1;
+		double one = riemann_opts(-1, 2, func, TEST_N, type, &opts);
+		bool same = true;
+
+		for (size_t i = 0; i < sizeof(threads) / sizeof(*threads);
+		     ++i) {
+			opts.threads = threads[i];
+			same &= riemann_opts(-1, 2, func, TEST_N, type,
+					     &opts) == one;
+		}
+
+		printf("%-10s %-13s %-8s %.17g %s\n", name,
+		       test_precision[precision], test_type[type], one,
+		       same ? "ok" : "FALHOU");
+		ok &= same;
+	}
+
+	return ok;
+}
+
+/**
+ * @brief Confere a fórmula fechada contra a soma ponto a ponto.
+ *
+ * @param func O polinômio.
+ * @param degree O grau do polinômio, para a saída.
+ * @param n O número de retângulos, ao menos `RIEMANN_CLOSED_MIN_N`.
+ * @return `true` se, nos três tipos de soma, as duas diferirem em no máximo
+ * `TEST_CLOSED_ULPS` ulps.
+ */
+static bool test_closed(Function *func, size_t degree, size_t n)
+{
+	RiemannOptions closed = { .threads = 1 };
+	RiemannOptions brute = { .threads = 1, .brute_force = true,
+				 .precision = RIEMANN_DOUBLE_DOUBLE };
+	bool ok = true;
+
+	for (SumType type = DIREITA; type <= MEIO; ++type) {
+		double value = riemann_opts(0.5, 2, func, n, type, &closed);
+		double exact = riemann_opts(0.5, 2, func, n, type, &brute);
+		double ulps = fabs(value - exact) / (DBL_EPSILON * exact);
+		bool same = ulps <= TEST_CLOSED_ULPS;
+
+		printf("faulhaber grau %-2zu n %-6zu %-8s %.17g (%.2g ulps) "
+		       "%s\n",
+		       degree, n, test_type[type], value, ulps,
+		       same ? "ok" : "FALHOU");
+		ok &= same;
+	}
+
+	return ok;
+}
+
+/**
+ * @brief Função principal do teste.
+ *
+ * @return EXIT_SUCCESS se todas as verificações passarem, EXIT_FAILURE caso
+ * contrário.
+ */
+int main(void)
+{
+	double coeffs[] = { 1, -2, 0.5, 3, -0.25, 1.5 };
+	bool ok = true;
+
+	Function *poly = function_new(POLYNOMIAL, (size_t)5, coeffs);
+	if (poly == nullptr)
+		return EXIT_FAILURE;
+	for (RiemannPrecision p = RIEMANN_DOUBLE; p <= RIEMANN_DOUBLE_DOUBLE;
+	     ++p)
+		ok &= test_threads("polinômio", poly, p);
+	function_free(poly);
+
+	Function *expr = function_new(EXPRESSION, "sin(x)*exp(-x^2)+3");
+	if (expr == nullptr)
+		return EXIT_FAILURE;
+	ok &= test_threads("expressão", expr, RIEMANN_DOUBLE);
+	function_free(expr);
+
+	// Polinômios de coeficientes positivos, de graus até 12.
+	double positive[] = { 1, 2, 0.5, 3, 0.25, 1.5, 0.75,
+			      1, 2, 0.125, 0.5, 1, 0.3 };
+	static const size_t degrees[] = { 0, 2, 5, 9, 12 };
+	static const size_t ns[] = { RIEMANN_CLOSED_MIN_N, 1000, 65537 };
+	for (size_t i = 0; i < sizeof(degrees) / sizeof(*degrees); ++i) {
+		poly = function_new(POLYNOMIAL, degrees[i], positive);
+		if (poly == nullptr)
+			return EXIT_FAILURE;
+		for (size_t j = 0; j < sizeof(ns) / sizeof(*ns); ++j)
+			ok &= test_closed(poly, degrees[i], ns[j]);
+		function_free(poly);
+	}
+
+	puts(ok ? "ok" : "FALHOU");
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
\ No newline at end of file
@@ -0,0 +1,145 @@
+// SPDX-License-Identifier: ISC
+
+/**
+ * @file simd.c
+ * @brief Verifica o limite de erro dos núcleos vetorizados de Horner.
+ *
+ * @details Para cada nível aceito por `simd_set_level()`, avalia polinômios
+ * de grau 0 a 64, com coeficientes e pontos pseudoaleatórios, por
+ * `simd_poly_horner()` e por `polynomial_eval()`, e verifica que a diferença
+ * é de no máximo `SIMD_POLY_ERROR_BOUND(grau)` vezes
+ * \f$u \sum |c_i| |x|^i\f$. As quantidades de pontos são ímpares, para
+ * exercitar as lanes da cauda, e a posição seguinte à última deve continuar
+ * intacta. Termina com erro na primeira violação de cada nível.
+ */
+
+#include <float.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "func.h"
+#include "simd.h"
+
+/**
+ * @brief Maior grau verificado.
+ */
+#define TEST_MAX_DEGREE 64
+
+/**
+ * @brief Maior número de pontos por chamada.
+ */
+#define TEST_MAX_COUNT 101
+
+/**
+ * @brief Valor que marca a posição após o último ponto.
+ */
+#define TEST_SENTINEL 12345.0
+
+// Definida em `func.c`, sem declaração pública.
+extern double polynomial_eval(double x, Polynomial *ptr);
+
+/**
+ * @brief Gera um número pseudoaleatório em \f$[-1, 1)\f$ (xorshift64).
+ *
+ * @param state O estado do gerador, não nulo.
+ * @return O número.
+ */
+static double test_random(uint64_t *state)
+{
+	*state ^= *state << 13;
+	*state ^= *state >> 7;
+	*state ^= *state << 17;
+	return (double)(*state >> 11) * 0x1p-52 - 1;
+}
+
+/**
+ * @brief Verifica um nível de vetorização.
+ *
+ * @param level O nível, já selecionado.
+ * @return O número de violações encontradas.
+ */
+static size_t test_level(SimdLevel level)
+{
+	static const size_t counts[] = { 1, 3, 5, 7, 9, 15, 17, 31, 33, 63,
+					 TEST_MAX_COUNT };
+	double coeffs[TEST_MAX_DEGREE + 1], x[TEST_MAX_COUNT];
+	double y[TEST_MAX_COUNT + 1];
+	uint64_t state = 0x9e3779b97f4a7c15;
+	size_t failures = 0;
+
+	for (size_t degree = 0; degree <= TEST_MAX_DEGREE; ++degree) {
+		for (size_t k = 0; k <= degree; ++k)
+			coeffs[k] = test_random(&state);
+		Polynomial poly = { .degree = degree, .coefficients = coeffs };
+		double bound = SIMD_POLY_ERROR_BOUND(degree) * DBL_EPSILON / 2;
+
+		for (size_t c = 0; c < sizeof(counts) / sizeof(*counts); ++c) {
+			size_t count = counts[c];
+			for (size_t j = 0; j < count; ++j)
+				x[j] = 1.5 * test_random(&state);
+			y[count] = TEST_SENTINEL;
+			simd_poly_horner(coeffs, degree, x, y, count);
+
+			if (y[count] != TEST_SENTINEL) {
+				fprintf(stderr,
+					"%s: grau %zu, %zu pontos: escreveu "
+					"além do último ponto\n",
+					simd_level_name(level), degree, count);
+				++failures;
+			}
+
+			for (size_t j = 0; j < count; ++j) {
+				long double sum = 0, pow = 1;
+				for (size_t k = 0; k <= degree; ++k) {
+					sum += fabsl((long double)coeffs[k]) *
+					       pow;
+					pow *= fabsl((long double)x[j]);
+				}
+
+				double ref = polynomial_eval(x[j], &poly);
+				long double diff = fabsl((long double)y[j] - ref);
+				// A margem cobre os termos de ordem u².
+				if (diff <= bound * sum * (1 + 0x1p-20))
+					continue;
+
+				fprintf(stderr,
+					"%s: grau %zu, x = %a: %a, "
+					"esperado %a (diferença %Lg u·Σ, "
+					"limite %g)\n",
+					simd_level_name(level), degree, x[j],
+					y[j], ref, diff / sum / (DBL_EPSILON / 2),
+					SIMD_POLY_ERROR_BOUND(degree));
+				++failures;
+			}
+		}
+	}
+
+	return failures;
+}
+
+/**
+ * @brief Função principal do teste.
+ *
+ * @return EXIT_SUCCESS se todos os níveis respeitarem o limite,
+ * EXIT_FAILURE caso contrário.
+ */
+int main(void)
+{
+	SimdLevel levels[] = { SIMD_SCALAR, SIMD_SSE2, SIMD_AVX2,
+			       SIMD_AVX512 };
+	size_t failures = 0;
+
+	for (size_t i = 0; i < sizeof(levels) / sizeof(*levels); ++i) {
+		if (simd_set_level(levels[i]) != levels[i])
+			continue;
+
+		size_t f = test_level(levels[i]);
+		printf("%-7s %s\n", simd_level_name(levels[i]),
+		       f == 0 ? "ok" : "FALHOU");
+		failures += f;
+	}
+
+	return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
\ No newline at end of file
@@ -0,0 +1,160 @@
+// SPDX-License-Identifier: ISC
+
+/**
+ * @file tabulated.c
+ * @brief Verifica o formato das funções tabeladas e a sua interpolação.
+ *
+ * @details Grava amostras de \f$\sin x\f$ em \f$[0, \pi]\f$ num arquivo
+ * temporário, nos dois leiautes, e verifica que, depois de mapeadas, o
+ * domínio e os valores nas amostras são os gravados, que a avaliação em lote
+ * coincide com a pontual, e que os erros nos pontos médios e da integral
+ * ficam dentro dos limites de cada interpolação. Verifica também que abscissas
+ * fora de ordem são recusadas já na abertura. Termina com erro se alguma
+ * verificação falhar.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "tabulated.h"
+
+/**
+ * @brief Número de amostras.
+ */
+#define TEST_COUNT 1025
+
+/**
+ * @brief O valor de \f$\pi\f$, que a biblioteca padrão do C não define.
+ */
+#define TEST_PI 3.14159265358979323846
+
+/**
+ * @brief Nomes dos métodos de interpolação, na ordem de `TabulatedInterp`.
+ */
+static const char *const test_interp[] = { "linear", "cúbica" };
+
+/**
+ * @brief Abscissa de uma amostra.
+ *
+ * @param layout O leiaute: as amostras de pares se adensam perto de 0.
+ * @param i O índice da amostra.
+ * @return \f$x_i\f$.
+ */
+static double test_x(TabulatedLayout layout, size_t i)
+{
+	double t = (double)i / (TEST_COUNT - 1);
+
+	// A mesma conta de `tabulated_x()`, com x₀ = 0.
+	if (layout == TABULATED_UNIFORM)
+		return i * (TEST_PI / (TEST_COUNT - 1));
+	return TEST_PI * t * t;
+}
+
+/**
+ * @brief Confere um arquivo de amostras com um método de interpolação.
+ *
+ * @param path O caminho do arquivo.
+ * @param layout O leiaute em que o arquivo foi gravado.
+ * @param interp O método de interpolação.
+ * @param tol O maior erro aceito nos pontos médios.
+ * @return `true` se todas as verificações passarem.
+ */
+static bool test_file(const char *path, TabulatedLayout layout,
+		      TabulatedInterp interp, double tol)
+{
+	static double x[TEST_COUNT - 1], y[TEST_COUNT - 1];
+	double min, max, integral;
+
+	Tabulated *tab = tabulated_open(path, interp);
+	if (tab == nullptr)
+		return false;
+
+	tabulated_domain(tab, &min, &max);
+	bool ok = min == test_x(layout, 0) &&
+		  max == test_x(layout, TEST_COUNT - 1);
+
+	// Os valores nas amostras são os gravados. A última é o fim do
+	// último intervalo, onde a linear pode arredondar y₀ + (y₁ - y₀).
+	for (size_t i = 0; i < TEST_COUNT - 1; ++i) {
+		double xi = test_x(layout, i);
+		ok &= tabulated_eval(xi, tab) == sin(xi);
+	}
+	ok &= fabs(tabulated_eval(max, tab) - sin(max)) <= DBL_EPSILON;
+
+	// Nos pontos médios, o erro é o da interpolação.
+	double err = 0;
+	for (size_t i = 0; i < TEST_COUNT - 1; ++i) {
+		x[i] = (test_x(layout, i) + test_x(layout, i + 1)) / 2;
+		y[i] = tabulated_eval(x[i], tab);
+		err = fmax(err, fabs(y[i] - sin(x[i])));
+	}
+	tabulated_eval_batch(x, x, TEST_COUNT - 1, tab);
+	for (size_t i = 0; i < TEST_COUNT - 1; ++i)
+		ok &= x[i] == y[i];
+	ok &= err <= tol;
+	tabulated_free(tab);
+
+	// A integral exata é 2; o erro é o da interpolação, integrado.
+	ok &= tabulated_integrate(path, interp, &integral) &&
+	      fabs(integral - 2) <= TEST_PI * tol;
+
+	printf("%-9s %-8s erro %.2g, integral %.17g %s\n",
+	       layout == TABULATED_UNIFORM ? "uniforme" : "pares",
+	       test_interp[interp], err, integral, ok ? "ok" : "FALHOU");
+	return ok;
+}
+
+/**
+ * @brief Função principal do teste.
+ *
+ * @return EXIT_SUCCESS se todas as verificações passarem, EXIT_FAILURE caso
+ * contrário.
+ */
+int main(void)
+{
+	static double data[2 * TEST_COUNT];
+	char path[] = "/tmp/riemann-tabulated-XXXXXX";
+	double h = TEST_PI / (TEST_COUNT - 1);
+	bool ok = true;
+
+	int fd = mkstemp(path);
+	if (fd < 0)
+		return EXIT_FAILURE;
+	close(fd);
+
+	// Leiaute uniforme: o erro da linear é até h²/8, e o da cúbica, com
+	// derivadas centradas, é O(h³).
+	for (size_t i = 0; i < TEST_COUNT; ++i)
+		data[i] = sin(test_x(TABULATED_UNIFORM, i));
+	ok &= tabulated_save(path, TABULATED_UNIFORM, 0, h, data, TEST_COUNT);
+	ok &= test_file(path, TABULATED_UNIFORM, TABULATED_LINEAR, h * h / 8);
+	ok &= test_file(path, TABULATED_UNIFORM, TABULATED_CUBIC, h * h * h);
+
+	// Leiaute de pares, com espaçamentos até 2h.
+	for (size_t i = 0; i < TEST_COUNT; ++i) {
+		data[2 * i] = test_x(TABULATED_PAIRS, i);
+		data[2 * i + 1] = sin(data[2 * i]);
+	}
+	ok &= tabulated_save(path, TABULATED_PAIRS, 0, 0, data, TEST_COUNT);
+	ok &= test_file(path, TABULATED_PAIRS, TABULATED_LINEAR, h * h / 2);
+	ok &= test_file(path, TABULATED_PAIRS, TABULATED_CUBIC, 8 * h * h * h);
+
+	// Duas abscissas trocadas: o arquivo é recusado na abertura.
+	data[2 * 500] = data[2 * 501];
+	double integral;
+	bool refused = tabulated_save(path, TABULATED_PAIRS, 0, 0, data,
+				      TEST_COUNT) &&
+		       tabulated_open(path, TABULATED_LINEAR) == nullptr &&
+		       !tabulated_integrate(path, TABULATED_LINEAR, &integral);
+	printf("%-9s %s\n", "ordem", refused ? "ok" : "FALHOU");
+	ok &= refused;
+
+	unlink(path);
+	puts(ok ? "ok" : "FALHOU");
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
\ No newline at end of file